@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_bearer.h"
+#include "sim800l_http.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L BEARER MANAGER EXAMPLE"
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+/* Manager config, short poll so a drop shows up quickly in this demo */
+sim800l_bearer_manager_config_t bearer_config = {
+    .poll_interval_ms = 10000,
+    .backoff_min_ms = 1000,
+    .backoff_max_ms = 30000};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_BEARER:
+    {
+        sim800l_bearer_event_t *event = (sim800l_bearer_event_t *)data->ptr;
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L EVENT BEARER: state %d, IP %s", event->state, event->ipv4);
+
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Set Bearer contype */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_CONTYPE, "GPRS") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer contype failed");
+        return;
+    }
+
+    /* Set Bearer APN */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_APN, "timbrasil.br") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer APN failed");
+        return;
+    }
+
+    /* Set Bearer USER */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_USER, "tim") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer USER failed");
+        return;
+    }
+
+    /* Set Bearer PASS */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_PWD, "tim") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer PASS failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L bearer params set");
+
+    /* Pre-warm: the bearer comes up while the application does the rest of its setup */
+    int64_t boot = esp_timer_get_time();
+    if (sim800l_bearer_manager_start(sim800l_handle, &bearer_config) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bearer manager start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L bearer manager started");
+
+    /* Application setup that does not need the network */
+    if (sim800l_http_switch(sim800l_handle, true) != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init HTTP failed");
+        return;
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, "1") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set CID failed");
+        return;
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, "www.helloworld.org/data/helloworld.c") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set URL failed");
+        return;
+    }
+
+    /* First request only waits for whatever is left of the attach */
+    int64_t request = esp_timer_get_time();
+    if (sim800l_bearer_wait_ready(sim800l_handle, 120000) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bearer not ready");
+        return;
+    }
+    int64_t ready = esp_timer_get_time();
+
+    if (sim800l_http_action(sim800l_handle, SIM800L_HTTP_METHOD_GET) != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L HTTP action failed");
+        return;
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Boot to bearer up: %lld ms, request waited: %lld ms", (ready - boot) / 1000, (ready - request) / 1000);
+
+    /* Pull the antenna to see drops and recoveries */
+    while (true)
+    {
+        sim800l_bearer_stats_t stats = {0};
+        sim800l_bearer_get_stats(&stats);
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "State %d, connects %lu, drops %lu, failures %lu, first up %llu ms, last recovery %llu ms",
+                 sim800l_bearer_get_state(), stats.connects, stats.drops, stats.failures,
+                 stats.first_up_us / 1000, stats.last_recovery_us / 1000);
+
+        vTaskDelay(10000 / portTICK_PERIOD_MS);
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
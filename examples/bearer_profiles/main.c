@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_bearer.h"
+#include "sim800l_http.h"
+#include "sim800l_shadow.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L BEARER PROFILES EXAMPLE"
+
+/* Profiles */
+#define TELEMETRY_CID 1
+#define BULK_CID 2
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+/* Low volume APN for telemetry, bulk APN for transfers */
+sim800l_bearer_param_t telemetry_param = {
+    .contype = "GPRS",
+    .apn = "telemetry.apn",
+    .user = "tim",
+    .pwd = "tim"};
+
+sim800l_bearer_param_t bulk_param = {
+    .contype = "GPRS",
+    .apn = "timbrasil.br",
+    .user = "tim",
+    .pwd = "tim"};
+
+static sim800l_ret_t bulk_transfer(void)
+{
+    int64_t start = esp_timer_get_time();
+
+    /* Parameters set on the first call are still on the modem, only the changed ones are sent */
+    if (sim800l_bearer_profile_config(sim800l_handle, BULK_CID, &bulk_param) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bulk profile config failed");
+        return SIM800L_RET_ERROR;
+    }
+    int64_t configured = esp_timer_get_time();
+
+    if (sim800l_bearer_profile_switch(sim800l_handle, BULK_CID, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bulk profile open failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Bulk profile config %lld ms, open %lld ms", (configured - start) / 1000, (esp_timer_get_time() - configured) / 1000);
+
+    /* HTTP on the bulk profile */
+    if (sim800l_http_switch(sim800l_handle, true) != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init HTTP failed");
+    }
+    else
+    {
+        sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, "2");
+        sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, "www.helloworld.org/data/helloworld.c");
+        sim800l_http_action(sim800l_handle, SIM800L_HTTP_METHOD_GET);
+        vTaskDelay(10000 / portTICK_PERIOD_MS);
+        sim800l_http_switch(sim800l_handle, false);
+    }
+
+    /* Close the bulk profile, telemetry stays up */
+    return sim800l_bearer_profile_switch(sim800l_handle, BULK_CID, false);
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Telemetry profile */
+    if (sim800l_bearer_profile_config(sim800l_handle, TELEMETRY_CID, &telemetry_param) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L telemetry profile config failed");
+        return;
+    }
+
+    if (sim800l_bearer_profile_switch(sim800l_handle, TELEMETRY_CID, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L telemetry profile open failed");
+        return;
+    }
+
+    sim800l_bearer_t bearer = {0};
+    if (sim800l_bearer_profile_query(sim800l_handle, TELEMETRY_CID, &bearer) == SIM800L_RET_OK)
+    {
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "Telemetry profile %lu status %lu IP %s", bearer.cid, bearer.status, bearer.ipv4);
+    }
+
+    /* First bulk transfer sends the parameters, the next ones only open the profile */
+    while (true)
+    {
+        bulk_transfer();
+
+        /* Settings the modem already had, each one a round trip not made */
+        sim800l_shadow_stats_t shadow = {0};
+        sim800l_shadow_get_stats(&shadow);
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "Shadow: %lu sets skipped, %lu queries served this boot, %lu before the last of %lu resets",
+                 shadow.sets_skipped, shadow.queries_served, shadow.previous_saved, shadow.invalidations);
+
+        vTaskDelay(60000 / portTICK_PERIOD_MS);
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
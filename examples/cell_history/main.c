@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_bearer.h"
+#include "sim800l_http.h"
+#include "sim800l_ceng.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L CELL HISTORY EXAMPLE"
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+/* One sample a minute */
+sim800l_ceng_config_t ceng_config = {
+    .interval_ms = 60000};
+
+/* Export buffer, history plus version and base record */
+static uint8_t export_buffer[SIM800L_CENG_HISTORY_SIZE + 64];
+
+static void cell_print(const sim800l_ceng_sample_t *sample, void *arg)
+{
+    const sim800l_ceng_cell_t *serving = &sample->cell[0];
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "%lu s: %u-%u LAC %04X CI %04X %d dBm, %lu neighbours",
+             sample->timestamp, serving->mcc, serving->mnc, serving->lac, serving->ci,
+             serving->rxlev - 110, sample->cells - 1);
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Bearer profile */
+    sim800l_bearer_param_t bearer_param = {
+        .contype = "GPRS",
+        .apn = "timbrasil.br",
+        .user = "tim",
+        .pwd = "tim"};
+    if (sim800l_bearer_profile_config(sim800l_handle, 1, &bearer_param) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bearer config failed");
+        return;
+    }
+
+    if (sim800l_http_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init HTTP failed");
+        return;
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, "1") != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set CID failed");
+        return;
+    }
+
+    /* Background AT+CENG? sampling */
+    if (sim800l_ceng_start(sim800l_handle, &ceng_config) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L CENG start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L CENG sampling started");
+
+    /* Ship the history once an hour in a single POST */
+    while (true)
+    {
+        vTaskDelay(3600000 / portTICK_PERIOD_MS);
+
+        sim800l_ceng_stats_t stats = {0};
+        sim800l_ceng_get_stats(&stats);
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "%lu samples in %lu bytes, %lu evicted, %llu us parse per sample",
+                 stats.samples, stats.bytes, stats.evicted, (stats.samples > 0) ? stats.parse_us / stats.samples : 0);
+
+        size_t export_len = 0;
+        if (sim800l_ceng_export(export_buffer, sizeof(export_buffer), &export_len) != SIM800L_RET_OK)
+        {
+            continue;
+        }
+
+        /* What the server will see */
+        sim800l_ceng_decode(export_buffer, export_len, cell_print, NULL);
+
+        if (sim800l_bearer_profile_switch(sim800l_handle, 1, true) != SIM800L_RET_OK)
+        {
+            ESP_LOGW(TAG_SIM800L_EXAMPLE, "SIM800L bearer open failed, keeping the history");
+            continue;
+        }
+
+        sim800l_http_action_t action = {0};
+        if ((sim800l_http_post_compressed(sim800l_handle, "www.example.com/cells", "application/octet-stream",
+                                          export_buffer, export_len, false, &action, NULL) == SIM800L_RET_OK) &&
+            (action.http_code == 200))
+        {
+            /* Acknowledged, start over */
+            sim800l_ceng_clear();
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "Uploaded %u bytes", export_len);
+        }
+
+        sim800l_bearer_profile_switch(sim800l_handle, 1, false);
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
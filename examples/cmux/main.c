@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_cmux.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L CMUX EXAMPLE"
+
+/* Benchmark */
+#define BENCH_ROUNDS 20
+
+volatile bool streaming = false;
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L EVENT %ld", event_id);
+}
+
+/* Keeps the data channel busy with its own command stream */
+static void data_channel_task(void *args)
+{
+    static const char command[] = "AT+GSN\r";
+    uint8_t buffer[64];
+    uint32_t bytes = 0;
+
+    while (streaming)
+    {
+        size_t received = 0;
+
+        sim800l_cmux_write(SIM800L_CMUX_DATA_DLCI, (const uint8_t *)command, strlen(command), 1000);
+        while ((sim800l_cmux_read(SIM800L_CMUX_DATA_DLCI, buffer, sizeof(buffer), &received, 100) == SIM800L_RET_OK) && (received > 0))
+        {
+            bytes += received;
+        }
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Data channel: %lu bytes received", bytes);
+    vTaskDelete(NULL);
+}
+
+static uint64_t at_latency_us(void)
+{
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < BENCH_ROUNDS; i++)
+    {
+        int64_t start = esp_timer_get_time();
+        sim800l_command_AT(sim800l_handle);
+        total += esp_timer_get_time() - start;
+    }
+
+    return total / BENCH_ROUNDS;
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* AT engine on DLCI 1 from here on */
+    if (sim800l_cmux_start(sim800l_handle) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L CMUX start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L CMUX start success");
+
+    uint64_t idle_us = at_latency_us();
+
+    /* Same AT round trips while DLCI 2 streams */
+    streaming = true;
+    xTaskCreate(data_channel_task, "data_channel_task", 4096, NULL, 1, NULL);
+
+    uint64_t busy_us = at_latency_us();
+
+    streaming = false;
+    vTaskDelay(500 / portTICK_PERIOD_MS);
+
+    sim800l_cmux_stats_t stats = {0};
+    sim800l_cmux_get_stats(&stats);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "AT latency: %llu us idle, %llu us with data channel busy", idle_us, busy_us);
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "TX %lu frames, %lu payload / %lu wire bytes", stats.tx_frames, stats.tx_payload, stats.tx_wire);
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "RX %lu frames, %lu payload / %lu wire bytes, %lu FCS errors, %lu dropped",
+             stats.rx_frames, stats.rx_payload, stats.rx_wire, stats.fcs_errors, stats.rx_dropped);
+
+    /* Back to plain AT on the UART */
+    sim800l_cmux_stop(sim800l_handle);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_bearer.h"
+#include "sim800l_ftp.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L FTP EXAMPLE"
+
+/* FTP server, a local vsftpd/pure-ftpd reachable from the cellular network */
+#define FTP_SERVER "ftp.example.com"
+#define FTP_USER "sim800l"
+#define FTP_PASSWORD "sim800l"
+#define FTP_PATH "/"
+#define FTP_FILE "data.bin"
+#define FTP_UPLOAD_FILE "upload.bin"
+#define FTP_UPLOAD_SIZE (32 * 1024)
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+/* Download sink, stops halfway on the first run to show the resume */
+static uint32_t download_limit = 0;
+static uint32_t download_bytes = 0;
+
+static sim800l_ret_t ftp_sink(const uint8_t *data, size_t data_len, void *arg)
+{
+    download_bytes += data_len;
+
+    return ((download_limit > 0) && (download_bytes >= download_limit)) ? SIM800L_RET_ERROR : SIM800L_RET_OK;
+}
+
+/* Upload source, a generated pattern */
+static uint32_t upload_bytes = 0;
+
+static size_t ftp_source(uint8_t *buffer, size_t buffer_size, void *arg)
+{
+    size_t length = FTP_UPLOAD_SIZE - upload_bytes;
+    if (length > buffer_size)
+    {
+        length = buffer_size;
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        buffer[i] = (upload_bytes + i) & 0xFF;
+    }
+
+    upload_bytes += length;
+
+    return length;
+}
+
+static void ftp_report(const char *name)
+{
+    sim800l_ftp_stats_t stats = {0};
+    sim800l_ftp_get_stats(&stats);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "%s: %lu bytes from %lu, %lu chunks, %llu ms, %llu B/s", name, stats.bytes, stats.offset, stats.chunks,
+             stats.elapsed_us / 1000, (stats.elapsed_us > 0) ? (uint64_t)stats.bytes * 1000000 / stats.elapsed_us : 0);
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Set Bearer contype */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_CONTYPE, "GPRS") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer contype failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer contype success");
+
+    /* Set Bearer APN */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_APN, "timbrasil.br") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer APN failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer APN success");
+
+    /* Set Bearer USER */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_USER, "tim") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer USER failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer USER success");
+
+    /* Set Bearer PASS */
+    if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_PWD, "tim") != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer PASS failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer PASS success");
+
+    /* Enable bearer */
+    if (sim800l_bearer_switch(sim800l_handle, true) != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L enable bearer failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L enable bearer success");
+
+    sim800l_ftp_config_t ftp_config = {
+        .server = FTP_SERVER,
+        .username = FTP_USER,
+        .password = FTP_PASSWORD};
+
+    if (sim800l_ftp_config(sim800l_handle, &ftp_config) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L FTP config failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L FTP config success");
+
+    /* First download is cut at 16 KiB, the second one resumes with AT+FTPREST */
+    download_limit = 16 * 1024;
+    sim800l_ftp_get(sim800l_handle, FTP_PATH, FTP_FILE, 0, ftp_sink, NULL, 600000);
+    ftp_report("get (interrupted)");
+
+    download_limit = 0;
+    if (sim800l_ftp_get(sim800l_handle, FTP_PATH, FTP_FILE, download_bytes, ftp_sink, NULL, 600000) == SIM800L_RET_OK)
+    {
+        ftp_report("get (resumed)");
+    }
+
+    if (sim800l_ftp_put(sim800l_handle, FTP_PATH, FTP_UPLOAD_FILE, false, ftp_source, NULL, 600000) == SIM800L_RET_OK)
+    {
+        ftp_report("put");
+    }
+
+    sim800l_bearer_switch(sim800l_handle, false);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_bearer.h"
+#include "sim800l_location.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L GSM LOCATION EXAMPLE"
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_TIME:
+    {
+        sim800l_time_event_t *event = (sim800l_time_event_t *)data->ptr;
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L EVENT TIME: %lld, timezone %ld, DST %lu", event->epoch, event->timezone, event->dst);
+
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Network time reports */
+    if (sim800l_location_time_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGW(TAG_SIM800L_EXAMPLE, "SIM800L network time not enabled");
+    }
+
+    /* AT+CIPGSMLOC needs the bearer up */
+    sim800l_bearer_param_t bearer_param = {
+        .contype = "GPRS",
+        .apn = "timbrasil.br",
+        .user = "tim",
+        .pwd = "tim"};
+    if ((sim800l_bearer_profile_config(sim800l_handle, 1, &bearer_param) != SIM800L_RET_OK) ||
+        (sim800l_bearer_profile_switch(sim800l_handle, 1, true) != SIM800L_RET_OK))
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bearer open failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L bearer open");
+
+    /* Asked every 10 s, only the first call and one every 5 minutes go to the network */
+    while (true)
+    {
+        sim800l_location_t location = {0};
+        if (sim800l_location_get(sim800l_handle, 1, 300000, &location) == SIM800L_RET_OK)
+        {
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "Location %.6f, %.6f, fix age %lu ms", location.latitude, location.longitude, location.age_ms);
+        }
+
+        sim800l_time_t now = {0};
+        if (sim800l_location_time_get(sim800l_handle, 1, 0, &now) == SIM800L_RET_OK)
+        {
+            struct tm utc = {0};
+            time_t epoch = (time_t)now.epoch;
+            gmtime_r(&epoch, &utc);
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "UTC %04d-%02d-%02d %02d:%02d:%02d, source %d, age %lu ms",
+                     utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, now.source, now.age_ms);
+        }
+
+        sim800l_location_stats_t stats = {0};
+        sim800l_location_get_stats(&stats);
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "Location hits %lu, queries %lu, avg query %llu ms",
+                 stats.location_hits, stats.location_queries,
+                 (stats.location_queries > 0) ? stats.location_query_us / stats.location_queries / 1000 : 0);
+
+        vTaskDelay(10000 / portTICK_PERIOD_MS);
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
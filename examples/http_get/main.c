@@ -51,42 +51,14 @@ static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t even
     }
 }
 
-void app_main(void)
+/* Full GET: bearer, HTTP, action, read, teardown */
+static esp_err_t http_get_flow(void)
 {
-    esp_err_t ret = ESP_OK;
-
-    /* Init SIM800L */
-    ret = sim800l_init(&sim800l_handle, &sim800l_config);
-    if (ret != ESP_OK)
-    {
-        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
-        ESP_ERROR_CHECK(ret);
-    }
-    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
-
-    /* Start SIM800L task */
-    ret = sim800l_start(sim800l_handle);
-    if (ret != ESP_OK)
-    {
-        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
-        ESP_ERROR_CHECK(ret);
-    }
-    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
-
-    /* Register SIM800L event */
-    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
-    if (ret != ESP_OK)
-    {
-        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
-        ESP_ERROR_CHECK(ret);
-    }
-    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
-
     /* Set Bearer contype */
     if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_CONTYPE, "GPRS") != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer contype failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer contype success");
 
@@ -94,7 +66,7 @@ void app_main(void)
     if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_APN, "timbrasil.br") != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer APN failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer APN success");
 
@@ -102,7 +74,7 @@ void app_main(void)
     if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_USER, "tim") != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer USER failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer USER success");
 
@@ -110,7 +82,7 @@ void app_main(void)
     if (sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_PWD, "tim") != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set bearer PASS failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set bearer PASS success");
 
@@ -118,7 +90,7 @@ void app_main(void)
     if (sim800l_bearer_switch(sim800l_handle, true) != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L enable bearer failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L enable bearer success");
 
@@ -126,7 +98,7 @@ void app_main(void)
     if (sim800l_http_switch(sim800l_handle, true) != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init HTTP failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init HTTP success");
 
@@ -134,7 +106,7 @@ void app_main(void)
     if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, "1") != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set CID failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set CID success");
 
@@ -142,39 +114,99 @@ void app_main(void)
     if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, "www.helloworld.org/data/helloworld.c") != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set URL failed");
-        return;
+        return ESP_FAIL;
     }
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L set URL success");
 
     /* HTTP action */
+    _flag = false;
     if (sim800l_http_action(sim800l_handle, SIM800L_HTTP_METHOD_GET) != ESP_OK)
     {
         ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L HTTP action failed");
-        return;
+        return ESP_FAIL;
+    }
+
+    /* Wait for +HTTPACTION */
+    for (uint32_t i = 0; (i < 60) && !_flag; i++)
+    {
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
     }
 
-    while (true)
+    if (_flag)
     {
-        if (_flag)
+        uint32_t data_len = action.content_length;
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L HTTP content-length: %lu", data_len);
+
+        char buffer[100] = {0};
+
+        /* Read */
+        if (sim800l_http_read(sim800l_handle, 0, (data_len < sizeof(buffer) - 1) ? data_len : sizeof(buffer) - 1, (uint8_t *)buffer) != ESP_OK)
         {
-            uint32_t data_len = action.content_length;
+            ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L HTTP read failed");
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L HTTP read success: %s", buffer);
+    }
 
-            ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L HTTP content-length: %lu", data_len);
+    /* Teardown, so the next run starts from the same state */
+    sim800l_http_switch(sim800l_handle, false);
+    sim800l_bearer_switch(sim800l_handle, false);
 
-            char buffer[100] = {0};
+    return _flag ? ESP_OK : ESP_FAIL;
+}
 
-            /* Read */
-            if (sim800l_http_read(sim800l_handle, 0, data_len, (uint8_t *)buffer) != ESP_OK)
-            {
-                ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L HTTP read failed");
-                return;
-            }
-            ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L HTTP read success: %s", buffer);
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
 
-            _flag = false;
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Same flow with echo, without echo, and with numeric result codes */
+    const sim800l_format_t formats[] = {SIM800L_FORMAT_ECHO, SIM800L_FORMAT_QUIET, SIM800L_FORMAT_NUMERIC};
+    const char *format_names[] = {"ATE1 V1", "ATE0 V1", "ATE0 V0"};
+
+    for (uint32_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+    {
+        if (sim800l_format_switch(sim800l_handle, formats[i]) != ESP_OK)
+        {
+            ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L format switch failed");
+            return;
         }
 
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        sim800l_reset_wire_stats(sim800l_handle);
+        esp_err_t flow = http_get_flow();
+
+        sim800l_wire_stats_t stats = {0};
+        sim800l_get_wire_stats(sim800l_handle, &stats);
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "%s: %s, TX %llu bytes, RX %llu bytes, %lu commands, avg round trip %llu ms",
+                 format_names[i], (flow == ESP_OK) ? "ok" : "failed", stats.tx_bytes, stats.rx_bytes, stats.commands,
+                 (stats.commands > 0) ? stats.command_us / stats.commands / 1000 : 0);
     }
 
     ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
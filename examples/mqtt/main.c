@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_tcpip.h"
+#include "sim800l_mqtt.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L MQTT EXAMPLE"
+
+/* Broker, a local mosquitto reachable from the cellular network */
+#define MQTT_BROKER_HOST "test.mosquitto.org"
+#define MQTT_BROKER_PORT 1883
+#define MQTT_LINK 0
+#define MQTT_TOPIC "sim800l/fleet/telemetry"
+#define MQTT_MESSAGES 200
+#define MQTT_BATCH 10
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void mqtt_message(const char *topic, size_t topic_len, const uint8_t *payload, size_t payload_len, void *arg)
+{
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "MQTT message %.*s: %.*s", (int)topic_len, topic, (int)payload_len, (const char *)payload);
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Enable TCP/IP with multiple links */
+    if (sim800l_tcpip_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP success");
+
+    /* Bring up GPRS */
+    char ip[16] = {0};
+    if (sim800l_tcpip_attach(sim800l_handle, "timbrasil.br", "tim", "tim", ip, sizeof(ip)) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach success: %s", ip);
+
+    sim800l_mqtt_config_t mqtt_config = {
+        .link = MQTT_LINK,
+        .host = MQTT_BROKER_HOST,
+        .port = MQTT_BROKER_PORT,
+        .client_id = "sim800l-example",
+        .keepalive = 60,
+        .clean_session = true};
+
+    sim800l_mqtt_set_message_callback(mqtt_message, NULL);
+
+    if (sim800l_mqtt_connect(sim800l_handle, &mqtt_config, 30000) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L MQTT connect failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L MQTT connect success");
+
+    if (sim800l_mqtt_subscribe(sim800l_handle, "sim800l/fleet/cmd", SIM800L_MQTT_QOS_1, 10000) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L MQTT subscribe failed");
+    }
+
+    /* Same run for QoS 0 and QoS 1, MQTT_BATCH messages per flush */
+    for (int qos = SIM800L_MQTT_QOS_0; qos <= SIM800L_MQTT_QOS_1; qos++)
+    {
+        sim800l_mqtt_stats_t before = {0};
+        sim800l_mqtt_get_stats(&before);
+        int64_t start = esp_timer_get_time();
+
+        for (uint32_t i = 0; i < MQTT_MESSAGES; i++)
+        {
+            char payload[48] = {0};
+            int length = snprintf(payload, sizeof(payload), "{\"seq\":%lu,\"qos\":%d}", i, qos);
+
+            if (sim800l_mqtt_publish(sim800l_handle, MQTT_TOPIC, (const uint8_t *)payload, length, qos, false) != SIM800L_RET_OK)
+            {
+                ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L MQTT publish failed");
+                break;
+            }
+
+            /* Queued messages share the CIPSEND */
+            if ((i + 1) % MQTT_BATCH == 0)
+            {
+                sim800l_mqtt_loop(sim800l_handle, 0);
+            }
+        }
+
+        sim800l_mqtt_loop(sim800l_handle, 0);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        sim800l_mqtt_stats_t after = {0};
+        sim800l_mqtt_get_stats(&after);
+
+        uint32_t published = after.published - before.published;
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "QoS %d: %lu messages in %lld ms, %lld msg/s, %lu bytes on wire per message, %lu batches", qos, published,
+                 elapsed / 1000, (int64_t)published * 1000000 / elapsed, (after.tx_bytes - before.tx_bytes) / published, after.batches - before.batches);
+    }
+
+    /* PUBACKs and commands from the broker */
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        if (sim800l_mqtt_loop(sim800l_handle, 100) != SIM800L_RET_OK)
+        {
+            break;
+        }
+    }
+
+    sim800l_mqtt_stats_t stats = {0};
+    sim800l_mqtt_get_stats(&stats);
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "published %lu, acked %lu, received %lu, retransmits %lu", stats.published, stats.acked, stats.received, stats.retransmits);
+
+    sim800l_mqtt_disconnect(sim800l_handle);
+    sim800l_tcpip_detach(sim800l_handle);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
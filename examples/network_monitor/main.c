@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_network.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L NETWORK MONITOR EXAMPLE"
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+/* One sample every 5 s, min and average over the last minute */
+sim800l_network_monitor_config_t monitor_config = {
+    .interval_ms = 5000,
+    .window = 12};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_NETWORK:
+    {
+        sim800l_network_event_t *event = (sim800l_network_event_t *)data->ptr;
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L EVENT NETWORK: %s stat %d, LAC %04lX, CI %04lX",
+                 event->gprs ? "GPRS" : "GSM", event->stat, event->lac, event->ci);
+
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Registration URCs and background CSQ sampling */
+    if (sim800l_network_monitor_start(sim800l_handle, &monitor_config) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L network monitor start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L network monitor started");
+
+    /* Queries read the cached state, nothing goes to the UART */
+    while (true)
+    {
+        sim800l_network_registration_t registration = {0};
+        sim800l_network_signal_t signal = {0};
+
+        sim800l_network_get_registration(&registration);
+        if (sim800l_network_get_signal(&signal) == SIM800L_RET_OK)
+        {
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "CREG %d, CGREG %d, RSSI %ld dBm, min %ld dBm, avg %ld dBm over %lu samples",
+                     registration.creg, registration.cgreg,
+                     sim800l_network_rssi_to_dbm(signal.current.rssi),
+                     sim800l_network_rssi_to_dbm(signal.min_rssi),
+                     sim800l_network_rssi_to_dbm(signal.avg_rssi), signal.samples);
+        }
+
+        vTaskDelay(10000 / portTICK_PERIOD_MS);
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_bearer.h"
+#include "sim800l_http.h"
+#include "sim800l_scheduler.h"
+#include "sim800l_ntp.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L NTP SYNC EXAMPLE"
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+/* Sessions are opened for the uploads only */
+sim800l_scheduler_config_t scheduler_config = {
+    .cid = 1,
+    .min_rssi = 10,
+    .check_interval_ms = 5000,
+    .max_retries = 2,
+    .lead_ms = 30000};
+
+/* UTC, at most one sync an hour */
+sim800l_ntp_config_t ntp_config = {
+    .cid = 1,
+    .server = "pool.ntp.org",
+    .timezone = 0,
+    .min_interval_ms = 3600000};
+
+/* Upload job, stamped with the system clock */
+static sim800l_ret_t telemetry_upload(sim800l_handle_t sim800l_handle, void *arg)
+{
+    char body[64] = {0};
+    struct timeval now = {0};
+    sim800l_http_action_t action = {0};
+
+    gettimeofday(&now, NULL);
+    snprintf(body, sizeof(body), "{\"time\":%lld,\"temperature\":21.5}", (long long)now.tv_sec);
+
+    sim800l_ret_t ret = sim800l_http_post_compressed(sim800l_handle, "www.example.com/telemetry", "application/json",
+                                                     (const uint8_t *)body, strlen(body), false, &action, NULL);
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    return (action.http_code == 200) ? SIM800L_RET_OK : SIM800L_RET_ERROR;
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Bearer profile, opened and closed by the scheduler */
+    sim800l_bearer_param_t bearer_param = {
+        .contype = "GPRS",
+        .apn = "timbrasil.br",
+        .user = "tim",
+        .pwd = "tim"};
+    if (sim800l_bearer_profile_config(sim800l_handle, scheduler_config.cid, &bearer_param) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bearer config failed");
+        return;
+    }
+
+    if (sim800l_http_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init HTTP failed");
+        return;
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, "1") != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set CID failed");
+        return;
+    }
+
+    if (sim800l_scheduler_start(sim800l_handle, &scheduler_config) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L scheduler start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L scheduler started");
+
+    sim800l_scheduler_job_t upload_job = {
+        .run = telemetry_upload,
+        .arg = NULL,
+        .priority = 1,
+        .deadline_ms = 600000};
+
+    /* Lowest priority and no deadline: never opens a session, rides after the uploads */
+    sim800l_scheduler_job_t ntp_job = {
+        .run = sim800l_ntp_job,
+        .arg = &ntp_config,
+        .priority = 0,
+        .deadline_ms = 0};
+
+    /* One reading a minute, one time check an hour */
+    for (uint32_t minute = 0;; minute++)
+    {
+        if (sim800l_scheduler_submit(&upload_job) != SIM800L_RET_OK)
+        {
+            ESP_LOGW(TAG_SIM800L_EXAMPLE, "SIM800L scheduler queue full");
+        }
+
+        if (((minute % 60) == 0) && (sim800l_scheduler_submit(&ntp_job) != SIM800L_RET_OK))
+        {
+            ESP_LOGW(TAG_SIM800L_EXAMPLE, "SIM800L scheduler queue full");
+        }
+
+        sim800l_ntp_stats_t stats = {0};
+        sim800l_ntp_get_stats(&stats);
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "NTP syncs %lu, skipped %lu, failures %lu, steps %lu, slews %lu, last offset %lld ms",
+                 stats.syncs, stats.skipped, stats.failures, stats.steps, stats.slews, stats.last_offset_ms);
+
+        vTaskDelay(60000 / portTICK_PERIOD_MS);
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
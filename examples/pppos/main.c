@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <esp_netif.h>
+#include <esp_http_client.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_bearer.h"
+#include "sim800l_http.h"
+#include "sim800l_ppp.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L PPPOS EXAMPLE"
+
+/* Same file over both paths */
+#define BENCH_URL "http://www.helloworld.org/data/helloworld.c"
+#define BENCH_APN "timbrasil.br"
+
+volatile bool got_ip = false;
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_PPP:
+    {
+        sim800l_ppp_event_t *event = (sim800l_ppp_event_t *)data->ptr;
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L EVENT PPP: state %d", event->state);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void ip_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    switch (event_id)
+    {
+    case IP_EVENT_PPP_GOT_IP:
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "PPP got IP");
+        got_ip = true;
+        break;
+    case IP_EVENT_PPP_LOST_IP:
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "PPP lost IP");
+        got_ip = false;
+        break;
+    default:
+        break;
+    }
+}
+
+static sim800l_ret_t http_body_counter(const uint8_t *data, size_t data_len, void *arg)
+{
+    *(uint32_t *)arg += data_len;
+
+    return SIM800L_RET_OK;
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* lwIP and default event loop for IP_EVENT */
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, ESP_EVENT_ANY_ID, ip_event_handler, NULL));
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* GET over lwIP */
+    if (sim800l_ppp_start(sim800l_handle, BENCH_APN, NULL) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L PPP start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L PPP start success");
+
+    for (uint32_t i = 0; (i < 30) && !got_ip; i++)
+    {
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    }
+
+    uint32_t ppp_bytes = 0;
+    int64_t start = esp_timer_get_time();
+
+    esp_http_client_config_t http_config = {.url = BENCH_URL, .timeout_ms = 30000};
+    esp_http_client_handle_t client = esp_http_client_init(&http_config);
+    if ((client != NULL) && (esp_http_client_open(client, 0) == ESP_OK))
+    {
+        esp_http_client_fetch_headers(client);
+
+        char buffer[512];
+        int read_len = 0;
+        while ((read_len = esp_http_client_read(client, buffer, sizeof(buffer))) > 0)
+        {
+            ppp_bytes += read_len;
+        }
+
+        esp_http_client_close(client);
+    }
+    esp_http_client_cleanup(client);
+
+    int64_t ppp_us = esp_timer_get_time() - start;
+
+    sim800l_ppp_stats_t ppp_stats = {0};
+    sim800l_ppp_get_stats(&ppp_stats);
+
+    /* Back to AT commands */
+    sim800l_ppp_stop(sim800l_handle);
+
+    /* Same GET through AT+HTTPACTION */
+    sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_CONTYPE, "GPRS");
+    sim800l_bearer_set_param(sim800l_handle, SIM800L_BEARER_APN, BENCH_APN);
+    if ((sim800l_bearer_switch(sim800l_handle, true) != ESP_OK) || (sim800l_http_switch(sim800l_handle, true) != ESP_OK))
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L HTTP setup failed");
+        return;
+    }
+    sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, "1");
+
+    uint32_t at_bytes = 0;
+    sim800l_http_transfer_stats_t at_stats = {0};
+    sim800l_http_get_compressed(sim800l_handle, BENCH_URL, false, http_body_counter, &at_bytes, NULL, &at_stats);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "PPP: %lu B in %llu ms (%lu B on the UART)", ppp_bytes, ppp_us / 1000, ppp_stats.rx_bytes);
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "AT:  %lu B in %llu ms", at_bytes, at_stats.elapsed_us / 1000);
+
+    sim800l_http_switch(sim800l_handle, false);
+    sim800l_bearer_switch(sim800l_handle, false);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
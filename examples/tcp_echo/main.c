@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_tcpip.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L TCP ECHO EXAMPLE"
+
+/* Echo server */
+#define ECHO_SERVER_HOST "tcpbin.com"
+#define ECHO_SERVER_PORT 4242
+#define ECHO_LINK 0
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_TCPIP:
+    {
+        sim800l_tcpip_event_t *event = (sim800l_tcpip_event_t *)data->ptr;
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L EVENT TCPIP: link %lu, state %d%s", event->link, event->state,
+                 event->send_done ? (event->send_failed ? ", send failed" : ", send ok") : "");
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Enable TCP/IP with multiple links */
+    if (sim800l_tcpip_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP success");
+
+    /* Bring up GPRS */
+    char ip[16] = {0};
+    if (sim800l_tcpip_attach(sim800l_handle, "timbrasil.br", "tim", "tim", ip, sizeof(ip)) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach success: %s", ip);
+
+    /* Connect to the echo server */
+    if (sim800l_tcpip_open(sim800l_handle, ECHO_LINK, SIM800L_TCPIP_PROTOCOL_TCP, ECHO_SERVER_HOST, ECHO_SERVER_PORT, 0) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L TCP open failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L TCP open success");
+
+    uint32_t counter = 0;
+
+    while (sim800l_tcpip_get_state(ECHO_LINK) == SIM800L_TCPIP_STATE_CONNECTED)
+    {
+        char message[32] = {0};
+        snprintf(message, sizeof(message), "ping %lu\n", counter++);
+
+        /* Send without waiting for SEND OK */
+        size_t sent = 0;
+        if (sim800l_tcpip_send(sim800l_handle, ECHO_LINK, (const uint8_t *)message, strlen(message), &sent, 0) != SIM800L_RET_OK)
+        {
+            ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L TCP send failed");
+        }
+
+        /* Echo arrives through +RECEIVE */
+        char buffer[64] = {0};
+        size_t received = 0;
+        if ((sim800l_tcpip_recv(sim800l_handle, ECHO_LINK, (uint8_t *)buffer, sizeof(buffer) - 1, &received, 5000) == SIM800L_RET_OK) && (received > 0))
+        {
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L TCP echo: %s", buffer);
+        }
+
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+    }
+
+    sim800l_tcpip_stats_t stats = {0};
+    sim800l_tcpip_get_stats(ECHO_LINK, &stats);
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "tx %lu, rx %lu, dropped %lu", stats.tx_bytes, stats.rx_bytes, stats.rx_dropped);
+
+    sim800l_tcpip_close(sim800l_handle, ECHO_LINK, 0);
+    sim800l_tcpip_detach(sim800l_handle);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
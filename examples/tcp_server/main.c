@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_tcpip.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L TCP SERVER EXAMPLE"
+
+/* Maintenance port */
+#define SERVER_PORT 2323
+
+/* Per inbound link */
+static int64_t link_accepted[SIM800L_TCPIP_MAX_LINKS] = {0};
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_TCPIP_SERVER:
+    {
+        sim800l_tcpip_server_event_t *event = (sim800l_tcpip_server_event_t *)data->ptr;
+
+        if ((event->state == SIM800L_TCPIP_SERVER_ACCEPT) && (event->link < SIM800L_TCPIP_MAX_LINKS))
+        {
+            /* URC parse to handler, the part of the accept latency this side controls */
+            link_accepted[event->link] = esp_timer_get_time();
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "Link %lu accepted from %s, %lld us after the URC", event->link, event->remote_ip,
+                     link_accepted[event->link] - event->timestamp);
+        }
+        else
+        {
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L server %s", (event->state == SIM800L_TCPIP_SERVER_LISTENING) ? "listening" : "closed");
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Enable TCP/IP with multiple links */
+    if (sim800l_tcpip_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP success");
+
+    /* Bring up GPRS */
+    char ip[16] = {0};
+    if (sim800l_tcpip_attach(sim800l_handle, "timbrasil.br", "tim", "tim", ip, sizeof(ip)) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach success: %s", ip);
+
+    if (sim800l_tcpip_server_start(sim800l_handle, SERVER_PORT) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L server start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L server on %s:%u", ip, SERVER_PORT);
+
+    /* Echo on every inbound link, connections are served side by side */
+    while (sim800l_tcpip_server_is_listening())
+    {
+        for (uint32_t link = 0; link < SIM800L_TCPIP_MAX_LINKS; link++)
+        {
+            if (link_accepted[link] == 0)
+            {
+                continue;
+            }
+
+            if (sim800l_tcpip_get_state(link) != SIM800L_TCPIP_STATE_CONNECTED)
+            {
+                sim800l_tcpip_stats_t stats = {0};
+                sim800l_tcpip_get_stats(link, &stats);
+
+                int64_t elapsed = esp_timer_get_time() - link_accepted[link];
+                ESP_LOGI(TAG_SIM800L_EXAMPLE, "Link %lu closed: rx %lu, tx %lu, %lld B/s", link, stats.rx_bytes, stats.tx_bytes,
+                         (int64_t)(stats.rx_bytes + stats.tx_bytes) * 1000000 / elapsed);
+                link_accepted[link] = 0;
+                continue;
+            }
+
+            uint8_t buffer[256] = {0};
+            size_t received = 0;
+            if ((sim800l_tcpip_recv(sim800l_handle, link, buffer, sizeof(buffer), &received, 0) == SIM800L_RET_OK) && (received > 0))
+            {
+                size_t sent = 0;
+                sim800l_tcpip_send(sim800l_handle, link, buffer, received, &sent, 5000);
+            }
+        }
+
+        vTaskDelay(50 / portTICK_PERIOD_MS);
+    }
+
+    sim800l_tcpip_server_stop(sim800l_handle);
+    sim800l_tcpip_detach(sim800l_handle);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_tcpip.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L TCP TRANSPARENT EXAMPLE"
+
+/* Echo server */
+#define ECHO_SERVER_HOST "tcpbin.com"
+#define ECHO_SERVER_PORT 4242
+
+/* Benchmark */
+#define BENCH_CHUNK_SIZE 512
+#define BENCH_TOTAL_SIZE (64 * 1024)
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_TCPIP:
+    {
+        sim800l_tcpip_event_t *event = (sim800l_tcpip_event_t *)data->ptr;
+
+        ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L EVENT TCPIP: link %lu, state %d%s", event->link, event->state,
+                 event->send_done ? (event->send_failed ? ", send failed" : ", send ok") : "");
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Enable TCP/IP in transparent mode, full-size packets, 100 ms flush */
+    sim800l_tcpip_transparent_config_t config = {.send_size = 1460, .wait_time = 1};
+    if (sim800l_tcpip_transparent_switch(sim800l_handle, true, &config) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L enable transparent mode failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L enable transparent mode success");
+
+    /* Bring up GPRS */
+    char ip[16] = {0};
+    if (sim800l_tcpip_attach(sim800l_handle, "timbrasil.br", "tim", "tim", ip, sizeof(ip)) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach success: %s", ip);
+
+    /* Connect to the echo server */
+    if (sim800l_tcpip_transparent_open(sim800l_handle, SIM800L_TCPIP_PROTOCOL_TCP, ECHO_SERVER_HOST, ECHO_SERVER_PORT, 0) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L transparent open failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L transparent open success");
+
+    static uint8_t chunk[BENCH_CHUNK_SIZE];
+    static uint8_t buffer[BENCH_CHUNK_SIZE];
+    for (uint32_t i = 0; i < sizeof(chunk); i++)
+    {
+        chunk[i] = (uint8_t)i;
+    }
+
+    /* Push the payload and drain the echo as it comes back */
+    size_t echoed = 0;
+    for (size_t written = 0; written < BENCH_TOTAL_SIZE; written += sizeof(chunk))
+    {
+        if (sim800l_tcpip_transparent_write(sim800l_handle, chunk, sizeof(chunk)) != SIM800L_RET_OK)
+        {
+            ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L transparent write failed");
+            break;
+        }
+
+        size_t received = 0;
+        while ((sim800l_tcpip_transparent_read(sim800l_handle, buffer, sizeof(buffer), &received, 0) == SIM800L_RET_OK) && (received > 0))
+        {
+            echoed += received;
+        }
+    }
+
+    /* Tail of the echo */
+    size_t received = 0;
+    while ((echoed < BENCH_TOTAL_SIZE) && (sim800l_tcpip_transparent_read(sim800l_handle, buffer, sizeof(buffer), &received, 5000) == SIM800L_RET_OK) && (received > 0))
+    {
+        echoed += received;
+    }
+
+    /* Goodput against the UART line rate (8N1, 10 bits per byte) */
+    sim800l_tcpip_transparent_stats_t stats = {0};
+    sim800l_tcpip_transparent_get_stats(sim800l_handle, &stats);
+
+    uint32_t line_rate = sim800l_config.sim800l_uart_baudrate / 10;
+    uint32_t tx_goodput = (stats.tx_us > 0) ? (uint32_t)((uint64_t)stats.tx_bytes * 1000000 / stats.tx_us) : 0;
+    uint32_t rx_goodput = (stats.connected_us > 0) ? (uint32_t)((uint64_t)stats.rx_bytes * 1000000 / stats.connected_us) : 0;
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "tx %lu B at %lu B/s, rx %lu B at %lu B/s, dropped %lu, line rate %lu B/s",
+             stats.tx_bytes, tx_goodput, stats.rx_bytes, rx_goodput, stats.rx_dropped, line_rate);
+
+    /* "+++" back to command mode, then close */
+    sim800l_tcpip_transparent_close(sim800l_handle);
+    sim800l_tcpip_detach(sim800l_handle);
+    sim800l_tcpip_transparent_switch(sim800l_handle, false, NULL);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
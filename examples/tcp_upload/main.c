@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include "sim800l_core.h"
+#include "sim800l_misc.h"
+#include "sim800l_tcpip.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L TCP UPLOAD EXAMPLE"
+
+/* Upload server */
+#define UPLOAD_SERVER_HOST "tcpbin.com"
+#define UPLOAD_SERVER_PORT 4242
+#define UPLOAD_LINK 0
+#define UPLOAD_SIZE (16 * 1024)
+
+/* Bytes in flight allowed by sim800l_tcpip_send_all, 0 waits for the peer on every chunk */
+static const uint32_t upload_windows[] = {0, 1460, 2920, 5840};
+
+static uint8_t upload_data[UPLOAD_SIZE];
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+static void sim800l_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_event_data_t *data = (sim800l_event_data_t *)event_data;
+
+    switch (event_id)
+    {
+    case SIM800L_EVENT_TCPIP:
+    {
+        sim800l_tcpip_event_t *event = (sim800l_tcpip_event_t *)data->ptr;
+
+        ESP_LOGD(TAG_SIM800L_EXAMPLE, "SIM800L EVENT TCPIP: link %lu, state %d%s", event->link, event->state,
+                 event->send_done ? (event->send_failed ? ", send failed" : ", send ok") : "");
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Register SIM800L event */
+    ret = sim800l_register_event(sim800l_handle, SIM800L_EVENT_ANY_ID, sim800l_event_handler, NULL);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L register event failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L register event success");
+
+    /* Enable TCP/IP with multiple links */
+    if (sim800l_tcpip_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L enable TCP/IP success");
+
+    /* Bring up GPRS */
+    char ip[16] = {0};
+    if (sim800l_tcpip_attach(sim800l_handle, "timbrasil.br", "tim", "tim", ip, sizeof(ip)) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L GPRS attach success: %s", ip);
+
+    for (size_t i = 0; i < sizeof(upload_data); i++)
+    {
+        upload_data[i] = 'a' + (i % 26);
+    }
+
+    for (size_t i = 0; i < sizeof(upload_windows) / sizeof(upload_windows[0]); i++)
+    {
+        uint32_t window = upload_windows[i];
+
+        /* Window 0 is the plain SEND OK path */
+        if (sim800l_tcpip_set_quick_send(sim800l_handle, window > 0) != SIM800L_RET_OK)
+        {
+            ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L quick send failed");
+            break;
+        }
+
+        if (sim800l_tcpip_open(sim800l_handle, UPLOAD_LINK, SIM800L_TCPIP_PROTOCOL_TCP, UPLOAD_SERVER_HOST, UPLOAD_SERVER_PORT, 0) != SIM800L_RET_OK)
+        {
+            ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L TCP open failed");
+            break;
+        }
+
+        int64_t start = esp_timer_get_time();
+        sim800l_ret_t ret = sim800l_tcpip_send_all(sim800l_handle, UPLOAD_LINK, upload_data, sizeof(upload_data), window, 120000);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        sim800l_tcpip_stats_t stats = {0};
+        sim800l_tcpip_get_stats(UPLOAD_LINK, &stats);
+
+        if (ret == SIM800L_RET_OK)
+        {
+            ESP_LOGI(TAG_SIM800L_EXAMPLE, "window %5lu: %u bytes in %lld ms, %lld B/s, %lu retransmits", window, sizeof(upload_data),
+                     elapsed / 1000, (int64_t)sizeof(upload_data) * 1000000 / elapsed, stats.retransmits);
+        }
+        else
+        {
+            ESP_LOGE(TAG_SIM800L_EXAMPLE, "window %5lu: upload failed", window);
+        }
+
+        sim800l_tcpip_close(sim800l_handle, UPLOAD_LINK, 0);
+    }
+
+    sim800l_tcpip_set_quick_send(sim800l_handle, false);
+    sim800l_tcpip_detach(sim800l_handle);
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <string.h>
+#include <driver/gpio.h>
+#include "sim800l_core.h"
+#include "sim800l_bearer.h"
+#include "sim800l_http.h"
+#include "sim800l_network.h"
+#include "sim800l_scheduler.h"
+
+/* Tag */
+#define TAG_SIM800L_EXAMPLE "SIM800L UPLOAD SCHEDULER EXAMPLE"
+
+/* SIM800L handle */
+sim800l_handle_t sim800l_handle;
+
+/* SIM800L config struct */
+sim800l_config_t sim800l_config = {
+    .sim800l_uart_port = UART_NUM_1,
+    .sim800l_uart_baudrate = 9600,
+    .sim800l_uart_rx_pin = GPIO_NUM_27,
+    .sim800l_uart_tx_pin = GPIO_NUM_26,
+    .sim800l_rst_pin = GPIO_NUM_25,
+    .sim800l_pwr_pin = GPIO_NUM_NC,
+    .sim800l_dtr_pin = GPIO_NUM_32,
+    .sim800l_ring_pin = GPIO_NUM_33};
+
+/* Wait for -91 dBm or better, give up waiting 30 s before a deadline */
+sim800l_scheduler_config_t scheduler_config = {
+    .cid = 1,
+    .min_rssi = 11,
+    .check_interval_ms = 5000,
+    .max_retries = 2,
+    .lead_ms = 30000};
+
+/* Recorded drive: 10 s samples, a dead zone, a good stretch, a weak stretch */
+static const sim800l_scheduler_trace_t trace[] = {
+    {0, 6, true}, {10000, 5, true}, {20000, 4, true}, {30000, 0, false}, {40000, 0, false},
+    {50000, 7, true}, {60000, 9, true}, {70000, 18, true}, {80000, 21, true}, {90000, 20, true},
+    {100000, 15, true}, {110000, 8, true}, {120000, 6, true}, {130000, 5, true}, {140000, 7, true},
+    {150000, 12, true}, {160000, 17, true}, {170000, 19, true}, {180000, 19, true}, {190000, 18, true}};
+
+/* Telemetry every 15 s, deadline 3 min, one alarm that must go out within a minute */
+static const sim800l_scheduler_replay_job_t replay_jobs[] = {
+    {0, 1, 180000}, {15000, 1, 180000}, {30000, 1, 180000}, {45000, 1, 180000},
+    {60000, 1, 180000}, {75000, 1, 180000}, {100000, 5, 60000}, {105000, 1, 180000},
+    {120000, 1, 180000}, {135000, 1, 180000}};
+
+/* Upload job */
+static sim800l_ret_t telemetry_upload(sim800l_handle_t sim800l_handle, void *arg)
+{
+    const char *body = (const char *)arg;
+    sim800l_http_action_t action = {0};
+
+    sim800l_ret_t ret = sim800l_http_post_compressed(sim800l_handle, "www.example.com/telemetry", "application/json",
+                                                     (const uint8_t *)body, strlen(body), false, &action, NULL);
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    return (action.http_code == 200) ? SIM800L_RET_OK : SIM800L_RET_ERROR;
+}
+
+static void scheduler_print_stats(const char *name, const sim800l_scheduler_stats_t *stats)
+{
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "%s: completed %lu/%lu, dropped %lu, pending %lu, retries %lu, sessions %lu (forced %lu), bearer up %llu s",
+             name, stats->completed, stats->submitted, stats->dropped, stats->pending, stats->retries,
+             stats->sessions, stats->forced, stats->bearer_up_us / 1000000);
+}
+
+void app_main(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    /* Energy proxies for the policy against sending right away, no modem needed */
+    sim800l_scheduler_stats_t scheduled = {0};
+    sim800l_scheduler_stats_t immediate = {0};
+    if (sim800l_scheduler_replay(&scheduler_config, NULL, trace, sizeof(trace) / sizeof(trace[0]),
+                                 replay_jobs, sizeof(replay_jobs) / sizeof(replay_jobs[0]), &scheduled, &immediate) == SIM800L_RET_OK)
+    {
+        scheduler_print_stats("Replay scheduled", &scheduled);
+        scheduler_print_stats("Replay immediate", &immediate);
+    }
+
+    /* Init SIM800L */
+    ret = sim800l_init(&sim800l_handle, &sim800l_config);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L init success");
+
+    /* Start SIM800L task */
+    ret = sim800l_start(sim800l_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L start failed: %s", esp_err_to_name(ret));
+        ESP_ERROR_CHECK(ret);
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L start success");
+
+    /* Bearer profile, opened and closed by the scheduler */
+    sim800l_bearer_param_t bearer_param = {
+        .contype = "GPRS",
+        .apn = "timbrasil.br",
+        .user = "tim",
+        .pwd = "tim"};
+    if (sim800l_bearer_profile_config(sim800l_handle, scheduler_config.cid, &bearer_param) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L bearer config failed");
+        return;
+    }
+
+    if (sim800l_http_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L init HTTP failed");
+        return;
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, "1") != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L set CID failed");
+        return;
+    }
+
+    /* Starts the network monitor too */
+    if (sim800l_scheduler_start(sim800l_handle, &scheduler_config) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(TAG_SIM800L_EXAMPLE, "SIM800L scheduler start failed");
+        return;
+    }
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "SIM800L scheduler started");
+
+    /* One reading a minute, each may wait up to 10 minutes for a good link */
+    sim800l_scheduler_job_t job = {
+        .run = telemetry_upload,
+        .arg = "{\"temperature\":21.5}",
+        .priority = 1,
+        .deadline_ms = 600000};
+
+    while (true)
+    {
+        if (sim800l_scheduler_submit(&job) != SIM800L_RET_OK)
+        {
+            ESP_LOGW(TAG_SIM800L_EXAMPLE, "SIM800L scheduler queue full");
+        }
+
+        sim800l_scheduler_stats_t stats = {0};
+        sim800l_scheduler_get_stats(&stats);
+        scheduler_print_stats("Live", &stats);
+
+        vTaskDelay(60000 / portTICK_PERIOD_MS);
+    }
+
+    ESP_LOGI(TAG_SIM800L_EXAMPLE, "Finish example");
+}
\ No newline at end of file
@@ -29,6 +29,9 @@
 #define SIM800L_BEARER_PHONENUM "PHONENUM"
 #define SIM800L_BEARER_RATE "RATE"
 
+#define SIM800L_BEARER_CID_DEFAULT 1
+#define SIM800L_BEARER_MAX_PROFILES 3   /* AT+SAPBR CID 1 to 3 */
+
 typedef struct
 {
     uint32_t cid;
@@ -46,7 +49,55 @@ typedef struct
     uint32_t rate;
 } sim800l_bearer_param_t;
 
+/* 
+ *     Sim800L bearer manager, keeps one profile up from a background task
+ */
+typedef enum
+{
+    SIM800L_BEARER_STATE_DOWN = 0,
+    SIM800L_BEARER_STATE_CONNECTING,
+    SIM800L_BEARER_STATE_UP,
+    SIM800L_BEARER_STATE_BACKOFF
+} sim800l_bearer_state_t;
+
+typedef struct
+{
+    uint32_t cid;                       /* Profile kept up, 0 means 1 */
+    uint32_t poll_interval_ms;          /* AT+SAPBR=2,<cid> keep-alive check, 0 means 30000 */
+    uint32_t backoff_min_ms;            /* First retry delay, 0 means 1000 */
+    uint32_t backoff_max_ms;            /* Retry delay cap, 0 means 60000 */
+} sim800l_bearer_manager_config_t;
+
+/* 
+ *     Posted with SIM800L_EVENT_BEARER on every state change
+ */
+typedef struct
+{
+    sim800l_bearer_state_t state;
+    char ipv4[16];
+} sim800l_bearer_event_t;
+
+typedef struct
+{
+    uint32_t connects;
+    uint32_t drops;                     /* UP lost, seen by the poll or +CGREG */
+    uint32_t failures;                  /* AT+SAPBR=1,1 errors, each one backs off */
+    uint64_t first_up_us;               /* From sim800l_bearer_manager_start to the first UP */
+    uint64_t last_recovery_us;          /* From the last drop to UP again */
+} sim800l_bearer_stats_t;
+
 sim800l_ret_t sim800l_bearer_switch(sim800l_handle_t sim800l_handle, bool bearer_state);
 sim800l_ret_t sim800l_bearer_query(sim800l_handle_t sim800l_handle, sim800l_bearer_t *bearer);
 sim800l_ret_t sim800l_bearer_set_param(sim800l_handle_t sim800l_handle, const char* param, const char* value);
 sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_bearer_param_t *param);
+sim800l_ret_t sim800l_bearer_profile_switch(sim800l_handle_t sim800l_handle, uint32_t cid, bool bearer_state);
+sim800l_ret_t sim800l_bearer_profile_query(sim800l_handle_t sim800l_handle, uint32_t cid, sim800l_bearer_t *bearer);
+sim800l_ret_t sim800l_bearer_profile_set_param(sim800l_handle_t sim800l_handle, uint32_t cid, const char* param, const char* value);
+sim800l_ret_t sim800l_bearer_profile_get_param(sim800l_handle_t sim800l_handle, uint32_t cid, sim800l_bearer_param_t *param);
+sim800l_ret_t sim800l_bearer_profile_config(sim800l_handle_t sim800l_handle, uint32_t cid, const sim800l_bearer_param_t *param);
+void sim800l_bearer_profile_flush(void);
+sim800l_ret_t sim800l_bearer_manager_start(sim800l_handle_t sim800l_handle, const sim800l_bearer_manager_config_t *config);
+sim800l_ret_t sim800l_bearer_manager_stop(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_bearer_wait_ready(sim800l_handle_t sim800l_handle, uint32_t timeout);
+sim800l_bearer_state_t sim800l_bearer_get_state(void);
+sim800l_ret_t sim800l_bearer_get_stats(sim800l_bearer_stats_t *stats);
@@ -0,0 +1,86 @@
+/*
+ * @file sim800l_ceng.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L cell environment (AT+CENG) sampling functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L cell environment, AT+CENG=1,1 serving cell and up to 6 neighbours
+ */
+#define SIM800L_CENG_MAX_CELLS          7
+#define SIM800L_CENG_HISTORY_SIZE       2048    /* Bytes of delta encoded samples, oldest dropped first */
+#define SIM800L_CENG_FORMAT_VERSION     1
+
+typedef struct
+{
+    uint16_t mcc;
+    uint16_t mnc;
+    uint16_t lac;
+    uint16_t ci;
+    uint8_t rxlev;                      /* 0..63, dBm = rxlev - 110 */
+} sim800l_ceng_cell_t;
+
+typedef struct
+{
+    uint32_t timestamp;                 /* Seconds since boot */
+    uint32_t cells;                     /* cell[0] is the serving cell */
+    sim800l_ceng_cell_t cell[SIM800L_CENG_MAX_CELLS];
+} sim800l_ceng_sample_t;
+
+typedef struct
+{
+    uint32_t interval_ms;               /* AT+CENG? period, 0 means 60000 */
+} sim800l_ceng_config_t;
+
+/*
+ *     SIM800L cell environment stats, parse_us / samples is the CPU cost per sample
+ */
+typedef struct
+{
+    uint32_t samples;                   /* In the history */
+    uint32_t evicted;                   /* Dropped to make room */
+    uint32_t failed;                    /* AT+CENG? errors or unparsable answers */
+    uint32_t bytes;                     /* History size, the export adds a version byte and a base record */
+    uint64_t parse_us;                  /* Tokenize and encode, the AT round trip is not included */
+} sim800l_ceng_stats_t;
+
+/*
+ *     Decoder output, called once per sample, oldest first
+ */
+typedef void (*sim800l_ceng_sample_cb_t)(const sim800l_ceng_sample_t *sample, void *arg);
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_ceng_start(sim800l_handle_t sim800l_handle, const sim800l_ceng_config_t *config);
+sim800l_ret_t sim800l_ceng_stop(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_ceng_sample(sim800l_handle_t sim800l_handle, sim800l_ceng_sample_t *sample);
+sim800l_ret_t sim800l_ceng_parse(char *response, sim800l_ceng_sample_t *sample);
+sim800l_ret_t sim800l_ceng_get_last(sim800l_ceng_sample_t *sample);
+sim800l_ret_t sim800l_ceng_export(uint8_t *buffer, size_t buffer_size, size_t *data_len);
+sim800l_ret_t sim800l_ceng_decode(const uint8_t *data, size_t data_len, sim800l_ceng_sample_cb_t callback, void *arg);
+void sim800l_ceng_clear(void);
+sim800l_ret_t sim800l_ceng_get_stats(sim800l_ceng_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
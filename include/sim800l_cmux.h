@@ -0,0 +1,60 @@
+/*
+ * @file sim800l_cmux.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L GSM 07.10 multiplexer functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L CMUX channels (DLCI 1-3, DLCI 0 is the control channel)
+ */
+#define SIM800L_CMUX_CHANNELS           3
+#define SIM800L_CMUX_AT_DLCI            1       /* Carries the AT engine once started */
+#define SIM800L_CMUX_DATA_DLCI          2
+
+/*
+ *     SIM800L CMUX stats
+ */
+typedef struct
+{
+    uint32_t tx_frames;
+    uint32_t tx_payload;
+    uint32_t tx_wire;                   /* Framing overhead is tx_wire - tx_payload */
+    uint32_t rx_frames;
+    uint32_t rx_payload;
+    uint32_t rx_wire;
+    uint32_t fcs_errors;
+    uint32_t rx_dropped;                /* Channel buffer full, or frame longer than N1 */
+} sim800l_cmux_stats_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_cmux_start(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_cmux_stop(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_cmux_write(uint32_t dlci, const uint8_t *data, size_t data_len, uint32_t timeout);
+sim800l_ret_t sim800l_cmux_read(uint32_t dlci, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout);
+sim800l_ret_t sim800l_cmux_get_io(uint32_t dlci, sim800l_io_t *io);
+sim800l_ret_t sim800l_cmux_get_stats(sim800l_cmux_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
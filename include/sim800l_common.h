@@ -24,6 +24,7 @@ typedef int sim800l_ret_t;
 #define SIM800L_RET_ERROR_BUILD_COMMAND 2
 #define SIM800L_RET_ERROR_SEND_COMMAND 3
 #define SIM800L_RET_INVALID_ARG 4
+#define SIM800L_RET_ERROR_CHECKSUM 5
 
 /*
  * SIM800L - Test command
@@ -207,4 +208,396 @@ typedef int sim800l_ret_t;
  * This command is used to read data from the HTTP server.
  *
  */
-#define SIM800L_COMMAND_HTTP_READ "AT+HTTPREAD"
\ No newline at end of file
+#define SIM800L_COMMAND_HTTP_READ "AT+HTTPREAD"
+
+/*
+ * SIM800L - HTTP SSL.
+ *
+ * This command is used to enable or disable HTTPS.
+ *
+ */
+#define SIM800L_COMMAND_HTTP_SSL "AT+HTTPSSL"
+
+/*
+ * SIM800L - HTTP head.
+ *
+ * This command is used to read the HTTP header of the server response.
+ *
+ */
+#define SIM800L_COMMAND_HTTP_HEAD "AT+HTTPHEAD\r\n"
+
+/*
+ * SIM800L - HTTP data.
+ *
+ * This command is used to upload the body of an HTTP POST.
+ *
+ */
+#define SIM800L_COMMAND_HTTP_DATA "AT+HTTPDATA"
+
+/*
+ * SIM800L - TCP/IP multiple connections.
+ *
+ * This command is used to enable up to 6 simultaneous IP connections.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_MUX "AT+CIPMUX=1\r\n"
+
+/*
+ * SIM800L - TCP/IP APN.
+ *
+ * This command is used to set the APN, user name and password of the GPRS context.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_APN "AT+CSTT"
+
+/*
+ * SIM800L - TCP/IP bring up.
+ *
+ * This command is used to bring up the wireless connection with GPRS.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_UP "AT+CIICR\r\n"
+
+/*
+ * SIM800L - TCP/IP local address.
+ *
+ * This command is used to get the local IP address.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_IP "AT+CIFSR\r\n"
+
+/*
+ * SIM800L - TCP/IP shut.
+ *
+ * This command is used to deactivate the GPRS context and close all connections.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_SHUT "AT+CIPSHUT\r\n"
+
+/*
+ * SIM800L - TCP/IP start.
+ *
+ * This command is used to start a TCP connection or register a UDP port.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_START "AT+CIPSTART"
+
+/*
+ * SIM800L - TCP/IP send.
+ *
+ * This command is used to send data through a TCP or UDP connection.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_SEND "AT+CIPSEND"
+
+/*
+ * SIM800L - TCP/IP close.
+ *
+ * This command is used to close a TCP or UDP connection.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_CLOSE "AT+CIPCLOSE"
+
+/*
+ * SIM800L - TCP/IP single connection.
+ *
+ * This command is used to select single IP connection, required by transparent mode.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_SINGLE "AT+CIPMUX=0\r\n"
+
+/*
+ * SIM800L - TCP/IP application mode.
+ *
+ * This command is used to select normal (0) or transparent (1) mode.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_MODE "AT+CIPMODE"
+
+/*
+ * SIM800L - TCP/IP transparent mode config.
+ *
+ * This command is used to set retries, wait time, send size and escape of transparent mode.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_TRANSPARENT_CONFIG "AT+CIPCCFG"
+
+/*
+ * SIM800L - Return to data mode.
+ *
+ * This command is used to resume the data mode after an escape sequence.
+ *
+ */
+#define SIM800L_COMMAND_DATA_MODE "ATO\r\n"
+
+/*
+ * SIM800L - Define PDP context.
+ *
+ * This command is used to set the APN of the PDP context used by dial-up.
+ *
+ */
+#define SIM800L_COMMAND_PPP_CONTEXT "AT+CGDCONT"
+
+/*
+ * SIM800L - Dial-up PPP.
+ *
+ * This command is used to start PPP on PDP context 1, answered with CONNECT.
+ *
+ */
+#define SIM800L_COMMAND_PPP_DIAL "ATD*99#\r\n"
+
+/*
+ * SIM800L - Multiplexer control.
+ *
+ * This command is used to start GSM 07.10 basic mode multiplexing with default parameters.
+ *
+ */
+#define SIM800L_COMMAND_CMUX "AT+CMUX=0\r\n"
+
+/*
+ * SIM800L - Get data from network manually.
+ *
+ * This command is used to switch to manual receive and to read the buffered data of a connection.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_RXGET "AT+CIPRXGET"
+
+/*
+ * SIM800L - Select data transmitting mode.
+ *
+ * This command is used to answer sends with DATA ACCEPT instead of waiting for SEND OK.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_QUICK_SEND "AT+CIPQSEND"
+
+/*
+ * SIM800L - Query previous connection data transmitting state.
+ *
+ * This command is used to read the sent, acknowledged and unacknowledged byte counts of a connection.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_ACK "AT+CIPACK"
+
+/*
+ * SIM800L - Configure module as server.
+ *
+ * This command is used to listen for inbound TCP connections on a local port.
+ *
+ */
+#define SIM800L_COMMAND_TCPIP_SERVER "AT+CIPSERVER"
+
+/*
+ * SIM800L - Query the IP address of given domain name.
+ *
+ * This command is used to resolve a host name, the result comes with the +CDNSGIP URC.
+ *
+ */
+#define SIM800L_COMMAND_DNS_QUERY "AT+CDNSGIP"
+
+/*
+ * SIM800L - Set FTP bearer profile identifier.
+ *
+ * This command is used to select the AT+SAPBR profile used for FTP.
+ *
+ */
+#define SIM800L_COMMAND_FTP_CID "AT+FTPCID"
+
+/*
+ * SIM800L - Set FTP server address.
+ *
+ * This command is used to set the FTP server domain name or IP address.
+ *
+ */
+#define SIM800L_COMMAND_FTP_SERVER "AT+FTPSERV"
+
+/*
+ * SIM800L - Set FTP control port.
+ *
+ * This command is used to set the FTP control port, 21 by default.
+ *
+ */
+#define SIM800L_COMMAND_FTP_PORT "AT+FTPPORT"
+
+/*
+ * SIM800L - Set FTP user name.
+ *
+ * This command is used to set the user name for the FTP session.
+ *
+ */
+#define SIM800L_COMMAND_FTP_USER "AT+FTPUN"
+
+/*
+ * SIM800L - Set FTP password.
+ *
+ * This command is used to set the password for the FTP session.
+ *
+ */
+#define SIM800L_COMMAND_FTP_PASSWORD "AT+FTPPW"
+
+/*
+ * SIM800L - Set the type of data to be transferred.
+ *
+ * This command is used to select ASCII (A) or binary (I) transfers.
+ *
+ */
+#define SIM800L_COMMAND_FTP_TYPE "AT+FTPTYPE"
+
+/*
+ * SIM800L - Set active or passive FTP mode.
+ *
+ * This command is used to select active (0) or passive (1) data connections.
+ *
+ */
+#define SIM800L_COMMAND_FTP_MODE "AT+FTPMODE"
+
+/*
+ * SIM800L - Set the get file path.
+ *
+ * This command is used to set the directory of the file to download.
+ *
+ */
+#define SIM800L_COMMAND_FTP_GET_PATH "AT+FTPGETPATH"
+
+/*
+ * SIM800L - Set the download file name.
+ *
+ * This command is used to set the name of the file to download.
+ *
+ */
+#define SIM800L_COMMAND_FTP_GET_NAME "AT+FTPGETNAME"
+
+/*
+ * SIM800L - Set the put file path.
+ *
+ * This command is used to set the directory of the file to upload.
+ *
+ */
+#define SIM800L_COMMAND_FTP_PUT_PATH "AT+FTPPUTPATH"
+
+/*
+ * SIM800L - Set the upload file name.
+ *
+ * This command is used to set the name of the file to upload.
+ *
+ */
+#define SIM800L_COMMAND_FTP_PUT_NAME "AT+FTPPUTNAME"
+
+/*
+ * SIM800L - Set FTP put type.
+ *
+ * This command is used to select STOR (overwrite) or APPE (append) uploads.
+ *
+ */
+#define SIM800L_COMMAND_FTP_PUT_OPT "AT+FTPPUTOPT"
+
+/*
+ * SIM800L - Set resume broken download.
+ *
+ * This command is used to start the next FTPGET at a byte offset.
+ *
+ */
+#define SIM800L_COMMAND_FTP_REST "AT+FTPREST"
+
+/*
+ * SIM800L - Download file.
+ *
+ * This command is used to open a download session and read its data.
+ *
+ */
+#define SIM800L_COMMAND_FTP_GET "AT+FTPGET"
+
+/*
+ * SIM800L - Set upload file.
+ *
+ * This command is used to open an upload session and write its data.
+ *
+ */
+#define SIM800L_COMMAND_FTP_PUT "AT+FTPPUT"
+
+/*
+ * SIM800L - Quit current FTP session.
+ *
+ * This command is used to end a download or upload that was not finished.
+ *
+ */
+#define SIM800L_COMMAND_FTP_QUIT "AT+FTPQUIT"
+
+/*
+ * SIM800L - GPRS network registration status.
+ *
+ * This command is used to enable the +CGREG unsolicited registration result.
+ *
+ */
+#define SIM800L_COMMAND_GPRS_REGISTRATION "AT+CGREG"
+
+/*
+ * SIM800L - Network registration.
+ *
+ * This command is used to enable the +CREG unsolicited registration result with location.
+ *
+ */
+#define SIM800L_COMMAND_NETWORK_REGISTRATION "AT+CREG"
+
+/*
+ * SIM800L - Signal quality report.
+ *
+ * This command returns the received signal strength indication and the channel bit error rate.
+ *
+ */
+#define SIM800L_COMMAND_SIGNAL_QUALITY "AT+CSQ"
+
+/*
+ * SIM800L - Switch on or off engineering mode.
+ *
+ * This command reports the serving and neighbour cell information.
+ *
+ */
+#define SIM800L_COMMAND_ENGINEERING_MODE "AT+CENG"
+
+/*
+ * SIM800L - GSM location and time.
+ *
+ * This command returns the longitude, latitude and UTC time of the serving cell, or the time only.
+ *
+ */
+#define SIM800L_COMMAND_GSM_LOCATION "AT+CIPGSMLOC"
+
+/*
+ * SIM800L - Get local timestamp.
+ *
+ * This command enables the *PSUTTZ network time report and the RTC update from the network.
+ *
+ */
+#define SIM800L_COMMAND_LOCAL_TIMESTAMP "AT+CLTS"
+
+/*
+ * SIM800L - Clock.
+ *
+ * This command reads the real time clock of the module.
+ *
+ */
+#define SIM800L_COMMAND_CLOCK "AT+CCLK"
+
+/*
+ * SIM800L - Set GPRS bearer profile's ID for NTP.
+ *
+ * This command selects the AT+SAPBR profile used by AT+CNTP.
+ *
+ */
+#define SIM800L_COMMAND_NTP_BEARER "AT+CNTPCID"
+
+/*
+ * SIM800L - Synchronize network time.
+ *
+ * This command sets the NTP server and timezone and starts the RTC synchronization, the result comes in +CNTP.
+ *
+ */
+#define SIM800L_COMMAND_NTP "AT+CNTP"
+
+/*
+ * SIM800L - Report mobile equipment error.
+ *
+ * This command selects ERROR or +CME ERROR: <n> / +CMS ERROR: <n> as the failure result code.
+ *
+ */
+#define SIM800L_COMMAND_ERROR_REPORT "AT+CMEE"
\ No newline at end of file
@@ -64,7 +64,15 @@ typedef enum
     SIM800L_EVENT_SMS_RECV          = BIT12,
     SIM800L_EVENT_SMS_SEND          = BIT13,
     SIM800L_EVENT_SMS_NEW_MASSAGE   = BIT14,
-    SIM800L_EVENT_HTTP_ACTION       = BIT15
+    SIM800L_EVENT_HTTP_ACTION       = BIT15,
+    SIM800L_EVENT_TCPIP             = BIT16,
+    SIM800L_EVENT_PPP               = BIT17,
+    SIM800L_EVENT_TCPIP_SERVER      = BIT18,
+    SIM800L_EVENT_DNS               = BIT19,
+    SIM800L_EVENT_FTP               = BIT20,
+    SIM800L_EVENT_BEARER            = BIT21,
+    SIM800L_EVENT_NETWORK           = BIT22,
+    SIM800L_EVENT_TIME              = BIT23     /* Last bit of the event group */
 }
 sim800l_event_t;
 
@@ -85,6 +93,106 @@ typedef struct
     uint32_t type;
 } sim800l_call_identify_t;
 
+/*
+ *     SIM800L counted data callback
+ *
+ *     Called by the bridge task for responses such as "+HTTPREAD: <len>" that
+ *     are followed by <len> raw bytes. The payload may be delivered in several
+ *     pieces, data_offset tells where the piece starts inside the payload.
+ */
+typedef void (*sim800l_data_callback_t)(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg);
+
+/*
+ *     SIM800L data mode
+ *
+ *     Used once the modem leaves command mode (CONNECT in transparent mode or
+ *     PPP). The bridge task stops parsing lines and queues the raw bytes.
+ */
+typedef enum
+{
+    SIM800L_DATA_MODE_OFF = 0,
+    SIM800L_DATA_MODE_ARMED,            /* Waiting for the enter line */
+    SIM800L_DATA_MODE_ON
+} sim800l_data_mode_t;
+
+/*
+ *     SIM800L data mode sink
+ *
+ *     Takes the raw bytes in place of the stream buffer. Runs in the bridge
+ *     task, data points into its UART read buffer and is only valid during the call.
+ */
+typedef void (*sim800l_data_mode_sink_t)(const uint8_t *data, size_t data_len, void *arg);
+
+/*
+ *     SIM800L virtual UART
+ *
+ *     Replaces the physical UART under the AT engine and data mode, e.g. with
+ *     a CMUX channel. read returns the number of bytes read, 0 on timeout.
+ */
+typedef struct
+{
+    int (*write)(const uint8_t *data, size_t data_len, void *arg);
+    int (*read)(uint8_t *data, size_t data_len, uint32_t timeout, void *arg);
+    void *arg;
+} sim800l_io_t;
+
+/*
+ *     SIM800L modem error
+ *
+ *     Last failing final result code. With AT+CMEE=1 the modem names the
+ *     reason (+CME ERROR: 10, no SIM) instead of a bare ERROR.
+ */
+typedef enum
+{
+    SIM800L_ERROR_NONE = 0,
+    SIM800L_ERROR_PLAIN,                /* ERROR, no code */
+    SIM800L_ERROR_CME,                  /* +CME ERROR: <n>, equipment and network */
+    SIM800L_ERROR_CMS                   /* +CMS ERROR: <n>, SMS */
+} sim800l_error_type_t;
+
+typedef struct
+{
+    sim800l_error_type_t type;
+    uint32_t code;
+} sim800l_error_t;
+
+/*
+ *     SIM800L frequent +CME ERROR codes
+ */
+#define SIM800L_CME_OPERATION_NOT_ALLOWED   3
+#define SIM800L_CME_OPERATION_NOT_SUPPORTED 4
+#define SIM800L_CME_SIM_NOT_INSERTED        10
+#define SIM800L_CME_SIM_PIN_REQUIRED        11
+#define SIM800L_CME_SIM_FAILURE             13
+#define SIM800L_CME_SIM_BUSY                14
+#define SIM800L_CME_NO_NETWORK_SERVICE      30
+#define SIM800L_CME_NETWORK_TIMEOUT         31
+#define SIM800L_CME_UNKNOWN                 100
+
+/*
+ *     SIM800L result format
+ *
+ *     Without echo the bridge task hands the in-flight command the block
+ *     that ends it, instead of the block that starts with its echo.
+ */
+typedef enum
+{
+    SIM800L_FORMAT_ECHO = 0,            /* ATE1 V1, modem default */
+    SIM800L_FORMAT_QUIET,               /* ATE0 V1 */
+    SIM800L_FORMAT_NUMERIC              /* ATE0 V0, "0\r" in place of "\r\nOK\r\n" */
+} sim800l_format_t;
+
+/*
+ *     SIM800L wire stats, UART bytes and command round trips
+ */
+typedef struct
+{
+    uint64_t tx_bytes;
+    uint64_t rx_bytes;
+    uint32_t commands;
+    uint64_t command_us;                /* Command sent to final result, summed */
+} sim800l_wire_stats_t;
+
 /*
  *     SIM800L functions prototypes
  */
@@ -93,12 +201,35 @@ esp_err_t sim800l_init(sim800l_handle_t *sim800l_handle, sim800l_config_t *sim80
 esp_err_t sim800l_deinit(sim800l_handle_t sim800l_handle);
 esp_err_t sim800l_start(sim800l_handle_t sim800l_handle);
 esp_err_t sim800l_stop(sim800l_handle_t sim800l_handle);
-esp_err_t sim800l_out_data(sim800l_handle_t sim800l_handle, uint8_t *command, uint8_t *response, uint32_t timeout);
+esp_err_t sim800l_out_data(sim800l_handle_t sim800l_handle, uint8_t *command, uint8_t *response, size_t response_size, uint32_t timeout);
 esp_err_t sim800l_out_data_event(sim800l_handle_t sim800l_handle, uint8_t *command, sim800l_event_t event, uint32_t timeout);
+esp_err_t sim800l_out_data_event_detached(sim800l_handle_t sim800l_handle, uint8_t *command, sim800l_event_t event, uint32_t timeout);
+esp_err_t sim800l_out_data_raw(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len);
+esp_err_t sim800l_lock(sim800l_handle_t sim800l_handle, uint32_t timeout);
+esp_err_t sim800l_unlock(sim800l_handle_t sim800l_handle);
+esp_err_t sim800l_post_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, void* data);
+esp_err_t sim800l_error_switch(sim800l_handle_t sim800l_handle, bool enable);
+esp_err_t sim800l_get_last_error(sim800l_handle_t sim800l_handle, sim800l_error_t *error);
+esp_err_t sim800l_format_switch(sim800l_handle_t sim800l_handle, sim800l_format_t format);
+esp_err_t sim800l_get_wire_stats(sim800l_handle_t sim800l_handle, sim800l_wire_stats_t *stats);
+esp_err_t sim800l_reset_wire_stats(sim800l_handle_t sim800l_handle);
+esp_err_t sim800l_set_io(sim800l_handle_t sim800l_handle, const sim800l_io_t *io);
+int sim800l_uart_write_raw(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len);
+int sim800l_uart_read_raw(sim800l_handle_t sim800l_handle, uint8_t *data, size_t data_len, uint32_t timeout);
+esp_err_t sim800l_data_mode_arm(sim800l_handle_t sim800l_handle, const char *enter_line, const char *exit_line, bool flush);
+esp_err_t sim800l_data_mode_exit(sim800l_handle_t sim800l_handle);
+esp_err_t sim800l_data_mode_escape(sim800l_handle_t sim800l_handle);
+esp_err_t sim800l_data_mode_set_sink(sim800l_handle_t sim800l_handle, sim800l_data_mode_sink_t sink, void *arg);
+esp_err_t sim800l_data_mode_read(sim800l_handle_t sim800l_handle, uint8_t *data, size_t data_size, size_t *data_len, uint32_t timeout);
+sim800l_data_mode_t sim800l_data_mode_get(sim800l_handle_t sim800l_handle, uint32_t *dropped);
 esp_err_t sim800l_register_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, esp_event_handler_t sim800l_event_handler, void *sim800l_event_handler_arg);
 esp_err_t sim800l_unregister_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, esp_event_handler_t sim800l_event_handler);
 esp_err_t sim800l_register_callback(const char *event_name, sim800l_event_t (*sim800l_event_callback)(char **input_args, void *output_data));
 esp_err_t sim800l_unregister_callback(const char *event_name);
+esp_err_t sim800l_set_no_carrier_callback(sim800l_event_t (*sim800l_event_callback)(char **input_args, void *output_data));
+esp_err_t sim800l_register_data_callback(const char *header_name, uint32_t length_arg, sim800l_data_callback_t sim800l_data_callback, void *arg);
+esp_err_t sim800l_unregister_data_callback(const char *header_name);
+size_t sim800l_tokenize(char *input, char delimiter, char **tokens, size_t max_tokens);
 
 
 #ifdef __cplusplus
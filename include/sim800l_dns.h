@@ -0,0 +1,58 @@
+/*
+ * @file sim800l_dns.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L DNS functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L DNS event, posted with SIM800L_EVENT_DNS
+ */
+typedef struct
+{
+    bool resolved;
+    uint32_t error;                     /* +CDNSGIP: 0,<error> */
+    char ip[16];
+} sim800l_dns_event_t;
+
+/*
+ *     SIM800L DNS cache stats
+ */
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;                    /* AT+CDNSGIP queries */
+    uint32_t failures;
+    uint64_t lookup_us;                 /* Total time spent in AT+CDNSGIP */
+    uint64_t saved_us;                  /* Average lookup time for every hit */
+} sim800l_dns_stats_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_dns_resolve(sim800l_handle_t sim800l_handle, const char *host, char *ip, size_t ip_size, uint32_t timeout);
+sim800l_ret_t sim800l_dns_set_ttl(uint32_t ttl);
+sim800l_ret_t sim800l_dns_flush(void);
+sim800l_ret_t sim800l_dns_get_stats(sim800l_dns_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+/*
+ * @file sim800l_ftp.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L FTP functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L FTP session, uses an AT+SAPBR bearer
+ */
+typedef struct
+{
+    uint32_t cid;                       /* Bearer profile, 0 means 1 */
+    const char *server;
+    uint16_t port;                      /* 0 means 21 */
+    const char *username;
+    const char *password;
+    bool active;                        /* Passive mode unless set */
+} sim800l_ftp_config_t;
+
+/*
+ *     SIM800L FTP event, posted with SIM800L_EVENT_FTP
+ */
+typedef struct
+{
+    uint32_t mode;                      /* 1 session state, 2 data */
+    uint32_t code;                      /* Mode 1: 1 ready, 0 finished, otherwise an FTP error */
+    uint32_t length;                    /* FTPPUT ready: max bytes per write, mode 2: confirmed bytes */
+} sim800l_ftp_event_t;
+
+/*
+ *     SIM800L FTP transfer stats
+ */
+typedef struct
+{
+    uint32_t bytes;
+    uint32_t chunks;                    /* FTPGET=2 / FTPPUT=2 round trips */
+    uint32_t offset;                    /* FTPREST offset or append start */
+    uint64_t elapsed_us;
+} sim800l_ftp_stats_t;
+
+/*
+ *     Download sink, anything but SIM800L_RET_OK aborts the transfer
+ */
+typedef sim800l_ret_t (*sim800l_ftp_sink_t)(const uint8_t *data, size_t data_len, void *arg);
+
+/*
+ *     Upload source, returns the bytes written to buffer, 0 ends the file
+ */
+typedef size_t (*sim800l_ftp_source_t)(uint8_t *buffer, size_t buffer_size, void *arg);
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_ftp_config(sim800l_handle_t sim800l_handle, const sim800l_ftp_config_t *config);
+sim800l_ret_t sim800l_ftp_get(sim800l_handle_t sim800l_handle, const char *path, const char *name, uint32_t offset, sim800l_ftp_sink_t sink, void *arg, uint32_t timeout);
+sim800l_ret_t sim800l_ftp_put(sim800l_handle_t sim800l_handle, const char *path, const char *name, bool append, sim800l_ftp_source_t source, void *arg, uint32_t timeout);
+sim800l_ret_t sim800l_ftp_get_stats(sim800l_ftp_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+/*
+ * @file sim800l_gzip.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L gzip/deflate functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L gzip handle
+ */
+typedef struct sim800l_gzip* sim800l_gzip_handle_t;
+
+/*
+ *     SIM800L gzip format
+ */
+typedef enum
+{
+    SIM800L_GZIP_FORMAT_GZIP = 0,       /* RFC 1952, "Content-Encoding: gzip" */
+    SIM800L_GZIP_FORMAT_ZLIB            /* RFC 1950, "Content-Encoding: deflate" */
+} sim800l_gzip_format_t;
+
+/*
+ *     SIM800L gzip output callback
+ *
+ *     Called with each piece of inflated data, the piece points into the
+ *     inflate window and is only valid during the call.
+ */
+typedef sim800l_ret_t (*sim800l_gzip_output_t)(const uint8_t *data, size_t data_len, void *arg);
+
+/*
+ *     SIM800L gzip functions prototypes
+ */
+sim800l_ret_t sim800l_gzip_inflate_init(sim800l_gzip_handle_t *gzip_handle, sim800l_gzip_format_t format, sim800l_gzip_output_t output, void *arg);
+sim800l_ret_t sim800l_gzip_inflate_feed(sim800l_gzip_handle_t gzip_handle, const uint8_t *data, size_t data_len);
+sim800l_ret_t sim800l_gzip_inflate_finish(sim800l_gzip_handle_t gzip_handle, uint32_t *total_out);
+void sim800l_gzip_inflate_deinit(sim800l_gzip_handle_t gzip_handle);
+sim800l_ret_t sim800l_gzip_deflate(const uint8_t *data, size_t data_len, uint8_t **out, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
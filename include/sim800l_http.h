@@ -17,6 +17,7 @@
  */
 #include <stdint.h>
 #include <sim800l_common.h>
+#include "sim800l_gzip.h"
 
 /*
  *     SIM800L HTTP param
@@ -66,6 +67,100 @@ typedef struct
     uint32_t content_length;
 }sim800l_http_action_t;
 
+/*
+ *     SIM800L HTTP download
+ */
+typedef struct
+{
+    uint32_t offset;            /* Last good offset, next byte to be fetched */
+    uint32_t total_length;      /* Resource length, 0 while unknown */
+    uint32_t crc32;             /* Running CRC-32 of bytes [0, offset) */
+} sim800l_http_download_checkpoint_t;
+
+typedef struct
+{
+    const char *url;
+    uint32_t cid;               /* Bearer profile, 0 means 1 */
+    uint32_t range_size;        /* Bytes per ranged request (BREAK/BREAKEND), 0 means default */
+    uint32_t chunk_size;        /* Bytes per AT+HTTPREAD, 0 means default */
+    uint32_t action_timeout;    /* ms to wait for +HTTPACTION, 0 means default */
+    uint32_t max_retries;       /* Consecutive failures tolerated before giving up */
+    bool verify_crc32;
+    uint32_t expected_crc32;
+    sim800l_ret_t (*data_callback)(const uint8_t *data, size_t data_len, uint32_t offset, void *arg);
+    void (*progress_callback)(const sim800l_http_download_checkpoint_t *checkpoint, void *arg);
+    sim800l_ret_t (*reconnect_callback)(sim800l_handle_t sim800l_handle, void *arg);   /* NULL restarts bearer and HTTP */
+    void *arg;
+} sim800l_http_download_config_t;
+
+typedef struct
+{
+    uint32_t bytes;             /* Bytes fetched by this call */
+    uint32_t requests;          /* HTTPACTION requests issued */
+    uint32_t retries;           /* Reconnections after a failure */
+    uint64_t elapsed_us;
+    uint32_t throughput;        /* Effective bytes/s, including reconnections */
+} sim800l_http_download_stats_t;
+
+
+/*
+ *     SIM800L HTTP session
+ */
+typedef struct
+{
+    bool ssl;
+    uint32_t cid;                   /* Bearer profile, 0 means 1 */
+    uint32_t handshake_timeout;     /* ms to wait for +HTTPACTION on a new session, 0 means default */
+    uint32_t request_timeout;       /* ms to wait for +HTTPACTION on a warm session, 0 means default */
+    bool open;
+    bool warm;                      /* A request already completed on this session */
+    char url[256];                  /* URL currently set on the modem */
+} sim800l_http_session_t;
+
+typedef struct
+{
+    bool reused;                    /* Request went out on a warm session */
+    uint64_t setup_us;              /* HTTPINIT, HTTPSSL and HTTPPARA */
+    uint64_t action_us;             /* HTTPACTION until +HTTPACTION: whole request, not just the TLS handshake */
+    uint64_t transfer_us;           /* HTTPREAD of the body */
+} sim800l_http_timing_t;
+
+/*
+ *     SIM800L HTTP header parser
+ *
+ *     Name and value are slices of the received data (not NUL terminated),
+ *     only a line split between two UART reads is staged in the parser.
+ */
+typedef void (*sim800l_http_header_callback_t)(const char *name, size_t name_len, const char *value, size_t value_len, void *arg);
+
+typedef struct
+{
+    sim800l_http_header_callback_t callback;
+    void *arg;
+    char line[128];
+    size_t line_len;
+} sim800l_http_header_parser_t;
+
+/*
+ *     SIM800L HTTP conditional GET
+ */
+typedef struct
+{
+    char etag[64];                  /* Validator from the last 200, sent as If-None-Match */
+    char content_type[48];
+    uint32_t retry_after;           /* Seconds, 0 when absent */
+} sim800l_http_conditional_t;
+
+/*
+ *     SIM800L HTTP compressed transfer
+ */
+typedef struct
+{
+    bool compressed;                /* Body crossed the link gzip/deflate encoded */
+    uint32_t wire_bytes;            /* Body bytes over the UART */
+    uint32_t body_bytes;            /* Body bytes before deflate or after inflate */
+    uint64_t elapsed_us;            /* HTTPACTION (or HTTPDATA) until the last body byte */
+} sim800l_http_transfer_stats_t;
 
 /* 
  *     Functions 
@@ -75,3 +170,18 @@ sim800l_ret_t sim800l_http_set_param(sim800l_handle_t sim800l_handle, sim800l_ht
 sim800l_ret_t sim800l_http_get_param(sim800l_handle_t sim800l_handle, sim800l_http_param_t *param);
 sim800l_ret_t sim800l_http_action(sim800l_handle_t sim800l_handle, sim800l_http_method_t method);
 sim800l_ret_t sim800l_http_read(sim800l_handle_t sim800l_handle, uint32_t start_addr, size_t length, uint8_t *buffer);
+sim800l_ret_t sim800l_http_read_data(sim800l_handle_t sim800l_handle, uint32_t start_addr, size_t length, uint8_t *buffer, size_t *data_len);
+sim800l_ret_t sim800l_http_action_wait(sim800l_handle_t sim800l_handle, sim800l_http_method_t method, sim800l_http_action_t *action, uint32_t timeout);
+sim800l_ret_t sim800l_http_download(sim800l_handle_t sim800l_handle, const sim800l_http_download_config_t *config, sim800l_http_download_checkpoint_t *checkpoint, sim800l_http_download_stats_t *stats);
+sim800l_ret_t sim800l_http_ssl(sim800l_handle_t sim800l_handle, bool enable);
+sim800l_ret_t sim800l_http_session_open(sim800l_handle_t sim800l_handle, sim800l_http_session_t *session);
+sim800l_ret_t sim800l_http_session_request(sim800l_handle_t sim800l_handle, sim800l_http_session_t *session, const char *url, sim800l_http_method_t method, sim800l_http_action_t *action, uint8_t *buffer, size_t buffer_size, size_t *data_len, sim800l_http_timing_t *timing);
+sim800l_ret_t sim800l_http_session_close(sim800l_handle_t sim800l_handle, sim800l_http_session_t *session);
+sim800l_ret_t sim800l_http_read_header(sim800l_handle_t sim800l_handle, sim800l_http_header_callback_t callback, void *arg);
+sim800l_ret_t sim800l_http_get_conditional(sim800l_handle_t sim800l_handle, const char *url, sim800l_http_conditional_t *conditional, sim800l_http_action_t *action, uint8_t *buffer, size_t buffer_size, size_t *data_len);
+void sim800l_http_header_parser_init(sim800l_http_header_parser_t *parser, sim800l_http_header_callback_t callback, void *arg);
+void sim800l_http_header_parser_feed(sim800l_http_header_parser_t *parser, const uint8_t *data, size_t data_len);
+void sim800l_http_header_parser_finish(sim800l_http_header_parser_t *parser);
+sim800l_ret_t sim800l_http_data(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len, uint32_t timeout);
+sim800l_ret_t sim800l_http_get_compressed(sim800l_handle_t sim800l_handle, const char *url, bool accept_gzip, sim800l_gzip_output_t data_callback, void *arg, sim800l_http_action_t *action, sim800l_http_transfer_stats_t *stats);
+sim800l_ret_t sim800l_http_post_compressed(sim800l_handle_t sim800l_handle, const char *url, const char *content_type, const uint8_t *body, size_t body_len, bool compress, sim800l_http_action_t *action, sim800l_http_transfer_stats_t *stats);
\ No newline at end of file
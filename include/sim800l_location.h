@@ -0,0 +1,96 @@
+/*
+ * @file sim800l_location.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L GSM location and network time functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L GSM location, AT+CIPGSMLOC over a bearer, cached
+ */
+typedef struct
+{
+    double longitude;
+    double latitude;
+    int64_t epoch;                      /* UTC of the fix, seconds since 1970 */
+    uint32_t age_ms;                    /* Since the fix was obtained, 0 for a fresh query */
+} sim800l_location_t;
+
+/*
+ *     SIM800L network time, *PSUTTZ / AT+CCLK / AT+CIPGSMLOC=2, advanced by the time since it was read
+ */
+typedef enum
+{
+    SIM800L_TIME_SOURCE_NETWORK = 0,    /* *PSUTTZ after AT+CLTS=1 */
+    SIM800L_TIME_SOURCE_RTC,            /* AT+CCLK, set by the network */
+    SIM800L_TIME_SOURCE_GSMLOC,         /* AT+CIPGSMLOC=2, needs the bearer */
+    SIM800L_TIME_SOURCE_NTP             /* AT+CCLK right after AT+CNTP */
+} sim800l_time_source_t;
+
+typedef struct
+{
+    int64_t epoch;                      /* UTC now, seconds since 1970 */
+    int32_t timezone;                   /* Quarters of an hour east of UTC, 0 from AT+CIPGSMLOC */
+    sim800l_time_source_t source;
+    uint32_t age_ms;                    /* Since the source reported it */
+} sim800l_time_t;
+
+/*
+ *     Posted with SIM800L_EVENT_TIME on every *PSUTTZ and +CNTP
+ */
+typedef struct
+{
+    sim800l_time_source_t source;       /* NETWORK or NTP */
+    int64_t epoch;                      /* *PSUTTZ only, read AT+CCLK after +CNTP */
+    int32_t timezone;
+    uint32_t dst;
+    uint32_t result;                    /* +CNTP only, 1 synced, 61..66 errors */
+} sim800l_time_event_t;
+
+/*
+ *     SIM800L location and time stats, hits / (hits + queries) is the hit rate
+ */
+typedef struct
+{
+    uint32_t location_hits;
+    uint32_t location_queries;          /* AT+CIPGSMLOC=1 */
+    uint32_t location_failures;
+    uint64_t location_query_us;         /* Total time spent in AT+CIPGSMLOC=1 */
+    uint32_t time_hits;
+    uint32_t time_queries;              /* AT+CCLK or AT+CIPGSMLOC=2 */
+    uint32_t time_failures;
+    uint64_t time_query_us;
+    uint32_t network_updates;           /* *PSUTTZ received */
+} sim800l_location_stats_t;
+
+/*
+ *     SIM800L functions prototypes, a max_age_ms of 0 means 5 minutes for a fix and 1 hour for the time
+ */
+sim800l_ret_t sim800l_location_get(sim800l_handle_t sim800l_handle, uint32_t cid, uint32_t max_age_ms, sim800l_location_t *location);
+sim800l_ret_t sim800l_location_time_switch(sim800l_handle_t sim800l_handle, bool enable);
+sim800l_ret_t sim800l_location_time_get(sim800l_handle_t sim800l_handle, uint32_t cid, uint32_t max_age_ms, sim800l_time_t *time);
+sim800l_ret_t sim800l_location_time_read_rtc(sim800l_handle_t sim800l_handle, sim800l_time_source_t source, sim800l_time_t *time);
+void sim800l_location_flush(void);
+sim800l_ret_t sim800l_location_get_stats(sim800l_location_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
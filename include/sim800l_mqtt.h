@@ -0,0 +1,88 @@
+/*
+ * @file sim800l_mqtt.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L MQTT 3.1.1 client functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L MQTT client, runs on one sim800l_tcpip link
+ */
+typedef enum
+{
+    SIM800L_MQTT_QOS_0 = 0,
+    SIM800L_MQTT_QOS_1
+} sim800l_mqtt_qos_t;
+
+typedef enum
+{
+    SIM800L_MQTT_STATE_DISCONNECTED = 0,
+    SIM800L_MQTT_STATE_CONNECTING,
+    SIM800L_MQTT_STATE_CONNECTED
+} sim800l_mqtt_state_t;
+
+typedef struct
+{
+    uint32_t link;                      /* sim800l_tcpip link used for the broker */
+    const char *host;
+    uint16_t port;
+    const char *client_id;
+    const char *username;               /* NULL for none */
+    const char *password;               /* NULL for none */
+    uint16_t keepalive;                 /* Seconds, 0 disables PINGREQ */
+    bool clean_session;
+} sim800l_mqtt_config_t;
+
+/*
+ *     SIM800L MQTT stats, tx_bytes / published is the wire cost per message
+ */
+typedef struct
+{
+    uint32_t published;
+    uint32_t acked;                     /* PUBACK for QoS 1 */
+    uint32_t received;
+    uint32_t retransmits;               /* QoS 1 PUBLISH sent again with DUP */
+    uint32_t batches;                   /* Flushes, each one is sent as few CIPSENDs as possible */
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+} sim800l_mqtt_stats_t;
+
+/*
+ *     Called from sim800l_mqtt_loop for every PUBLISH from the broker
+ */
+typedef void sim800l_mqtt_message_cb_t(const char *topic, size_t topic_len, const uint8_t *payload, size_t payload_len, void *arg);
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_mqtt_connect(sim800l_handle_t sim800l_handle, const sim800l_mqtt_config_t *config, uint32_t timeout);
+sim800l_ret_t sim800l_mqtt_disconnect(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_mqtt_publish(sim800l_handle_t sim800l_handle, const char *topic, const uint8_t *payload, size_t payload_len, sim800l_mqtt_qos_t qos, bool retain);
+sim800l_ret_t sim800l_mqtt_subscribe(sim800l_handle_t sim800l_handle, const char *topic, sim800l_mqtt_qos_t qos, uint32_t timeout);
+sim800l_ret_t sim800l_mqtt_flush(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_mqtt_loop(sim800l_handle_t sim800l_handle, uint32_t timeout);
+sim800l_ret_t sim800l_mqtt_set_message_callback(sim800l_mqtt_message_cb_t *callback, void *arg);
+sim800l_mqtt_state_t sim800l_mqtt_get_state(void);
+sim800l_ret_t sim800l_mqtt_get_stats(sim800l_mqtt_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
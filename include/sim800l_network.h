@@ -0,0 +1,99 @@
+/*
+ * @file sim800l_network.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L network registration and signal quality functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L network, AT+CREG=2 / AT+CGREG=2 reports and AT+CSQ history
+ */
+#define SIM800L_NETWORK_HISTORY_SIZE    64
+
+typedef enum
+{
+    SIM800L_NETWORK_NOT_REGISTERED = 0,
+    SIM800L_NETWORK_HOME,
+    SIM800L_NETWORK_SEARCHING,
+    SIM800L_NETWORK_DENIED,
+    SIM800L_NETWORK_UNKNOWN,
+    SIM800L_NETWORK_ROAMING
+} sim800l_network_stat_t;
+
+/*
+ *     SIM800L network event, posted with SIM800L_EVENT_NETWORK on every +CREG / +CGREG
+ */
+typedef struct
+{
+    bool gprs;                          /* +CGREG, otherwise +CREG */
+    sim800l_network_stat_t stat;
+    uint32_t lac;                       /* 0 when not reported */
+    uint32_t ci;
+} sim800l_network_event_t;
+
+typedef struct
+{
+    sim800l_network_stat_t creg;
+    sim800l_network_stat_t cgreg;
+    uint32_t lac;
+    uint32_t ci;
+    int64_t changed;                    /* esp_timer_get_time() of the last change */
+} sim800l_network_registration_t;
+
+/*
+ *     SIM800L signal samples, rssi 99 (not known) is not kept
+ */
+typedef struct
+{
+    int64_t timestamp;
+    uint8_t rssi;                       /* 0..31, dBm = -113 + 2 * rssi */
+    uint8_t ber;                        /* 0..7, 99 not known */
+} sim800l_network_sample_t;
+
+typedef struct
+{
+    sim800l_network_sample_t current;
+    uint8_t min_rssi;                   /* Over the last window samples */
+    uint8_t avg_rssi;
+    uint32_t samples;                   /* In the window, 0 before the first sample */
+} sim800l_network_signal_t;
+
+typedef struct
+{
+    uint32_t interval_ms;               /* AT+CSQ period, 0 means 10000 */
+    uint32_t window;                    /* Samples in min / avg, 0 or above the history means all of it */
+} sim800l_network_monitor_config_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_network_switch(sim800l_handle_t sim800l_handle, bool enable);
+sim800l_ret_t sim800l_network_monitor_start(sim800l_handle_t sim800l_handle, const sim800l_network_monitor_config_t *config);
+sim800l_ret_t sim800l_network_monitor_stop(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_network_get_registration(sim800l_network_registration_t *registration);
+sim800l_ret_t sim800l_network_get_signal(sim800l_network_signal_t *signal);
+size_t sim800l_network_get_history(sim800l_network_sample_t *samples, size_t max_samples);
+bool sim800l_network_is_registered(void);
+int32_t sim800l_network_rssi_to_dbm(uint8_t rssi);
+
+#ifdef __cplusplus
+}
+#endif
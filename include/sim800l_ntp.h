@@ -0,0 +1,62 @@
+/*
+ * @file sim800l_ntp.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L NTP (AT+CNTP) time sync functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L NTP, only over a bearer that is already up, never opens one
+ */
+typedef struct
+{
+    uint32_t cid;                       /* Bearer profile, 0 means 1 */
+    const char *server;                 /* NULL means pool.ntp.org */
+    int32_t timezone;                   /* Quarters of an hour, the RTC is kept in this local time */
+    uint32_t min_interval_ms;           /* Between syncs, 0 means 6 hours */
+} sim800l_ntp_config_t;
+
+/*
+ *     SIM800L NTP stats
+ */
+typedef struct
+{
+    uint32_t syncs;
+    uint32_t skipped;                   /* Bearer down or synced less than min_interval_ms ago */
+    uint32_t failures;
+    uint32_t steps;                     /* settimeofday, clock unset or too far off */
+    uint32_t slews;                     /* adjtime */
+    int64_t last_offset_ms;             /* NTP minus the system clock before the correction */
+    int64_t last_sync;                  /* esp_timer_get_time() of the last sync */
+} sim800l_ntp_stats_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_ntp_sync(sim800l_handle_t sim800l_handle, const sim800l_ntp_config_t *config);
+sim800l_ret_t sim800l_ntp_job(sim800l_handle_t sim800l_handle, void *arg);
+sim800l_ret_t sim800l_ntp_auto_start(sim800l_handle_t sim800l_handle, const sim800l_ntp_config_t *config);
+sim800l_ret_t sim800l_ntp_auto_stop(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_ntp_get_stats(sim800l_ntp_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+/*
+ * @file sim800l_ota.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L OTA functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L OTA config
+ */
+typedef struct
+{
+    const char *url;
+    uint32_t cid;                       /* Bearer profile, 0 means 1 */
+    uint32_t buffer_size;               /* Bytes per flash write, 0 means one sector */
+    uint32_t chunk_size;                /* Bytes per AT+HTTPREAD, 0 means default */
+    uint32_t max_retries;               /* Consecutive link failures tolerated */
+    bool serial;                        /* Write flash inline instead of overlapping with the radio */
+    const uint8_t *expected_sha256;     /* 32 bytes, NULL to skip */
+    void (*progress_callback)(uint32_t written, uint32_t total, void *arg);  /* After each flash write, total 0 until known */
+    void *arg;
+} sim800l_ota_config_t;
+
+/*
+ *     SIM800L OTA stats
+ */
+typedef struct
+{
+    uint32_t bytes;
+    uint32_t retries;
+    uint64_t elapsed_us;
+    uint64_t flash_us;                  /* Time spent in esp_ota_write */
+    uint64_t stall_us;                  /* Time the radio side waited for a free buffer */
+    uint32_t throughput;                /* Bytes/s end to end */
+    uint8_t sha256[32];
+} sim800l_ota_stats_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_ota_update(sim800l_handle_t sim800l_handle, const sim800l_ota_config_t *config, sim800l_ota_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
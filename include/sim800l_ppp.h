@@ -0,0 +1,66 @@
+/*
+ * @file sim800l_ppp.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L PPPoS functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include <esp_netif.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L PPP state
+ */
+typedef enum
+{
+    SIM800L_PPP_STATE_IDLE = 0,
+    SIM800L_PPP_STATE_DIALING,
+    SIM800L_PPP_STATE_CONNECTED,        /* UART belongs to lwIP */
+    SIM800L_PPP_STATE_HANGUP            /* NO CARRIER, back in command mode */
+} sim800l_ppp_state_t;
+
+/*
+ *     SIM800L PPP event, posted with SIM800L_EVENT_PPP
+ */
+typedef struct
+{
+    sim800l_ppp_state_t state;
+} sim800l_ppp_event_t;
+
+/*
+ *     SIM800L PPP stats
+ */
+typedef struct
+{
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint64_t connected_us;
+} sim800l_ppp_stats_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_ppp_start(sim800l_handle_t sim800l_handle, const char *apn, esp_netif_t **esp_netif);
+sim800l_ret_t sim800l_ppp_stop(sim800l_handle_t sim800l_handle);
+sim800l_ppp_state_t sim800l_ppp_get_state(void);
+sim800l_ret_t sim800l_ppp_get_stats(sim800l_ppp_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
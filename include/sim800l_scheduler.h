@@ -0,0 +1,108 @@
+/*
+ * @file sim800l_scheduler.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L link aware transfer scheduler functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L scheduler, holds deferrable jobs until the link is good or a deadline forces them,
+ *     then runs them back to back in one AT+SAPBR session
+ */
+#define SIM800L_SCHEDULER_MAX_JOBS      16
+
+/*
+ *     Job body, runs with the bearer up, anything but SIM800L_RET_OK is retried
+ */
+typedef sim800l_ret_t (*sim800l_scheduler_run_t)(sim800l_handle_t sim800l_handle, void *arg);
+
+typedef struct
+{
+    sim800l_scheduler_run_t run;
+    void *arg;
+    uint32_t priority;                  /* Higher runs first in a session */
+    uint32_t deadline_ms;               /* From submit, 0 waits for a good link however long it takes */
+} sim800l_scheduler_job_t;
+
+typedef struct
+{
+    uint32_t cid;                       /* Bearer profile, 0 means 1, not shared with the bearer manager */
+    uint8_t min_rssi;                   /* Good link from this AT+CSQ rssi up, 0 means 10 (-93 dBm) */
+    uint32_t check_interval_ms;         /* Link check period, 0 means 5000 */
+    uint32_t max_retries;               /* Per job and session, 0 means 2 */
+    uint32_t lead_ms;                   /* A deadline forces a session this long before it, 0 means 30000 */
+} sim800l_scheduler_config_t;
+
+/*
+ *     SIM800L scheduler stats, bearer_up_us and retries are the energy proxies
+ */
+typedef struct
+{
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t dropped;                   /* Deadline passed, or the queue was full */
+    uint32_t pending;
+    uint32_t retries;
+    uint32_t sessions;
+    uint32_t forced;                    /* Sessions opened by a deadline on a bad link */
+    uint64_t bearer_up_us;
+} sim800l_scheduler_stats_t;
+
+/*
+ *     SIM800L scheduler replay, runs the same policy against a recorded signal trace without the modem
+ */
+typedef struct
+{
+    uint32_t time_ms;
+    uint8_t rssi;                       /* 99 not known */
+    bool registered;
+} sim800l_scheduler_trace_t;
+
+typedef struct
+{
+    uint32_t submit_ms;                 /* Jobs in submit order */
+    uint32_t priority;
+    uint32_t deadline_ms;
+} sim800l_scheduler_replay_job_t;
+
+typedef struct
+{
+    uint32_t bearer_open_ms;            /* AT+SAPBR=1,<cid> time, 0 means 3000 */
+    uint32_t attempt_ms;                /* One job attempt, 0 means 2000 */
+    uint8_t fail_rssi;                  /* Attempts fail below this rssi or unregistered, 0 means 8 */
+} sim800l_scheduler_model_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_scheduler_start(sim800l_handle_t sim800l_handle, const sim800l_scheduler_config_t *config);
+sim800l_ret_t sim800l_scheduler_stop(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_scheduler_submit(const sim800l_scheduler_job_t *job);
+sim800l_ret_t sim800l_scheduler_flush(void);
+sim800l_ret_t sim800l_scheduler_get_stats(sim800l_scheduler_stats_t *stats);
+sim800l_ret_t sim800l_scheduler_replay(const sim800l_scheduler_config_t *config, const sim800l_scheduler_model_t *model,
+                                       const sim800l_scheduler_trace_t *trace, size_t trace_len,
+                                       const sim800l_scheduler_replay_job_t *jobs, size_t jobs_len,
+                                       sim800l_scheduler_stats_t *scheduled, sim800l_scheduler_stats_t *immediate);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+/*
+ * @file sim800l_shadow.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L settings shadow functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L shadow keys, one per setting written to or read from the modem
+ */
+#define SIM800L_SHADOW_KEY_SIZE         24
+#define SIM800L_SHADOW_VALUE_MAX        256     /* Longer values are sent every time */
+
+/*
+ *     SIM800L shadow stats, sets_skipped + queries_served is the round trips saved since the last modem reset
+ */
+typedef struct
+{
+    uint32_t sets_skipped;              /* Set calls that matched the modem value */
+    uint32_t queries_served;            /* Get calls answered without a command */
+    uint32_t previous_saved;            /* Round trips saved in the boot before the last reset */
+    uint32_t invalidations;             /* RDY / +CFUN resets */
+    uint32_t entries;
+} sim800l_shadow_stats_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_shadow_init(void);
+sim800l_ret_t sim800l_shadow_switch(bool enable);
+bool sim800l_shadow_unchanged(const char *key, const char *value);
+void sim800l_shadow_store(const char *key, const char *value);
+bool sim800l_shadow_lookup(const char *key, char *value, size_t value_size);
+void sim800l_shadow_count_served(void);
+void sim800l_shadow_invalidate(const char *prefix);
+sim800l_ret_t sim800l_shadow_get_stats(sim800l_shadow_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,136 @@
+/*
+ * @file sim800l_tcpip.h
+ * @author Eduardo Gomes
+ * @brief Header file for SIM800L TCP/IP functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Preprocessor guard
+ */
+#pragma once
+
+/*
+ *     Includes
+ */
+#include <stdint.h>
+#include "sim800l_core.h"
+#include "sim800l_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *     SIM800L TCP/IP links (AT+CIPMUX=1)
+ */
+#define SIM800L_TCPIP_MAX_LINKS         6
+
+typedef enum
+{
+    SIM800L_TCPIP_PROTOCOL_TCP = 0,
+    SIM800L_TCPIP_PROTOCOL_UDP
+} sim800l_tcpip_protocol_t;
+
+typedef enum
+{
+    SIM800L_TCPIP_STATE_CLOSED = 0,
+    SIM800L_TCPIP_STATE_CONNECTING,
+    SIM800L_TCPIP_STATE_CONNECTED,
+    SIM800L_TCPIP_STATE_CLOSING,
+    SIM800L_TCPIP_STATE_FAILED
+} sim800l_tcpip_state_t;
+
+/*
+ *     SIM800L TCP/IP event, posted with SIM800L_EVENT_TCPIP
+ */
+typedef struct
+{
+    uint32_t link;
+    sim800l_tcpip_state_t state;
+    bool send_done;                     /* SEND OK or SEND FAIL for the last send */
+    bool send_failed;
+} sim800l_tcpip_event_t;
+
+/*
+ *     SIM800L TCP/IP server event, posted with SIM800L_EVENT_TCPIP_SERVER
+ */
+typedef enum
+{
+    SIM800L_TCPIP_SERVER_LISTENING = 0, /* SERVER OK */
+    SIM800L_TCPIP_SERVER_CLOSED,        /* SERVER CLOSE */
+    SIM800L_TCPIP_SERVER_ACCEPT         /* "<n>, REMOTE IP: <ip>", link is connected */
+} sim800l_tcpip_server_state_t;
+
+typedef struct
+{
+    sim800l_tcpip_server_state_t state;
+    uint32_t link;
+    char remote_ip[16];
+    int64_t timestamp;                  /* esp_timer_get_time() when the URC was parsed */
+} sim800l_tcpip_server_event_t;
+
+/*
+ *     SIM800L TCP/IP link stats
+ */
+typedef struct
+{
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t rx_dropped;                /* Bytes lost because the ring buffer was full */
+    uint32_t send_failed;
+    uint32_t retransmits;               /* Chunks sent again by sim800l_tcpip_send_all */
+} sim800l_tcpip_stats_t;
+
+/*
+ *     SIM800L TCP/IP transparent mode (AT+CIPMODE=1, single link)
+ */
+typedef struct
+{
+    uint32_t send_size;                 /* CIPCCFG SendSz, bytes per packet, 0 means 1460 */
+    uint32_t wait_time;                 /* CIPCCFG WaitTm, x100 ms before a partial packet goes out, 0 means 1 */
+} sim800l_tcpip_transparent_config_t;
+
+typedef struct
+{
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t rx_dropped;
+    uint64_t tx_us;                     /* Time spent writing, tx_bytes / tx_us is the goodput */
+    uint64_t connected_us;              /* Since CONNECT */
+} sim800l_tcpip_transparent_stats_t;
+
+/*
+ *     SIM800L functions prototypes
+ */
+sim800l_ret_t sim800l_tcpip_switch(sim800l_handle_t sim800l_handle, bool enable);
+sim800l_ret_t sim800l_tcpip_attach(sim800l_handle_t sim800l_handle, const char *apn, const char *user, const char *pwd, char *ip, size_t ip_size);
+sim800l_ret_t sim800l_tcpip_detach(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_tcpip_open(sim800l_handle_t sim800l_handle, uint32_t link, sim800l_tcpip_protocol_t protocol, const char *host, uint16_t port, uint32_t timeout);
+sim800l_ret_t sim800l_tcpip_send(sim800l_handle_t sim800l_handle, uint32_t link, const uint8_t *data, size_t data_len, size_t *sent, uint32_t timeout);
+sim800l_ret_t sim800l_tcpip_recv(sim800l_handle_t sim800l_handle, uint32_t link, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout);
+sim800l_ret_t sim800l_tcpip_close(sim800l_handle_t sim800l_handle, uint32_t link, uint32_t timeout);
+size_t sim800l_tcpip_available(uint32_t link);
+sim800l_tcpip_state_t sim800l_tcpip_get_state(uint32_t link);
+sim800l_ret_t sim800l_tcpip_get_stats(uint32_t link, sim800l_tcpip_stats_t *stats);
+sim800l_ret_t sim800l_tcpip_set_quick_send(sim800l_handle_t sim800l_handle, bool enable);
+sim800l_ret_t sim800l_tcpip_get_ack(sim800l_handle_t sim800l_handle, uint32_t link, uint32_t *sent, uint32_t *acked, uint32_t *unacked);
+sim800l_ret_t sim800l_tcpip_send_all(sim800l_handle_t sim800l_handle, uint32_t link, const uint8_t *data, size_t data_len, uint32_t window, uint32_t timeout);
+sim800l_ret_t sim800l_tcpip_server_start(sim800l_handle_t sim800l_handle, uint16_t port);
+sim800l_ret_t sim800l_tcpip_server_stop(sim800l_handle_t sim800l_handle);
+bool sim800l_tcpip_server_is_listening(void);
+sim800l_ret_t sim800l_tcpip_set_manual_receive(sim800l_handle_t sim800l_handle, bool enable);
+sim800l_ret_t sim800l_tcpip_transparent_switch(sim800l_handle_t sim800l_handle, bool enable, const sim800l_tcpip_transparent_config_t *config);
+sim800l_ret_t sim800l_tcpip_transparent_open(sim800l_handle_t sim800l_handle, sim800l_tcpip_protocol_t protocol, const char *host, uint16_t port, uint32_t timeout);
+sim800l_ret_t sim800l_tcpip_transparent_write(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len);
+sim800l_ret_t sim800l_tcpip_transparent_read(sim800l_handle_t sim800l_handle, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout);
+sim800l_ret_t sim800l_tcpip_transparent_escape(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_tcpip_transparent_resume(sim800l_handle_t sim800l_handle, uint32_t timeout);
+sim800l_ret_t sim800l_tcpip_transparent_close(sim800l_handle_t sim800l_handle);
+sim800l_ret_t sim800l_tcpip_transparent_get_stats(sim800l_handle_t sim800l_handle, sim800l_tcpip_transparent_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
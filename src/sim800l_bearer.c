@@ -13,20 +13,117 @@
 #include "sim800l_core.h"
 #include "sim800l_bearer.h"
 #include "sim800l_misc.h"
+#include "sim800l_shadow.h"
+#include "sim800l_network.h"
 #include <string.h>
+#include <esp_timer.h>
+#include <esp_random.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_BEARER_POLL_INTERVAL_MS     30000
+#define SIM800L_BEARER_BACKOFF_MIN_MS       1000
+#define SIM800L_BEARER_BACKOFF_MAX_MS       60000
+#define SIM800L_BEARER_OPEN_TIMEOUT         85000   /* AT+SAPBR=1,1 worst case */
+#define SIM800L_BEARER_SETTLE_POLL_MS       1000    /* Status poll while the profile is still connecting or closing */
+#define SIM800L_BEARER_BUSY_MS              1000    /* Data mode owns the UART, check again later */
+
+#define SIM800L_BEARER_TASK_STACK_SIZE      4096
+#define SIM800L_BEARER_TASK_PRIORITY        1
+#define SIM800L_BEARER_TASK_NAME            "sim800l_bearer_task"
+
+/*
+ *     Event bits
+ */
+#define SIM800L_BEARER_READY_BIT            BIT0
+#define SIM800L_BEARER_WAKE_BIT             BIT1
+#define SIM800L_BEARER_STOPPED_BIT          BIT2
 
 /*
  *     Tag
  */
 #define SIM800L_BEARER_TAG "SIM800L BEARER"
 
+/*
+ *     Manager
+ */
+static sim800l_handle_t sim800l_bearer_handle = NULL;
+static EventGroupHandle_t sim800l_bearer_events = NULL;
+static volatile bool sim800l_bearer_running = false;
+static volatile sim800l_bearer_state_t sim800l_bearer_state = SIM800L_BEARER_STATE_DOWN;
+static sim800l_bearer_manager_config_t sim800l_bearer_config = {0};
+static sim800l_bearer_stats_t sim800l_bearer_stats = {0};
+static sim800l_bearer_event_t sim800l_bearer_event = {0};   /* Posted by pointer, must outlive the post */
+static int64_t sim800l_bearer_started = 0;
+static int64_t sim800l_bearer_dropped = 0;
+
+/*
+ *     Profile parameters, kept in the settings shadow as SAPBR:<cid>:<param>
+ */
+static const char *sim800l_bearer_fields[] = {
+    SIM800L_BEARER_CONTYPE,
+    SIM800L_BEARER_APN,
+    SIM800L_BEARER_USER,
+    SIM800L_BEARER_PWD,
+    SIM800L_BEARER_PHONENUM,
+    SIM800L_BEARER_RATE
+};
+
+#define SIM800L_BEARER_FIELDS               (sizeof(sim800l_bearer_fields) / sizeof(sim800l_bearer_fields[0]))
+#define SIM800L_BEARER_SHADOW_PREFIX        "SAPBR:"
+
+/*
+ *     Private functions
+ */
+static bool sim800l_bearer_cid_valid(uint32_t cid);
+static void sim800l_bearer_shadow_key(char *key, uint32_t cid, const char *param);
+static bool sim800l_bearer_shadow_get(uint32_t cid, sim800l_bearer_param_t *param);
+static void sim800l_bearer_task(void *args);
+static void sim800l_bearer_set_state(sim800l_bearer_state_t state, const char *ipv4);
+static uint32_t sim800l_bearer_jitter(uint32_t delay);
+
+/*
+ *     Event handlers
+ */
+static void sim800l_bearer_network_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data);
+
 /*
  *     Functions
  */
 
 sim800l_ret_t sim800l_bearer_switch(sim800l_handle_t sim800l_handle, bool bearer_state)
+{
+    return sim800l_bearer_profile_switch(sim800l_handle, SIM800L_BEARER_CID_DEFAULT, bearer_state);
+}
+
+sim800l_ret_t sim800l_bearer_query(sim800l_handle_t sim800l_handle, sim800l_bearer_t *bearer)
+{
+    return sim800l_bearer_profile_query(sim800l_handle, SIM800L_BEARER_CID_DEFAULT, bearer);
+}
+
+sim800l_ret_t sim800l_bearer_set_param(sim800l_handle_t sim800l_handle, const char* param, const char* value)
+{
+    return sim800l_bearer_profile_set_param(sim800l_handle, SIM800L_BEARER_CID_DEFAULT, param, value);
+}
+
+sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_bearer_param_t *param)
+{
+    return sim800l_bearer_profile_get_param(sim800l_handle, SIM800L_BEARER_CID_DEFAULT, param);
+}
+
+sim800l_ret_t sim800l_bearer_profile_switch(sim800l_handle_t sim800l_handle, uint32_t cid, bool bearer_state)
 {
     ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
+
+    if (!sim800l_bearer_cid_valid(cid))
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Invalid CID %lu", cid);
+        return SIM800L_RET_INVALID_ARG;
+    }
     
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_BEARER) + 4*sizeof(char) + strlen("\r\n") + 1; /* cmd=d,d\r\n */
@@ -40,31 +137,64 @@ sim800l_ret_t sim800l_bearer_switch(sim800l_handle_t sim800l_handle, bool bearer
     }
     
     /* Assembly of the command to be sent */
-    if (snprintf((char*)command, command_length, "%s=%d,1\r\n", SIM800L_COMMAND_BEARER, bearer_state) < 0)
+    if (snprintf((char*)command, command_length, "%s=%d,%lu\r\n", SIM800L_COMMAND_BEARER, bearer_state, cid) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Assembly of the command to be sent failed");
         free(command);
         return SIM800L_RET_ERROR_BUILD_COMMAND;
     }
 
-    /* Send AT command */
-    esp_err_t ret = sim800l_out_data_event(sim800l_handle, command, SIM800L_EVENT_OK, 85000);
-    if (ret != ESP_OK)
+    int64_t deadline = esp_timer_get_time() + (int64_t)SIM800L_BEARER_OPEN_TIMEOUT * 1000;
+
+    /* The attach can take 85 s, other commands are not held up while it runs */
+    esp_err_t ret = sim800l_out_data_event_detached(sim800l_handle, command, SIM800L_EVENT_OK, SIM800L_BEARER_OPEN_TIMEOUT);
+
+    free(command);
+
+    /* Without the lock an OK or ERROR may have been someone else's, the profile status tells */
+    uint32_t wanted = bearer_state ? 1 : 3;     /* Connected / closed */
+    sim800l_bearer_t bearer = {0};
+    while (true)
     {
-        ESP_LOGE(SIM800L_BEARER_TAG, "sim800l_out_data failed: %s", esp_err_to_name(ret));
-        free(command);
-        return SIM800L_RET_ERROR_SEND_COMMAND;
+        /* No status, go by the final result */
+        if (sim800l_bearer_profile_query(sim800l_handle, cid, &bearer) != SIM800L_RET_OK)
+        {
+            if (ret == ESP_OK)
+            {
+                return SIM800L_RET_OK;
+            }
+            break;
+        }
+
+        if (bearer.status == wanted)
+        {
+            return SIM800L_RET_OK;
+        }
+
+        /* 0 connecting, 2 closing, anything else is final */
+        if (((bearer.status != 0) && (bearer.status != 2)) || (esp_timer_get_time() >= deadline))
+        {
+            break;
+        }
+
+        vTaskDelay(SIM800L_BEARER_SETTLE_POLL_MS / portTICK_PERIOD_MS);
     }
-    
-    free(command);
-    
-    return SIM800L_RET_OK;
+
+    ESP_LOGE(SIM800L_BEARER_TAG, "AT+SAPBR=%d,%lu failed: %s", bearer_state, cid, esp_err_to_name(ret));
+
+    return SIM800L_RET_ERROR_SEND_COMMAND;
 }
 
-sim800l_ret_t sim800l_bearer_query(sim800l_handle_t sim800l_handle, sim800l_bearer_t *bearer)
+sim800l_ret_t sim800l_bearer_profile_query(sim800l_handle_t sim800l_handle, uint32_t cid, sim800l_bearer_t *bearer)
 {
     ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
 
+    if (!sim800l_bearer_cid_valid(cid) || (bearer == NULL))
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_BEARER) + 4*sizeof(char) + strlen("\r\n") + 1; /* cmd=d,d\r\n */
 
@@ -77,18 +207,18 @@ sim800l_ret_t sim800l_bearer_query(sim800l_handle_t sim800l_handle, sim800l_bear
     }
 
     /* Assembly of the command to be sent */
-    if (snprintf((char*)command, command_length, "%s=2,1\r\n", SIM800L_COMMAND_BEARER) < 0)
+    if (snprintf((char*)command, command_length, "%s=2,%lu\r\n", SIM800L_COMMAND_BEARER, cid) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Assembly of the command to be sent failed");
         free(command);
         return SIM800L_RET_ERROR_BUILD_COMMAND;
     }
 
-    /* Response */
-    char response[10] = {0};
+    /* Response, +SAPBR: <cid>,<status>,"<ip>" */
+    char response[64] = {0};
     
     /* Send AT command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000) != ESP_OK)
+    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "sim800l_call_answer failed");
         free(command);
@@ -104,23 +234,20 @@ sim800l_ret_t sim800l_bearer_query(sim800l_handle_t sim800l_handle, sim800l_bear
         return SIM800L_RET_ERROR;
     }
 
+    /* Skip the +SAPBR: prefix */
+    char *args = strchr(response, ':');
+    args = (args != NULL) ? args + 1 : response;
+
     /* Extract CID */
-    char *token = strtok((char *)response, "M,");
+    char *token = strtok(args, ",");
     if (token == NULL)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Extracting CID failed");
         return SIM800L_RET_ERROR;
     }
 
-    char cid_string[4] = {0};
-    if (strncpy(cid_string, token, strlen(token)) == NULL)
-    {
-        ESP_LOGE(SIM800L_BEARER_TAG, "Store CID failed");
-        return SIM800L_RET_ERROR;
-    }
-
     /* Set CID */
-    bearer->cid = atoi(cid_string);
+    bearer->cid = atoi(token);
 
     /* Extract status */
     token = strtok(NULL, ",");
@@ -130,18 +257,11 @@ sim800l_ret_t sim800l_bearer_query(sim800l_handle_t sim800l_handle, sim800l_bear
         return SIM800L_RET_ERROR;
     }
 
-    char status_string[2] = {0};
-    if (strncpy(status_string, token, strlen(token)) == NULL)
-    {
-        ESP_LOGE(SIM800L_BEARER_TAG, "Store status failed");
-        return SIM800L_RET_ERROR;
-    }
-
     /* Set status */
-    bearer->status = atoi(status_string);
+    bearer->status = atoi(token);
 
     /* Extract ipv4 */
-    token = strtok(NULL, ",");
+    token = strtok(NULL, "\"\r\n");
     if (token == NULL)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Extracting ipv4 failed");
@@ -149,19 +269,29 @@ sim800l_ret_t sim800l_bearer_query(sim800l_handle_t sim800l_handle, sim800l_bear
     }
 
     /* Set ipv4 */    
-    if (strncpy(bearer->ipv4, token, strlen(token)) == NULL)
-    {
-        ESP_LOGE(SIM800L_BEARER_TAG, "Store ipv4 failed");
-        return SIM800L_RET_ERROR;
-    }
+    snprintf(bearer->ipv4, sizeof(bearer->ipv4), "%s", token);
 
     return SIM800L_RET_OK;
 }
 
-sim800l_ret_t sim800l_bearer_set_param(sim800l_handle_t sim800l_handle, const char* param, const char* value)
+sim800l_ret_t sim800l_bearer_profile_set_param(sim800l_handle_t sim800l_handle, uint32_t cid, const char* param, const char* value)
 {
     ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
 
+    if (!sim800l_bearer_cid_valid(cid) || (param == NULL) || (value == NULL))
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Already on the modem, nothing to send */
+    char key[SIM800L_SHADOW_KEY_SIZE] = {0};
+    sim800l_bearer_shadow_key(key, cid, param);
+    if (sim800l_shadow_unchanged(key, value))
+    {
+        return SIM800L_RET_OK;
+    }
+
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_BEARER) 
                             + strlen(param) 
@@ -179,7 +309,7 @@ sim800l_ret_t sim800l_bearer_set_param(sim800l_handle_t sim800l_handle, const ch
     }
 
     /* Assembly of the command to be sent */
-    if (snprintf((char*)command, command_length, "%s=3,1,\"%s\",\"%s\"\r\n", SIM800L_COMMAND_BEARER, param, value) < 0)
+    if (snprintf((char*)command, command_length, "%s=3,%lu,\"%s\",\"%s\"\r\n", SIM800L_COMMAND_BEARER, cid, param, value) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Assembly of the command to be sent failed");
         free(command);
@@ -187,10 +317,10 @@ sim800l_ret_t sim800l_bearer_set_param(sim800l_handle_t sim800l_handle, const ch
     }
 
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
     
     /* Send AT command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000) != ESP_OK)
+    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "sim800l_call_answer failed");
         free(command);
@@ -206,13 +336,28 @@ sim800l_ret_t sim800l_bearer_set_param(sim800l_handle_t sim800l_handle, const ch
         return SIM800L_RET_ERROR;
     }
 
+    sim800l_shadow_store(key, value);
+
     return SIM800L_RET_OK;
 }
 
-sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_bearer_param_t *param)
+sim800l_ret_t sim800l_bearer_profile_get_param(sim800l_handle_t sim800l_handle, uint32_t cid, sim800l_bearer_param_t *param)
 {
     ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
 
+    if (!sim800l_bearer_cid_valid(cid) || (param == NULL))
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Every field written or read before, no need to ask */
+    if (sim800l_bearer_shadow_get(cid, param))
+    {
+        sim800l_shadow_count_served();
+        return SIM800L_RET_OK;
+    }
+
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_BEARER) + 4*sizeof(char) + strlen("\r\n") + 1; /* cmd=d,d\r\n */
 
@@ -225,7 +370,7 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
     }
 
     /* Assembly of the command to be sent */
-    if (snprintf((char*)command, command_length, "%s=4,1\r\n", SIM800L_COMMAND_BEARER) < 0)
+    if (snprintf((char*)command, command_length, "%s=4,%lu\r\n", SIM800L_COMMAND_BEARER, cid) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Assembly of the command to be sent failed");
         free(command);
@@ -233,10 +378,10 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
     }
 
     /* Response */
-    char response[100] = {0};
+    char response[256] = {0};
     
     /* Send AT command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000) != ESP_OK)
+    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "sim800l_call_answer failed");
         free(command);
@@ -255,7 +400,7 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
     
     char *temp = token + strlen("CONTYPE: ");
 
-    if (strncpy(param->contype, temp, strlen(temp)) == NULL)
+    if (snprintf(param->contype, sizeof(param->contype), "%s", temp) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Store temp Contype failed");
         return SIM800L_RET_ERROR;
@@ -271,7 +416,7 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
 
     temp = token + strlen("APN: ");
 
-    if (strncpy(param->apn, temp, strlen(temp)) == NULL)
+    if (snprintf(param->apn, sizeof(param->apn), "%s", temp) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Store temp APN failed");
         return SIM800L_RET_ERROR;
@@ -287,7 +432,7 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
 
     temp = token + strlen("PHONENUM: ");
 
-    if (strncpy(param->phonenum, temp, strlen(temp)) == NULL)
+    if (snprintf(param->phonenum, sizeof(param->phonenum), "%s", temp) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Store temp Phone Number failed");
         return SIM800L_RET_ERROR;
@@ -303,7 +448,7 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
 
     temp = token + strlen("USER: ");
 
-    if (strncpy(param->user, temp, strlen(temp)) == NULL)
+    if (snprintf(param->user, sizeof(param->user), "%s", temp) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Store temp User failed");
         return SIM800L_RET_ERROR;
@@ -319,7 +464,7 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
 
     temp = token + strlen("PWD: ");
 
-    if (strncpy(param->pwd, temp, strlen(temp)) == NULL)
+    if (snprintf(param->pwd, sizeof(param->pwd), "%s", temp) < 0)
     {
         ESP_LOGE(SIM800L_BEARER_TAG, "Store temp PWD failed");
         return SIM800L_RET_ERROR;
@@ -338,6 +483,375 @@ sim800l_ret_t sim800l_bearer_get_param(sim800l_handle_t sim800l_handle, sim800l_
     /* Convert to int */
     param->rate = atoi(temp);
 
+    /* The modem answered for every field, later set_param calls can skip unchanged ones */
+    char rate[12] = {0};
+    snprintf(rate, sizeof(rate), "%lu", param->rate);
+
+    const char *values[SIM800L_BEARER_FIELDS] = {param->contype, param->apn, param->user, param->pwd, param->phonenum, rate};
+
+    for (uint32_t i = 0; i < SIM800L_BEARER_FIELDS; i++)
+    {
+        char key[SIM800L_SHADOW_KEY_SIZE] = {0};
+        sim800l_bearer_shadow_key(key, cid, sim800l_bearer_fields[i]);
+        sim800l_shadow_store(key, values[i]);
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_bearer_profile_config(sim800l_handle_t sim800l_handle, uint32_t cid, const sim800l_bearer_param_t *param)
+{
+    ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
+
+    if (!sim800l_bearer_cid_valid(cid) || (param == NULL))
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    char rate[12] = {0};
+    snprintf(rate, sizeof(rate), "%lu", param->rate);
+
+    const char *values[SIM800L_BEARER_FIELDS] = {param->contype, param->apn, param->user, param->pwd, param->phonenum, rate};
+
+    for (uint32_t i = 0; i < SIM800L_BEARER_FIELDS; i++)
+    {
+        /* Empty fields are the power-on default, only sent to clear a value set before */
+        char key[SIM800L_SHADOW_KEY_SIZE] = {0};
+        sim800l_bearer_shadow_key(key, cid, sim800l_bearer_fields[i]);
+
+        bool empty = (values[i][0] == '\0') || ((i == SIM800L_BEARER_FIELDS - 1) && (param->rate == 0));
+        if (empty && !sim800l_shadow_lookup(key, NULL, 0))
+        {
+            continue;
+        }
+
+        /* Unchanged fields are skipped by the shadow */
+        sim800l_ret_t ret = sim800l_bearer_profile_set_param(sim800l_handle, cid, sim800l_bearer_fields[i], values[i]);
+        if (ret != SIM800L_RET_OK)
+        {
+            return ret;
+        }
+    }
+
+    return SIM800L_RET_OK;
+}
+
+void sim800l_bearer_profile_flush(void)
+{
+    /* RDY and +CFUN clear the whole shadow, this is for resets the driver did not see */
+    sim800l_shadow_invalidate(SIM800L_BEARER_SHADOW_PREFIX);
+}
+
+sim800l_ret_t sim800l_bearer_manager_start(sim800l_handle_t sim800l_handle, const sim800l_bearer_manager_config_t *config)
+{
+    ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_bearer_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Defaults for unset fields */
+    sim800l_bearer_config.cid = ((config != NULL) && (config->cid > 0)) ? config->cid : SIM800L_BEARER_CID_DEFAULT;
+    if (!sim800l_bearer_cid_valid(sim800l_bearer_config.cid))
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Invalid CID %lu", sim800l_bearer_config.cid);
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_bearer_config.poll_interval_ms = ((config != NULL) && (config->poll_interval_ms > 0)) ? config->poll_interval_ms : SIM800L_BEARER_POLL_INTERVAL_MS;
+    sim800l_bearer_config.backoff_min_ms = ((config != NULL) && (config->backoff_min_ms > 0)) ? config->backoff_min_ms : SIM800L_BEARER_BACKOFF_MIN_MS;
+    sim800l_bearer_config.backoff_max_ms = ((config != NULL) && (config->backoff_max_ms > 0)) ? config->backoff_max_ms : SIM800L_BEARER_BACKOFF_MAX_MS;
+    if (sim800l_bearer_config.backoff_max_ms < sim800l_bearer_config.backoff_min_ms)
+    {
+        sim800l_bearer_config.backoff_max_ms = sim800l_bearer_config.backoff_min_ms;
+    }
+
+    if (sim800l_bearer_events == NULL)
+    {
+        sim800l_bearer_events = xEventGroupCreate();
+        if (sim800l_bearer_events == NULL)
+        {
+            ESP_LOGE(SIM800L_BEARER_TAG, "xEventGroupCreate failed");
+            return SIM800L_RET_ERROR_MEM;
+        }
+    }
+
+    xEventGroupClearBits(sim800l_bearer_events, SIM800L_BEARER_READY_BIT | SIM800L_BEARER_WAKE_BIT | SIM800L_BEARER_STOPPED_BIT);
+
+    /* Registration loss is usually reported before the keep-alive poll notices it */
+    if (sim800l_register_event(sim800l_handle, SIM800L_EVENT_NETWORK, sim800l_bearer_network_handler, NULL) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "sim800l_register_event failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    if (sim800l_network_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGW(SIM800L_BEARER_TAG, "+CGREG URC not enabled, relying on polling");
+    }
+
+    memset(&sim800l_bearer_stats, 0, sizeof(sim800l_bearer_stats_t));
+    sim800l_bearer_handle = sim800l_handle;
+    sim800l_bearer_state = SIM800L_BEARER_STATE_DOWN;
+    sim800l_bearer_started = esp_timer_get_time();
+    sim800l_bearer_dropped = 0;
+
+    sim800l_bearer_running = true;
+    if (xTaskCreate(sim800l_bearer_task, SIM800L_BEARER_TASK_NAME, SIM800L_BEARER_TASK_STACK_SIZE, NULL, SIM800L_BEARER_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "xTaskCreate failed");
+        sim800l_bearer_running = false;
+        sim800l_unregister_event(sim800l_handle, SIM800L_EVENT_NETWORK, sim800l_bearer_network_handler);
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_bearer_manager_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
+
+    if (!sim800l_bearer_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* The bearer is left as it is, only the supervision stops */
+    sim800l_bearer_running = false;
+    xEventGroupSetBits(sim800l_bearer_events, SIM800L_BEARER_WAKE_BIT);
+
+    /* An AT+SAPBR=1,1 in flight has to finish first */
+    if (!(xEventGroupWaitBits(sim800l_bearer_events, SIM800L_BEARER_STOPPED_BIT, pdTRUE, pdTRUE, (SIM800L_BEARER_OPEN_TIMEOUT + SIM800L_BEARER_BUSY_MS) / portTICK_PERIOD_MS) & SIM800L_BEARER_STOPPED_BIT))
+    {
+        ESP_LOGW(SIM800L_BEARER_TAG, "Manager task did not stop");
+    }
+
+    /* Registration reports stay on, the network monitor may rely on them */
+    sim800l_unregister_event(sim800l_handle, SIM800L_EVENT_NETWORK, sim800l_bearer_network_handler);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_bearer_wait_ready(sim800l_handle_t sim800l_handle, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_BEARER_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (sim800l_bearer_events == NULL))
+    {
+        ESP_LOGE(SIM800L_BEARER_TAG, "Bearer manager not started");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Not cleared on exit, every waiter sees the bearer up */
+    if (!(xEventGroupWaitBits(sim800l_bearer_events, SIM800L_BEARER_READY_BIT, pdFALSE, pdTRUE, timeout / portTICK_PERIOD_MS) & SIM800L_BEARER_READY_BIT))
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_bearer_state_t sim800l_bearer_get_state(void)
+{
+    return sim800l_bearer_state;
+}
+
+sim800l_ret_t sim800l_bearer_get_stats(sim800l_bearer_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_bearer_stats, sizeof(sim800l_bearer_stats_t));
 
     return SIM800L_RET_OK;
-}
\ No newline at end of file
+}
+
+/*
+ *     Private functions development
+ */
+static bool sim800l_bearer_cid_valid(uint32_t cid)
+{
+    return (cid >= 1) && (cid <= SIM800L_BEARER_MAX_PROFILES);
+}
+
+static void sim800l_bearer_shadow_key(char *key, uint32_t cid, const char *param)
+{
+    snprintf(key, SIM800L_SHADOW_KEY_SIZE, "%s%lu:%s", SIM800L_BEARER_SHADOW_PREFIX, cid, param);
+}
+
+static bool sim800l_bearer_shadow_get(uint32_t cid, sim800l_bearer_param_t *param)
+{
+    char *values[SIM800L_BEARER_FIELDS - 1] = {param->contype, param->apn, param->user, param->pwd, param->phonenum};
+    size_t sizes[SIM800L_BEARER_FIELDS - 1] = {sizeof(param->contype), sizeof(param->apn), sizeof(param->user), sizeof(param->pwd), sizeof(param->phonenum)};
+    char key[SIM800L_SHADOW_KEY_SIZE] = {0};
+
+    /* All or nothing, a partial answer would mix in stale fields */
+    for (uint32_t i = 0; i < SIM800L_BEARER_FIELDS; i++)
+    {
+        sim800l_bearer_shadow_key(key, cid, sim800l_bearer_fields[i]);
+        if (!sim800l_shadow_lookup(key, NULL, 0))
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < SIM800L_BEARER_FIELDS - 1; i++)
+    {
+        sim800l_bearer_shadow_key(key, cid, sim800l_bearer_fields[i]);
+        sim800l_shadow_lookup(key, values[i], sizes[i]);
+    }
+
+    char rate[12] = {0};
+    sim800l_bearer_shadow_key(key, cid, SIM800L_BEARER_RATE);
+    sim800l_shadow_lookup(key, rate, sizeof(rate));
+    param->rate = atoi(rate);
+
+    return true;
+}
+
+static void sim800l_bearer_task(void *args)
+{
+    uint32_t backoff = sim800l_bearer_config.backoff_min_ms;
+
+    while (sim800l_bearer_running)
+    {
+        uint32_t delay = sim800l_bearer_config.poll_interval_ms;
+
+        /* PPP or transparent mode owns the UART, AT commands would land in the data stream */
+        if (sim800l_data_mode_get(sim800l_bearer_handle, NULL) != SIM800L_DATA_MODE_OFF)
+        {
+            delay = SIM800L_BEARER_BUSY_MS;
+        }
+        else
+        {
+            sim800l_bearer_t bearer = {0};
+            sim800l_ret_t ret = sim800l_bearer_profile_query(sim800l_bearer_handle, sim800l_bearer_config.cid, &bearer);
+
+            /* Status 1 connected, 0 connecting */
+            if ((ret == SIM800L_RET_OK) && (bearer.status == 1))
+            {
+                if (sim800l_bearer_state != SIM800L_BEARER_STATE_UP)
+                {
+                    int64_t now = esp_timer_get_time();
+
+                    sim800l_bearer_stats.connects++;
+                    if (sim800l_bearer_stats.first_up_us == 0)
+                    {
+                        sim800l_bearer_stats.first_up_us = now - sim800l_bearer_started;
+                    }
+                    if (sim800l_bearer_dropped != 0)
+                    {
+                        sim800l_bearer_stats.last_recovery_us = now - sim800l_bearer_dropped;
+                        sim800l_bearer_dropped = 0;
+                    }
+
+                    ESP_LOGI(SIM800L_BEARER_TAG, "Bearer up, IP %s", bearer.ipv4);
+                    sim800l_bearer_set_state(SIM800L_BEARER_STATE_UP, bearer.ipv4);
+                }
+
+                backoff = sim800l_bearer_config.backoff_min_ms;
+            }
+            else if ((ret == SIM800L_RET_OK) && (bearer.status == 0))
+            {
+                /* Opened by someone else, give it time */
+                delay = SIM800L_BEARER_BUSY_MS;
+            }
+            else
+            {
+                if (sim800l_bearer_state == SIM800L_BEARER_STATE_UP)
+                {
+                    ESP_LOGW(SIM800L_BEARER_TAG, "Bearer lost");
+                    sim800l_bearer_stats.drops++;
+                    sim800l_bearer_dropped = esp_timer_get_time();
+                }
+
+                sim800l_bearer_set_state(SIM800L_BEARER_STATE_CONNECTING, NULL);
+
+                if (sim800l_bearer_profile_switch(sim800l_bearer_handle, sim800l_bearer_config.cid, true) == SIM800L_RET_OK)
+                {
+                    /* Query again right away for the IP */
+                    continue;
+                }
+
+                /* Exponential backoff with jitter, a fleet that lost the cell together does not retry together */
+                sim800l_bearer_stats.failures++;
+                sim800l_bearer_set_state(SIM800L_BEARER_STATE_BACKOFF, NULL);
+
+                delay = sim800l_bearer_jitter(backoff);
+                ESP_LOGW(SIM800L_BEARER_TAG, "Bearer open failed, retry in %lu ms", delay);
+
+                backoff = (backoff > sim800l_bearer_config.backoff_max_ms / 2) ? sim800l_bearer_config.backoff_max_ms : backoff * 2;
+            }
+        }
+
+        /* +CGREG or stop cut the wait short */
+        xEventGroupWaitBits(sim800l_bearer_events, SIM800L_BEARER_WAKE_BIT, pdTRUE, pdTRUE, delay / portTICK_PERIOD_MS);
+    }
+
+    xEventGroupSetBits(sim800l_bearer_events, SIM800L_BEARER_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+static void sim800l_bearer_set_state(sim800l_bearer_state_t state, const char *ipv4)
+{
+    if (state == sim800l_bearer_state)
+    {
+        return;
+    }
+
+    sim800l_bearer_state = state;
+
+    if (state == SIM800L_BEARER_STATE_UP)
+    {
+        xEventGroupSetBits(sim800l_bearer_events, SIM800L_BEARER_READY_BIT);
+    }
+    else
+    {
+        xEventGroupClearBits(sim800l_bearer_events, SIM800L_BEARER_READY_BIT);
+    }
+
+    sim800l_bearer_event.state = state;
+    snprintf(sim800l_bearer_event.ipv4, sizeof(sim800l_bearer_event.ipv4), "%s", (ipv4 != NULL) ? ipv4 : "");
+
+    sim800l_post_event(sim800l_bearer_handle, SIM800L_EVENT_BEARER, &sim800l_bearer_event);
+}
+
+static uint32_t sim800l_bearer_jitter(uint32_t delay)
+{
+    /* delay +-25% */
+    uint32_t spread = delay / 2;
+
+    return delay - (delay / 4) + ((spread > 0) ? (esp_random() % (spread + 1)) : 0);
+}
+
+/*
+ *     Event handlers development
+ */
+static void sim800l_bearer_network_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_network_event_t *event = (sim800l_network_event_t *)((sim800l_event_data_t *)event_data)->ptr;
+
+    /* Only GPRS registration matters to the bearer, 1 home, 5 roaming, either way the task checks it now */
+    if ((event == NULL) || (!event->gprs) || (sim800l_bearer_events == NULL))
+    {
+        return;
+    }
+
+    if ((event->stat != SIM800L_NETWORK_HOME) && (event->stat != SIM800L_NETWORK_ROAMING))
+    {
+        ESP_LOGW(SIM800L_BEARER_TAG, "GPRS registration lost (%d)", event->stat);
+    }
+
+    xEventGroupSetBits(sim800l_bearer_events, SIM800L_BEARER_WAKE_BIT);
+}
@@ -12,6 +12,7 @@
  */
 #include "sim800l_core.h"
 #include "sim800l_call.h"
+#include "sim800l_shadow.h"
 #include <esp_log.h>
 #include <string.h>
 
@@ -20,7 +21,8 @@
  */
 #define SIM800L_EVENT_CALL_RING_STR "RING"
 #define SIM800L_EVENT_CALL_IDENTIFY_STR "+CLIP"
-#define SIM800L_EVENT_CALL_NO_CARRIER_STR "NO CARRIER"
+
+#define SIM800L_CALL_SHADOW_CLIP "CLIP"
 
 
 /*
@@ -30,7 +32,6 @@
 
 sim800l_event_t sim800l_event_call_ring(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_call_identify(char **input_args, void *output_data);
-sim800l_event_t sim800l_event_call_no_carrier(char **input_args, void *output_data);
 
 /*
  *     Public functions development
@@ -56,12 +57,7 @@ sim800l_ret_t sim800l_call_switch(sim800l_handle_t sim800l_handle, bool enable)
             return SIM800L_RET_ERROR;
         }
 
-        /* Register NO CARRIER callback */
-        if (sim800l_register_callback(SIM800L_EVENT_CALL_NO_CARRIER_STR, sim800l_event_call_no_carrier) != ESP_OK)
-        {
-            ESP_LOGE(SIM800L_CALL_TAG, "sim800l_register_callback failed");
-            return SIM800L_RET_ERROR;
-        }
+        /* NO CARRIER is reported by the core, which hands it to PPP while a data call is up */
 
         return SIM800L_RET_OK;
     }
@@ -80,13 +76,6 @@ sim800l_ret_t sim800l_call_switch(sim800l_handle_t sim800l_handle, bool enable)
         return SIM800L_RET_ERROR;
     }
 
-    /* Unregister NO CARRIER callback */
-    if (sim800l_unregister_callback(SIM800L_EVENT_CALL_NO_CARRIER_STR) != ESP_OK)
-    {
-        ESP_LOGE(SIM800L_CALL_TAG, "sim800l_unregister_callback failed");
-        return SIM800L_RET_ERROR;
-    }
-
     return SIM800L_RET_OK;
 }
 
@@ -114,10 +103,10 @@ sim800l_ret_t sim800l_call_make_call(sim800l_handle_t sim800l_handle, const char
     }
 
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Send AT command */
-    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000);
+    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_CALL_TAG, "sim800l_call_make_call failed: %s", esp_err_to_name(ret));
@@ -143,13 +132,13 @@ sim800l_ret_t sim800l_call_response(sim800l_handle_t sim800l_handle, sim800l_cal
     esp_err_t ret = ESP_FAIL;
 
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Check if call_response is SIM800L_CALL_HANGUP */
     if (call_response == SIM800L_CALL_HANGUP)
     {
         /* Send AT command */
-        ret = sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_CALL_HANGUP, (uint8_t *)response, 1000);
+        ret = sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_CALL_HANGUP, (uint8_t *)response, sizeof(response), 1000);
         if (ret != ESP_OK)
         {
             ESP_LOGE(SIM800L_CALL_TAG, "sim800l_call_answer failed: %s", esp_err_to_name(ret));
@@ -158,7 +147,7 @@ sim800l_ret_t sim800l_call_response(sim800l_handle_t sim800l_handle, sim800l_cal
     }
 
     /* Send AT command */
-    ret = sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_CALL_ANSWER, (uint8_t *)response, 1000);
+    ret = sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_CALL_ANSWER, (uint8_t *)response, sizeof(response), 1000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_CALL_TAG, "sim800l_call_answer failed: %s", esp_err_to_name(ret));
@@ -178,8 +167,14 @@ sim800l_ret_t sim800l_call_line_identify(sim800l_handle_t sim800l_handle, bool e
 {
     ESP_LOGD(SIM800L_CALL_TAG, "%s", __func__);
 
+    /* Already in this state, nothing to send */
+    if (sim800l_shadow_unchanged(SIM800L_CALL_SHADOW_CLIP, enable ? "1" : "0"))
+    {
+        return SIM800L_RET_OK;
+    }
+
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_CALL_LINE_ID) + sizeof(char) + strlen("\r\n") + 1;
@@ -201,7 +196,7 @@ sim800l_ret_t sim800l_call_line_identify(sim800l_handle_t sim800l_handle, bool e
     }
 
     /* Send AT command */
-    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, 1000);
+    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, sizeof(response), 1000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_CALL_TAG, "sim800l_call_answer failed: %s", esp_err_to_name(ret));
@@ -217,6 +212,8 @@ sim800l_ret_t sim800l_call_line_identify(sim800l_handle_t sim800l_handle, bool e
         return SIM800L_RET_ERROR;
     }
 
+    sim800l_shadow_store(SIM800L_CALL_SHADOW_CLIP, enable ? "1" : "0");
+
     return SIM800L_RET_OK;
 }
 
@@ -262,10 +259,4 @@ sim800l_event_t sim800l_event_call_identify(char **input_args, void *output_data
     call_identify->type = atoi(input_args[1]);
 
     return SIM800L_EVENT_CALL_IDENTIFY;
-}
-
-sim800l_event_t sim800l_event_call_no_carrier(char **input_args, void *output_data)
-{
-    ESP_LOGD(SIM800L_CALL_TAG, "%s", __func__);
-    return SIM800L_EVENT_CALL_NO_CARRIER;
 }
\ No newline at end of file
@@ -0,0 +1,605 @@
+/*
+ * @file sim800l_ceng.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L cell environment (AT+CENG) sampling functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_ceng.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_CENG_INTERVAL_MS        60000
+#define SIM800L_CENG_BUSY_MS            100     /* Line in use, try the sample again shortly */
+#define SIM800L_CENG_RESPONSE_SIZE      512
+#define SIM800L_CENG_MAX_LINES          (SIM800L_CENG_MAX_CELLS + 3)    /* Mode line, cells, OK */
+#define SIM800L_CENG_MAX_FIELDS         12
+#define SIM800L_CENG_SERVING_FIELDS     11      /* arfcn,rxl,rxq,mcc,mnc,bsic,cellid,rla,txp,lac,TA */
+#define SIM800L_CENG_NEIGHBOUR_FIELDS   7       /* arfcn,rxl,bsic,cellid,mcc,mnc,lac */
+#define SIM800L_CENG_RECORD_SIZE        128     /* dt + count + 7 * (mask + 5 varints), worst case 118 */
+
+#define SIM800L_CENG_TASK_STACK_SIZE    4096
+#define SIM800L_CENG_TASK_PRIORITY      0       /* Diagnostics, never urgent */
+#define SIM800L_CENG_TASK_NAME          "sim800l_ceng_task"
+
+/*
+ *     Record field mask
+ */
+#define SIM800L_CENG_FIELD_MCC          BIT0
+#define SIM800L_CENG_FIELD_MNC          BIT1
+#define SIM800L_CENG_FIELD_LAC          BIT2
+#define SIM800L_CENG_FIELD_CI           BIT3
+#define SIM800L_CENG_FIELD_RXLEV        BIT4
+
+/*
+ *     Event bits
+ */
+#define SIM800L_CENG_WAKE_BIT           BIT0
+#define SIM800L_CENG_STOPPED_BIT        BIT1
+
+/*
+ *     Tag
+ */
+#define SIM800L_CENG_TAG "SIM800L CENG"
+
+/*
+ *     History, records are deltas against the previous sample, base is the sample before the first record
+ */
+static uint8_t sim800l_ceng_history[SIM800L_CENG_HISTORY_SIZE] = {0};
+static size_t sim800l_ceng_history_len = 0;
+static sim800l_ceng_sample_t sim800l_ceng_base = {0};
+static sim800l_ceng_sample_t sim800l_ceng_last = {0};
+static sim800l_ceng_stats_t sim800l_ceng_stats = {0};
+
+/*
+ *     Sampler
+ */
+static sim800l_handle_t sim800l_ceng_handle = NULL;
+static SemaphoreHandle_t sim800l_ceng_mutex = NULL;
+static EventGroupHandle_t sim800l_ceng_events = NULL;
+static volatile bool sim800l_ceng_running = false;
+static uint32_t sim800l_ceng_interval = SIM800L_CENG_INTERVAL_MS;
+
+/*
+ *     Private functions
+ */
+static void sim800l_ceng_task(void *args);
+static bool sim800l_ceng_init(void);
+static void sim800l_ceng_store(const sim800l_ceng_sample_t *sample);
+static size_t sim800l_ceng_encode(const sim800l_ceng_sample_t *previous, const sim800l_ceng_sample_t *sample, uint8_t *record);
+static size_t sim800l_ceng_decode_record(const uint8_t *record, size_t record_len, sim800l_ceng_sample_t *state);
+static size_t sim800l_ceng_put_varint(uint8_t *data, uint32_t value);
+static size_t sim800l_ceng_get_varint(const uint8_t *data, size_t data_len, uint32_t *value);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_ceng_start(sim800l_handle_t sim800l_handle, const sim800l_ceng_config_t *config)
+{
+    ESP_LOGD(SIM800L_CENG_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_ceng_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    if (!sim800l_ceng_init())
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Engineering mode on, neighbour cells with cell id */
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_ENGINEERING_MODE "=1,1\r\n", SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "AT+CENG=1,1 failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    sim800l_ceng_interval = ((config != NULL) && (config->interval_ms > 0)) ? config->interval_ms : SIM800L_CENG_INTERVAL_MS;
+
+    xEventGroupClearBits(sim800l_ceng_events, SIM800L_CENG_WAKE_BIT | SIM800L_CENG_STOPPED_BIT);
+
+    sim800l_ceng_handle = sim800l_handle;
+    sim800l_ceng_running = true;
+    if (xTaskCreate(sim800l_ceng_task, SIM800L_CENG_TASK_NAME, SIM800L_CENG_TASK_STACK_SIZE, NULL, SIM800L_CENG_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "xTaskCreate failed");
+        sim800l_ceng_running = false;
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ceng_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_CENG_TAG, "%s", __func__);
+
+    if (!sim800l_ceng_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* History is kept for a last export */
+    sim800l_ceng_running = false;
+    xEventGroupSetBits(sim800l_ceng_events, SIM800L_CENG_WAKE_BIT);
+
+    if (!(xEventGroupWaitBits(sim800l_ceng_events, SIM800L_CENG_STOPPED_BIT, pdTRUE, pdTRUE, 5000 / portTICK_PERIOD_MS) & SIM800L_CENG_STOPPED_BIT))
+    {
+        ESP_LOGW(SIM800L_CENG_TAG, "Sampler task did not stop");
+    }
+
+    sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_ENGINEERING_MODE "=0\r\n", SIM800L_EVENT_OK, 1000);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ceng_sample(sim800l_handle_t sim800l_handle, sim800l_ceng_sample_t *sample)
+{
+    ESP_LOGD(SIM800L_CENG_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (sample == NULL))
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_ceng_init())
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Response, <mode>,<Ncell> then one <cell>,"<fields>" line per cell */
+    char response[SIM800L_CENG_RESPONSE_SIZE] = {0};
+
+    if (sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_ENGINEERING_MODE "?\r\n", (uint8_t *)response, sizeof(response), 2000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "sim800l_out_data failed");
+        sim800l_ceng_stats.failed++;
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    sim800l_ret_t ret = sim800l_ceng_parse(response, sample);
+    if (ret != SIM800L_RET_OK)
+    {
+        sim800l_ceng_stats.failed++;
+        return ret;
+    }
+
+    sample->timestamp = (uint32_t)(start / 1000000);
+
+    xSemaphoreTake(sim800l_ceng_mutex, portMAX_DELAY);
+    sim800l_ceng_store(sample);
+    sim800l_ceng_stats.parse_us += (uint64_t)(esp_timer_get_time() - start);
+    xSemaphoreGive(sim800l_ceng_mutex);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ceng_parse(char *response, sim800l_ceng_sample_t *sample)
+{
+    if ((response == NULL) || (sample == NULL))
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memset(sample, 0, sizeof(sim800l_ceng_sample_t));
+
+    /* Split in place, fields point into response */
+    char *lines[SIM800L_CENG_MAX_LINES] = {0};
+    size_t lines_count = sim800l_tokenize(response, '\n', lines, SIM800L_CENG_MAX_LINES);
+    bool serving = false;
+
+    for (size_t i = 0; i < lines_count; i++)
+    {
+        /* Raw "+CENG: " lines too, sim800l_out_data already strips it */
+        char *line = lines[i];
+        char *prefix = strstr(line, "+CENG:");
+        if (prefix != NULL)
+        {
+            line = prefix + strlen("+CENG:");
+        }
+
+        char *cell[2] = {0};
+        if (sim800l_tokenize(line, ',', cell, 2) < 2)
+        {
+            continue;
+        }
+
+        /* The mode line has no quoted field list */
+        char *fields[SIM800L_CENG_MAX_FIELDS] = {0};
+        size_t fields_count = sim800l_tokenize(cell[1], ',', fields, SIM800L_CENG_MAX_FIELDS);
+        uint32_t index = strtoul(cell[0], NULL, 10);
+
+        if ((index == 0) && (fields_count >= SIM800L_CENG_SERVING_FIELDS))
+        {
+            sim800l_ceng_cell_t *serving_cell = &sample->cell[0];
+            serving_cell->rxlev = (uint8_t)strtoul(fields[1], NULL, 10);
+            serving_cell->mcc = (uint16_t)strtoul(fields[3], NULL, 10);
+            serving_cell->mnc = (uint16_t)strtoul(fields[4], NULL, 10);
+            serving_cell->ci = (uint16_t)strtoul(fields[6], NULL, 16);
+            serving_cell->lac = (uint16_t)strtoul(fields[9], NULL, 16);
+            serving = true;
+        }
+        else if ((index > 0) && (fields_count >= SIM800L_CENG_NEIGHBOUR_FIELDS) && (sample->cells < SIM800L_CENG_MAX_CELLS - 1))
+        {
+            sim800l_ceng_cell_t neighbour = {
+                .rxlev = (uint8_t)strtoul(fields[1], NULL, 10),
+                .ci = (uint16_t)strtoul(fields[3], NULL, 16),
+                .mcc = (uint16_t)strtoul(fields[4], NULL, 10),
+                .mnc = (uint16_t)strtoul(fields[5], NULL, 10),
+                .lac = (uint16_t)strtoul(fields[6], NULL, 16)};
+
+            /* Unused neighbour slots are reported with zeros or ffff */
+            if ((neighbour.mcc != 0) && (neighbour.ci != 0) && (neighbour.ci != 0xFFFF))
+            {
+                sample->cell[++sample->cells] = neighbour;
+            }
+        }
+    }
+
+    if (!serving)
+    {
+        ESP_LOGW(SIM800L_CENG_TAG, "No serving cell");
+        return SIM800L_RET_ERROR;
+    }
+
+    sample->cells++;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ceng_get_last(sim800l_ceng_sample_t *sample)
+{
+    if (sample == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if ((sim800l_ceng_mutex == NULL) || (sim800l_ceng_last.cells == 0))
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    xSemaphoreTake(sim800l_ceng_mutex, portMAX_DELAY);
+    memcpy(sample, &sim800l_ceng_last, sizeof(sim800l_ceng_sample_t));
+    xSemaphoreGive(sim800l_ceng_mutex);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ceng_export(uint8_t *buffer, size_t buffer_size, size_t *data_len)
+{
+    ESP_LOGD(SIM800L_CENG_TAG, "%s", __func__);
+
+    if ((buffer == NULL) || (data_len == NULL))
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    *data_len = 0;
+
+    if (sim800l_ceng_mutex == NULL)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Version, base record against an empty sample, then the history as stored */
+    sim800l_ceng_sample_t empty = {0};
+    uint8_t base[SIM800L_CENG_RECORD_SIZE] = {0};
+    sim800l_ret_t ret = SIM800L_RET_OK;
+
+    xSemaphoreTake(sim800l_ceng_mutex, portMAX_DELAY);
+
+    size_t base_len = sim800l_ceng_encode(&empty, &sim800l_ceng_base, base);
+    size_t total = 1 + base_len + sim800l_ceng_history_len;
+    if (total <= buffer_size)
+    {
+        buffer[0] = SIM800L_CENG_FORMAT_VERSION;
+        memcpy(buffer + 1, base, base_len);
+        memcpy(buffer + 1 + base_len, sim800l_ceng_history, sim800l_ceng_history_len);
+        *data_len = total;
+    }
+    else
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "Buffer too small, %u bytes needed", total);
+        ret = SIM800L_RET_ERROR_MEM;
+    }
+
+    xSemaphoreGive(sim800l_ceng_mutex);
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_ceng_decode(const uint8_t *data, size_t data_len, sim800l_ceng_sample_cb_t callback, void *arg)
+{
+    if ((data == NULL) || (data_len < 1) || (callback == NULL))
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (data[0] != SIM800L_CENG_FORMAT_VERSION)
+    {
+        ESP_LOGE(SIM800L_CENG_TAG, "Unknown format %u", data[0]);
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Base record sets the state, it is not a sample */
+    sim800l_ceng_sample_t state = {0};
+    size_t offset = 1;
+    size_t used = sim800l_ceng_decode_record(data + offset, data_len - offset, &state);
+    if (used == 0)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    offset += used;
+    while (offset < data_len)
+    {
+        used = sim800l_ceng_decode_record(data + offset, data_len - offset, &state);
+        if (used == 0)
+        {
+            ESP_LOGE(SIM800L_CENG_TAG, "Truncated record at %u", offset);
+            return SIM800L_RET_ERROR;
+        }
+
+        callback(&state, arg);
+        offset += used;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+void sim800l_ceng_clear(void)
+{
+    ESP_LOGD(SIM800L_CENG_TAG, "%s", __func__);
+
+    if (sim800l_ceng_mutex == NULL)
+    {
+        return;
+    }
+
+    /* After a successful upload, the next record still deltas against the last sample */
+    xSemaphoreTake(sim800l_ceng_mutex, portMAX_DELAY);
+    sim800l_ceng_base = sim800l_ceng_last;
+    sim800l_ceng_history_len = 0;
+    sim800l_ceng_stats.samples = 0;
+    sim800l_ceng_stats.bytes = 0;
+    xSemaphoreGive(sim800l_ceng_mutex);
+}
+
+sim800l_ret_t sim800l_ceng_get_stats(sim800l_ceng_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_ceng_stats, sizeof(sim800l_ceng_stats_t));
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static void sim800l_ceng_task(void *args)
+{
+    while (sim800l_ceng_running)
+    {
+        uint32_t delay = sim800l_ceng_interval;
+
+        /* Only on an idle line, same as the network monitor */
+        if ((sim800l_data_mode_get(sim800l_ceng_handle, NULL) != SIM800L_DATA_MODE_OFF) || (sim800l_lock(sim800l_ceng_handle, 0) != ESP_OK))
+        {
+            delay = SIM800L_CENG_BUSY_MS;
+        }
+        else
+        {
+            sim800l_ceng_sample_t sample = {0};
+            sim800l_ceng_sample(sim800l_ceng_handle, &sample);
+            sim800l_unlock(sim800l_ceng_handle);
+        }
+
+        /* Stop cuts the wait short */
+        xEventGroupWaitBits(sim800l_ceng_events, SIM800L_CENG_WAKE_BIT, pdTRUE, pdTRUE, delay / portTICK_PERIOD_MS);
+    }
+
+    xEventGroupSetBits(sim800l_ceng_events, SIM800L_CENG_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+static bool sim800l_ceng_init(void)
+{
+    if (sim800l_ceng_mutex == NULL)
+    {
+        sim800l_ceng_mutex = xSemaphoreCreateMutex();
+        sim800l_ceng_events = xEventGroupCreate();
+    }
+
+    return (sim800l_ceng_mutex != NULL) && (sim800l_ceng_events != NULL);
+}
+
+static void sim800l_ceng_store(const sim800l_ceng_sample_t *sample)
+{
+    uint8_t record[SIM800L_CENG_RECORD_SIZE] = {0};
+    size_t record_len = sim800l_ceng_encode(&sim800l_ceng_last, sample, record);
+
+    /* Drop the oldest records, each one moves the base forward */
+    while ((sim800l_ceng_history_len > 0) && (sim800l_ceng_history_len + record_len > SIM800L_CENG_HISTORY_SIZE))
+    {
+        size_t used = sim800l_ceng_decode_record(sim800l_ceng_history, sim800l_ceng_history_len, &sim800l_ceng_base);
+        if (used == 0)
+        {
+            used = sim800l_ceng_history_len;
+        }
+
+        memmove(sim800l_ceng_history, sim800l_ceng_history + used, sim800l_ceng_history_len - used);
+        sim800l_ceng_history_len -= used;
+        sim800l_ceng_stats.samples--;
+        sim800l_ceng_stats.evicted++;
+    }
+
+    memcpy(sim800l_ceng_history + sim800l_ceng_history_len, record, record_len);
+    sim800l_ceng_history_len += record_len;
+    sim800l_ceng_last = *sample;
+
+    sim800l_ceng_stats.samples++;
+    sim800l_ceng_stats.bytes = sim800l_ceng_history_len;
+}
+
+static size_t sim800l_ceng_encode(const sim800l_ceng_sample_t *previous, const sim800l_ceng_sample_t *sample, uint8_t *record)
+{
+    static const sim800l_ceng_cell_t empty = {0};
+
+    /* <dt varint><cells> then per cell <mask> and a zigzag varint for every changed field */
+    size_t len = sim800l_ceng_put_varint(record, sample->timestamp - previous->timestamp);
+    record[len++] = (uint8_t)sample->cells;
+
+    for (uint32_t i = 0; i < sample->cells; i++)
+    {
+        const sim800l_ceng_cell_t *cell = &sample->cell[i];
+        const sim800l_ceng_cell_t *reference = (i < previous->cells) ? &previous->cell[i] : &empty;
+        int32_t delta[5] = {
+            (int32_t)cell->mcc - reference->mcc,
+            (int32_t)cell->mnc - reference->mnc,
+            (int32_t)cell->lac - reference->lac,
+            (int32_t)cell->ci - reference->ci,
+            (int32_t)cell->rxlev - reference->rxlev};
+
+        size_t mask_offset = len++;
+        uint8_t mask = 0;
+        for (uint32_t field = 0; field < 5; field++)
+        {
+            if (delta[field] != 0)
+            {
+                mask |= (1 << field);
+                len += sim800l_ceng_put_varint(record + len, ((uint32_t)delta[field] << 1) ^ (uint32_t)(delta[field] >> 31));
+            }
+        }
+
+        record[mask_offset] = mask;
+    }
+
+    return len;
+}
+
+static size_t sim800l_ceng_decode_record(const uint8_t *record, size_t record_len, sim800l_ceng_sample_t *state)
+{
+    uint32_t dt = 0;
+    size_t len = sim800l_ceng_get_varint(record, record_len, &dt);
+    if ((len == 0) || (len >= record_len) || (record[len] > SIM800L_CENG_MAX_CELLS))
+    {
+        return 0;
+    }
+
+    uint32_t cells = record[len++];
+    sim800l_ceng_sample_t next = {
+        .timestamp = state->timestamp + dt,
+        .cells = cells};
+
+    for (uint32_t i = 0; i < cells; i++)
+    {
+        if (len >= record_len)
+        {
+            return 0;
+        }
+
+        /* Same reference as the encoder, the previous cell in the slot or an empty one */
+        sim800l_ceng_cell_t cell = {0};
+        if (i < state->cells)
+        {
+            cell = state->cell[i];
+        }
+
+        uint8_t mask = record[len++];
+        uint16_t *fields[4] = {&cell.mcc, &cell.mnc, &cell.lac, &cell.ci};
+        for (uint32_t field = 0; field < 5; field++)
+        {
+            if (!(mask & (1 << field)))
+            {
+                continue;
+            }
+
+            uint32_t zigzag = 0;
+            size_t used = sim800l_ceng_get_varint(record + len, record_len - len, &zigzag);
+            if (used == 0)
+            {
+                return 0;
+            }
+
+            len += used;
+            int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            if (field < 4)
+            {
+                *fields[field] = (uint16_t)(*fields[field] + delta);
+            }
+            else
+            {
+                cell.rxlev = (uint8_t)(cell.rxlev + delta);
+            }
+        }
+
+        next.cell[i] = cell;
+    }
+
+    *state = next;
+
+    return len;
+}
+
+static size_t sim800l_ceng_put_varint(uint8_t *data, uint32_t value)
+{
+    size_t len = 0;
+
+    while (value >= 0x80)
+    {
+        data[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    data[len++] = (uint8_t)value;
+
+    return len;
+}
+
+static size_t sim800l_ceng_get_varint(const uint8_t *data, size_t data_len, uint32_t *value)
+{
+    *value = 0;
+
+    for (size_t i = 0; (i < data_len) && (i < 5); i++)
+    {
+        *value |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80))
+        {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
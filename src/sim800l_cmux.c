@@ -0,0 +1,752 @@
+/*
+ * @file sim800l_cmux.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L GSM 07.10 multiplexer functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_cmux.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+#include <freertos/stream_buffer.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_CMUX_N1                 31      /* AT+CMUX default maximum information length */
+#define SIM800L_CMUX_FRAME_SIZE         (SIM800L_CMUX_N1 + 6)
+#define SIM800L_CMUX_RX_BUFFER_SIZE     2048
+#define SIM800L_CMUX_RX_CHUNK_SIZE      128
+#define SIM800L_CMUX_INFO_SIZE          128     /* Largest frame kept, in case the modem exceeds N1 */
+#define SIM800L_CMUX_READ_MS            20
+#define SIM800L_CMUX_TIMEOUT            1000
+#define SIM800L_CMUX_SETTLE_MS          700     /* Longer than a bridge task UART read */
+#define SIM800L_CMUX_FLOW_POLL_MS       10
+#define SIM800L_CMUX_FLOW_STOP          256     /* Free bytes left when the modem is told to stop */
+#define SIM800L_CMUX_FLOW_START         1024
+
+#define SIM800L_CMUX_TASK_STACK_SIZE    4096
+#define SIM800L_CMUX_TASK_PRIORITY      2       /* Above the bridge task */
+#define SIM800L_CMUX_TASK_NAME          "sim800l_cmux_task"
+
+/*
+ *     Frame
+ */
+#define SIM800L_CMUX_FLAG               0xF9
+#define SIM800L_CMUX_EA                 0x01
+#define SIM800L_CMUX_CR                 0x02
+#define SIM800L_CMUX_PF                 0x10
+#define SIM800L_CMUX_FCS_GOOD           0xCF
+
+#define SIM800L_CMUX_SABM               0x2F
+#define SIM800L_CMUX_UA                 0x63
+#define SIM800L_CMUX_DM                 0x0F
+#define SIM800L_CMUX_DISC               0x43
+#define SIM800L_CMUX_UIH                0xEF
+#define SIM800L_CMUX_UI                 0x03
+
+/*
+ *     Control channel messages (type octet with EA set)
+ */
+#define SIM800L_CMUX_MSG_MSC            0xE1
+#define SIM800L_CMUX_MSG_CLD            0xC1
+#define SIM800L_CMUX_MSC_FC             0x02
+#define SIM800L_CMUX_MSC_SIGNALS        0x0D    /* EA, RTC, RTR */
+
+/*
+ *     Event bits
+ */
+#define SIM800L_CMUX_UA_BIT(dlci)       (BIT0 << (dlci))
+#define SIM800L_CMUX_DM_BIT(dlci)       (BIT8 << (dlci))
+#define SIM800L_CMUX_CLD_BIT            BIT12
+
+/*
+ *     Tag
+ */
+#define SIM800L_CMUX_TAG "SIM800L CMUX"
+
+/*
+ *     Channel
+ */
+typedef struct
+{
+    bool open;
+    volatile bool remote_fc;            /* Modem asked us to stop sending */
+    volatile bool local_fc;             /* We asked the modem to stop sending */
+    StreamBufferHandle_t rx_buffer;
+} sim800l_cmux_channel_t;
+
+/*
+ *     Frame decoder
+ */
+typedef enum
+{
+    SIM800L_CMUX_DECODE_FLAG = 0,
+    SIM800L_CMUX_DECODE_ADDRESS,
+    SIM800L_CMUX_DECODE_CONTROL,
+    SIM800L_CMUX_DECODE_LENGTH,
+    SIM800L_CMUX_DECODE_LENGTH2,
+    SIM800L_CMUX_DECODE_INFO,
+    SIM800L_CMUX_DECODE_FCS,
+    SIM800L_CMUX_DECODE_END
+} sim800l_cmux_decode_state_t;
+
+typedef struct
+{
+    sim800l_cmux_decode_state_t state;
+    uint8_t address;
+    uint8_t control;
+    uint8_t fcs;
+    bool fcs_ok;
+    size_t length;
+    size_t received;
+    uint8_t info[SIM800L_CMUX_INFO_SIZE];
+} sim800l_cmux_decoder_t;
+
+static sim800l_handle_t sim800l_cmux_handle = NULL;
+static TaskHandle_t sim800l_cmux_task_handle = NULL;
+static SemaphoreHandle_t sim800l_cmux_tx_mutex = NULL;
+static EventGroupHandle_t sim800l_cmux_events = NULL;
+static volatile bool sim800l_cmux_running = false;
+static sim800l_cmux_channel_t sim800l_cmux_channels[SIM800L_CMUX_CHANNELS + 1] = {0};
+static sim800l_cmux_decoder_t sim800l_cmux_decoder = {0};
+static sim800l_cmux_stats_t sim800l_cmux_stats = {0};
+
+/*
+ *     FCS table, reversed CRC-8 x^8 + x^2 + x + 1 (GSM 07.10 annex B)
+ */
+static const uint8_t sim800l_cmux_crc_table[256] = {
+    0x00, 0x91, 0xE3, 0x72, 0x07, 0x96, 0xE4, 0x75,
+    0x0E, 0x9F, 0xED, 0x7C, 0x09, 0x98, 0xEA, 0x7B,
+    0x1C, 0x8D, 0xFF, 0x6E, 0x1B, 0x8A, 0xF8, 0x69,
+    0x12, 0x83, 0xF1, 0x60, 0x15, 0x84, 0xF6, 0x67,
+    0x38, 0xA9, 0xDB, 0x4A, 0x3F, 0xAE, 0xDC, 0x4D,
+    0x36, 0xA7, 0xD5, 0x44, 0x31, 0xA0, 0xD2, 0x43,
+    0x24, 0xB5, 0xC7, 0x56, 0x23, 0xB2, 0xC0, 0x51,
+    0x2A, 0xBB, 0xC9, 0x58, 0x2D, 0xBC, 0xCE, 0x5F,
+    0x70, 0xE1, 0x93, 0x02, 0x77, 0xE6, 0x94, 0x05,
+    0x7E, 0xEF, 0x9D, 0x0C, 0x79, 0xE8, 0x9A, 0x0B,
+    0x6C, 0xFD, 0x8F, 0x1E, 0x6B, 0xFA, 0x88, 0x19,
+    0x62, 0xF3, 0x81, 0x10, 0x65, 0xF4, 0x86, 0x17,
+    0x48, 0xD9, 0xAB, 0x3A, 0x4F, 0xDE, 0xAC, 0x3D,
+    0x46, 0xD7, 0xA5, 0x34, 0x41, 0xD0, 0xA2, 0x33,
+    0x54, 0xC5, 0xB7, 0x26, 0x53, 0xC2, 0xB0, 0x21,
+    0x5A, 0xCB, 0xB9, 0x28, 0x5D, 0xCC, 0xBE, 0x2F,
+    0xE0, 0x71, 0x03, 0x92, 0xE7, 0x76, 0x04, 0x95,
+    0xEE, 0x7F, 0x0D, 0x9C, 0xE9, 0x78, 0x0A, 0x9B,
+    0xFC, 0x6D, 0x1F, 0x8E, 0xFB, 0x6A, 0x18, 0x89,
+    0xF2, 0x63, 0x11, 0x80, 0xF5, 0x64, 0x16, 0x87,
+    0xD8, 0x49, 0x3B, 0xAA, 0xDF, 0x4E, 0x3C, 0xAD,
+    0xD6, 0x47, 0x35, 0xA4, 0xD1, 0x40, 0x32, 0xA3,
+    0xC4, 0x55, 0x27, 0xB6, 0xC3, 0x52, 0x20, 0xB1,
+    0xCA, 0x5B, 0x29, 0xB8, 0xCD, 0x5C, 0x2E, 0xBF,
+    0x90, 0x01, 0x73, 0xE2, 0x97, 0x06, 0x74, 0xE5,
+    0x9E, 0x0F, 0x7D, 0xEC, 0x99, 0x08, 0x7A, 0xEB,
+    0x8C, 0x1D, 0x6F, 0xFE, 0x8B, 0x1A, 0x68, 0xF9,
+    0x82, 0x13, 0x61, 0xF0, 0x85, 0x14, 0x66, 0xF7,
+    0xA8, 0x39, 0x4B, 0xDA, 0xAF, 0x3E, 0x4C, 0xDD,
+    0xA6, 0x37, 0x45, 0xD4, 0xA1, 0x30, 0x42, 0xD3,
+    0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1,
+    0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF,
+};
+
+/*
+ *     Private functions
+ */
+static size_t sim800l_cmux_encode(uint32_t dlci, uint8_t control, bool command, const uint8_t *info, size_t info_len, uint8_t *frame);
+static sim800l_ret_t sim800l_cmux_send_frame(uint32_t dlci, uint8_t control, bool command, const uint8_t *info, size_t info_len);
+static sim800l_ret_t sim800l_cmux_open_channel(uint32_t dlci);
+static sim800l_ret_t sim800l_cmux_send_msc(uint32_t dlci, bool flow_stop, bool command);
+static void sim800l_cmux_decode(uint8_t byte);
+static void sim800l_cmux_dispatch(void);
+static void sim800l_cmux_control(const uint8_t *info, size_t info_len);
+static int sim800l_cmux_io_write(const uint8_t *data, size_t data_len, void *arg);
+static int sim800l_cmux_io_read(uint8_t *data, size_t data_len, uint32_t timeout, void *arg);
+static void sim800l_cmux_release(void);
+
+/*
+ *     SIM800L task
+ */
+static void sim800l_cmux_task(void *args);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_cmux_start(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_CMUX_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_CMUX_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_cmux_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    sim800l_cmux_tx_mutex = xSemaphoreCreateMutex();
+    sim800l_cmux_events = xEventGroupCreate();
+    if ((sim800l_cmux_tx_mutex == NULL) || (sim800l_cmux_events == NULL))
+    {
+        ESP_LOGE(SIM800L_CMUX_TAG, "Memory allocation failed");
+        sim800l_cmux_release();
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    for (uint32_t dlci = 1; dlci <= SIM800L_CMUX_CHANNELS; dlci++)
+    {
+        sim800l_cmux_channels[dlci].rx_buffer = xStreamBufferCreate(SIM800L_CMUX_RX_BUFFER_SIZE, 1);
+        if (sim800l_cmux_channels[dlci].rx_buffer == NULL)
+        {
+            ESP_LOGE(SIM800L_CMUX_TAG, "Memory allocation failed");
+            sim800l_cmux_release();
+            return SIM800L_RET_ERROR_MEM;
+        }
+    }
+
+    /* Last command in plain AT mode */
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_CMUX, SIM800L_EVENT_OK, SIM800L_CMUX_TIMEOUT) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_CMUX_TAG, "AT+CMUX failed");
+        sim800l_cmux_release();
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    sim800l_cmux_handle = sim800l_handle;
+    memset(&sim800l_cmux_decoder, 0, sizeof(sim800l_cmux_decoder_t));
+    memset(&sim800l_cmux_stats, 0, sizeof(sim800l_cmux_stats_t));
+
+    /* The AT engine moves to its DLCI, wait for the bridge task to leave the physical UART */
+    sim800l_io_t io = {0};
+    sim800l_cmux_get_io(SIM800L_CMUX_AT_DLCI, &io);
+    sim800l_set_io(sim800l_handle, &io);
+    vTaskDelay(SIM800L_CMUX_SETTLE_MS / portTICK_PERIOD_MS);
+
+    sim800l_cmux_running = true;
+    if (xTaskCreate(sim800l_cmux_task, SIM800L_CMUX_TASK_NAME, SIM800L_CMUX_TASK_STACK_SIZE, NULL, SIM800L_CMUX_TASK_PRIORITY, &sim800l_cmux_task_handle) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_CMUX_TAG, "xTaskCreate failed");
+        sim800l_cmux_running = false;
+        sim800l_set_io(sim800l_handle, NULL);
+        sim800l_cmux_release();
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Control channel first, then the virtual UARTs */
+    for (uint32_t dlci = 0; dlci <= SIM800L_CMUX_CHANNELS; dlci++)
+    {
+        if (sim800l_cmux_open_channel(dlci) != SIM800L_RET_OK)
+        {
+            ESP_LOGE(SIM800L_CMUX_TAG, "DLCI %lu not opened", dlci);
+            sim800l_cmux_stop(sim800l_handle);
+            return SIM800L_RET_ERROR;
+        }
+    }
+
+    ESP_LOGI(SIM800L_CMUX_TAG, "Multiplexer up, AT on DLCI %d", SIM800L_CMUX_AT_DLCI);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_cmux_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_CMUX_TAG, "%s", __func__);
+
+    if (!sim800l_cmux_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Close down, the modem goes back to AT mode on the physical UART */
+    const uint8_t close_down[] = {SIM800L_CMUX_MSG_CLD | SIM800L_CMUX_CR, SIM800L_CMUX_EA};
+
+    xEventGroupClearBits(sim800l_cmux_events, SIM800L_CMUX_CLD_BIT);
+    sim800l_cmux_send_frame(0, SIM800L_CMUX_UIH, true, close_down, sizeof(close_down));
+    if (!(xEventGroupWaitBits(sim800l_cmux_events, SIM800L_CMUX_CLD_BIT, pdTRUE, pdTRUE, SIM800L_CMUX_TIMEOUT / portTICK_PERIOD_MS) & SIM800L_CMUX_CLD_BIT))
+    {
+        ESP_LOGW(SIM800L_CMUX_TAG, "No close down response");
+    }
+
+    sim800l_cmux_running = false;
+    sim800l_set_io(sim800l_handle, NULL);
+
+    /* Task and bridge task both leave their reads within the settle time */
+    vTaskDelay(SIM800L_CMUX_SETTLE_MS / portTICK_PERIOD_MS);
+
+    sim800l_cmux_release();
+
+    ESP_LOGI(SIM800L_CMUX_TAG, "Multiplexer down");
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_cmux_write(uint32_t dlci, const uint8_t *data, size_t data_len, uint32_t timeout)
+{
+    if ((dlci == 0) || (dlci > SIM800L_CMUX_CHANNELS) || (data == NULL))
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_cmux_channel_t *channel = &sim800l_cmux_channels[dlci];
+
+    if (!sim800l_cmux_running || !channel->open)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    for (size_t offset = 0; offset < data_len; offset += SIM800L_CMUX_N1)
+    {
+        /* MSC flow control from the modem */
+        uint32_t waited = 0;
+        while (channel->remote_fc)
+        {
+            if (waited >= timeout)
+            {
+                ESP_LOGW(SIM800L_CMUX_TAG, "DLCI %lu flow stopped", dlci);
+                return SIM800L_RET_ERROR;
+            }
+
+            vTaskDelay(SIM800L_CMUX_FLOW_POLL_MS / portTICK_PERIOD_MS);
+            waited += SIM800L_CMUX_FLOW_POLL_MS;
+        }
+
+        size_t length = ((data_len - offset) > SIM800L_CMUX_N1) ? SIM800L_CMUX_N1 : (data_len - offset);
+
+        if (sim800l_cmux_send_frame(dlci, SIM800L_CMUX_UIH, true, data + offset, length) != SIM800L_RET_OK)
+        {
+            return SIM800L_RET_ERROR_SEND_COMMAND;
+        }
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_cmux_read(uint32_t dlci, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout)
+{
+    if ((dlci == 0) || (dlci > SIM800L_CMUX_CHANNELS) || (buffer == NULL) || (received == NULL))
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_cmux_channel_t *channel = &sim800l_cmux_channels[dlci];
+    *received = 0;
+
+    if (channel->rx_buffer == NULL)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    *received = xStreamBufferReceive(channel->rx_buffer, buffer, buffer_size, timeout / portTICK_PERIOD_MS);
+
+    /* Drained enough, let the modem send again */
+    if (channel->local_fc && (xStreamBufferSpacesAvailable(channel->rx_buffer) >= SIM800L_CMUX_FLOW_START))
+    {
+        if (sim800l_cmux_send_msc(dlci, false, true) == SIM800L_RET_OK)
+        {
+            channel->local_fc = false;
+        }
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_cmux_get_io(uint32_t dlci, sim800l_io_t *io)
+{
+    if ((dlci == 0) || (dlci > SIM800L_CMUX_CHANNELS) || (io == NULL))
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    io->write = sim800l_cmux_io_write;
+    io->read = sim800l_cmux_io_read;
+    io->arg = (void *)(uintptr_t)dlci;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_cmux_get_stats(sim800l_cmux_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_cmux_stats, sizeof(sim800l_cmux_stats_t));
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static size_t sim800l_cmux_encode(uint32_t dlci, uint8_t control, bool command, const uint8_t *info, size_t info_len, uint8_t *frame)
+{
+    /* Basic mode: flag, address, control, length, info, FCS, flag */
+    frame[0] = SIM800L_CMUX_FLAG;
+    frame[1] = (uint8_t)((dlci << 2) | (command ? SIM800L_CMUX_CR : 0) | SIM800L_CMUX_EA);
+    frame[2] = control;
+    frame[3] = (uint8_t)((info_len << 1) | SIM800L_CMUX_EA);
+
+    if (info_len > 0)
+    {
+        memcpy(&frame[4], info, info_len);
+    }
+
+    /* FCS covers address, control and length only, for UIH as well */
+    uint8_t fcs = 0xFF;
+    for (uint32_t i = 1; i < 4; i++)
+    {
+        fcs = sim800l_cmux_crc_table[fcs ^ frame[i]];
+    }
+
+    frame[4 + info_len] = 0xFF - fcs;
+    frame[5 + info_len] = SIM800L_CMUX_FLAG;
+
+    return info_len + 6;
+}
+
+static sim800l_ret_t sim800l_cmux_send_frame(uint32_t dlci, uint8_t control, bool command, const uint8_t *info, size_t info_len)
+{
+    uint8_t frame[SIM800L_CMUX_FRAME_SIZE];
+    size_t frame_len = sim800l_cmux_encode(dlci, control, command, info, info_len, frame);
+
+    /* AT engine, data writers and the RX task (UA, MSC) share the UART */
+    xSemaphoreTake(sim800l_cmux_tx_mutex, portMAX_DELAY);
+    int ret = sim800l_uart_write_raw(sim800l_cmux_handle, frame, frame_len);
+    xSemaphoreGive(sim800l_cmux_tx_mutex);
+
+    if (ret != (int)frame_len)
+    {
+        ESP_LOGE(SIM800L_CMUX_TAG, "uart_write_bytes failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    sim800l_cmux_stats.tx_frames++;
+    sim800l_cmux_stats.tx_payload += info_len;
+    sim800l_cmux_stats.tx_wire += frame_len;
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_cmux_open_channel(uint32_t dlci)
+{
+    EventBits_t bits = SIM800L_CMUX_UA_BIT(dlci) | SIM800L_CMUX_DM_BIT(dlci);
+
+    xEventGroupClearBits(sim800l_cmux_events, bits);
+
+    if (sim800l_cmux_send_frame(dlci, SIM800L_CMUX_SABM | SIM800L_CMUX_PF, true, NULL, 0) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* UA accepts, DM refuses */
+    EventBits_t ret = xEventGroupWaitBits(sim800l_cmux_events, bits, pdTRUE, pdFALSE, SIM800L_CMUX_TIMEOUT / portTICK_PERIOD_MS);
+    if (!(ret & SIM800L_CMUX_UA_BIT(dlci)))
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_cmux_channels[dlci].open = true;
+
+    /* DTR/RTS on, some firmwares hold the channel until they see it */
+    if (dlci > 0)
+    {
+        return sim800l_cmux_send_msc(dlci, false, true);
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_cmux_send_msc(uint32_t dlci, bool flow_stop, bool command)
+{
+    const uint8_t msc[] = {
+        SIM800L_CMUX_MSG_MSC | (command ? SIM800L_CMUX_CR : 0),
+        (2 << 1) | SIM800L_CMUX_EA,
+        (uint8_t)((dlci << 2) | SIM800L_CMUX_CR | SIM800L_CMUX_EA),
+        SIM800L_CMUX_MSC_SIGNALS | (flow_stop ? SIM800L_CMUX_MSC_FC : 0)};
+
+    return sim800l_cmux_send_frame(0, SIM800L_CMUX_UIH, true, msc, sizeof(msc));
+}
+
+static void sim800l_cmux_decode(uint8_t byte)
+{
+    sim800l_cmux_decoder_t *decoder = &sim800l_cmux_decoder;
+
+    switch (decoder->state)
+    {
+    case SIM800L_CMUX_DECODE_FLAG:
+        if (byte == SIM800L_CMUX_FLAG)
+        {
+            decoder->state = SIM800L_CMUX_DECODE_ADDRESS;
+        }
+        break;
+    case SIM800L_CMUX_DECODE_ADDRESS:
+        /* Back to back flags */
+        if (byte == SIM800L_CMUX_FLAG)
+        {
+            break;
+        }
+
+        decoder->address = byte;
+        decoder->fcs = sim800l_cmux_crc_table[0xFF ^ byte];
+        decoder->state = SIM800L_CMUX_DECODE_CONTROL;
+        break;
+    case SIM800L_CMUX_DECODE_CONTROL:
+        decoder->control = byte;
+        decoder->fcs = sim800l_cmux_crc_table[decoder->fcs ^ byte];
+        decoder->state = SIM800L_CMUX_DECODE_LENGTH;
+        break;
+    case SIM800L_CMUX_DECODE_LENGTH:
+        decoder->fcs = sim800l_cmux_crc_table[decoder->fcs ^ byte];
+        decoder->length = byte >> 1;
+        decoder->received = 0;
+
+        if (!(byte & SIM800L_CMUX_EA))
+        {
+            decoder->state = SIM800L_CMUX_DECODE_LENGTH2;
+        }
+        else
+        {
+            decoder->state = (decoder->length > 0) ? SIM800L_CMUX_DECODE_INFO : SIM800L_CMUX_DECODE_FCS;
+        }
+        break;
+    case SIM800L_CMUX_DECODE_LENGTH2:
+        decoder->fcs = sim800l_cmux_crc_table[decoder->fcs ^ byte];
+        decoder->length |= (size_t)byte << 7;
+        decoder->state = (decoder->length > 0) ? SIM800L_CMUX_DECODE_INFO : SIM800L_CMUX_DECODE_FCS;
+        break;
+    case SIM800L_CMUX_DECODE_INFO:
+        /* Longer than negotiated, bytes are counted but not kept */
+        if (decoder->received < sizeof(decoder->info))
+        {
+            decoder->info[decoder->received] = byte;
+        }
+
+        if (++decoder->received >= decoder->length)
+        {
+            decoder->state = SIM800L_CMUX_DECODE_FCS;
+        }
+        break;
+    case SIM800L_CMUX_DECODE_FCS:
+        decoder->fcs_ok = (sim800l_cmux_crc_table[decoder->fcs ^ byte] == SIM800L_CMUX_FCS_GOOD);
+        decoder->state = SIM800L_CMUX_DECODE_END;
+        break;
+    case SIM800L_CMUX_DECODE_END:
+        if (byte != SIM800L_CMUX_FLAG)
+        {
+            /* Lost sync, hunt for the next flag */
+            sim800l_cmux_stats.fcs_errors++;
+            decoder->state = SIM800L_CMUX_DECODE_FLAG;
+            break;
+        }
+
+        if (!decoder->fcs_ok)
+        {
+            sim800l_cmux_stats.fcs_errors++;
+        }
+        else if (decoder->length > sizeof(decoder->info))
+        {
+            sim800l_cmux_stats.rx_dropped += decoder->length;
+        }
+        else
+        {
+            sim800l_cmux_stats.rx_frames++;
+            sim800l_cmux_stats.rx_wire += decoder->length + 6;
+            sim800l_cmux_dispatch();
+        }
+
+        /* Closing flag may open the next frame */
+        decoder->state = SIM800L_CMUX_DECODE_ADDRESS;
+        break;
+    default:
+        decoder->state = SIM800L_CMUX_DECODE_FLAG;
+        break;
+    }
+}
+
+static void sim800l_cmux_dispatch(void)
+{
+    sim800l_cmux_decoder_t *decoder = &sim800l_cmux_decoder;
+    uint32_t dlci = decoder->address >> 2;
+    uint8_t control = decoder->control & ~SIM800L_CMUX_PF;
+
+    if (dlci > SIM800L_CMUX_CHANNELS)
+    {
+        return;
+    }
+
+    sim800l_cmux_channel_t *channel = &sim800l_cmux_channels[dlci];
+
+    switch (control)
+    {
+    case SIM800L_CMUX_UA:
+        xEventGroupSetBits(sim800l_cmux_events, SIM800L_CMUX_UA_BIT(dlci));
+        break;
+    case SIM800L_CMUX_DM:
+        channel->open = false;
+        xEventGroupSetBits(sim800l_cmux_events, SIM800L_CMUX_DM_BIT(dlci));
+        break;
+    case SIM800L_CMUX_DISC:
+        channel->open = false;
+        sim800l_cmux_send_frame(dlci, SIM800L_CMUX_UA | SIM800L_CMUX_PF, false, NULL, 0);
+        break;
+    case SIM800L_CMUX_UIH:
+    case SIM800L_CMUX_UI:
+        if (dlci == 0)
+        {
+            sim800l_cmux_control(decoder->info, decoder->length);
+            break;
+        }
+
+        if (channel->rx_buffer == NULL)
+        {
+            break;
+        }
+
+        /* Never block the demultiplexer, other channels would stall */
+        size_t stored = xStreamBufferSend(channel->rx_buffer, decoder->info, decoder->length, 0);
+
+        sim800l_cmux_stats.rx_payload += stored;
+        sim800l_cmux_stats.rx_dropped += decoder->length - stored;
+
+        /* Ask the modem to hold this channel before the buffer overflows */
+        if (!channel->local_fc && (xStreamBufferSpacesAvailable(channel->rx_buffer) < SIM800L_CMUX_FLOW_STOP))
+        {
+            if (sim800l_cmux_send_msc(dlci, true, true) == SIM800L_RET_OK)
+            {
+                channel->local_fc = true;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void sim800l_cmux_control(const uint8_t *info, size_t info_len)
+{
+    if (info_len < 2)
+    {
+        return;
+    }
+
+    uint8_t type = info[0] & ~SIM800L_CMUX_CR;
+    bool command = (info[0] & SIM800L_CMUX_CR) != 0;
+
+    switch (type)
+    {
+    case SIM800L_CMUX_MSG_MSC:
+    {
+        if (!command || (info_len < 4))
+        {
+            break;
+        }
+
+        uint32_t dlci = info[2] >> 2;
+        if ((dlci == 0) || (dlci > SIM800L_CMUX_CHANNELS))
+        {
+            break;
+        }
+
+        sim800l_cmux_channels[dlci].remote_fc = (info[3] & SIM800L_CMUX_MSC_FC) != 0;
+
+        /* Echo the command back as the response */
+        uint8_t response[4];
+        memcpy(response, info, sizeof(response));
+        response[0] &= ~SIM800L_CMUX_CR;
+        sim800l_cmux_send_frame(0, SIM800L_CMUX_UIH, true, response, sizeof(response));
+        break;
+    }
+    case SIM800L_CMUX_MSG_CLD:
+        xEventGroupSetBits(sim800l_cmux_events, SIM800L_CMUX_CLD_BIT);
+        break;
+    default:
+        break;
+    }
+}
+
+static int sim800l_cmux_io_write(const uint8_t *data, size_t data_len, void *arg)
+{
+    uint32_t dlci = (uint32_t)(uintptr_t)arg;
+
+    if (sim800l_cmux_write(dlci, data, data_len, SIM800L_CMUX_TIMEOUT) != SIM800L_RET_OK)
+    {
+        return -1;
+    }
+
+    return (int)data_len;
+}
+
+static int sim800l_cmux_io_read(uint8_t *data, size_t data_len, uint32_t timeout, void *arg)
+{
+    uint32_t dlci = (uint32_t)(uintptr_t)arg;
+    size_t received = 0;
+
+    if (sim800l_cmux_read(dlci, data, data_len, &received, timeout) != SIM800L_RET_OK)
+    {
+        return -1;
+    }
+
+    return (int)received;
+}
+
+static void sim800l_cmux_release(void)
+{
+    for (uint32_t dlci = 0; dlci <= SIM800L_CMUX_CHANNELS; dlci++)
+    {
+        if (sim800l_cmux_channels[dlci].rx_buffer != NULL)
+        {
+            vStreamBufferDelete(sim800l_cmux_channels[dlci].rx_buffer);
+        }
+
+        memset(&sim800l_cmux_channels[dlci], 0, sizeof(sim800l_cmux_channel_t));
+    }
+
+    if (sim800l_cmux_events != NULL)
+    {
+        vEventGroupDelete(sim800l_cmux_events);
+        sim800l_cmux_events = NULL;
+    }
+
+    if (sim800l_cmux_tx_mutex != NULL)
+    {
+        vSemaphoreDelete(sim800l_cmux_tx_mutex);
+        sim800l_cmux_tx_mutex = NULL;
+    }
+
+    sim800l_cmux_handle = NULL;
+}
+
+/*
+ *     SIM800L task development
+ */
+static void sim800l_cmux_task(void *args)
+{
+    uint8_t chunk[SIM800L_CMUX_RX_CHUNK_SIZE];
+
+    while (sim800l_cmux_running)
+    {
+        int chunk_len = sim800l_uart_read_raw(sim800l_cmux_handle, chunk, sizeof(chunk), SIM800L_CMUX_READ_MS);
+
+        for (int i = 0; i < chunk_len; i++)
+        {
+            sim800l_cmux_decode(chunk[i]);
+        }
+    }
+
+    sim800l_cmux_task_handle = NULL;
+    vTaskDelete(NULL);
+}
@@ -13,12 +13,18 @@
 #include "sim800l_core.h"
 #include "sim800l_common.h"
 #include "sim800l_misc.h"
+#include "sim800l_shadow.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <driver/gpio.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/event_groups.h>
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/stream_buffer.h>
+#include <esp_timer.h>
 
 /*
  *     Define
@@ -41,17 +47,37 @@
 
 #define TABLE_SIZE 8
 
+#define DATA_TABLE_SIZE                 8
+#define MAX_DATA_ARGS                   4
+#define SIM800L_DATA_CHUNK_SIZE         256
+#define SIM800L_DATA_TIMEOUT_MS         1000
+#define SIM800L_DATA_TAIL_TIMEOUT_MS    20
+
+#define SIM800L_EVENT_OUTPUT_SIZE       64
+#define SIM800L_EVENT_MAX_ARGS          8       /* *PSUTTZ has 8 */
+
+#define SIM800L_DATA_MODE_BUFFER_SIZE   4096
+#define SIM800L_DATA_MODE_READ_MS       10
+#define SIM800L_DATA_MODE_SEND_MS       1000
+#define SIM800L_DATA_MODE_LINE_SIZE     16
+#define SIM800L_DATA_MODE_GUARD_MS      1000    /* Silence required around "+++" */
+#define SIM800L_DATA_MODE_MARGIN_MS     200
+#define SIM800L_DATA_MODE_ESCAPE_STR    "+++"
+
 
 /*
  *     EVENT names
  */
 #define SIM800L_EVENT_OK_STR "OK"
 #define SIM800L_EVENT_ERROR_STR "ERROR"
+#define SIM800L_EVENT_CME_ERROR_STR "+CME ERROR"
+#define SIM800L_EVENT_CMS_ERROR_STR "+CMS ERROR"
 #define SIM800L_EVENT_RDY_STR "RDY"
 #define SIM800L_EVENT_CFUN_STR "+CFUN"
 #define SIM800L_EVENT_CPIN_STR "+CPIN"
 #define SIM800L_EVENT_CALL_READY_STR "Call Ready"
 #define SIM800L_EVENT_SMS_READY_STR "SMS Ready"
+#define SIM800L_EVENT_NO_CARRIER_STR "NO CARRIER"
 
 /*
  *     Tag
@@ -74,6 +100,17 @@ struct sim800l
     esp_event_loop_handle_t sim800l_event_loop_handle;
     QueueHandle_t sim800l_queue_tx_handle;
     QueueHandle_t sim800l_queue_rx_handle;
+    volatile sim800l_data_mode_t data_mode;
+    char data_mode_enter[SIM800L_DATA_MODE_LINE_SIZE];
+    char data_mode_exit[SIM800L_DATA_MODE_LINE_SIZE];
+    StreamBufferHandle_t data_mode_buffer;
+    uint32_t data_mode_dropped;
+    sim800l_data_mode_sink_t data_mode_sink;
+    void *data_mode_sink_arg;
+    int64_t data_mode_last_tx;
+    sim800l_io_t io;                        /* Virtual UART, e.g. a CMUX channel */
+    SemaphoreHandle_t command_mutex;        /* One command (or prompt + data) on the wire at a time */
+    sim800l_wire_stats_t wire_stats;
 };
 
 /*
@@ -90,15 +127,71 @@ typedef struct sim800l_event_hash_t {
  */
 static sim800l_event_hash_t *sim800l_event_table[TABLE_SIZE] = {NULL};
 
+/*
+ *     counted data struct
+ */
+typedef struct sim800l_data_hook_t {
+    const char *header_name;
+    uint32_t length_arg;
+    sim800l_data_callback_t sim800l_data_callback;
+    void *arg;
+} sim800l_data_hook_t;
+
+/*
+ *     counted data table
+ */
+static sim800l_data_hook_t sim800l_data_table[DATA_TABLE_SIZE] = {0};
+
+/*
+ *     Modem errors
+ */
+static sim800l_error_t sim800l_last_error = {0};
+static volatile bool sim800l_error_wanted = false;      /* sim800l_error_switch(true) */
+static volatile bool sim800l_error_enabled = false;     /* AT+CMEE=1 sent since the last RDY */
+
+/*
+ *     Result format, the modem is back to echo and verbose codes after RDY
+ */
+static volatile sim800l_format_t sim800l_format_wanted = SIM800L_FORMAT_ECHO;
+static volatile sim800l_format_t sim800l_format_current = SIM800L_FORMAT_ECHO;
+
+/*
+ *     NO CARRIER owner while a data call is up, voice calls otherwise
+ */
+static sim800l_event_t (*volatile sim800l_no_carrier_callback)(char **input_args, void *output_data) = NULL;
+
+/*
+ *     ATV0 result codes, by number
+ */
+static const char *sim800l_result_names[] = {"OK", "CONNECT", "RING", "NO CARRIER", "ERROR", NULL, "NO DIALTONE", "BUSY", "NO ANSWER"};
+
+/*
+ *     Commands answered without a final result code, their info line ends them
+ */
+static const char *sim800l_unterminated_commands[] = {SIM800L_COMMAND_TCPIP_IP, NULL};
+
 /*
  *     Private functions
  */
 static esp_err_t sim800l_uart_init(sim800l_handle_t sim800l_handle);
 static uint32_t sim800l_uart_send_data(sim800l_handle_t sim800l_handle, uint8_t* data, uint32_t data_len);
 static uint32_t sim800l_uart_recv_data(sim800l_handle_t sim800l_handle, uint8_t* data, uint32_t data_len, uint32_t timeout);
-static esp_err_t sim800l_post_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, void* data);
+static esp_err_t sim800l_out_data_unlocked(sim800l_handle_t sim800l_handle, uint8_t *command, uint8_t *response, size_t response_size, uint32_t timeout);
+static esp_err_t sim800l_out_data_event_unlocked(sim800l_handle_t sim800l_handle, uint8_t *command, sim800l_event_t event, uint32_t timeout);
+static esp_err_t sim800l_out_data_raw_unlocked(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len);
 static uint32_t event_hash(const char *event_name);
 static sim800l_event_t sim800l_event_interpreter(sim800l_handle_t sim800l_handle, const char *event_name, char *event_args[]);
+static uint32_t sim800l_data_extract(sim800l_handle_t sim800l_handle, uint8_t *data, uint32_t data_len, uint32_t data_size);
+static uint32_t sim800l_data_mode_filter(sim800l_handle_t sim800l_handle, uint8_t *data, uint32_t data_len);
+static void sim800l_data_mode_push(sim800l_handle_t sim800l_handle, const uint8_t *data, uint32_t data_len);
+static esp_err_t sim800l_error_switch_unlocked(sim800l_handle_t sim800l_handle, bool enable);
+static void sim800l_error_store(sim800l_error_type_t type, const char *code);
+static void sim800l_settings_restore(sim800l_handle_t sim800l_handle, uint8_t *command);
+static esp_err_t sim800l_format_switch_unlocked(sim800l_handle_t sim800l_handle, sim800l_format_t format);
+static const char *sim800l_result_name(const char *line);
+static void sim800l_event_name(const char *line, char *event, size_t event_size);
+static bool sim800l_response_complete(const char *block, const char *command);
+static bool sim800l_response_extract(const char *block, const char *command, bool echo, char *response);
 
 /*
  *     SIM800L task
@@ -110,11 +203,14 @@ static void sim800l_bridge_task(void* args);
  */
 sim800l_event_t sim800l_event_ok(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_error(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_cme_error(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_cms_error(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_rdy(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_cfun(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_cpin(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_call_ready(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_sms_ready(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_no_carrier(char **input_args, void *output_data);
 
 /*
  *     Public functions development
@@ -260,6 +356,21 @@ esp_err_t sim800l_init(sim800l_handle_t* sim800l_handle, sim800l_config_t* sim80
         return ESP_ERR_NO_MEM;
     }
 
+    /* Create command mutex, recursive so modules can hold it around several commands */
+    sim800l_handle_temp->command_mutex = xSemaphoreCreateRecursiveMutex();
+    if (sim800l_handle_temp->command_mutex == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "xSemaphoreCreateRecursiveMutex failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Settings shadow, cleared by RDY and +CFUN */
+    if (sim800l_shadow_init() != SIM800L_RET_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_shadow_init failed");
+        return ESP_ERR_NO_MEM;
+    }
+
     /* Assign temporary handle to main handle */
     *sim800l_handle = sim800l_handle_temp;
 
@@ -336,6 +447,15 @@ esp_err_t sim800l_deinit(sim800l_handle_t sim800l_handle)
     vQueueDelete(sim800l_handle->sim800l_queue_tx_handle);
     vQueueDelete(sim800l_handle->sim800l_queue_rx_handle);
 
+    /* Delete command mutex */
+    vSemaphoreDelete(sim800l_handle->command_mutex);
+
+    /* Delete data mode buffer */
+    if (sim800l_handle->data_mode_buffer != NULL)
+    {
+        vStreamBufferDelete(sim800l_handle->data_mode_buffer);
+    }
+
     free(sim800l_handle);
     sim800l_handle = NULL;
 
@@ -408,6 +528,20 @@ esp_err_t sim800l_start(sim800l_handle_t sim800l_handle)
         return ret;
     }
 
+    ret = sim800l_register_callback(SIM800L_EVENT_CME_ERROR_STR, sim800l_event_cme_error);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_register_callback failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = sim800l_register_callback(SIM800L_EVENT_CMS_ERROR_STR, sim800l_event_cms_error);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_register_callback failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     ret = sim800l_register_callback(SIM800L_EVENT_RDY_STR, sim800l_event_rdy);
     if (ret != ESP_OK)
     {
@@ -443,6 +577,13 @@ esp_err_t sim800l_start(sim800l_handle_t sim800l_handle)
         return ret;
     }
 
+    ret = sim800l_register_callback(SIM800L_EVENT_NO_CARRIER_STR, sim800l_event_no_carrier);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_register_callback failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     /* AT command test */
     if (sim800l_command_AT(sim800l_handle) != ESP_OK)
     {
@@ -468,6 +609,13 @@ esp_err_t sim800l_start(sim800l_handle_t sim800l_handle)
     {
 
         ESP_LOGI(SIM800L_TAG, "SIM800L is ready");
+
+        /* Failures end with +CME ERROR: <n> right away, not with a timeout */
+        if (sim800l_error_switch(sim800l_handle, true) != ESP_OK)
+        {
+            ESP_LOGW(SIM800L_TAG, "sim800l_error_switch failed");
+        }
+
         return ESP_OK;
     }
     
@@ -527,6 +675,20 @@ esp_err_t sim800l_stop(sim800l_handle_t sim800l_handle)
         return ret;
     }
 
+    ret = sim800l_unregister_callback(SIM800L_EVENT_CME_ERROR_STR);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_register_callback failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = sim800l_unregister_callback(SIM800L_EVENT_CMS_ERROR_STR);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_register_callback failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     ret = sim800l_unregister_callback(SIM800L_EVENT_RDY_STR);
     if (ret != ESP_OK)
     {
@@ -562,10 +724,17 @@ esp_err_t sim800l_stop(sim800l_handle_t sim800l_handle)
         return ret;
     }
 
+    ret = sim800l_unregister_callback(SIM800L_EVENT_NO_CARRIER_STR);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_register_callback failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     return ESP_OK;
 }
 
-esp_err_t sim800l_out_data(sim800l_handle_t sim800l_handle, uint8_t *command, uint8_t *response, uint32_t timeout)
+esp_err_t sim800l_lock(sim800l_handle_t sim800l_handle, uint32_t timeout)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
@@ -575,48 +744,33 @@ esp_err_t sim800l_out_data(sim800l_handle_t sim800l_handle, uint8_t *command, ui
         ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
         return ESP_ERR_INVALID_ARG;
     }
-    
-    /* Check if data_set is NULL */
-    if (command != NULL)
-    {
-        /* Send AT command */
-        if (sim800l_uart_send_data(sim800l_handle, command, strlen((char *)command)) < 1)
-        {
-            ESP_LOGE(SIM800L_TAG, "uart_write_bytes failed");
-
-            return ESP_FAIL;
-        }
-    }
 
-    /* Check if response is NULL */
-    if (response != NULL)
+    if (xSemaphoreTakeRecursive(sim800l_handle->command_mutex, timeout / portTICK_PERIOD_MS) != pdTRUE)
     {
-        /* Send Queue */
-        if (xQueueSend(sim800l_handle->sim800l_queue_tx_handle, command, timeout) != pdPASS)
-        {
-            ESP_LOGE(SIM800L_TAG, "xQueueSend failed"); 
-            return ESP_FAIL;
-        }
-        
-        char respo_temp[MAX_PARAMS_SIZE] = {0};
+        ESP_LOGW(SIM800L_TAG, "Command lock timeout");
+        return ESP_ERR_TIMEOUT;
+    }
 
-        /* Wait for response */
-        if (xQueueReceive(sim800l_handle->sim800l_queue_rx_handle, respo_temp, timeout) != pdPASS)
-        {
-            ESP_LOGE(SIM800L_TAG, "xQueueReceive failed"); 
-            return ESP_FAIL;
-        }
+    return ESP_OK;
+}
 
-        /* Copy response */
-        memcpy(response, respo_temp, strlen(respo_temp));
+esp_err_t sim800l_unlock(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
-        return ESP_OK;
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
     }
 
+    xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
+
     return ESP_OK;
 }
 
-esp_err_t sim800l_out_data_event(sim800l_handle_t sim800l_handle, uint8_t *command, sim800l_event_t event, uint32_t timeout)
+esp_err_t sim800l_error_switch(sim800l_handle_t sim800l_handle, bool enable)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
@@ -627,40 +781,69 @@ esp_err_t sim800l_out_data_event(sim800l_handle_t sim800l_handle, uint8_t *comma
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Check if data_set is NULL */
-    if (command != NULL)
-    {
-        /* Send AT command */
-        if (sim800l_uart_send_data(sim800l_handle, command, strlen((char *)command)) < 1)
-        {
-            ESP_LOGE(SIM800L_TAG, "uart_write_bytes failed");
+    xSemaphoreTakeRecursive(sim800l_handle->command_mutex, portMAX_DELAY);
+    sim800l_error_wanted = enable;
+    esp_err_t ret = sim800l_error_switch_unlocked(sim800l_handle, enable);
+    xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
 
-            return ESP_FAIL;
-        }
-    }
+    return ret;
+}
 
-    /* Check if event group is void */
-    EventBits_t event_prev = xEventGroupGetBits(sim800l_handle->sim800l_event_group_handle);
-    if (event_prev != 0)
+esp_err_t sim800l_get_last_error(sim800l_handle_t sim800l_handle, sim800l_error_t *error)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check if handle is NULL */
+    if ((sim800l_handle == NULL) || (error == NULL))
     {
-        xEventGroupClearBits(sim800l_handle->sim800l_event_group_handle, event_prev);
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    /* Wait for response */
-    EventBits_t events_ret = xEventGroupWaitBits(sim800l_handle->sim800l_event_group_handle, (uint32_t)event, pdTRUE, pdTRUE, timeout/portTICK_PERIOD_MS);
-    if (events_ret & event)
+    /* Of the last command sent, SIM800L_ERROR_NONE when it did not fail */
+    memcpy(error, &sim800l_last_error, sizeof(sim800l_error_t));
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_format_switch(sim800l_handle_t sim800l_handle, sim800l_format_t format)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check args */
+    if ((sim800l_handle == NULL) || (format > SIM800L_FORMAT_NUMERIC))
     {
-        return ESP_OK;
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    return ESP_FAIL;
+    xSemaphoreTakeRecursive(sim800l_handle->command_mutex, portMAX_DELAY);
+    sim800l_format_wanted = format;
+    esp_err_t ret = sim800l_format_switch_unlocked(sim800l_handle, format);
+    xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
+
+    return ret;
 }
 
-esp_err_t sim800l_register_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, esp_event_handler_t sim800l_event_handler, void *sim800l_event_handler_arg)
+esp_err_t sim800l_get_wire_stats(sim800l_handle_t sim800l_handle, sim800l_wire_stats_t *stats)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
-    esp_err_t ret = ESP_OK;
+    /* Check args */
+    if ((sim800l_handle == NULL) || (stats == NULL))
+    {
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_handle->wire_stats, sizeof(sim800l_wire_stats_t));
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_reset_wire_stats(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
     /* Check if handle is NULL */
     if (sim800l_handle == NULL)
@@ -669,26 +852,52 @@ esp_err_t sim800l_register_event(sim800l_handle_t sim800l_handle, sim800l_event_
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Register event handler */
-    ret = esp_event_handler_register_with(sim800l_handle->sim800l_event_loop_handle,
-                                          SIM800L_EVENTS,
-                                          (int32_t)sim800l_event,
-                                          sim800l_event_handler,
-                                          sim800l_event_handler_arg);
-    if (ret != ESP_OK)
+    memset(&sim800l_handle->wire_stats, 0, sizeof(sim800l_wire_stats_t));
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_out_data(sim800l_handle_t sim800l_handle, uint8_t *command, uint8_t *response, size_t response_size, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
     {
-        ESP_LOGE(SIM800L_TAG, "esp_event_handler_register failed: %s", esp_err_to_name(ret));
-        return ret;
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
     }
 
+    /* Command and response are matched through shared queues, one caller at a time */
+    xSemaphoreTakeRecursive(sim800l_handle->command_mutex, portMAX_DELAY);
+    sim800l_settings_restore(sim800l_handle, command);
+    esp_err_t ret = sim800l_out_data_unlocked(sim800l_handle, command, response, response_size, timeout);
+    xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
+
     return ret;
 }
 
-esp_err_t sim800l_unregister_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, esp_event_handler_t sim800l_event_handler)
+esp_err_t sim800l_out_data_raw(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
-    esp_err_t ret = ESP_OK;
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL || (data == NULL && data_len > 0))
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(sim800l_handle->command_mutex, portMAX_DELAY);
+    esp_err_t ret = sim800l_out_data_raw_unlocked(sim800l_handle, data, data_len);
+    xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
+
+    return ret;
+}
+
+esp_err_t sim800l_out_data_event(sim800l_handle_t sim800l_handle, uint8_t *command, sim800l_event_t event, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
     /* Check if handle is NULL */
     if (sim800l_handle == NULL)
@@ -697,97 +906,740 @@ esp_err_t sim800l_unregister_event(sim800l_handle_t sim800l_handle, sim800l_even
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Unregister event handler */
-    ret = esp_event_handler_unregister_with(sim800l_handle->sim800l_event_loop_handle,
-                                            SIM800L_EVENTS,
-                                            (int32_t)sim800l_event,
-                                            sim800l_event_handler);
-    if (ret != ESP_OK)
+    /* Waiting for a URC alone does not need the line */
+    if (command == NULL)
     {
-        ESP_LOGE(SIM800L_TAG, "esp_event_handler_unregister failed: %s", esp_err_to_name(ret));
-        return ret;
+        return sim800l_out_data_event_unlocked(sim800l_handle, command, event, timeout);
     }
 
-    return ESP_OK;
+    xSemaphoreTakeRecursive(sim800l_handle->command_mutex, portMAX_DELAY);
+    sim800l_settings_restore(sim800l_handle, command);
+    esp_err_t ret = sim800l_out_data_event_unlocked(sim800l_handle, command, event, timeout);
+    xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
+
+    return ret;
 }
 
-esp_err_t sim800l_register_callback(const char *event_name, sim800l_event_t (*sim800l_event_callback)(char **input_args, void *output_data))
+esp_err_t sim800l_out_data_event_detached(sim800l_handle_t sim800l_handle, uint8_t *command, sim800l_event_t event, uint32_t timeout)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
-    /* Get event hash */
-    uint32_t index = event_hash(event_name);
-
-    /* Create new event struct */
-    sim800l_event_hash_t *new_event = calloc(1, sizeof(sim800l_event_hash_t));
-    if (new_event == NULL)
+    /* Check args */
+    if ((sim800l_handle == NULL) || (command == NULL))
     {
-        ESP_LOGE(SIM800L_TAG, "Memory allocation failed");
-        return ESP_ERR_NO_MEM;
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
     }
 
-    /* Assembly of the new event struct */
-    new_event->event_name = strdup(event_name);
-    if (new_event->event_name == NULL)
+    /* Only the command itself holds the line */
+    xSemaphoreTakeRecursive(sim800l_handle->command_mutex, portMAX_DELAY);
+    sim800l_settings_restore(sim800l_handle, command);
+
+    EventBits_t event_prev = xEventGroupGetBits(sim800l_handle->sim800l_event_group_handle);
+    if (event_prev != 0)
     {
-        ESP_LOGE(SIM800L_TAG, "Memory allocation failed");
-        free(new_event);
-        return ESP_ERR_NO_MEM;
+        xEventGroupClearBits(sim800l_handle->sim800l_event_group_handle, event_prev);
     }
 
-    /* Assembly of the new event struct */
-    new_event->sim800l_event_callback = sim800l_event_callback;
+    memset(&sim800l_last_error, 0, sizeof(sim800l_error_t));
+    uint32_t sent = sim800l_uart_send_data(sim800l_handle, command, strlen((char *)command));
 
-    /* Check if event is already registered */
-    if (sim800l_event_table[index] != NULL)
-    {   
-        /* Set chain of previous event */
-        new_event->chain = sim800l_event_table[index];
+    xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
+
+    if (sent < 1)
+    {
+        ESP_LOGE(SIM800L_TAG, "uart_write_bytes failed");
+        return ESP_FAIL;
     }
 
-    /* Set new event struct */
-    sim800l_event_table[index] = new_event;
+    /* Other commands run meanwhile and their final result ends this wait as well, the caller checks the outcome */
+    EventBits_t events_ret = xEventGroupWaitBits(sim800l_handle->sim800l_event_group_handle, (uint32_t)event | SIM800L_EVENT_ERROR, pdTRUE, pdFALSE, timeout/portTICK_PERIOD_MS);
 
-    return ESP_OK;
+    return (events_ret & event) ? ESP_OK : ESP_FAIL;
 }
 
-esp_err_t sim800l_unregister_callback(const char *event_name)
+static esp_err_t sim800l_out_data_unlocked(sim800l_handle_t sim800l_handle, uint8_t *command, uint8_t *response, size_t response_size, uint32_t timeout)
 {
-    ESP_LOGD(SIM800L_TAG, "%s", __func__);
-
-    /* Get event hash */
-    uint32_t index = event_hash(event_name);
+    int64_t start = esp_timer_get_time();
 
-    /* Get event struct */
-    sim800l_event_hash_t *event = sim800l_event_table[index];
-    sim800l_event_hash_t *prev_event = NULL;
+    /* Room for at least the terminator */
+    if (response_size == 0)
+    {
+        response = NULL;
+    }
 
-    while (event)
+    /* Check if response is NULL */
+    if (response != NULL)
     {
-        /*Check if event name is equal to event_name*/
-        if (strstr(event->event_name, event_name) != NULL)
-        {   
-            /* Check if chain is NULL */
-            if (event->chain != NULL)
-            {   
-                /* Set chain of previous event */
-                sim800l_event_table[index] = event->chain;
+        /* A command that timed out may still be pending (no echo) or answered late */
+        xQueueReset(sim800l_handle->sim800l_queue_tx_handle);
+        xQueueReset(sim800l_handle->sim800l_queue_rx_handle);
+
+        /* Send Queue, before the command so a fast answer finds it pending */
+        if (xQueueSend(sim800l_handle->sim800l_queue_tx_handle, command, timeout) != pdPASS)
+        {
+            ESP_LOGE(SIM800L_TAG, "xQueueSend failed"); 
+            return ESP_FAIL;
+        }
+    }
+
+    /* Check if data_set is NULL */
+    if (command != NULL)
+    {
+        memset(&sim800l_last_error, 0, sizeof(sim800l_error_t));
+
+        /* Send AT command */
+        if (sim800l_uart_send_data(sim800l_handle, command, strlen((char *)command)) < 1)
+        {
+            ESP_LOGE(SIM800L_TAG, "uart_write_bytes failed");
+
+            return ESP_FAIL;
+        }
+    }
+
+    /* Check if response is NULL */
+    if (response != NULL)
+    {
+        char respo_temp[MAX_PARAMS_SIZE] = {0};
+
+        /* Wait for response */
+        if (xQueueReceive(sim800l_handle->sim800l_queue_rx_handle, respo_temp, timeout) != pdPASS)
+        {
+            ESP_LOGE(SIM800L_TAG, "xQueueReceive failed"); 
+            return ESP_FAIL;
+        }
+
+        /* Copy response, "+CME ERROR: <n>" does not fit every caller */
+        size_t respo_len = strnlen(respo_temp, sizeof(respo_temp));
+        if (respo_len > response_size - 1)
+        {
+            ESP_LOGW(SIM800L_TAG, "Response truncated to %u bytes", response_size - 1);
+            respo_len = response_size - 1;
+        }
+
+        memcpy(response, respo_temp, respo_len);
+        response[respo_len] = '\0';
+    }
+
+    if (command != NULL)
+    {
+        sim800l_handle->wire_stats.commands++;
+        sim800l_handle->wire_stats.command_us += esp_timer_get_time() - start;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t sim800l_error_switch_unlocked(sim800l_handle_t sim800l_handle, bool enable)
+{
+    char command[16] = {0};
+    snprintf(command, sizeof(command), "%s=%d\r\n", SIM800L_COMMAND_ERROR_REPORT, enable ? 1 : 0);
+
+    /* Tried once per RDY, a modem that refuses is not asked before every command */
+    sim800l_error_enabled = enable;
+
+    if (sim800l_out_data_event_unlocked(sim800l_handle, (uint8_t *)command, SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "AT+CMEE failed");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static void sim800l_error_store(sim800l_error_type_t type, const char *code)
+{
+    sim800l_last_error.code = (code != NULL) ? strtoul(code, NULL, 10) : 0;
+    sim800l_last_error.type = type;
+}
+
+static void sim800l_settings_restore(sim800l_handle_t sim800l_handle, uint8_t *command)
+{
+    /* Set again before the next command, not from the bridge task */
+    if ((command == NULL) || (sim800l_handle->data_mode != SIM800L_DATA_MODE_OFF))
+    {
+        return;
+    }
+
+    /* RDY brings back AT+CMEE=0 */
+    if (sim800l_error_wanted && !sim800l_error_enabled)
+    {
+        sim800l_error_switch_unlocked(sim800l_handle, true);
+    }
+
+    /* RDY brings back echo, data mode verbose codes */
+    if (sim800l_format_current != sim800l_format_wanted)
+    {
+        sim800l_format_switch_unlocked(sim800l_handle, sim800l_format_wanted);
+    }
+}
+
+static esp_err_t sim800l_format_switch_unlocked(sim800l_handle_t sim800l_handle, sim800l_format_t format)
+{
+    char command[16] = {0};
+    snprintf(command, sizeof(command), "%s%dV%d\r\n", SIM800L_COMMAND_ECHO_MODE,
+             (format == SIM800L_FORMAT_ECHO) ? 1 : 0, (format == SIM800L_FORMAT_NUMERIC) ? 0 : 1);
+
+    /* Before the command, its own OK already comes in the new format; tried once like AT+CMEE */
+    sim800l_format_current = format;
+
+    if (sim800l_out_data_event_unlocked(sim800l_handle, (uint8_t *)command, SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "ATE/ATV failed");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static const char *sim800l_result_name(const char *line)
+{
+    /* ATV0 result codes are a lone digit */
+    if ((sim800l_format_current == SIM800L_FORMAT_NUMERIC) && (line[0] >= '0') && (line[0] <= '9') && (line[1] == '\0'))
+    {
+        uint32_t code = line[0] - '0';
+        if ((code < sizeof(sim800l_result_names) / sizeof(sim800l_result_names[0])) && (sim800l_result_names[code] != NULL))
+        {
+            return sim800l_result_names[code];
+        }
+    }
+
+    return line;
+}
+
+static void sim800l_event_name(const char *line, char *event, size_t event_size)
+{
+    /* ATV0 result code, reported under its verbose name */
+    const char *result = sim800l_result_name(line);
+    if (result != line)
+    {
+        strncpy(event, result, event_size - 1);
+        return;
+    }
+
+    /* Link event: <n>, <event>[: <arg>] */
+    if ((line[0] >= '0') && (line[0] <= '9') && (line[1] == ',') && (line[2] == ' '))
+    {
+        line += 3;
+    }
+
+    /* +<event>: and <event>: (DATA ACCEPT:<n>,<len>), or the whole line */
+    size_t event_len = strcspn(line, ":");
+    strncpy(event, line, event_len < event_size - 1 ? event_len : event_size - 1);
+}
+
+static bool sim800l_response_complete(const char *block, const char *command)
+{
+    char block_temp[MAX_PARAMS_SIZE] = {0};
+    strncpy(block_temp, block, MAX_PARAMS_SIZE - 1);
+
+    /* Only a command without a final result code is ended by a line no URC owns, for the rest that is an unregistered URC */
+    bool unterminated = false;
+    for (uint32_t i = 0; sim800l_unterminated_commands[i] != NULL; i++)
+    {
+        unterminated |= (strcmp(command, sim800l_unterminated_commands[i]) == 0);
+    }
+
+    bool unknown = false;
+    char *save = NULL;
+    char *token = strtok_r(block_temp, "\r\n", &save);
+    while (token != NULL)
+    {
+        const char *line = sim800l_result_name(token);
+        if ((strcmp(line, SIM800L_EVENT_OK_STR) == 0) || (strcmp(line, SIM800L_EVENT_ERROR_STR) == 0) ||
+            (strncmp(line, SIM800L_EVENT_CME_ERROR_STR, strlen(SIM800L_EVENT_CME_ERROR_STR)) == 0) ||
+            (strncmp(line, SIM800L_EVENT_CMS_ERROR_STR, strlen(SIM800L_EVENT_CMS_ERROR_STR)) == 0))
+        {
+            return true;
+        }
+
+        /* Same event name as the line parser */
+        char event[25] = {0};
+        sim800l_event_name(token, event, sizeof(event));
+
+        bool owned = false;
+        for (sim800l_event_hash_t *entry = sim800l_event_table[event_hash(event)]; entry != NULL; entry = entry->chain)
+        {
+            owned |= (strcmp(entry->event_name, event) == 0);
+        }
+
+        unknown |= !owned;
+        token = strtok_r(NULL, "\r\n", &save);
+    }
+
+    return unterminated && unknown;
+}
+
+static bool sim800l_response_extract(const char *block, const char *command, bool echo, char *response)
+{
+    char block_temp[MAX_PARAMS_SIZE] = {0};
+    strncpy(block_temp, block, MAX_PARAMS_SIZE - 1);
+
+    char *save = NULL;
+    char *token_respose = strtok_r(block_temp, "\r\n", &save);
+
+    /* Check if the token is a command, without echo one still comes right after a restart */
+    if ((token_respose != NULL) && (echo || (strncmp(token_respose, "AT", 2) == 0)) &&
+        (strnstr(command, token_respose, strlen(command)) != NULL))
+    {
+        token_respose = strtok_r(NULL, "\r\n", &save);
+    }
+    else if (echo)
+    {
+        return false;
+    }
+
+    /* Extract response */
+    while (token_respose != NULL)
+    {
+        /* ATV0 codes are given to the callers by name */
+        const char *line = sim800l_result_name(token_respose);
+
+        /* Recorded before the caller wakes up, the callback runs after the response is queued */
+        if (strncmp(line, SIM800L_EVENT_CME_ERROR_STR, strlen(SIM800L_EVENT_CME_ERROR_STR)) == 0)
+        {
+            sim800l_error_store(SIM800L_ERROR_CME, line + strlen(SIM800L_EVENT_CME_ERROR_STR) + 1);
+        }
+        else if (strncmp(line, SIM800L_EVENT_CMS_ERROR_STR, strlen(SIM800L_EVENT_CMS_ERROR_STR)) == 0)
+        {
+            sim800l_error_store(SIM800L_ERROR_CMS, line + strlen(SIM800L_EVENT_CMS_ERROR_STR) + 1);
+        }
+        else if (strcmp(line, SIM800L_EVENT_ERROR_STR) == 0)
+        {
+            sim800l_error_store(SIM800L_ERROR_PLAIN, NULL);
+        }
+        /* Check if token starts with '+', "+CME ERROR: <n>" stays whole for the "ERROR" checks */
+        else if (line[0] == '+')
+        {
+            /* Remove '+<>:' */
+            const char *result_find = strchr(line, ':');
+            if (result_find != NULL)
+            {
+                line = result_find + 1;
+            }
+        }
+
+        /* Add token and '\r\n' to response */
+        strncat(response, line, MAX_PARAMS_SIZE - strlen(response) - 1);
+        strncat(response, "\r\n", MAX_PARAMS_SIZE - strlen(response) - 1);
+
+        /* Get next token */
+        token_respose = strtok_r(NULL, "\r\n", &save);
+    }
+
+    return true;
+}
+
+static esp_err_t sim800l_out_data_raw_unlocked(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len)
+{
+    /* Send binary payload, no echo is expected after a data prompt */
+    size_t sent = 0;
+    while (sent < data_len)
+    {
+        int ret = (int)sim800l_uart_send_data(sim800l_handle, (uint8_t *)data + sent, data_len - sent);
+        if (ret < 1)
+        {
+            ESP_LOGE(SIM800L_TAG, "uart_write_bytes failed");
+            return ESP_FAIL;
+        }
+
+        sent += ret;
+    }
+
+    /* Escape guard time reference */
+    sim800l_handle->data_mode_last_tx = esp_timer_get_time();
+
+    return ESP_OK;
+}
+
+static esp_err_t sim800l_out_data_event_unlocked(sim800l_handle_t sim800l_handle, uint8_t *command, sim800l_event_t event, uint32_t timeout)
+{
+    int64_t start = esp_timer_get_time();
+
+    /* Check if event group is void, before the command so a fast answer is not lost */
+    EventBits_t event_prev = xEventGroupGetBits(sim800l_handle->sim800l_event_group_handle);
+    if (event_prev != 0)
+    {
+        xEventGroupClearBits(sim800l_handle->sim800l_event_group_handle, event_prev);
+    }
+
+    /* Check if data_set is NULL */
+    if (command != NULL)
+    {
+        memset(&sim800l_last_error, 0, sizeof(sim800l_error_t));
+
+        /* Send AT command */
+        if (sim800l_uart_send_data(sim800l_handle, command, strlen((char *)command)) < 1)
+        {
+            ESP_LOGE(SIM800L_TAG, "uart_write_bytes failed");
+
+            return ESP_FAIL;
+        }
+    }
+
+    /* A URC wait has no final result code of its own, someone else's ERROR is not ours */
+    if ((command == NULL) || (event & SIM800L_EVENT_ERROR))
+    {
+        EventBits_t events_ret = xEventGroupWaitBits(sim800l_handle->sim800l_event_group_handle, (uint32_t)event, pdTRUE, pdTRUE, timeout/portTICK_PERIOD_MS);
+
+        return (events_ret & event) ? ESP_OK : ESP_FAIL;
+    }
+
+    /* Wait for response, ERROR / +CME ERROR / +CMS ERROR end the command right away */
+    EventBits_t events_ret = xEventGroupWaitBits(sim800l_handle->sim800l_event_group_handle, (uint32_t)event | SIM800L_EVENT_ERROR, pdTRUE, pdFALSE, timeout/portTICK_PERIOD_MS);
+    sim800l_handle->wire_stats.commands++;
+    sim800l_handle->wire_stats.command_us += esp_timer_get_time() - start;
+    if (events_ret & event)
+    {
+        return ESP_OK;
+    }
+
+    if (events_ret & SIM800L_EVENT_ERROR)
+    {
+        ESP_LOGW(SIM800L_TAG, "Command failed, error %d code %lu", sim800l_last_error.type, sim800l_last_error.code);
+    }
+
+    return ESP_FAIL;
+}
+
+esp_err_t sim800l_set_io(sim800l_handle_t sim800l_handle, const sim800l_io_t *io)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* NULL goes back to the physical UART */
+    if (io == NULL)
+    {
+        memset(&sim800l_handle->io, 0, sizeof(sim800l_io_t));
+        return ESP_OK;
+    }
+
+    if ((io->write == NULL) || (io->read == NULL))
+    {
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memcpy(&sim800l_handle->io, io, sizeof(sim800l_io_t));
+
+    return ESP_OK;
+}
+
+int sim800l_uart_write_raw(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len)
+{
+    /* Always the physical UART, for whoever implements the virtual one */
+    return uart_write_bytes(sim800l_handle->config->sim800l_uart_port, data, data_len);
+}
+
+int sim800l_uart_read_raw(sim800l_handle_t sim800l_handle, uint8_t *data, size_t data_len, uint32_t timeout)
+{
+    return uart_read_bytes(sim800l_handle->config->sim800l_uart_port, data, data_len, timeout / portTICK_PERIOD_MS);
+}
+
+esp_err_t sim800l_data_mode_arm(sim800l_handle_t sim800l_handle, const char *enter_line, const char *exit_line, bool flush)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check args */
+    if ((sim800l_handle == NULL) || (enter_line == NULL) || (exit_line == NULL) ||
+        (strlen(enter_line) >= SIM800L_DATA_MODE_LINE_SIZE) || (strlen(exit_line) >= SIM800L_DATA_MODE_LINE_SIZE))
+    {
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Raw bytes are handed over through a stream buffer, unless a sink takes them */
+    if ((sim800l_handle->data_mode_sink == NULL) && (sim800l_handle->data_mode_buffer == NULL))
+    {
+        sim800l_handle->data_mode_buffer = xStreamBufferCreate(SIM800L_DATA_MODE_BUFFER_SIZE, 1);
+        if (sim800l_handle->data_mode_buffer == NULL)
+        {
+            ESP_LOGE(SIM800L_TAG, "xStreamBufferCreate failed");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    else if ((sim800l_handle->data_mode_buffer != NULL) && flush)
+    {
+        /* New session, unread bytes of the previous one are stale */
+        xStreamBufferReset(sim800l_handle->data_mode_buffer);
+    }
+
+    /* Enter and exit lines are matched as text, verbose codes until data mode is over */
+    if ((sim800l_format_current == SIM800L_FORMAT_NUMERIC) && (sim800l_handle->data_mode == SIM800L_DATA_MODE_OFF))
+    {
+        xSemaphoreTakeRecursive(sim800l_handle->command_mutex, portMAX_DELAY);
+        sim800l_format_switch_unlocked(sim800l_handle, SIM800L_FORMAT_QUIET);
+        xSemaphoreGiveRecursive(sim800l_handle->command_mutex);
+    }
+
+    strcpy(sim800l_handle->data_mode_enter, enter_line);
+    strcpy(sim800l_handle->data_mode_exit, exit_line);
+    sim800l_handle->data_mode_dropped = 0;
+
+    /* The bridge task switches to raw once it sees enter_line */
+    sim800l_handle->data_mode = SIM800L_DATA_MODE_ARMED;
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_data_mode_exit(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Next block goes through the line parser */
+    sim800l_handle->data_mode = SIM800L_DATA_MODE_OFF;
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_data_mode_escape(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (sim800l_handle->data_mode != SIM800L_DATA_MODE_ON)
+    {
+        return ESP_OK;
+    }
+
+    /* Guard time before "+++" */
+    int64_t idle_ms = (esp_timer_get_time() - sim800l_handle->data_mode_last_tx) / 1000;
+    if (idle_ms < SIM800L_DATA_MODE_GUARD_MS)
+    {
+        vTaskDelay((SIM800L_DATA_MODE_GUARD_MS - idle_ms) / portTICK_PERIOD_MS);
+    }
+
+    if (sim800l_out_data_raw(sim800l_handle, (const uint8_t *)SIM800L_DATA_MODE_ESCAPE_STR, strlen(SIM800L_DATA_MODE_ESCAPE_STR)) != ESP_OK)
+    {
+        return ESP_FAIL;
+    }
+
+    /* Guard time after "+++", the parser takes over just before OK is due */
+    vTaskDelay((SIM800L_DATA_MODE_GUARD_MS - SIM800L_DATA_MODE_MARGIN_MS) / portTICK_PERIOD_MS);
+    sim800l_handle->data_mode = SIM800L_DATA_MODE_OFF;
+
+    if (sim800l_out_data_event(sim800l_handle, NULL, SIM800L_EVENT_OK, SIM800L_DATA_MODE_GUARD_MS) != ESP_OK)
+    {
+        /* OK may have raced the event wait, make sure the modem is in command mode */
+        if (sim800l_command_AT(sim800l_handle) != SIM800L_RET_OK)
+        {
+            ESP_LOGE(SIM800L_TAG, "Escape failed");
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_data_mode_set_sink(sim800l_handle_t sim800l_handle, sim800l_data_mode_sink_t sink, void *arg)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Only while the bridge task is not pushing */
+    if (sim800l_handle->data_mode != SIM800L_DATA_MODE_OFF)
+    {
+        ESP_LOGE(SIM800L_TAG, "Data mode active");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sim800l_handle->data_mode_sink = sink;
+    sim800l_handle->data_mode_sink_arg = arg;
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_data_mode_read(sim800l_handle_t sim800l_handle, uint8_t *data, size_t data_size, size_t *data_len, uint32_t timeout)
+{
+    /* Check args */
+    if ((sim800l_handle == NULL) || (data == NULL) || (data_len == NULL))
+    {
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *data_len = 0;
+
+    if (sim800l_handle->data_mode_buffer == NULL)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* Whatever is left after the exit line is still readable */
+    *data_len = xStreamBufferReceive(sim800l_handle->data_mode_buffer, data, data_size, timeout / portTICK_PERIOD_MS);
+
+    if ((*data_len == 0) && (sim800l_handle->data_mode == SIM800L_DATA_MODE_OFF))
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    return ESP_OK;
+}
+
+sim800l_data_mode_t sim800l_data_mode_get(sim800l_handle_t sim800l_handle, uint32_t *dropped)
+{
+    if (sim800l_handle == NULL)
+    {
+        return SIM800L_DATA_MODE_OFF;
+    }
+
+    if (dropped != NULL)
+    {
+        *dropped = sim800l_handle->data_mode_dropped;
+    }
+
+    return sim800l_handle->data_mode;
+}
+
+esp_err_t sim800l_register_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, esp_event_handler_t sim800l_event_handler, void *sim800l_event_handler_arg)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    esp_err_t ret = ESP_OK;
+
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Register event handler */
+    ret = esp_event_handler_register_with(sim800l_handle->sim800l_event_loop_handle,
+                                          SIM800L_EVENTS,
+                                          (int32_t)sim800l_event,
+                                          sim800l_event_handler,
+                                          sim800l_event_handler_arg);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "esp_event_handler_register failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    return ret;
+}
+
+esp_err_t sim800l_unregister_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, esp_event_handler_t sim800l_event_handler)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    esp_err_t ret = ESP_OK;
+
+    /* Check if handle is NULL */
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "sim800l_handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Unregister event handler */
+    ret = esp_event_handler_unregister_with(sim800l_handle->sim800l_event_loop_handle,
+                                            SIM800L_EVENTS,
+                                            (int32_t)sim800l_event,
+                                            sim800l_event_handler);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TAG, "esp_event_handler_unregister failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_register_callback(const char *event_name, sim800l_event_t (*sim800l_event_callback)(char **input_args, void *output_data))
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Get event hash */
+    uint32_t index = event_hash(event_name);
+
+    /* Create new event struct */
+    sim800l_event_hash_t *new_event = calloc(1, sizeof(sim800l_event_hash_t));
+    if (new_event == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "Memory allocation failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Assembly of the new event struct */
+    new_event->event_name = strdup(event_name);
+    if (new_event->event_name == NULL)
+    {
+        ESP_LOGE(SIM800L_TAG, "Memory allocation failed");
+        free(new_event);
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Assembly of the new event struct */
+    new_event->sim800l_event_callback = sim800l_event_callback;
+
+    /* Check if event is already registered */
+    if (sim800l_event_table[index] != NULL)
+    {   
+        /* Set chain of previous event */
+        new_event->chain = sim800l_event_table[index];
+    }
+
+    /* Set new event struct */
+    sim800l_event_table[index] = new_event;
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_unregister_callback(const char *event_name)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Get event hash */
+    uint32_t index = event_hash(event_name);
+
+    /* Get event struct */
+    sim800l_event_hash_t *event = sim800l_event_table[index];
+    sim800l_event_hash_t *prev_event = NULL;
+
+    while (event)
+    {
+        /* Check if event name is equal to event_name, buckets are shared ("OK" and "CLOSE OK") */
+        if (strcmp(event->event_name, event_name) == 0)
+        {   
+            /* Unlink, the other events of the bucket stay chained */
+            if (prev_event != NULL)
+            {
+                prev_event->chain = event->chain;
             }
             else
             {
-                /* Clear table */
-                sim800l_event_table[index] = NULL;
+                sim800l_event_table[index] = event->chain;
             }
-            
+
             /* Free event struct */
+            free((void *)event->event_name);
             free(event);
-            event = NULL;
-
-            /* Clear chain of previous event */
-            if (prev_event != NULL)
-            {
-                prev_event->chain = NULL;
-            }
 
             return ESP_OK;
         }
@@ -802,6 +1654,135 @@ esp_err_t sim800l_unregister_callback(const char *event_name)
     return ESP_OK;
 }
 
+esp_err_t sim800l_set_no_carrier_callback(sim800l_event_t (*sim800l_event_callback)(char **input_args, void *output_data))
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* One data call at a time, NULL hands NO CARRIER back to voice calls */
+    if ((sim800l_event_callback != NULL) && (sim800l_no_carrier_callback != NULL) && (sim800l_no_carrier_callback != sim800l_event_callback))
+    {
+        ESP_LOGE(SIM800L_TAG, "NO CARRIER already owned");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sim800l_no_carrier_callback = sim800l_event_callback;
+
+    return ESP_OK;
+}
+
+esp_err_t sim800l_register_data_callback(const char *header_name, uint32_t length_arg, sim800l_data_callback_t sim800l_data_callback, void *arg)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Check args */
+    if ((header_name == NULL) || (sim800l_data_callback == NULL) || (length_arg >= MAX_DATA_ARGS))
+    {
+        ESP_LOGE(SIM800L_TAG, "Invalid argument");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Update the header if it is already registered */
+    for (uint32_t i = 0; i < DATA_TABLE_SIZE; i++)
+    {
+        if ((sim800l_data_table[i].header_name != NULL) && (strcmp(sim800l_data_table[i].header_name, header_name) == 0))
+        {
+            sim800l_data_table[i].length_arg = length_arg;
+            sim800l_data_table[i].sim800l_data_callback = sim800l_data_callback;
+            sim800l_data_table[i].arg = arg;
+
+            return ESP_OK;
+        }
+    }
+
+    /* Look for a free slot */
+    for (uint32_t i = 0; i < DATA_TABLE_SIZE; i++)
+    {
+        if (sim800l_data_table[i].header_name == NULL)
+        {
+            sim800l_data_table[i].header_name = strdup(header_name);
+            if (sim800l_data_table[i].header_name == NULL)
+            {
+                ESP_LOGE(SIM800L_TAG, "Memory allocation failed");
+                return ESP_ERR_NO_MEM;
+            }
+
+            sim800l_data_table[i].length_arg = length_arg;
+            sim800l_data_table[i].sim800l_data_callback = sim800l_data_callback;
+            sim800l_data_table[i].arg = arg;
+
+            return ESP_OK;
+        }
+    }
+
+    ESP_LOGE(SIM800L_TAG, "Data table is full");
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t sim800l_unregister_data_callback(const char *header_name)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    for (uint32_t i = 0; i < DATA_TABLE_SIZE; i++)
+    {
+        if ((sim800l_data_table[i].header_name != NULL) && (strcmp(sim800l_data_table[i].header_name, header_name) == 0))
+        {
+            free((void *)sim800l_data_table[i].header_name);
+            memset(&sim800l_data_table[i], 0, sizeof(sim800l_data_hook_t));
+        }
+    }
+
+    return ESP_OK;
+}
+
+size_t sim800l_tokenize(char *input, char delimiter, char **tokens, size_t max_tokens)
+{
+    size_t count = 0;
+
+    if ((input == NULL) || (tokens == NULL))
+    {
+        return 0;
+    }
+
+    /* In place: delimiters become '\0', quoted fields keep their delimiters and lose the quotes, empty fields are kept */
+    char *cursor = input;
+    while (count < max_tokens)
+    {
+        while (*cursor == ' ')
+        {
+            cursor++;
+        }
+
+        char *end = NULL;
+        if (*cursor == '"')
+        {
+            tokens[count++] = ++cursor;
+            end = strchr(cursor, '"');
+            if (end == NULL)
+            {
+                break;
+            }
+
+            *end++ = '\0';
+            end = strchr(end, delimiter);
+        }
+        else
+        {
+            tokens[count++] = cursor;
+            end = strchr(cursor, delimiter);
+        }
+
+        if (end == NULL)
+        {
+            break;
+        }
+
+        *end = '\0';
+        cursor = end + 1;
+    }
+
+    return count;
+}
+
 /*
  *     Private functions development
  */
@@ -860,18 +1841,35 @@ static uint32_t sim800l_uart_send_data(sim800l_handle_t sim800l_handle, uint8_t
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
+    /* Virtual UART */
+    if (sim800l_handle->io.write != NULL)
+    {
+        int ret = sim800l_handle->io.write(data, data_len, sim800l_handle->io.arg);
+        sim800l_handle->wire_stats.tx_bytes += (ret > 0) ? ret : 0;
+        return (ret > 0) ? (uint32_t)ret : 0;
+    }
+
     /* Send data to sim800l uart */
-    return uart_write_bytes (sim800l_handle->config->sim800l_uart_port, data, data_len);
+    int ret = uart_write_bytes (sim800l_handle->config->sim800l_uart_port, data, data_len);
+    sim800l_handle->wire_stats.tx_bytes += (ret > 0) ? ret : 0;
+    return (ret > 0) ? (uint32_t)ret : 0;
 }
 
 static uint32_t sim800l_uart_recv_data(sim800l_handle_t sim800l_handle, uint8_t *data, uint32_t data_len, uint32_t timeout)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
+    /* Virtual UART */
+    if (sim800l_handle->io.read != NULL)
+    {
+        int ret = sim800l_handle->io.read(data, data_len, timeout, sim800l_handle->io.arg);
+        return (ret > 0) ? (uint32_t)ret : 0;
+    }
+
     return uart_read_bytes (sim800l_handle->config->sim800l_uart_port, data, data_len, timeout / portTICK_PERIOD_MS);
 }
 
-static esp_err_t sim800l_post_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, void* data)
+esp_err_t sim800l_post_event(sim800l_handle_t sim800l_handle, sim800l_event_t sim800l_event, void* data)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
@@ -939,21 +1937,22 @@ static sim800l_event_t sim800l_event_interpreter(sim800l_handle_t sim800l_handle
 
     while (event)
     {
-        /*Check if event name is equal to event_name*/
-        if (strstr(event->event_name, event_name) != NULL)
+        /* Check if event name is equal to event_name, buckets are shared ("OK" and "CLOSE OK") */
+        if (strcmp(event->event_name, event_name) == 0)
         {
             /* event callback */
             if (event->sim800l_event_callback != NULL)
             {   
-                void *output = {0};
+                /* Output storage, large enough for any event struct */
+                uint32_t output[SIM800L_EVENT_OUTPUT_SIZE / sizeof(uint32_t)] = {0};
 
-                sim800l_event_t ret = event->sim800l_event_callback((char**)event_args, &output);
+                sim800l_event_t ret = event->sim800l_event_callback((char**)event_args, output);
 
                 /* Set eventgroup */
                 xEventGroupSetBits(sim800l_handle->sim800l_event_group_handle, ret);
 
                 /* Post event with args */
-                if (sim800l_post_event(sim800l_handle, ret, &output) != ESP_OK)
+                if (sim800l_post_event(sim800l_handle, ret, output) != ESP_OK)
                 {
                     ESP_LOGE(SIM800L_TAG, "sim800l_post_event failed");
                     return -1;
@@ -970,6 +1969,230 @@ static sim800l_event_t sim800l_event_interpreter(sim800l_handle_t sim800l_handle
     return -1;
 }
 
+/*
+ * SIM800L counted data extraction
+ *
+ * @brief Removes the raw payload that follows a registered header ("+HTTPREAD: <len>")
+ *        from the received block and hands it to the data callback, so binary data
+ *        never reaches the line parser. Returns the new length of the block.
+ *
+ */
+static uint32_t sim800l_data_extract(sim800l_handle_t sim800l_handle, uint8_t *data, uint32_t data_len, uint32_t data_size)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    uint32_t position = 0;
+
+    while (position < data_len)
+    {
+        /* Header must start a line */
+        if ((position != 0) && (data[position - 1] != '\n'))
+        {
+            position++;
+            continue;
+        }
+
+        /* Look for a registered header */
+        sim800l_data_hook_t *hook = NULL;
+        for (uint32_t i = 0; i < DATA_TABLE_SIZE; i++)
+        {
+            if (sim800l_data_table[i].header_name == NULL)
+            {
+                continue;
+            }
+
+            uint32_t header_len = strlen(sim800l_data_table[i].header_name);
+            if ((data_len - position >= header_len) && (memcmp(data + position, sim800l_data_table[i].header_name, header_len) == 0))
+            {
+                hook = &sim800l_data_table[i];
+                break;
+            }
+        }
+
+        if (hook == NULL)
+        {
+            position++;
+            continue;
+        }
+
+        /* Make sure the whole header line was received */
+        uint8_t *line_end = memchr(data + position, '\n', data_len - position);
+        if ((line_end == NULL) && (data_len < data_size))
+        {
+            uint32_t tail_len = sim800l_uart_recv_data(sim800l_handle, data + data_len, data_size - data_len, SIM800L_DATA_TAIL_TIMEOUT_MS);
+            if (tail_len <= data_size - data_len)
+            {
+                data_len += tail_len;
+            }
+            line_end = memchr(data + position, '\n', data_len - position);
+        }
+
+        if (line_end == NULL)
+        {
+            ESP_LOGE(SIM800L_TAG, "Incomplete data header");
+            return data_len;
+        }
+
+        /* Extract args (<header>: a,b,c or <header>,a,b:) */
+        uint32_t args[MAX_DATA_ARGS] = {0};
+        uint32_t num_args = 0;
+        uint8_t *cursor = data + position + strlen(hook->header_name);
+        while ((cursor < line_end) && (num_args < MAX_DATA_ARGS))
+        {
+            if ((*cursor >= '0') && (*cursor <= '9'))
+            {
+                args[num_args] = (uint32_t)strtoul((const char *)cursor, (char **)&cursor, 10);
+                num_args++;
+                continue;
+            }
+
+            cursor++;
+        }
+
+        uint32_t payload_start = (line_end - data) + 1;
+
+        /* Header without length (e.g. "+CIPRXGET: 1,0"), leave it to the line parser */
+        if (num_args <= hook->length_arg)
+        {
+            position = payload_start;
+            continue;
+        }
+
+        uint32_t payload_len = args[hook->length_arg];
+        uint32_t available = data_len - payload_start;
+
+        if (available >= payload_len)
+        {
+            /* Whole payload is in the block */
+            hook->sim800l_data_callback(args, num_args, data + payload_start, 0, payload_len, hook->arg);
+
+            memmove(data + payload_start, data + payload_start + payload_len, data_len - payload_start - payload_len);
+            data_len -= payload_len;
+        }
+        else
+        {
+            /* Deliver what is already in the block */
+            hook->sim800l_data_callback(args, num_args, data + payload_start, 0, available, hook->arg);
+            data_len = payload_start;
+
+            /* Read the rest straight from the UART */
+            uint32_t received = available;
+            uint8_t chunk[SIM800L_DATA_CHUNK_SIZE];
+            while (received < payload_len)
+            {
+                uint32_t chunk_len = payload_len - received;
+                if (chunk_len > sizeof(chunk))
+                {
+                    chunk_len = sizeof(chunk);
+                }
+
+                uint32_t read_len = sim800l_uart_recv_data(sim800l_handle, chunk, chunk_len, SIM800L_DATA_TIMEOUT_MS);
+                if ((read_len == 0) || (read_len > chunk_len))
+                {
+                    ESP_LOGE(SIM800L_TAG, "Counted data timeout (%lu/%lu)", received, payload_len);
+                    break;
+                }
+
+                hook->sim800l_data_callback(args, num_args, chunk, received, read_len, hook->arg);
+                received += read_len;
+            }
+
+            /* Pick up the trailer ("\r\nOK\r\n") */
+            uint32_t tail_len = sim800l_uart_recv_data(sim800l_handle, data + data_len, data_size - data_len, SIM800L_DATA_TAIL_TIMEOUT_MS);
+            if (tail_len <= data_size - data_len)
+            {
+                data_len += tail_len;
+            }
+        }
+
+        position = payload_start;
+    }
+
+    return data_len;
+}
+
+/*
+ * SIM800L data mode filter
+ *
+ * @brief Armed: looks for the enter line ("CONNECT"), everything after it is raw.
+ *        On: everything is raw until a block ends with the exit line ("CLOSED").
+ *        Returns the length of what is left for the line parser.
+ *
+ */
+static uint32_t sim800l_data_mode_filter(sim800l_handle_t sim800l_handle, uint8_t *data, uint32_t data_len)
+{
+    if (sim800l_handle->data_mode == SIM800L_DATA_MODE_ARMED)
+    {
+        uint32_t enter_len = strlen(sim800l_handle->data_mode_enter);
+
+        for (uint32_t position = 0; position + enter_len + 2 <= data_len; position++)
+        {
+            /* Whole line only, "CONNECT" must not match "CONNECT FAIL" */
+            if (((position == 0) || (data[position - 1] == '\n')) &&
+                (memcmp(data + position, sim800l_handle->data_mode_enter, enter_len) == 0) &&
+                (data[position + enter_len] == '\r') && (data[position + enter_len + 1] == '\n'))
+            {
+                uint32_t line_end = position + enter_len + 2;
+
+                sim800l_handle->data_mode = SIM800L_DATA_MODE_ON;
+                sim800l_data_mode_push(sim800l_handle, data + line_end, data_len - line_end);
+
+                /* Enter line is still reported as an event */
+                return line_end;
+            }
+        }
+
+        return data_len;
+    }
+
+    /* "\r\n<exit>\r\n" closing the block ends data mode */
+    uint32_t exit_len = strlen(sim800l_handle->data_mode_exit);
+    if (data_len >= exit_len + 2)
+    {
+        uint32_t position = data_len - exit_len - 2;
+
+        if ((memcmp(data + position, sim800l_handle->data_mode_exit, exit_len) == 0) &&
+            (data[data_len - 2] == '\r') && (data[data_len - 1] == '\n') &&
+            ((position == 0) || (data[position - 1] == '\n')))
+        {
+            uint32_t raw_len = (position >= 2) ? position - 2 : 0;
+
+            sim800l_data_mode_push(sim800l_handle, data, raw_len);
+            sim800l_handle->data_mode = SIM800L_DATA_MODE_OFF;
+
+            memmove(data, data + position, data_len - position);
+            return data_len - position;
+        }
+    }
+
+    sim800l_data_mode_push(sim800l_handle, data, data_len);
+
+    return 0;
+}
+
+static void sim800l_data_mode_push(sim800l_handle_t sim800l_handle, const uint8_t *data, uint32_t data_len)
+{
+    if (data_len == 0)
+    {
+        return;
+    }
+
+    /* Straight from the UART read buffer, no intermediate copy */
+    if (sim800l_handle->data_mode_sink != NULL)
+    {
+        sim800l_handle->data_mode_sink(data, data_len, sim800l_handle->data_mode_sink_arg);
+        return;
+    }
+
+    /* Back pressure on the reader, drop once it stops reading */
+    size_t sent = xStreamBufferSend(sim800l_handle->data_mode_buffer, data, data_len, SIM800L_DATA_MODE_SEND_MS / portTICK_PERIOD_MS);
+    if (sent < data_len)
+    {
+        sim800l_handle->data_mode_dropped += data_len - sent;
+        ESP_LOGW(SIM800L_TAG, "Data mode: %lu bytes dropped", data_len - sent);
+    }
+}
+
 static uint32_t event_hash(const char *event_name)
 {
     uint32_t event_hash = 10037;
@@ -997,110 +2220,114 @@ static void sim800l_bridge_task(void *args)
         uint8_t command_response[MAX_PARAMS_SIZE] = {0};
         uint8_t response[MAX_PARAMS_SIZE] = {0};
 
-        /* Read data from sim800l uart */
+        /* Read data from sim800l uart, short reads keep data mode latency low */
         uint8_t data[MAX_PARAMS_SIZE] = {0};
-        if (sim800l_uart_recv_data(sim800l_handle, data, sizeof(data), MAX_PARAMS_SIZE) > 0)
+        bool data_mode = (sim800l_handle->data_mode == SIM800L_DATA_MODE_ON);
+        uint32_t data_len = sim800l_uart_recv_data(sim800l_handle, data, sizeof(data) - 1, data_mode ? SIM800L_DATA_MODE_READ_MS : MAX_PARAMS_SIZE);
+        sim800l_handle->wire_stats.rx_bytes += data_len;
+
+        /* Raw bytes bypass the parser */
+        if ((data_len > 0) && (data_len < sizeof(data)) && (sim800l_handle->data_mode != SIM800L_DATA_MODE_OFF))
         {
-            /* Receive Queue */
-            if (xQueueReceive(sim800l_handle->sim800l_queue_tx_handle, command_response, 0) == pdTRUE)
-            {
-                /* Data temp */
-                uint8_t data_temp[MAX_PARAMS_SIZE] = {0};
-                strncpy((char *)data_temp, (const char *)data, MAX_PARAMS_SIZE);
-
-                /* Token response */
-                char *token_respose = strtok((char *)data_temp, "\r\n");
-                
-                /* Check if the token is a command*/
-                if (strnstr((const char *)command_response, (const char *)token_respose, strlen((const char *)command_response)) != NULL)
-                {
-                    /* Extract response */
-                    token_respose = strtok(NULL, "\r\n");
-                    if (token_respose == NULL) ESP_LOGI(SIM800L_TAG, "Vai dar errado");
-                    do
-                    {
-                        /* Check if token starts with '+' */
-                        if (token_respose[0] == '+')
-                        {
-                            /* Remove '+<>:' */
-                            char *result_find = strchr((const char *)token_respose, ':');
-                            if (result_find != NULL)
-                            {
-                                token_respose = result_find + 1;
-                            }
-                        }
+            data_len = sim800l_data_mode_filter(sim800l_handle, data, data_len);
+        }
 
-                        /* Add token to response */
-                        if (strncat((char *)response, (const char *)token_respose, strlen((const char *)token_respose)) == NULL)
-                        {
-                            ESP_LOGE(SIM800L_TAG, "strncat failed");
-                        }
+        if ((data_len > 0) && (data_len < sizeof(data)))
+        {
+            /* Move counted payloads out of the block */
+            data_len = sim800l_data_extract(sim800l_handle, data, data_len, sizeof(data) - 1);
+            data[data_len] = '\0';
 
-                        /* Add '\r\n' to response */
-                        if (strncat((char *)response, "\r\n", strlen("\r\n") + 1) == NULL)
-                        {
-                            ESP_LOGE(SIM800L_TAG, "strncat failed");
-                        }
+            /* Receive Queue, with echo the block that repeats the command answers it */
+            bool echo = (sim800l_format_current == SIM800L_FORMAT_ECHO);
+            if (echo && (xQueueReceive(sim800l_handle->sim800l_queue_tx_handle, command_response, 0) == pdTRUE))
+            {
+                /* Send response */
+                if (sim800l_response_extract((const char *)data, (const char *)command_response, true, (char *)response) &&
+                    (xQueueSend(sim800l_handle->sim800l_queue_rx_handle, response, 0) != pdPASS))
+                {
+                    ESP_LOGE(SIM800L_TAG, "xQueueSend failed");
+                }
+            }
+            /* Without echo, the lock keeps one command in flight and the block that ends it is its answer */
+            else if (!echo && (xQueuePeek(sim800l_handle->sim800l_queue_tx_handle, command_response, 0) == pdTRUE) &&
+                     sim800l_response_complete((const char *)data, (const char *)command_response))
+            {
+                xQueueReceive(sim800l_handle->sim800l_queue_tx_handle, command_response, 0);
 
-                        /* Get next token */
-                        token_respose = strtok(NULL, "\r\n");
-                    } while (token_respose != NULL);
-                    
-                    /* Send response */
-                    if (xQueueSend(sim800l_handle->sim800l_queue_rx_handle, response, 0) != pdPASS)
-                    {
-                        ESP_LOGE(SIM800L_TAG, "xQueueSend failed");
-                    }
+                /* Send response */
+                sim800l_response_extract((const char *)data, (const char *)command_response, false, (char *)response);
+                if (xQueueSend(sim800l_handle->sim800l_queue_rx_handle, response, 0) != pdPASS)
+                {
+                    ESP_LOGE(SIM800L_TAG, "xQueueSend failed");
                 }
             }
 
-            /* Extract tokens */
-            char **event_args = (char **)calloc(5, sizeof(char *));
-            char *token = strtok((char*)data, "\r\n");
-            do
+            /* Extract tokens, lines and args keep separate strtok state, args point into data */
+            char *event_args[SIM800L_EVENT_MAX_ARGS] = {0};
+            char *line_save = NULL;
+            char *token = strtok_r((char*)data, "\r\n", &line_save);
+            while (token != NULL)
             {
                 // ESP_LOGI(SIM800L_TAG, "Token event: %s", token);
-                memset(event_args, 0, sizeof(char *) * 5);
+                memset(event_args, 0, sizeof(event_args));
                 char event[25] = {0};
 
-                /* Check if the token is a event in format: +<token>:*/
-                if (token[0] == '+')
+                /* Event name, the same one sim800l_response_complete looks up, ATV0 result codes have no args */
+                sim800l_event_name(token, event, sizeof(event));
+                bool result_code = (sim800l_result_name(token) != token);
+
+                /* Check if the token is a link event in format: <n>, <token>[: <arg>] */
+                if (!result_code && (token[0] >= '0') && (token[0] <= '9') && (token[1] == ',') && (token[2] == ' '))
                 {
-                    /* Extract event (+<event>:args) */
-                    token = strtok(token, ":");
-                    strncpy(event, token, strlen(token));
+                    /* Extract link event, the link is the first arg and "REMOTE IP: <ip>" style text the second */
+                    char *colon = strchr(token + 3, ':');
+                    if (colon != NULL)
+                    {
+                        *colon++ = '\0';
+                        while (*colon == ' ')
+                        {
+                            colon++;
+                        }
+                        event_args[1] = colon;
+                    }
+
+                    token[1] = '\0';
+                    event_args[0] = token;
+                }
+                /* Check if the token is a event in format: +<token>: or <token>: (DATA ACCEPT:<n>,<len>) */
+                else if (!result_code && ((token[0] == '+') || (strchr(token, ':') != NULL)))
+                {
+                    /* Extract args (+<event>:args) */
+                    char *args_save = NULL;
+                    strtok_r(token, ":", &args_save);
 
                     int i = 0;
-                    token = strtok(NULL, ",");
-                    do
+                    token = strtok_r(NULL, ",", &args_save);
+                    while ((token != NULL) && (i < SIM800L_EVENT_MAX_ARGS))
                     {
                         /* Extract args */
-                        event_args[i] = strdup(token);
+                        event_args[i] = token;
                         
                         /* Get next token */
-                        token = strtok(NULL, ",");
+                        token = strtok_r(NULL, ",", &args_save);
                         i++;
-                    } while ((token != NULL) && (i < 5));
-                }
-                else
-                {
-                    /* Extract simple event */
-                    strncpy(event, token, strlen(token));
+                    }
                 }
 
-                /* Interpret event */
+                /* Interpret event, callbacks copy what they need */
                 sim800l_event_interpreter(sim800l_handle, (const char *)event, event_args);
-                
-                /* Get next token */
-                token = strtok(NULL, "\r\n");
-            } while (token != NULL);
 
-            
-            free(event_args);
-            event_args = NULL;
+                /* Get next token */
+                token = strtok_r(NULL, "\r\n", &line_save);
+            }
         }
 
-        vTaskDelay(50 / portTICK_PERIOD_MS);
+        /* Data mode is paced by the UART read timeout */
+        if (sim800l_handle->data_mode != SIM800L_DATA_MODE_ON)
+        {
+            vTaskDelay(50 / portTICK_PERIOD_MS);
+        }
     }
 }
 
@@ -1118,6 +2345,31 @@ sim800l_event_t sim800l_event_error(char **input_args, void *output_data)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
+    sim800l_error_store(SIM800L_ERROR_PLAIN, NULL);
+    memcpy(output_data, &sim800l_last_error, sizeof(sim800l_error_t));
+
+    return SIM800L_EVENT_ERROR;
+}
+
+sim800l_event_t sim800l_event_cme_error(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* +CME ERROR: <n>, same event as ERROR so waiting commands end now */
+    sim800l_error_store(SIM800L_ERROR_CME, input_args[0]);
+    memcpy(output_data, &sim800l_last_error, sizeof(sim800l_error_t));
+
+    return SIM800L_EVENT_ERROR;
+}
+
+sim800l_event_t sim800l_event_cms_error(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* +CMS ERROR: <n> */
+    sim800l_error_store(SIM800L_ERROR_CMS, input_args[0]);
+    memcpy(output_data, &sim800l_last_error, sizeof(sim800l_error_t));
+
     return SIM800L_EVENT_ERROR;
 }
 
@@ -1125,6 +2377,11 @@ sim800l_event_t sim800l_event_rdy(char **input_args, void *output_data)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
+    /* Modem restarted with its defaults */
+    sim800l_shadow_invalidate(NULL);
+    sim800l_error_enabled = false;
+    sim800l_format_current = SIM800L_FORMAT_ECHO;
+
     return SIM800L_EVENT_RDY;
 }
 
@@ -1132,6 +2389,9 @@ sim800l_event_t sim800l_event_cfun(char **input_args, void *output_data)
 {
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
+    /* Functionality change, settings may be back to defaults */
+    sim800l_shadow_invalidate(NULL);
+
     if (strstr(input_args[0], "0") != NULL)
     {
         return SIM800L_EVENT_CFUN_MINIMUM;
@@ -1168,4 +2428,18 @@ sim800l_event_t sim800l_event_sms_ready(char **input_args, void *output_data)
     ESP_LOGD(SIM800L_TAG, "%s", __func__);
 
     return SIM800L_EVENT_SMS_READY;
+}
+
+sim800l_event_t sim800l_event_no_carrier(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_TAG, "%s", __func__);
+
+    /* Voice and data calls end with the same line, the data call owner (PPP) routes it while it is up */
+    sim800l_event_t (*callback)(char **input_args, void *output_data) = sim800l_no_carrier_callback;
+    if (callback != NULL)
+    {
+        return callback(input_args, output_data);
+    }
+
+    return SIM800L_EVENT_CALL_NO_CARRIER;
 }
\ No newline at end of file
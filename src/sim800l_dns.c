@@ -0,0 +1,303 @@
+/*
+ * @file sim800l_dns.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L DNS functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_dns.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <esp_timer.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_DNS_CACHE_SIZE          8
+#define SIM800L_DNS_HOST_SIZE           64      /* Longer names are resolved but not cached */
+#define SIM800L_DNS_DEFAULT_TTL         300     /* Seconds, the modem does not report the record TTL */
+
+/*
+ *     Tag
+ */
+#define SIM800L_DNS_TAG "SIM800L DNS"
+
+/*
+ *     URC
+ */
+#define SIM800L_EVENT_DNS_STR           "+CDNSGIP"
+
+/*
+ *     DNS cache
+ */
+typedef struct
+{
+    char host[SIM800L_DNS_HOST_SIZE];   /* Empty for a free entry */
+    char ip[16];
+    int64_t expires;
+} sim800l_dns_entry_t;
+
+static sim800l_dns_entry_t sim800l_dns_cache[SIM800L_DNS_CACHE_SIZE] = {0};
+static uint32_t sim800l_dns_ttl = SIM800L_DNS_DEFAULT_TTL;
+static sim800l_dns_stats_t sim800l_dns_stats = {0};
+static sim800l_dns_event_t sim800l_dns_result = {0};
+
+/*
+ *     Private functions
+ */
+static bool sim800l_dns_is_ip(const char *host);
+static sim800l_dns_entry_t *sim800l_dns_lookup(const char *host);
+static void sim800l_dns_store(const char *host, const char *ip);
+static void sim800l_dns_unquote(char *output, size_t output_size, const char *input);
+
+/*
+ *     Callbacks
+ */
+sim800l_event_t sim800l_event_dns(char **input_args, void *output_data);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_dns_resolve(sim800l_handle_t sim800l_handle, const char *host, char *ip, size_t ip_size, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_DNS_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (host == NULL) || (ip == NULL) || (ip_size == 0))
+    {
+        ESP_LOGE(SIM800L_DNS_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Nothing to resolve */
+    if (sim800l_dns_is_ip(host))
+    {
+        snprintf(ip, ip_size, "%s", host);
+        return SIM800L_RET_OK;
+    }
+
+    sim800l_dns_entry_t *entry = sim800l_dns_lookup(host);
+    if (entry != NULL)
+    {
+        sim800l_dns_stats.hits++;
+
+        /* Every hit saves one lookup, priced at the average so far */
+        if (sim800l_dns_stats.misses > 0)
+        {
+            sim800l_dns_stats.saved_us += sim800l_dns_stats.lookup_us / sim800l_dns_stats.misses;
+        }
+
+        snprintf(ip, ip_size, "%s", entry->ip);
+        return SIM800L_RET_OK;
+    }
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_DNS_QUERY) + strlen(host) + 3 * sizeof(char) + strlen("\r\n") + 1; /* cmd="s"\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_DNS_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=\"%s\"\r\n", SIM800L_COMMAND_DNS_QUERY, host) < 0)
+    {
+        ESP_LOGE(SIM800L_DNS_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* Registered per query, "+CDNSGIP" is not used by anything else */
+    if (sim800l_register_callback(SIM800L_EVENT_DNS_STR, sim800l_event_dns) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_DNS_TAG, "sim800l_register_callback failed");
+        free(command);
+        return SIM800L_RET_ERROR;
+    }
+
+    memset(&sim800l_dns_result, 0, sizeof(sim800l_dns_event_t));
+    int64_t start = esp_timer_get_time();
+
+    /* OK first, the answer comes with the URC */
+    esp_err_t ret = sim800l_out_data_event(sim800l_handle, command, SIM800L_EVENT_DNS, timeout);
+
+    free(command);
+    sim800l_unregister_callback(SIM800L_EVENT_DNS_STR);
+
+    sim800l_dns_stats.misses++;
+    sim800l_dns_stats.lookup_us += esp_timer_get_time() - start;
+
+    if ((ret != ESP_OK) || !sim800l_dns_result.resolved)
+    {
+        ESP_LOGE(SIM800L_DNS_TAG, "%s not resolved, error %lu", host, sim800l_dns_result.error);
+        sim800l_dns_stats.failures++;
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_dns_store(host, sim800l_dns_result.ip);
+    snprintf(ip, ip_size, "%s", sim800l_dns_result.ip);
+
+    ESP_LOGI(SIM800L_DNS_TAG, "%s is %s", host, sim800l_dns_result.ip);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_dns_set_ttl(uint32_t ttl)
+{
+    ESP_LOGD(SIM800L_DNS_TAG, "%s", __func__);
+
+    /* 0 turns the cache off, every resolve goes to the modem */
+    sim800l_dns_ttl = ttl;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_dns_flush(void)
+{
+    ESP_LOGD(SIM800L_DNS_TAG, "%s", __func__);
+
+    memset(sim800l_dns_cache, 0, sizeof(sim800l_dns_cache));
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_dns_get_stats(sim800l_dns_stats_t *stats)
+{
+    ESP_LOGD(SIM800L_DNS_TAG, "%s", __func__);
+
+    if (stats == NULL)
+    {
+        ESP_LOGE(SIM800L_DNS_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    *stats = sim800l_dns_stats;
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static bool sim800l_dns_is_ip(const char *host)
+{
+    /* Dotted quad, digits and three dots */
+    uint32_t dots = 0;
+
+    for (const char *c = host; *c != '\0'; c++)
+    {
+        if (*c == '.')
+        {
+            dots++;
+        }
+        else if ((*c < '0') || (*c > '9'))
+        {
+            return false;
+        }
+    }
+
+    return dots == 3;
+}
+
+static sim800l_dns_entry_t *sim800l_dns_lookup(const char *host)
+{
+    int64_t now = esp_timer_get_time();
+
+    for (uint32_t i = 0; i < SIM800L_DNS_CACHE_SIZE; i++)
+    {
+        sim800l_dns_entry_t *entry = &sim800l_dns_cache[i];
+
+        if ((entry->host[0] != '\0') && (strcmp(entry->host, host) == 0))
+        {
+            if (now < entry->expires)
+            {
+                return entry;
+            }
+
+            /* Expired */
+            entry->host[0] = '\0';
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+static void sim800l_dns_store(const char *host, const char *ip)
+{
+    if ((sim800l_dns_ttl == 0) || (strlen(host) >= SIM800L_DNS_HOST_SIZE))
+    {
+        return;
+    }
+
+    /* Free entry, or the one closest to expiring */
+    sim800l_dns_entry_t *slot = &sim800l_dns_cache[0];
+
+    for (uint32_t i = 0; i < SIM800L_DNS_CACHE_SIZE; i++)
+    {
+        sim800l_dns_entry_t *entry = &sim800l_dns_cache[i];
+
+        if (entry->host[0] == '\0')
+        {
+            slot = entry;
+            break;
+        }
+
+        if (entry->expires < slot->expires)
+        {
+            slot = entry;
+        }
+    }
+
+    snprintf(slot->host, sizeof(slot->host), "%s", host);
+    snprintf(slot->ip, sizeof(slot->ip), "%s", ip);
+    slot->expires = esp_timer_get_time() + (int64_t)sim800l_dns_ttl * 1000000;
+}
+
+static void sim800l_dns_unquote(char *output, size_t output_size, const char *input)
+{
+    while ((*input == ' ') || (*input == '"'))
+    {
+        input++;
+    }
+
+    snprintf(output, output_size, "%s", input);
+
+    char *quote = strchr(output, '"');
+    if (quote != NULL)
+    {
+        *quote = '\0';
+    }
+}
+
+/*
+ *     Callbacks development
+ */
+sim800l_event_t sim800l_event_dns(char **input_args, void *output_data)
+{
+    sim800l_dns_event_t *event = (sim800l_dns_event_t *)output_data;
+
+    /* +CDNSGIP: 1,"<domain>","<ip>"[,"<ip2>"] or +CDNSGIP: 0,<error> */
+    if ((input_args[0] != NULL) && (atoi(input_args[0]) == 1) && (input_args[2] != NULL))
+    {
+        event->resolved = true;
+        sim800l_dns_unquote(event->ip, sizeof(event->ip), input_args[2]);
+    }
+    else
+    {
+        event->resolved = false;
+        event->error = (input_args[1] != NULL) ? atoi(input_args[1]) : 0;
+    }
+
+    sim800l_dns_result = *event;
+
+    return SIM800L_EVENT_DNS;
+}
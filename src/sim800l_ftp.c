@@ -0,0 +1,560 @@
+/*
+ * @file sim800l_ftp.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L FTP functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_ftp.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_FTP_CHUNK_SIZE          1024    /* FTPGET=2 / FTPPUT=2 length, the modem takes up to 1460 */
+#define SIM800L_FTP_POLL_MS             50
+#define SIM800L_FTP_OPEN_TIMEOUT        75000   /* Login and data connection */
+
+/*
+ *     Tag
+ */
+#define SIM800L_FTP_TAG "SIM800L FTP"
+
+/*
+ *     URC
+ */
+#define SIM800L_EVENT_FTP_GET_STR       "+FTPGET"
+#define SIM800L_EVENT_FTP_PUT_STR       "+FTPPUT"
+#define SIM800L_DATA_FTP_GET_STR        "+FTPGET: 2,"
+
+/*
+ *     FTP session, one transfer at a time
+ */
+typedef struct
+{
+    volatile bool ready;                /* "+FTPGET: 1,1" / "+FTPPUT: 1,1,<maxlength>" */
+    volatile bool finished;             /* "<cmd>: 1,0" */
+    volatile uint32_t error;            /* "<cmd>: 1,<error>" */
+    volatile bool confirmed;            /* "+FTPPUT: 2,<cnflength>" */
+    volatile uint32_t length;
+} sim800l_ftp_session_t;
+
+static sim800l_ftp_session_t sim800l_ftp_session = {0};
+static sim800l_ftp_stats_t sim800l_ftp_stats = {0};
+
+/*
+ *     FTPGET=2 payload goes straight to this buffer, the mutex keeps it alive while the bridge task copies into it
+ */
+static struct
+{
+    SemaphoreHandle_t mutex;
+    uint8_t *buffer;
+    size_t buffer_size;
+    size_t received;
+} sim800l_ftp_read_ctx = {0};
+
+/*
+ *     Private functions
+ */
+static sim800l_ret_t sim800l_ftp_set(sim800l_handle_t sim800l_handle, const char *command, const char *value, bool quoted);
+static sim800l_ret_t sim800l_ftp_callbacks(bool enable);
+static sim800l_ret_t sim800l_ftp_open(sim800l_handle_t sim800l_handle, const char *command, int64_t deadline);
+static sim800l_ret_t sim800l_ftp_wait(volatile bool *flag, int64_t deadline);
+static void sim800l_ftp_read(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg);
+
+/*
+ *     Callbacks
+ */
+sim800l_event_t sim800l_event_ftp(char **input_args, void *output_data);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_ftp_config(sim800l_handle_t sim800l_handle, const sim800l_ftp_config_t *config)
+{
+    ESP_LOGD(SIM800L_FTP_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (config == NULL) || (config->server == NULL))
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    char cid[11] = {0};
+    char port[6] = {0};
+    snprintf(cid, sizeof(cid), "%lu", (config->cid > 0) ? config->cid : 1);
+    snprintf(port, sizeof(port), "%u", (config->port > 0) ? config->port : 21);
+
+    /* Binary type, counted data is never translated */
+    if ((sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_CID, cid, false) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_SERVER, config->server, true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_PORT, port, false) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_USER, (config->username != NULL) ? config->username : "anonymous", true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_PASSWORD, (config->password != NULL) ? config->password : "", true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_TYPE, "I", true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_MODE, config->active ? "0" : "1", false) != SIM800L_RET_OK))
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "FTP configuration failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ftp_get(sim800l_handle_t sim800l_handle, const char *path, const char *name, uint32_t offset, sim800l_ftp_sink_t sink, void *arg, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_FTP_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (path == NULL) || (name == NULL) || (sink == NULL))
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    char rest[11] = {0};
+    snprintf(rest, sizeof(rest), "%lu", offset);
+
+    /* FTPREST applies to the next FTPGET only, 0 clears a previous one */
+    if ((sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_GET_PATH, path, true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_GET_NAME, name, true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_REST, rest, false) != SIM800L_RET_OK))
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "FTP get setup failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    uint8_t *buffer = calloc(SIM800L_FTP_CHUNK_SIZE, sizeof(uint8_t));
+    if (buffer == NULL)
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    if (sim800l_ftp_callbacks(true) != SIM800L_RET_OK)
+    {
+        free(buffer);
+        return SIM800L_RET_ERROR;
+    }
+
+    memset(&sim800l_ftp_stats, 0, sizeof(sim800l_ftp_stats_t));
+    sim800l_ftp_stats.offset = offset;
+
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = start + (int64_t)timeout * 1000;
+
+    sim800l_ret_t ret = sim800l_ftp_open(sim800l_handle, SIM800L_COMMAND_FTP_GET "=1\r\n", start + (int64_t)SIM800L_FTP_OPEN_TIMEOUT * 1000);
+
+    /* Same read for every chunk */
+    char command[32] = {0};
+    snprintf(command, sizeof(command), "%s=2,%d\r\n", SIM800L_COMMAND_FTP_GET, SIM800L_FTP_CHUNK_SIZE);
+
+    while (ret == SIM800L_RET_OK)
+    {
+        if (esp_timer_get_time() >= deadline)
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "Download timeout at %lu bytes", sim800l_ftp_stats.bytes);
+            ret = SIM800L_RET_ERROR;
+            break;
+        }
+
+        /* Cleared before the read, a "1,1" that comes during it is not lost */
+        sim800l_ftp_session.ready = false;
+
+        xSemaphoreTake(sim800l_ftp_read_ctx.mutex, portMAX_DELAY);
+        sim800l_ftp_read_ctx.buffer = buffer;
+        sim800l_ftp_read_ctx.buffer_size = SIM800L_FTP_CHUNK_SIZE;
+        sim800l_ftp_read_ctx.received = 0;
+        xSemaphoreGive(sim800l_ftp_read_ctx.mutex);
+
+        /* "+FTPGET: 2,<cnflength>" followed by the data, then OK */
+        char response[32] = {0};
+        esp_err_t err = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, sizeof(response), 1000 + SIM800L_FTP_CHUNK_SIZE);
+
+        /* On timeout the payload may still be arriving, the buffer is freed once no copy is in progress */
+        xSemaphoreTake(sim800l_ftp_read_ctx.mutex, portMAX_DELAY);
+        sim800l_ftp_read_ctx.buffer = NULL;
+        size_t received = sim800l_ftp_read_ctx.received;
+        xSemaphoreGive(sim800l_ftp_read_ctx.mutex);
+
+        if ((err != ESP_OK) || (strnstr(response, "ERROR", sizeof(response)) != NULL))
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "AT+FTPGET=2 failed");
+            ret = SIM800L_RET_ERROR_SEND_COMMAND;
+            break;
+        }
+
+        sim800l_ftp_stats.chunks++;
+
+        if (received > 0)
+        {
+            sim800l_ftp_stats.bytes += received;
+
+            if (sink(buffer, received, arg) != SIM800L_RET_OK)
+            {
+                ESP_LOGW(SIM800L_FTP_TAG, "Download aborted by the sink");
+                ret = SIM800L_RET_ERROR;
+                break;
+            }
+            continue;
+        }
+
+        /* Nothing buffered, "1,0" means the server is done */
+        if (sim800l_ftp_session.finished)
+        {
+            break;
+        }
+
+        /* Wait for the next "1,1", or the end of the transfer */
+        while (!sim800l_ftp_session.ready && !sim800l_ftp_session.finished && (sim800l_ftp_session.error == 0) && (esp_timer_get_time() < deadline))
+        {
+            vTaskDelay(SIM800L_FTP_POLL_MS / portTICK_PERIOD_MS);
+        }
+
+        if (sim800l_ftp_session.error != 0)
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "Download failed, FTP error %lu", sim800l_ftp_session.error);
+            ret = SIM800L_RET_ERROR;
+        }
+    }
+
+    sim800l_ftp_stats.elapsed_us = esp_timer_get_time() - start;
+
+    /* Session still open on the modem, the next transfer would fail to start */
+    if ((ret != SIM800L_RET_OK) && !sim800l_ftp_session.finished)
+    {
+        sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_FTP_QUIT "\r\n", SIM800L_EVENT_OK, 1000);
+    }
+
+    sim800l_ftp_callbacks(false);
+    free(buffer);
+
+    if (ret == SIM800L_RET_OK)
+    {
+        ESP_LOGI(SIM800L_FTP_TAG, "%s%s: %lu bytes from offset %lu in %llu ms", path, name, sim800l_ftp_stats.bytes, offset, sim800l_ftp_stats.elapsed_us / 1000);
+    }
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_ftp_put(sim800l_handle_t sim800l_handle, const char *path, const char *name, bool append, sim800l_ftp_source_t source, void *arg, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_FTP_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (path == NULL) || (name == NULL) || (source == NULL))
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* APPE continues a broken upload */
+    if ((sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_PUT_PATH, path, true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_PUT_NAME, name, true) != SIM800L_RET_OK) ||
+        (sim800l_ftp_set(sim800l_handle, SIM800L_COMMAND_FTP_PUT_OPT, append ? "APPE" : "STOR", true) != SIM800L_RET_OK))
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "FTP put setup failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    uint8_t *buffer = calloc(SIM800L_FTP_CHUNK_SIZE, sizeof(uint8_t));
+    if (buffer == NULL)
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    if (sim800l_ftp_callbacks(true) != SIM800L_RET_OK)
+    {
+        free(buffer);
+        return SIM800L_RET_ERROR;
+    }
+
+    memset(&sim800l_ftp_stats, 0, sizeof(sim800l_ftp_stats_t));
+
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = start + (int64_t)timeout * 1000;
+
+    sim800l_ret_t ret = sim800l_ftp_open(sim800l_handle, SIM800L_COMMAND_FTP_PUT "=1\r\n", start + (int64_t)SIM800L_FTP_OPEN_TIMEOUT * 1000);
+
+    while (ret == SIM800L_RET_OK)
+    {
+        /* Largest write the modem announced with "+FTPPUT: 1,1,<maxlength>" */
+        size_t length = ((sim800l_ftp_session.length > 0) && (sim800l_ftp_session.length < SIM800L_FTP_CHUNK_SIZE)) ? sim800l_ftp_session.length : SIM800L_FTP_CHUNK_SIZE;
+        length = source(buffer, length, arg);
+
+        char command[32] = {0};
+
+        /* Assembly of the command to be sent, length 0 closes the file */
+        if (snprintf(command, sizeof(command), "%s=2,%u\r\n", SIM800L_COMMAND_FTP_PUT, length) < 0)
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "Assembly of the command to be sent failed");
+            ret = SIM800L_RET_ERROR_BUILD_COMMAND;
+            break;
+        }
+
+        sim800l_ftp_session.confirmed = false;
+        sim800l_ftp_session.ready = false;
+
+        /* Held from AT+FTPPUT=2 until the data is written */
+        sim800l_lock(sim800l_handle, portMAX_DELAY);
+
+        if (sim800l_out_data_raw(sim800l_handle, (const uint8_t *)command, strlen(command)) != ESP_OK)
+        {
+            sim800l_unlock(sim800l_handle);
+            ret = SIM800L_RET_ERROR_SEND_COMMAND;
+            break;
+        }
+
+        if (length == 0)
+        {
+            sim800l_unlock(sim800l_handle);
+
+            /* "+FTPPUT: 1,0" once the server has the whole file */
+            ret = sim800l_ftp_wait(&sim800l_ftp_session.finished, deadline);
+            break;
+        }
+
+        /* "+FTPPUT: 2,<cnflength>", then the modem takes exactly that many bytes */
+        ret = sim800l_ftp_wait(&sim800l_ftp_session.confirmed, deadline);
+        if ((ret != SIM800L_RET_OK) || (sim800l_ftp_session.length != length))
+        {
+            sim800l_unlock(sim800l_handle);
+            ESP_LOGE(SIM800L_FTP_TAG, "AT+FTPPUT=2 not confirmed");
+            ret = SIM800L_RET_ERROR;
+            break;
+        }
+
+        esp_err_t err = sim800l_out_data_raw(sim800l_handle, buffer, length);
+
+        sim800l_unlock(sim800l_handle);
+
+        if (err != ESP_OK)
+        {
+            ret = SIM800L_RET_ERROR_SEND_COMMAND;
+            break;
+        }
+
+        sim800l_ftp_stats.bytes += length;
+        sim800l_ftp_stats.chunks++;
+
+        /* Ready for the next write */
+        ret = sim800l_ftp_wait(&sim800l_ftp_session.ready, deadline);
+    }
+
+    sim800l_ftp_stats.elapsed_us = esp_timer_get_time() - start;
+
+    /* Session still open on the modem, the next transfer would fail to start */
+    if ((ret != SIM800L_RET_OK) && !sim800l_ftp_session.finished)
+    {
+        sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_FTP_QUIT "\r\n", SIM800L_EVENT_OK, 1000);
+    }
+
+    sim800l_ftp_callbacks(false);
+    free(buffer);
+
+    if (ret == SIM800L_RET_OK)
+    {
+        ESP_LOGI(SIM800L_FTP_TAG, "%s%s: %lu bytes in %llu ms", path, name, sim800l_ftp_stats.bytes, sim800l_ftp_stats.elapsed_us / 1000);
+    }
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_ftp_get_stats(sim800l_ftp_stats_t *stats)
+{
+    ESP_LOGD(SIM800L_FTP_TAG, "%s", __func__);
+
+    if (stats == NULL)
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    *stats = sim800l_ftp_stats;
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static sim800l_ret_t sim800l_ftp_set(sim800l_handle_t sim800l_handle, const char *command, const char *value, bool quoted)
+{
+    /* Get command length */
+    uint32_t command_length = strlen(command) + strlen(value) + 3 * sizeof(char) + strlen("\r\n") + 1; /* cmd="s"\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command_buffer = calloc(command_length, sizeof(uint8_t));
+    if (command_buffer == NULL)
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command_buffer, command_length, quoted ? "%s=\"%s\"\r\n" : "%s=%s\r\n", command, value) < 0)
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "Assembly of the command to be sent failed");
+        free(command_buffer);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    esp_err_t ret = sim800l_out_data_event(sim800l_handle, command_buffer, SIM800L_EVENT_OK, 1000);
+
+    free(command_buffer);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "%s failed", command);
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_ftp_callbacks(bool enable)
+{
+    if (enable)
+    {
+        if (sim800l_ftp_read_ctx.mutex == NULL)
+        {
+            sim800l_ftp_read_ctx.mutex = xSemaphoreCreateMutex();
+            if (sim800l_ftp_read_ctx.mutex == NULL)
+            {
+                ESP_LOGE(SIM800L_FTP_TAG, "Mutex creation failed");
+                return SIM800L_RET_ERROR_MEM;
+            }
+        }
+
+        /* Session URCs, "+FTPGET: 1,<code>" and "+FTPPUT: 1,<code>[,<maxlength>]" */
+        if ((sim800l_register_callback(SIM800L_EVENT_FTP_GET_STR, sim800l_event_ftp) != ESP_OK) ||
+            (sim800l_register_callback(SIM800L_EVENT_FTP_PUT_STR, sim800l_event_ftp) != ESP_OK))
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "sim800l_register_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
+        /* "+FTPGET: 2,<cnflength>" followed by <cnflength> bytes */
+        if (sim800l_register_data_callback(SIM800L_DATA_FTP_GET_STR, 0, sim800l_ftp_read, NULL) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "sim800l_register_data_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
+        return SIM800L_RET_OK;
+    }
+
+    sim800l_unregister_callback(SIM800L_EVENT_FTP_GET_STR);
+    sim800l_unregister_callback(SIM800L_EVENT_FTP_PUT_STR);
+    sim800l_unregister_data_callback(SIM800L_DATA_FTP_GET_STR);
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_ftp_open(sim800l_handle_t sim800l_handle, const char *command, int64_t deadline)
+{
+    memset((void *)&sim800l_ftp_session, 0, sizeof(sim800l_ftp_session_t));
+
+    /* OK first, the session URC comes after login */
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)command, SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_FTP_TAG, "%s failed", command);
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    return sim800l_ftp_wait(&sim800l_ftp_session.ready, deadline);
+}
+
+static sim800l_ret_t sim800l_ftp_wait(volatile bool *flag, int64_t deadline)
+{
+    while (!*flag)
+    {
+        if (sim800l_ftp_session.error != 0)
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "FTP error %lu", sim800l_ftp_session.error);
+            return SIM800L_RET_ERROR;
+        }
+
+        /* Session closed before what was waited for */
+        if (sim800l_ftp_session.finished && (flag != &sim800l_ftp_session.finished))
+        {
+            return SIM800L_RET_ERROR;
+        }
+
+        if (esp_timer_get_time() >= deadline)
+        {
+            ESP_LOGE(SIM800L_FTP_TAG, "FTP timeout");
+            return SIM800L_RET_ERROR;
+        }
+
+        vTaskDelay(SIM800L_FTP_POLL_MS / portTICK_PERIOD_MS);
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_ftp_read(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg)
+{
+    if (sim800l_ftp_read_ctx.mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(sim800l_ftp_read_ctx.mutex, portMAX_DELAY);
+
+    /* Nobody waiting means a stale response */
+    if ((sim800l_ftp_read_ctx.buffer != NULL) && (data_offset + data_len <= sim800l_ftp_read_ctx.buffer_size))
+    {
+        memcpy(sim800l_ftp_read_ctx.buffer + data_offset, data, data_len);
+        sim800l_ftp_read_ctx.received = data_offset + data_len;
+    }
+
+    xSemaphoreGive(sim800l_ftp_read_ctx.mutex);
+}
+
+/*
+ *     Callbacks development
+ */
+sim800l_event_t sim800l_event_ftp(char **input_args, void *output_data)
+{
+    sim800l_ftp_event_t *event = (sim800l_ftp_event_t *)output_data;
+
+    event->mode = (input_args[0] != NULL) ? atoi(input_args[0]) : 0;
+    event->code = (input_args[1] != NULL) ? atoi(input_args[1]) : 0;
+    event->length = (input_args[2] != NULL) ? atoi(input_args[2]) : 0;
+
+    if (event->mode == 2)
+    {
+        /* "+FTPPUT: 2,<cnflength>", "+FTPGET: 2,<cnflength>" lines are seen here after the data hook */
+        event->length = event->code;
+        sim800l_ftp_session.length = event->length;
+        sim800l_ftp_session.confirmed = true;
+    }
+    else if (event->code == 1)
+    {
+        if (event->length > 0)
+        {
+            sim800l_ftp_session.length = event->length;
+        }
+        sim800l_ftp_session.ready = true;
+    }
+    else if (event->code == 0)
+    {
+        sim800l_ftp_session.finished = true;
+    }
+    else
+    {
+        sim800l_ftp_session.error = event->code;
+    }
+
+    return SIM800L_EVENT_FTP;
+}
@@ -0,0 +1,681 @@
+/*
+ * @file sim800l_gzip.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L gzip/deflate functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_gzip.h"
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <rom/miniz.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_GZIP_HEADER_SIZE        10
+#define SIM800L_GZIP_TRAILER_SIZE       8
+
+#define SIM800L_GZIP_FLAG_HCRC          0x02
+#define SIM800L_GZIP_FLAG_EXTRA         0x04
+#define SIM800L_GZIP_FLAG_NAME          0x08
+#define SIM800L_GZIP_FLAG_COMMENT       0x10
+
+#define SIM800L_GZIP_WINDOW_SIZE        4096        /* Deflate match distance, power of two */
+#define SIM800L_GZIP_HASH_BITS          12
+#define SIM800L_GZIP_HASH_SIZE          (1 << SIM800L_GZIP_HASH_BITS)
+#define SIM800L_GZIP_MAX_CHAIN          16
+#define SIM800L_GZIP_MIN_MATCH          3
+#define SIM800L_GZIP_MAX_MATCH          258
+
+/*
+ *     Tag
+ */
+#define SIM800L_GZIP_TAG "SIM800L GZIP"
+
+/*
+ *     Inflate state
+ */
+typedef enum
+{
+    SIM800L_GZIP_STATE_HEADER = 0,
+    SIM800L_GZIP_STATE_EXTRA_LEN,
+    SIM800L_GZIP_STATE_EXTRA,
+    SIM800L_GZIP_STATE_NAME,
+    SIM800L_GZIP_STATE_COMMENT,
+    SIM800L_GZIP_STATE_HCRC,
+    SIM800L_GZIP_STATE_BODY,
+    SIM800L_GZIP_STATE_TRAILER,
+    SIM800L_GZIP_STATE_DONE
+} sim800l_gzip_state_t;
+
+/*
+ *     Inflate context
+ *
+ *     tinfl needs the whole 32 KiB deflate window as a circular output buffer,
+ *     inflated bytes are handed out from it before they are overwritten.
+ */
+struct sim800l_gzip
+{
+    tinfl_decompressor decomp;
+    uint8_t *window;
+    size_t window_ofs;
+    sim800l_gzip_format_t format;
+    sim800l_gzip_state_t state;
+    uint8_t flags;
+    uint8_t field[SIM800L_GZIP_HEADER_SIZE];    /* Header or trailer bytes being collected */
+    uint32_t field_len;
+    uint32_t field_pos;
+    uint32_t crc32;
+    uint32_t total_out;
+    sim800l_gzip_output_t output;
+    void *arg;
+};
+
+/*
+ *     Deflate bit writer
+ */
+typedef struct
+{
+    uint8_t *out;
+    size_t out_len;
+    size_t out_size;
+    uint32_t bit_buf;
+    uint32_t bit_count;
+} sim800l_gzip_bits_t;
+
+/*
+ *     Deflate length and distance tables (RFC 1951 3.2.5)
+ */
+static const uint16_t sim800l_gzip_length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t sim800l_gzip_length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t sim800l_gzip_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t sim800l_gzip_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/*
+ *     Private functions
+ */
+static sim800l_ret_t sim800l_gzip_inflate_body(sim800l_gzip_handle_t gzip_handle, const uint8_t *data, size_t data_len, size_t *used);
+static void sim800l_gzip_next_field(sim800l_gzip_handle_t gzip_handle);
+static void sim800l_gzip_put_bits(sim800l_gzip_bits_t *bits, uint32_t value, uint32_t count);
+static void sim800l_gzip_put_code(sim800l_gzip_bits_t *bits, uint32_t code, uint32_t count);
+static void sim800l_gzip_put_literal(sim800l_gzip_bits_t *bits, uint32_t symbol);
+static void sim800l_gzip_put_match(sim800l_gzip_bits_t *bits, uint32_t length, uint32_t distance);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_gzip_inflate_init(sim800l_gzip_handle_t *gzip_handle, sim800l_gzip_format_t format, sim800l_gzip_output_t output, void *arg)
+{
+    ESP_LOGD(SIM800L_GZIP_TAG, "%s", __func__);
+
+    /* Check args */
+    if (gzip_handle == NULL || output == NULL)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Allocate context and window */
+    sim800l_gzip_handle_t handle = calloc(1, sizeof(struct sim800l_gzip));
+    if (handle == NULL)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    handle->window = malloc(TINFL_LZ_DICT_SIZE);
+    if (handle->window == NULL)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Memory allocation failed");
+        free(handle);
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    tinfl_init(&handle->decomp);
+    handle->format = format;
+    handle->output = output;
+    handle->arg = arg;
+
+    /* zlib header and Adler-32 are handled by tinfl, gzip framing here */
+    if (format == SIM800L_GZIP_FORMAT_GZIP)
+    {
+        handle->state = SIM800L_GZIP_STATE_HEADER;
+        handle->field_len = SIM800L_GZIP_HEADER_SIZE;
+    }
+    else
+    {
+        handle->state = SIM800L_GZIP_STATE_BODY;
+    }
+
+    *gzip_handle = handle;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_gzip_inflate_feed(sim800l_gzip_handle_t gzip_handle, const uint8_t *data, size_t data_len)
+{
+    ESP_LOGD(SIM800L_GZIP_TAG, "%s", __func__);
+
+    /* Check args */
+    if (gzip_handle == NULL || (data == NULL && data_len > 0))
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    size_t pos = 0;
+    while (pos < data_len)
+    {
+        uint8_t byte = data[pos];
+
+        switch (gzip_handle->state)
+        {
+        case SIM800L_GZIP_STATE_HEADER:
+            gzip_handle->field[gzip_handle->field_pos++] = byte;
+            pos++;
+
+            if (gzip_handle->field_pos < gzip_handle->field_len)
+            {
+                break;
+            }
+
+            /* ID1, ID2 and CM = deflate */
+            if (gzip_handle->field[0] != 0x1f || gzip_handle->field[1] != 0x8b || gzip_handle->field[2] != 8)
+            {
+                ESP_LOGE(SIM800L_GZIP_TAG, "Not a gzip stream");
+                return SIM800L_RET_ERROR;
+            }
+
+            gzip_handle->flags = gzip_handle->field[3];
+            sim800l_gzip_next_field(gzip_handle);
+            break;
+
+        case SIM800L_GZIP_STATE_EXTRA_LEN:
+            gzip_handle->field[gzip_handle->field_pos++] = byte;
+            pos++;
+
+            if (gzip_handle->field_pos < gzip_handle->field_len)
+            {
+                break;
+            }
+
+            gzip_handle->state = SIM800L_GZIP_STATE_EXTRA;
+            gzip_handle->field_len = gzip_handle->field[0] | (gzip_handle->field[1] << 8);
+            gzip_handle->field_pos = 0;
+
+            if (gzip_handle->field_len == 0)
+            {
+                sim800l_gzip_next_field(gzip_handle);
+            }
+            break;
+
+        case SIM800L_GZIP_STATE_EXTRA:
+        case SIM800L_GZIP_STATE_HCRC:
+        {
+            /* Skipped fields */
+            size_t skip = data_len - pos;
+            if (skip > gzip_handle->field_len - gzip_handle->field_pos)
+            {
+                skip = gzip_handle->field_len - gzip_handle->field_pos;
+            }
+
+            gzip_handle->field_pos += skip;
+            pos += skip;
+
+            if (gzip_handle->field_pos == gzip_handle->field_len)
+            {
+                sim800l_gzip_next_field(gzip_handle);
+            }
+            break;
+        }
+
+        case SIM800L_GZIP_STATE_NAME:
+        case SIM800L_GZIP_STATE_COMMENT:
+            /* Zero terminated fields */
+            pos++;
+
+            if (byte == 0)
+            {
+                sim800l_gzip_next_field(gzip_handle);
+            }
+            break;
+
+        case SIM800L_GZIP_STATE_BODY:
+        {
+            size_t used = 0;
+            sim800l_ret_t ret = sim800l_gzip_inflate_body(gzip_handle, data + pos, data_len - pos, &used);
+            if (ret != SIM800L_RET_OK)
+            {
+                return ret;
+            }
+
+            pos += used;
+
+            /* Input exhausted before the end of the stream */
+            if (gzip_handle->state == SIM800L_GZIP_STATE_BODY)
+            {
+                return SIM800L_RET_OK;
+            }
+            break;
+        }
+
+        case SIM800L_GZIP_STATE_TRAILER:
+        {
+            gzip_handle->field[gzip_handle->field_pos++] = byte;
+            pos++;
+
+            if (gzip_handle->field_pos < gzip_handle->field_len)
+            {
+                break;
+            }
+
+            /* CRC-32 and ISIZE, both little endian */
+            uint32_t crc32 = gzip_handle->field[0] | (gzip_handle->field[1] << 8) | (gzip_handle->field[2] << 16) | ((uint32_t)gzip_handle->field[3] << 24);
+            uint32_t isize = gzip_handle->field[4] | (gzip_handle->field[5] << 8) | (gzip_handle->field[6] << 16) | ((uint32_t)gzip_handle->field[7] << 24);
+
+            gzip_handle->state = SIM800L_GZIP_STATE_DONE;
+
+            if (crc32 != gzip_handle->crc32 || isize != gzip_handle->total_out)
+            {
+                ESP_LOGE(SIM800L_GZIP_TAG, "gzip trailer mismatch: crc 0x%08x/0x%08x, size %u/%u",
+                         (unsigned)crc32, (unsigned)gzip_handle->crc32, (unsigned)isize, (unsigned)gzip_handle->total_out);
+                return SIM800L_RET_ERROR_CHECKSUM;
+            }
+            break;
+        }
+
+        case SIM800L_GZIP_STATE_DONE:
+        default:
+            /* Trailing garbage, a second member is not supported */
+            ESP_LOGW(SIM800L_GZIP_TAG, "Ignoring %u bytes after the end of the stream", (unsigned)(data_len - pos));
+            return SIM800L_RET_OK;
+        }
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_gzip_inflate_finish(sim800l_gzip_handle_t gzip_handle, uint32_t *total_out)
+{
+    ESP_LOGD(SIM800L_GZIP_TAG, "%s", __func__);
+
+    /* Check args */
+    if (gzip_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (total_out != NULL)
+    {
+        *total_out = gzip_handle->total_out;
+    }
+
+    /* Stream must have reached its end marker (and trailer) */
+    if (gzip_handle->state != SIM800L_GZIP_STATE_DONE)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Truncated stream");
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+void sim800l_gzip_inflate_deinit(sim800l_gzip_handle_t gzip_handle)
+{
+    ESP_LOGD(SIM800L_GZIP_TAG, "%s", __func__);
+
+    if (gzip_handle == NULL)
+    {
+        return;
+    }
+
+    free(gzip_handle->window);
+    free(gzip_handle);
+}
+
+sim800l_ret_t sim800l_gzip_deflate(const uint8_t *data, size_t data_len, uint8_t **out, size_t *out_len)
+{
+    ESP_LOGD(SIM800L_GZIP_TAG, "%s", __func__);
+
+    /* Check args */
+    if ((data == NULL && data_len > 0) || out == NULL || out_len == NULL)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Worst case is 9 bits per literal plus framing */
+    sim800l_gzip_bits_t bits = {0};
+    bits.out_size = SIM800L_GZIP_HEADER_SIZE + data_len + data_len / 8 + 8 + SIM800L_GZIP_TRAILER_SIZE;
+    bits.out = malloc(bits.out_size);
+    if (bits.out == NULL)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Match finder: last position per hash and a chain bounded by the window */
+    uint32_t *head = calloc(SIM800L_GZIP_HASH_SIZE, sizeof(uint32_t));
+    uint32_t *prev = calloc(SIM800L_GZIP_WINDOW_SIZE, sizeof(uint32_t));
+    if (head == NULL || prev == NULL)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Memory allocation failed");
+        free(head);
+        free(prev);
+        free(bits.out);
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* gzip header: deflate, no flags, no mtime, unknown OS */
+    static const uint8_t header[SIM800L_GZIP_HEADER_SIZE] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+    memcpy(bits.out, header, sizeof(header));
+    bits.out_len = sizeof(header);
+
+    /* Single final block with the fixed Huffman code */
+    sim800l_gzip_put_bits(&bits, 1, 1);
+    sim800l_gzip_put_bits(&bits, 1, 2);
+
+    size_t pos = 0;
+    while (pos < data_len)
+    {
+        uint32_t best_len = 0;
+        uint32_t best_dist = 0;
+
+        if (pos + SIM800L_GZIP_MIN_MATCH <= data_len)
+        {
+            uint32_t hash = ((data[pos] << 16) | (data[pos + 1] << 8) | data[pos + 2]) * 2654435761u >> (32 - SIM800L_GZIP_HASH_BITS);
+            size_t max_len = data_len - pos;
+            if (max_len > SIM800L_GZIP_MAX_MATCH)
+            {
+                max_len = SIM800L_GZIP_MAX_MATCH;
+            }
+
+            /* Walk the chain, entries are position + 1 so that 0 means empty */
+            uint32_t candidate = head[hash];
+            for (uint32_t chain = 0; candidate != 0 && chain < SIM800L_GZIP_MAX_CHAIN; chain++)
+            {
+                size_t match_pos = candidate - 1;
+                if (pos - match_pos >= SIM800L_GZIP_WINDOW_SIZE)
+                {
+                    break;
+                }
+
+                uint32_t len = 0;
+                while (len < max_len && data[match_pos + len] == data[pos + len])
+                {
+                    len++;
+                }
+
+                if (len > best_len)
+                {
+                    best_len = len;
+                    best_dist = pos - match_pos;
+                    if (len == max_len)
+                    {
+                        break;
+                    }
+                }
+
+                candidate = prev[match_pos & (SIM800L_GZIP_WINDOW_SIZE - 1)];
+            }
+        }
+
+        if (best_len < SIM800L_GZIP_MIN_MATCH)
+        {
+            sim800l_gzip_put_literal(&bits, data[pos]);
+            best_len = 1;
+        }
+        else
+        {
+            sim800l_gzip_put_match(&bits, best_len, best_dist);
+        }
+
+        /* Index every position covered by the literal or match */
+        for (size_t end = pos + best_len; pos < end; pos++)
+        {
+            if (pos + SIM800L_GZIP_MIN_MATCH <= data_len)
+            {
+                uint32_t hash = ((data[pos] << 16) | (data[pos + 1] << 8) | data[pos + 2]) * 2654435761u >> (32 - SIM800L_GZIP_HASH_BITS);
+                prev[pos & (SIM800L_GZIP_WINDOW_SIZE - 1)] = head[hash];
+                head[hash] = pos + 1;
+            }
+        }
+    }
+
+    free(head);
+    free(prev);
+
+    /* End of block and flush to a byte boundary */
+    sim800l_gzip_put_literal(&bits, 256);
+    sim800l_gzip_put_bits(&bits, 0, (8 - bits.bit_count) & 7);
+
+    /* Trailer: CRC-32 and ISIZE, little endian */
+    uint32_t crc32 = esp_rom_crc32_le(0, data, data_len);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        sim800l_gzip_put_bits(&bits, (crc32 >> (8 * i)) & 0xff, 8);
+    }
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        sim800l_gzip_put_bits(&bits, ((uint32_t)data_len >> (8 * i)) & 0xff, 8);
+    }
+
+    /* Output bound is exact, running past it is a bug */
+    if (bits.out_len > bits.out_size)
+    {
+        ESP_LOGE(SIM800L_GZIP_TAG, "Deflate output overflow");
+        free(bits.out);
+        return SIM800L_RET_ERROR;
+    }
+
+    ESP_LOGI(SIM800L_GZIP_TAG, "Deflated %u -> %u bytes", (unsigned)data_len, (unsigned)bits.out_len);
+
+    *out = bits.out;
+    *out_len = bits.out_len;
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static sim800l_ret_t sim800l_gzip_inflate_body(sim800l_gzip_handle_t gzip_handle, const uint8_t *data, size_t data_len, size_t *used)
+{
+    uint32_t flags = TINFL_FLAG_HAS_MORE_INPUT;
+    if (gzip_handle->format == SIM800L_GZIP_FORMAT_ZLIB)
+    {
+        flags |= TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32;
+    }
+
+    size_t pos = 0;
+    for (;;)
+    {
+        size_t in_size = data_len - pos;
+        size_t out_size = TINFL_LZ_DICT_SIZE - gzip_handle->window_ofs;
+
+        tinfl_status status = tinfl_decompress(&gzip_handle->decomp, data + pos, &in_size,
+                                               gzip_handle->window, gzip_handle->window + gzip_handle->window_ofs, &out_size, flags);
+        pos += in_size;
+
+        /* Hand out what was produced before the window wraps over it */
+        if (out_size > 0)
+        {
+            const uint8_t *produced = gzip_handle->window + gzip_handle->window_ofs;
+
+            gzip_handle->crc32 = esp_rom_crc32_le(gzip_handle->crc32, produced, out_size);
+            gzip_handle->total_out += out_size;
+            gzip_handle->window_ofs = (gzip_handle->window_ofs + out_size) & (TINFL_LZ_DICT_SIZE - 1);
+
+            sim800l_ret_t ret = gzip_handle->output(produced, out_size, gzip_handle->arg);
+            if (ret != SIM800L_RET_OK)
+            {
+                *used = pos;
+                return ret;
+            }
+        }
+
+        if (status < TINFL_STATUS_DONE)
+        {
+            ESP_LOGE(SIM800L_GZIP_TAG, "tinfl_decompress failed: %d", status);
+            *used = pos;
+            return SIM800L_RET_ERROR;
+        }
+
+        if (status == TINFL_STATUS_DONE)
+        {
+            if (gzip_handle->format == SIM800L_GZIP_FORMAT_GZIP)
+            {
+                gzip_handle->state = SIM800L_GZIP_STATE_TRAILER;
+                gzip_handle->field_len = SIM800L_GZIP_TRAILER_SIZE;
+                gzip_handle->field_pos = 0;
+            }
+            else
+            {
+                gzip_handle->state = SIM800L_GZIP_STATE_DONE;
+            }
+            break;
+        }
+
+        /* HAS_MORE_OUTPUT loops, NEEDS_MORE_INPUT waits for the next feed */
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && pos == data_len)
+        {
+            break;
+        }
+    }
+
+    *used = pos;
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_gzip_next_field(sim800l_gzip_handle_t gzip_handle)
+{
+    gzip_handle->field_pos = 0;
+
+    /* Optional header fields come in this order (RFC 1952 2.3.1) */
+    if (gzip_handle->flags & SIM800L_GZIP_FLAG_EXTRA)
+    {
+        gzip_handle->flags &= ~SIM800L_GZIP_FLAG_EXTRA;
+        gzip_handle->state = SIM800L_GZIP_STATE_EXTRA_LEN;
+        gzip_handle->field_len = 2;
+    }
+    else if (gzip_handle->flags & SIM800L_GZIP_FLAG_NAME)
+    {
+        gzip_handle->flags &= ~SIM800L_GZIP_FLAG_NAME;
+        gzip_handle->state = SIM800L_GZIP_STATE_NAME;
+    }
+    else if (gzip_handle->flags & SIM800L_GZIP_FLAG_COMMENT)
+    {
+        gzip_handle->flags &= ~SIM800L_GZIP_FLAG_COMMENT;
+        gzip_handle->state = SIM800L_GZIP_STATE_COMMENT;
+    }
+    else if (gzip_handle->flags & SIM800L_GZIP_FLAG_HCRC)
+    {
+        gzip_handle->flags &= ~SIM800L_GZIP_FLAG_HCRC;
+        gzip_handle->state = SIM800L_GZIP_STATE_HCRC;
+        gzip_handle->field_len = 2;
+    }
+    else
+    {
+        gzip_handle->state = SIM800L_GZIP_STATE_BODY;
+    }
+}
+
+static void sim800l_gzip_put_bits(sim800l_gzip_bits_t *bits, uint32_t value, uint32_t count)
+{
+    /* Deflate packs bits LSB first */
+    bits->bit_buf |= value << bits->bit_count;
+    bits->bit_count += count;
+
+    while (bits->bit_count >= 8)
+    {
+        if (bits->out_len < bits->out_size)
+        {
+            bits->out[bits->out_len] = bits->bit_buf & 0xff;
+        }
+
+        bits->out_len++;
+        bits->bit_buf >>= 8;
+        bits->bit_count -= 8;
+    }
+}
+
+static void sim800l_gzip_put_code(sim800l_gzip_bits_t *bits, uint32_t code, uint32_t count)
+{
+    /* Huffman codes are stored MSB first */
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+
+    sim800l_gzip_put_bits(bits, reversed, count);
+}
+
+static void sim800l_gzip_put_literal(sim800l_gzip_bits_t *bits, uint32_t symbol)
+{
+    /* Fixed literal/length code (RFC 1951 3.2.6) */
+    if (symbol <= 143)
+    {
+        sim800l_gzip_put_code(bits, 0x30 + symbol, 8);
+    }
+    else if (symbol <= 255)
+    {
+        sim800l_gzip_put_code(bits, 0x190 + symbol - 144, 9);
+    }
+    else if (symbol <= 279)
+    {
+        sim800l_gzip_put_code(bits, symbol - 256, 7);
+    }
+    else
+    {
+        sim800l_gzip_put_code(bits, 0xc0 + symbol - 280, 8);
+    }
+}
+
+static void sim800l_gzip_put_match(sim800l_gzip_bits_t *bits, uint32_t length, uint32_t distance)
+{
+    uint32_t code = 28;
+    while (sim800l_gzip_length_base[code] > length)
+    {
+        code--;
+    }
+
+    sim800l_gzip_put_literal(bits, 257 + code);
+    sim800l_gzip_put_bits(bits, length - sim800l_gzip_length_base[code], sim800l_gzip_length_extra[code]);
+
+    code = 29;
+    while (sim800l_gzip_dist_base[code] > distance)
+    {
+        code--;
+    }
+
+    /* Fixed distance codes are plain 5 bit numbers */
+    sim800l_gzip_put_code(bits, code, 5);
+    sim800l_gzip_put_bits(bits, distance - sim800l_gzip_dist_base[code], sim800l_gzip_dist_extra[code]);
+}
@@ -14,13 +14,89 @@
 #include "sim800l_http.h"
 #include "sim800l_common.h"
 #include "sim800l_misc.h"
+#include "sim800l_bearer.h"
+#include "sim800l_shadow.h"
 #include <string.h>
+#include <esp_timer.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 
 #define SIM800L_HTTP_TAG "SIM800L HTTP"
 
 #define SIM800L_EVENT_HTTP_ACTION_STR "+HTTPACTION"
+#define SIM800L_DATA_HTTP_READ_STR "+HTTPREAD:"
+#define SIM800L_DATA_HTTP_HEAD_STR "+HTTPHEAD:"
+
+#define SIM800L_HTTP_DOWNLOAD_RANGE_SIZE        16384
+#define SIM800L_HTTP_DOWNLOAD_CHUNK_SIZE        256
+#define SIM800L_HTTP_DOWNLOAD_ACTION_TIMEOUT    60000
+#define SIM800L_HTTP_DOWNLOAD_BACKOFF_MS        1000
+#define SIM800L_HTTP_DOWNLOAD_BACKOFF_MAX_MS    30000
+
+#define SIM800L_HTTP_SESSION_HANDSHAKE_TIMEOUT  120000
+#define SIM800L_HTTP_SESSION_REQUEST_TIMEOUT    60000
+
+#define SIM800L_HTTP_COMPRESSED_CHUNK_SIZE      512
+#define SIM800L_HTTP_DATA_TIMEOUT               5000
+
+/*
+ *     HTTPPARA values in the settings shadow, HTTPINIT and HTTPTERM reset them
+ */
+#define SIM800L_HTTP_SHADOW_PREFIX              "HTTPPARA:"
+#define SIM800L_HTTP_SHADOW_PARAMS              11
+
+/*
+ *     HTTP read context, the mutex keeps the buffer (and the HTTPHEAD parser) alive while the bridge task uses it
+ */
+typedef struct
+{
+    SemaphoreHandle_t mutex;
+    uint8_t *buffer;
+    size_t buffer_size;
+    size_t data_len;
+} sim800l_http_read_ctx_t;
+
+static sim800l_http_read_ctx_t sim800l_http_read_ctx = {0};
+
+/*
+ *     HTTP head parser, fed from the bridge task
+ */
+static sim800l_http_header_parser_t *sim800l_http_head_parser = NULL;
+
+/*
+ *     Last +HTTPACTION result
+ */
+static sim800l_http_action_t sim800l_http_last_action = {0};
+
+/*
+ *     Compressed transfer context
+ */
+typedef struct
+{
+    sim800l_gzip_output_t data_callback;
+    void *arg;
+    sim800l_http_transfer_stats_t *stats;
+    bool gzip;
+    bool deflate;
+} sim800l_http_compressed_ctx_t;
+
+static sim800l_ret_t sim800l_http_download_range(sim800l_handle_t sim800l_handle, const sim800l_http_download_config_t *config, sim800l_http_download_checkpoint_t *checkpoint, sim800l_http_download_stats_t *stats, uint8_t *chunk, bool *complete, bool *abort);
+static sim800l_ret_t sim800l_http_download_reconnect(sim800l_handle_t sim800l_handle, uint32_t cid);
+static void sim800l_http_header_parse_line(sim800l_http_header_parser_t *parser, const char *line, size_t line_len);
+static void sim800l_http_conditional_header(const char *name, size_t name_len, const char *value, size_t value_len, void *arg);
+static void sim800l_http_encoding_header(const char *name, size_t name_len, const char *value, size_t value_len, void *arg);
+static sim800l_ret_t sim800l_http_compressed_output(const uint8_t *data, size_t data_len, void *arg);
+static sim800l_ret_t sim800l_http_compressed_read(sim800l_handle_t sim800l_handle, uint32_t content_length, sim800l_http_compressed_ctx_t *ctx);
+static bool sim800l_http_shadow_get(sim800l_http_param_t *param);
+static void sim800l_http_shadow_put(const sim800l_http_param_t *param);
+static sim800l_ret_t sim800l_http_conditional_request(sim800l_handle_t sim800l_handle, sim800l_http_conditional_t *conditional, sim800l_http_action_t *action, uint8_t *buffer, size_t buffer_size, size_t *data_len);
+static void sim800l_http_escape_quotes(const char *input, char *output, size_t output_size);
 
 sim800l_event_t sim800l_event_http_action(char **input_args, void *output_data);
+void sim800l_data_http_read(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg);
+void sim800l_data_http_head(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg);
 
 sim800l_ret_t sim800l_http_switch(sim800l_handle_t sim800l_handle, bool enable)
 {
@@ -37,6 +113,30 @@ sim800l_ret_t sim800l_http_switch(sim800l_handle_t sim800l_handle, bool enable)
             return SIM800L_RET_ERROR;
         }
 
+        if (sim800l_http_read_ctx.mutex == NULL)
+        {
+            sim800l_http_read_ctx.mutex = xSemaphoreCreateMutex();
+            if (sim800l_http_read_ctx.mutex == NULL)
+            {
+                ESP_LOGE(SIM800L_HTTP_TAG, "Mutex creation failed");
+                return SIM800L_RET_ERROR_MEM;
+            }
+        }
+
+        /* Register HTTPREAD payload callback, data length is the first arg */
+        if (sim800l_register_data_callback(SIM800L_DATA_HTTP_READ_STR, 0, sim800l_data_http_read, &sim800l_http_read_ctx) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_register_data_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
+        /* Register HTTPHEAD payload callback */
+        if (sim800l_register_data_callback(SIM800L_DATA_HTTP_HEAD_STR, 0, sim800l_data_http_head, NULL) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_register_data_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
         /* Assembly of the command to be sent */
         if (strncpy(command, SIM800L_COMMAND_HTTP_INIT, strlen(SIM800L_COMMAND_HTTP_INIT)) == NULL)
         {
@@ -53,6 +153,18 @@ sim800l_ret_t sim800l_http_switch(sim800l_handle_t sim800l_handle, bool enable)
             return SIM800L_RET_ERROR;
         }
 
+        if (sim800l_unregister_data_callback(SIM800L_DATA_HTTP_READ_STR) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_unregister_data_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
+        if (sim800l_unregister_data_callback(SIM800L_DATA_HTTP_HEAD_STR) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_unregister_data_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
         /* Assembly of the command to be sent */
         if (strncpy(command, SIM800L_COMMAND_HTTP_TERMINATE, strlen(SIM800L_COMMAND_HTTP_TERMINATE)) == NULL)
         {
@@ -61,11 +173,14 @@ sim800l_ret_t sim800l_http_switch(sim800l_handle_t sim800l_handle, bool enable)
         }
     }
 
+    /* Both start over from the HTTPPARA defaults */
+    sim800l_shadow_invalidate(SIM800L_HTTP_SHADOW_PREFIX);
+
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Send AT command */
-    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, 2000);
+    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, sizeof(response), 2000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_out_data failed: %s", esp_err_to_name(ret));
@@ -182,6 +297,14 @@ sim800l_ret_t sim800l_http_set_param(sim800l_handle_t sim800l_handle, sim800l_ht
         return SIM800L_RET_INVALID_ARG;
     }
 
+    /* Already set since HTTPINIT, nothing to send */
+    char key[SIM800L_SHADOW_KEY_SIZE] = {0};
+    snprintf(key, sizeof(key), "%s%s", SIM800L_HTTP_SHADOW_PREFIX, http_parameter);
+    if (sim800l_shadow_unchanged(key, value))
+    {
+        return SIM800L_RET_OK;
+    }
+
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_HTTP_PARAM) 
                             + strlen(http_parameter) 
@@ -210,7 +333,7 @@ sim800l_ret_t sim800l_http_set_param(sim800l_handle_t sim800l_handle, sim800l_ht
     char response[100] = {0};
 
     /* Send command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 60000) != ESP_OK)
+    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 60000) != ESP_OK)
     {
         ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_call_answer failed");
         free(command);
@@ -226,6 +349,8 @@ sim800l_ret_t sim800l_http_set_param(sim800l_handle_t sim800l_handle, sim800l_ht
         return SIM800L_RET_ERROR;
     }
 
+    sim800l_shadow_store(key, value);
+
     return SIM800L_RET_OK;
 }
 
@@ -233,6 +358,13 @@ sim800l_ret_t sim800l_http_get_param(sim800l_handle_t sim800l_handle, sim800l_ht
 {
     ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
 
+    /* Every parameter known since HTTPINIT, no need to ask */
+    if (sim800l_http_shadow_get(param))
+    {
+        sim800l_shadow_count_served();
+        return SIM800L_RET_OK;
+    }
+
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_HTTP_PARAM) 
                             + sizeof(char) 
@@ -259,7 +391,7 @@ sim800l_ret_t sim800l_http_get_param(sim800l_handle_t sim800l_handle, sim800l_ht
     char response[256] = {0};
 
     /* Send command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 60000) != ESP_OK)
+    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 60000) != ESP_OK)
     {
         ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_call_answer failed");
         free(command);
@@ -439,6 +571,8 @@ sim800l_ret_t sim800l_http_get_param(sim800l_handle_t sim800l_handle, sim800l_ht
         return SIM800L_RET_ERROR;
     }
 
+    sim800l_http_shadow_put(param);
+
     return SIM800L_RET_OK;
 }
 
@@ -469,7 +603,7 @@ sim800l_ret_t sim800l_http_action(sim800l_handle_t sim800l_handle, sim800l_http_
     char response[128] = {0};
     
     /* Send AT command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000) != ESP_OK)
+    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
     {
         ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_call_answer failed");
         free(command);
@@ -492,27 +626,104 @@ sim800l_ret_t sim800l_http_read(sim800l_handle_t sim800l_handle, uint32_t start_
 {
     ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
 
-    if (buffer == NULL)
+    size_t data_len = 0;
+
+    /* Read payload */
+    sim800l_ret_t ret = sim800l_http_read_data(sim800l_handle, start_addr, length, buffer, &data_len);
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    /* Add byte \0 when it fits */
+    if (data_len < length)
+    {
+        buffer[data_len] = '\0';
+    }
+
+    ESP_LOGI(SIM800L_HTTP_TAG, "Response: %.*s", (int)data_len, (char *)buffer);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_http_read_data(sim800l_handle_t sim800l_handle, uint32_t start_addr, size_t length, uint8_t *buffer, size_t *data_len)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if ((buffer == NULL) || (data_len == NULL))
     {
         ESP_LOGE(SIM800L_HTTP_TAG, "Buffer is NULL");
         return SIM800L_RET_INVALID_ARG;
     }
 
-    char start_addr_str[8] = {0};
-    if (snprintf(start_addr_str, sizeof(start_addr_str), "%lu", start_addr) < 0)
+    if (sim800l_http_read_ctx.mutex == NULL)
     {
-        ESP_LOGE(SIM800L_HTTP_TAG, "Assembly of the command to be sent failed");
-        return SIM800L_RET_ERROR_BUILD_COMMAND;
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTP not initialized");
+        return SIM800L_RET_ERROR;
+    }
+
+    uint32_t command_length = strlen(SIM800L_COMMAND_HTTP_READ) + 2 * sizeof(char) + 2 * 10 + strlen("\r\n") + 1; /* cmd=d,d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
     }
 
-    char length_str[8] = {0};
-    if (snprintf(length_str, sizeof(length_str), "%d", length) < 0)
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=%lu,%u\r\n", SIM800L_COMMAND_HTTP_READ, start_addr, length) < 0)
     {
         ESP_LOGE(SIM800L_HTTP_TAG, "Assembly of the command to be sent failed");
+        free(command);
         return SIM800L_RET_ERROR_BUILD_COMMAND;
     }
 
-    uint32_t command_length = strlen(SIM800L_COMMAND_HTTP_READ) + 2 * sizeof(char) + strlen(start_addr_str) + strlen(length_str) + strlen("\r\n") + 1; /* cmd=d,d\r\n */
+    /* Payload goes straight to the caller buffer */
+    xSemaphoreTake(sim800l_http_read_ctx.mutex, portMAX_DELAY);
+    sim800l_http_read_ctx.buffer = buffer;
+    sim800l_http_read_ctx.buffer_size = length;
+    sim800l_http_read_ctx.data_len = 0;
+    xSemaphoreGive(sim800l_http_read_ctx.mutex);
+
+    /* Response */
+    char response[64] = {0};
+
+    /* Send command, allow ~1 ms per byte on the wire */
+    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000 + length);
+
+    /* On timeout the payload may still be arriving, wait out a copy in progress and drop the rest */
+    xSemaphoreTake(sim800l_http_read_ctx.mutex, portMAX_DELAY);
+    sim800l_http_read_ctx.buffer = NULL;
+    size_t read_len = sim800l_http_read_ctx.data_len;
+    xSemaphoreGive(sim800l_http_read_ctx.mutex);
+    free(command);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Command sending failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* Check response */
+    if (strnstr(response, "ERROR", sizeof(response)) != NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Command sending failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    *data_len = read_len;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_http_action_wait(sim800l_handle_t sim800l_handle, sim800l_http_method_t method, sim800l_http_action_t *action, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    /* Command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_HTTP_ACTION) + 2*sizeof(char) + strlen("\r\n") + 1; /* cmd=d\r\n */
 
     /* Allocate dinamic memory */
     uint8_t *command = calloc(command_length, sizeof(uint8_t));
@@ -522,77 +733,1308 @@ sim800l_ret_t sim800l_http_read(sim800l_handle_t sim800l_handle, uint32_t start_
         return SIM800L_RET_ERROR_MEM;
     }
 
-    ESP_LOGI(SIM800L_HTTP_TAG, "start_addr_str: %s", start_addr_str);
-
     /* Assembly of the command to be sent */
-    if (snprintf((char *)command, command_length, "%s=%s,%s\r\n", SIM800L_COMMAND_HTTP_READ, start_addr_str, length_str) < 0)
+    if (snprintf((char*)command, command_length, "%s=%d\r\n", SIM800L_COMMAND_HTTP_ACTION, method) < 0)
     {
         ESP_LOGE(SIM800L_HTTP_TAG, "Assembly of the command to be sent failed");
         free(command);
         return SIM800L_RET_ERROR_BUILD_COMMAND;
     }
 
-    /* Response */
-    char response[512] = {0};
+    memset(&sim800l_http_last_action, 0, sizeof(sim800l_http_action_t));
 
-    /* Send command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000) != ESP_OK)
+    /* Send AT command and wait for +HTTPACTION */
+    if (sim800l_out_data_event(sim800l_handle, command, SIM800L_EVENT_HTTP_ACTION, timeout) != ESP_OK)
     {
-        ESP_LOGE(SIM800L_HTTP_TAG, "Command sending failed");
+        ESP_LOGE(SIM800L_HTTP_TAG, "+HTTPACTION not received");
         free(command);
         return SIM800L_RET_ERROR_SEND_COMMAND;
     }
 
     free(command);
 
-    /* Check response */
-    if (strncmp(response, "ERROR", strlen("ERROR")) == 0)
+    if (action != NULL)
     {
-        ESP_LOGE(SIM800L_HTTP_TAG, "Command sending failed");
+        memcpy(action, &sim800l_http_last_action, sizeof(sim800l_http_action_t));
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_http_download(sim800l_handle_t sim800l_handle, const sim800l_http_download_config_t *config, sim800l_http_download_checkpoint_t *checkpoint, sim800l_http_download_stats_t *stats)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    /* Check args */
+    if ((config == NULL) || (config->url == NULL) || (checkpoint == NULL))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Apply defaults */
+    sim800l_http_download_config_t download_config = *config;
+    if (download_config.cid == 0)
+    {
+        download_config.cid = 1;
+    }
+    if (download_config.range_size == 0)
+    {
+        download_config.range_size = SIM800L_HTTP_DOWNLOAD_RANGE_SIZE;
+    }
+    if (download_config.chunk_size == 0)
+    {
+        download_config.chunk_size = SIM800L_HTTP_DOWNLOAD_CHUNK_SIZE;
+    }
+    if (download_config.action_timeout == 0)
+    {
+        download_config.action_timeout = SIM800L_HTTP_DOWNLOAD_ACTION_TIMEOUT;
+    }
+
+    sim800l_http_download_stats_t download_stats = {0};
+
+    /* Allocate chunk buffer */
+    uint8_t *chunk = calloc(download_config.chunk_size, sizeof(uint8_t));
+    if (chunk == NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    ESP_LOGI(SIM800L_HTTP_TAG, "Download from offset %lu", checkpoint->offset);
+
+    int64_t start_time = esp_timer_get_time();
+    uint32_t failures = 0;
+    bool complete = false;
+    bool abort = false;
+    bool linked = true;
+    sim800l_ret_t ret = SIM800L_RET_OK;
+
+    while (!complete)
+    {
+        /* Fetch the next range, no point without a link */
+        if (linked)
+        {
+            ret = sim800l_http_download_range(sim800l_handle, &download_config, checkpoint, &download_stats, chunk, &complete, &abort);
+            if (ret == SIM800L_RET_OK)
+            {
+                failures = 0;
+                continue;
+            }
+
+            if (abort)
+            {
+                ESP_LOGE(SIM800L_HTTP_TAG, "Download aborted by data callback");
+                break;
+            }
+        }
+
+        if (failures >= download_config.max_retries)
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "Download failed at offset %lu", checkpoint->offset);
+            break;
+        }
+
+        /* Back off, then bring the link up again and resume from the last good offset */
+        uint32_t backoff = SIM800L_HTTP_DOWNLOAD_BACKOFF_MS << (failures < 5 ? failures : 5);
+        if (backoff > SIM800L_HTTP_DOWNLOAD_BACKOFF_MAX_MS)
+        {
+            backoff = SIM800L_HTTP_DOWNLOAD_BACKOFF_MAX_MS;
+        }
+
+        failures++;
+        download_stats.retries++;
+
+        ESP_LOGW(SIM800L_HTTP_TAG, "Range failed at offset %lu, retry %lu in %lu ms", checkpoint->offset, failures, backoff);
+        vTaskDelay(backoff / portTICK_PERIOD_MS);
+
+        if (download_config.reconnect_callback != NULL)
+        {
+            ret = download_config.reconnect_callback(sim800l_handle, download_config.arg);
+        }
+        else
+        {
+            ret = sim800l_http_download_reconnect(sim800l_handle, download_config.cid);
+        }
+
+        /* A failed reconnect uses up the retry, back off again before the next range */
+        linked = (ret == SIM800L_RET_OK);
+        if (!linked)
+        {
+            ESP_LOGW(SIM800L_HTTP_TAG, "Reconnect failed, retry %lu", failures);
+        }
+    }
+
+    free(chunk);
+
+    /* Throughput */
+    download_stats.elapsed_us = (uint64_t)(esp_timer_get_time() - start_time);
+    if (download_stats.elapsed_us > 0)
+    {
+        download_stats.throughput = (uint32_t)(((uint64_t)download_stats.bytes * 1000000) / download_stats.elapsed_us);
+    }
+
+    if (stats != NULL)
+    {
+        memcpy(stats, &download_stats, sizeof(sim800l_http_download_stats_t));
+    }
+
+    if (!complete)
+    {
+        return (ret != SIM800L_RET_OK) ? ret : SIM800L_RET_ERROR;
+    }
+
+    ESP_LOGI(SIM800L_HTTP_TAG, "Download complete: %lu bytes, crc32 0x%08lx, %lu B/s", checkpoint->total_length, checkpoint->crc32, download_stats.throughput);
+
+    /* Verify */
+    if (download_config.verify_crc32 && (checkpoint->crc32 != download_config.expected_crc32))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "CRC-32 mismatch: 0x%08lx != 0x%08lx", checkpoint->crc32, download_config.expected_crc32);
+
+        /* Nothing can be trusted, start over next time */
+        memset(checkpoint, 0, sizeof(sim800l_http_download_checkpoint_t));
+        return SIM800L_RET_ERROR_CHECKSUM;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_http_ssl(sim800l_handle_t sim800l_handle, bool enable)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    char command[20] = {0};
+
+    /* Assembly of the command to be sent */
+    if (snprintf(command, sizeof(command), "%s=%d\r\n", SIM800L_COMMAND_HTTP_SSL, enable) < 0)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Assembly of the command to be sent failed");
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* Response */
+    char response[32] = {0};
+
+    /* Send AT command */
+    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, sizeof(response), 2000);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_out_data failed: %s", esp_err_to_name(ret));
         return SIM800L_RET_ERROR_SEND_COMMAND;
     }
 
-    char *response_start = strnstr(response, "\r\n", strlen(response)) + 1;
-    char *response_end = strnstr(response_start, "OK", strlen(response_start));
-    size_t response_length = response_end - response_start;
-    char buffer_temp[response_length + 1];
-    memset(buffer_temp, 0, response_length + 1);
-    if (strncpy(buffer_temp, response_start, response_length) == NULL)
+    if (strnstr(response, "OK", sizeof(response)) == NULL)
     {
-        ESP_LOGE(SIM800L_HTTP_TAG, "strncpy failed");
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTPSSL failed");
         return SIM800L_RET_ERROR;
     }
-    buffer[response_length] = '\0';
 
-    ESP_LOGI(SIM800L_HTTP_TAG, "Response: %s", buffer_temp);
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_http_session_open(sim800l_handle_t sim800l_handle, sim800l_http_session_t *session)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if (session == NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Session is NULL");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Already open */
+    if (session->open)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Init HTTP, a stale service from a previous run is terminated first */
+    if (sim800l_http_switch(sim800l_handle, true) != SIM800L_RET_OK)
+    {
+        sim800l_http_switch(sim800l_handle, false);
+
+        if (sim800l_http_switch(sim800l_handle, true) != SIM800L_RET_OK)
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_http_switch failed");
+            return SIM800L_RET_ERROR;
+        }
+    }
+
+    /* HTTPS */
+    if (sim800l_http_ssl(sim800l_handle, session->ssl) != SIM800L_RET_OK)
+    {
+        sim800l_http_switch(sim800l_handle, false);
+        return SIM800L_RET_ERROR;
+    }
 
-    if (strncpy((char *)buffer, buffer_temp, strlen(buffer_temp)) == NULL)
+    /* Bearer profile */
+    char value[12] = {0};
+    snprintf(value, sizeof(value), "%lu", (session->cid != 0) ? session->cid : 1);
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, value) != SIM800L_RET_OK)
     {
-        ESP_LOGE(SIM800L_HTTP_TAG, "strncpy failed");
+        sim800l_http_switch(sim800l_handle, false);
         return SIM800L_RET_ERROR;
     }
 
+    session->open = true;
+    session->warm = false;
+    session->url[0] = '\0';
+
     return SIM800L_RET_OK;
 }
 
-
-/*
- *     SIM800L call event functions
- */
-sim800l_event_t sim800l_event_http_action(char **input_args, void *output_data)
+sim800l_ret_t sim800l_http_session_request(sim800l_handle_t sim800l_handle, sim800l_http_session_t *session, const char *url, sim800l_http_method_t method, sim800l_http_action_t *action, uint8_t *buffer, size_t buffer_size, size_t *data_len, sim800l_http_timing_t *timing)
 {
     ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
 
-    sim800l_http_action_t *action = (sim800l_http_action_t *)output_data;
+    if ((session == NULL) || (url == NULL))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
 
-    /* Get Method */
-    action->method = atoi(input_args[0]);
+    sim800l_http_timing_t request_timing = {0};
+    request_timing.reused = session->warm;
 
-    /* Get http code */
-    action->http_code = atoi(input_args[1]);
+    int64_t time_mark = esp_timer_get_time();
 
-    /* Get content length */
-    action->content_length = atoi(input_args[2]);
+    /* Open on first use */
+    if (sim800l_http_session_open(sim800l_handle, session) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
 
-    return SIM800L_EVENT_HTTP_ACTION;
+    /* URL is only sent when it changes */
+    if (strncmp(session->url, url, sizeof(session->url)) != 0)
+    {
+        if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, url) != SIM800L_RET_OK)
+        {
+            session->url[0] = '\0';
+            return SIM800L_RET_ERROR;
+        }
+
+        strncpy(session->url, url, sizeof(session->url) - 1);
+    }
+
+    request_timing.setup_us = (uint64_t)(esp_timer_get_time() - time_mark);
+    time_mark = esp_timer_get_time();
+
+    /* New sessions pay the TCP connect and TLS handshake */
+    uint32_t timeout = session->warm ? session->request_timeout : session->handshake_timeout;
+    if (timeout == 0)
+    {
+        timeout = session->warm ? SIM800L_HTTP_SESSION_REQUEST_TIMEOUT : SIM800L_HTTP_SESSION_HANDSHAKE_TIMEOUT;
+    }
+
+    sim800l_http_action_t request_action = {0};
+    if (sim800l_http_action_wait(sim800l_handle, method, &request_action, timeout) != SIM800L_RET_OK)
+    {
+        /* Next request starts cold */
+        session->warm = false;
+        return SIM800L_RET_ERROR;
+    }
+
+    request_timing.action_us = (uint64_t)(esp_timer_get_time() - time_mark);
+
+    if (action != NULL)
+    {
+        memcpy(action, &request_action, sizeof(sim800l_http_action_t));
+    }
+
+    /* 6xx codes are modem side network errors */
+    if (request_action.http_code >= 600)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTP code %lu", request_action.http_code);
+        session->warm = false;
+        return SIM800L_RET_ERROR;
+    }
+
+    session->warm = true;
+
+    /* Body */
+    if ((buffer != NULL) && (data_len != NULL))
+    {
+        *data_len = 0;
+
+        size_t length = request_action.content_length;
+        if (length > buffer_size)
+        {
+            length = buffer_size;
+        }
+
+        time_mark = esp_timer_get_time();
+
+        if ((length > 0) && (sim800l_http_read_data(sim800l_handle, 0, length, buffer, data_len) != SIM800L_RET_OK))
+        {
+            return SIM800L_RET_ERROR;
+        }
+
+        request_timing.transfer_us = (uint64_t)(esp_timer_get_time() - time_mark);
+    }
+
+    ESP_LOGD(SIM800L_HTTP_TAG, "setup %llu us, action %llu us, transfer %llu us", request_timing.setup_us, request_timing.action_us, request_timing.transfer_us);
+
+    if (timing != NULL)
+    {
+        memcpy(timing, &request_timing, sizeof(sim800l_http_timing_t));
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_http_session_close(sim800l_handle_t sim800l_handle, sim800l_http_session_t *session)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if ((session == NULL) || !session->open)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    session->open = false;
+    session->warm = false;
+    session->url[0] = '\0';
+
+    return sim800l_http_switch(sim800l_handle, false);
+}
+
+sim800l_ret_t sim800l_http_read_header(sim800l_handle_t sim800l_handle, sim800l_http_header_callback_t callback, void *arg)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if (callback == NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Callback is NULL");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_http_read_ctx.mutex == NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTP not initialized");
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Header lines are parsed as they come out of the UART */
+    sim800l_http_header_parser_t parser;
+    sim800l_http_header_parser_init(&parser, callback, arg);
+
+    xSemaphoreTake(sim800l_http_read_ctx.mutex, portMAX_DELAY);
+    sim800l_http_head_parser = &parser;
+    xSemaphoreGive(sim800l_http_read_ctx.mutex);
+
+    /* Response */
+    char response[64] = {0};
+
+    /* Send AT command */
+    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_HTTP_HEAD, (uint8_t *)response, sizeof(response), 2000);
+
+    /* The parser lives on this stack, a late HTTPHEAD payload must not reach it */
+    xSemaphoreTake(sim800l_http_read_ctx.mutex, portMAX_DELAY);
+    sim800l_http_head_parser = NULL;
+    xSemaphoreGive(sim800l_http_read_ctx.mutex);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_out_data failed: %s", esp_err_to_name(ret));
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    if (strnstr(response, "ERROR", sizeof(response)) != NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTPHEAD failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Last line without CRLF */
+    sim800l_http_header_parser_finish(&parser);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_http_get_conditional(sim800l_handle_t sim800l_handle, const char *url, sim800l_http_conditional_t *conditional, sim800l_http_action_t *action, uint8_t *buffer, size_t buffer_size, size_t *data_len)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if ((url == NULL) || (conditional == NULL))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (data_len != NULL)
+    {
+        *data_len = 0;
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, url) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Validator from the previous response, ETags are quoted and the quotes would end the AT string */
+    char etag[3 * sizeof(conditional->etag)] = {0};
+    sim800l_http_escape_quotes(conditional->etag, etag, sizeof(etag));
+
+    char userdata[sizeof(etag) + 16] = {0};
+    if (conditional->etag[0] != '\0')
+    {
+        snprintf(userdata, sizeof(userdata), "If-None-Match: %s", etag);
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_USERDATA, userdata) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_ret_t ret = sim800l_http_conditional_request(sim800l_handle, conditional, action, buffer, buffer_size, data_len);
+
+    /* For this request only, a plain GET afterwards must not get a 304 */
+    if ((userdata[0] != '\0') && (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_USERDATA, "") != SIM800L_RET_OK))
+    {
+        ESP_LOGW(SIM800L_HTTP_TAG, "Clearing USERDATA failed");
+    }
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_http_data(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if ((data == NULL) || (data_len == 0))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    uint32_t command_length = strlen(SIM800L_COMMAND_HTTP_DATA) + 2 * sizeof(char) + 2 * 10 + strlen("\r\n") + 1; /* cmd=d,d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=%u,%lu\r\n", SIM800L_COMMAND_HTTP_DATA, data_len, timeout) < 0)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* Response */
+    char response[32] = {0};
+
+    /* The modem owns the line from DOWNLOAD until its OK */
+    sim800l_lock(sim800l_handle, portMAX_DELAY);
+
+    /* Send AT command and wait for the DOWNLOAD prompt */
+    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000);
+
+    free(command);
+
+    sim800l_ret_t result = SIM800L_RET_OK;
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_out_data failed: %s", esp_err_to_name(ret));
+        result = SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+    else if (strncmp(response, "DOWNLOAD", strlen("DOWNLOAD")) != 0)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "DOWNLOAD prompt not received");
+        result = SIM800L_RET_ERROR;
+    }
+    /* Body is binary, write it as is */
+    else if (sim800l_out_data_raw(sim800l_handle, data, data_len) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_out_data_raw failed");
+        result = SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+    /* OK once the modem has received data_len bytes */
+    else if (sim800l_out_data_event(sim800l_handle, NULL, SIM800L_EVENT_OK, timeout) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTPDATA not acknowledged");
+        result = SIM800L_RET_ERROR;
+    }
+
+    sim800l_unlock(sim800l_handle);
+
+    return result;
+}
+
+sim800l_ret_t sim800l_http_get_compressed(sim800l_handle_t sim800l_handle, const char *url, bool accept_gzip, sim800l_gzip_output_t data_callback, void *arg, sim800l_http_action_t *action, sim800l_http_transfer_stats_t *stats)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if ((url == NULL) || (data_callback == NULL))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_http_transfer_stats_t transfer_stats = {0};
+    sim800l_http_compressed_ctx_t ctx = {
+        .data_callback = data_callback,
+        .arg = arg,
+        .stats = &transfer_stats,
+    };
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, url) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Advertise encodings, an empty USERDATA clears a previous one */
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_USERDATA, accept_gzip ? "Accept-Encoding: gzip, deflate" : "") != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    int64_t start = esp_timer_get_time();
+    sim800l_ret_t ret = SIM800L_RET_OK;
+
+    /* Request */
+    sim800l_http_action_t request_action = {0};
+    if (sim800l_http_action_wait(sim800l_handle, SIM800L_HTTP_METHOD_GET, &request_action, SIM800L_HTTP_SESSION_REQUEST_TIMEOUT) != SIM800L_RET_OK)
+    {
+        ret = SIM800L_RET_ERROR;
+    }
+
+    if ((ret == SIM800L_RET_OK) && (action != NULL))
+    {
+        memcpy(action, &request_action, sizeof(sim800l_http_action_t));
+    }
+
+    if ((ret == SIM800L_RET_OK) && (request_action.http_code != 200))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTP code %lu", request_action.http_code);
+        ret = SIM800L_RET_ERROR;
+    }
+
+    if (ret == SIM800L_RET_OK)
+    {
+        /* Content-Encoding, the body is sniffed when the header is not available */
+        if (accept_gzip && (sim800l_http_read_header(sim800l_handle, sim800l_http_encoding_header, &ctx) != SIM800L_RET_OK))
+        {
+            ESP_LOGW(SIM800L_HTTP_TAG, "Header not available");
+        }
+
+        ret = sim800l_http_compressed_read(sim800l_handle, request_action.content_length, &ctx);
+
+        transfer_stats.elapsed_us = esp_timer_get_time() - start;
+
+        ESP_LOGI(SIM800L_HTTP_TAG, "GET %s: %lu bytes on the wire, %lu bytes of body in %llu ms",
+                 transfer_stats.compressed ? "compressed" : "plain", transfer_stats.wire_bytes, transfer_stats.body_bytes, transfer_stats.elapsed_us / 1000);
+
+        if (stats != NULL)
+        {
+            memcpy(stats, &transfer_stats, sizeof(sim800l_http_transfer_stats_t));
+        }
+    }
+
+    /* For this request only, plain requests afterwards must not advertise gzip */
+    if (accept_gzip && (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_USERDATA, "") != SIM800L_RET_OK))
+    {
+        ESP_LOGW(SIM800L_HTTP_TAG, "Clearing USERDATA failed");
+    }
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_http_post_compressed(sim800l_handle_t sim800l_handle, const char *url, const char *content_type, const uint8_t *body, size_t body_len, bool compress, sim800l_http_action_t *action, sim800l_http_transfer_stats_t *stats)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if ((url == NULL) || (body == NULL) || (body_len == 0))
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_http_transfer_stats_t transfer_stats = {0};
+    transfer_stats.body_bytes = body_len;
+
+    /* Deflate up front, HTTPDATA needs the final length */
+    const uint8_t *payload = body;
+    size_t payload_len = body_len;
+    uint8_t *deflated = NULL;
+    size_t deflated_len = 0;
+
+    if (compress && (sim800l_gzip_deflate(body, body_len, &deflated, &deflated_len) == SIM800L_RET_OK))
+    {
+        /* Incompressible body goes out as is */
+        if (deflated_len < body_len)
+        {
+            payload = deflated;
+            payload_len = deflated_len;
+            transfer_stats.compressed = true;
+        }
+    }
+
+    transfer_stats.wire_bytes = payload_len;
+
+    sim800l_ret_t ret = sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, url);
+
+    if ((ret == SIM800L_RET_OK) && (content_type != NULL))
+    {
+        ret = sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CONTENT, content_type);
+    }
+
+    if (ret == SIM800L_RET_OK)
+    {
+        ret = sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_USERDATA, transfer_stats.compressed ? "Content-Encoding: gzip" : "");
+    }
+
+    bool labelled = (ret == SIM800L_RET_OK) && transfer_stats.compressed;
+    int64_t start = esp_timer_get_time();
+
+    /* Upload, allow ~1 ms per byte on the wire */
+    if (ret == SIM800L_RET_OK)
+    {
+        ret = sim800l_http_data(sim800l_handle, payload, payload_len, SIM800L_HTTP_DATA_TIMEOUT + payload_len);
+    }
+
+    free(deflated);
+
+    /* Request */
+    sim800l_http_action_t request_action = {0};
+    if ((ret == SIM800L_RET_OK) &&
+        (sim800l_http_action_wait(sim800l_handle, SIM800L_HTTP_METHOD_POST, &request_action, SIM800L_HTTP_SESSION_REQUEST_TIMEOUT) != SIM800L_RET_OK))
+    {
+        ret = SIM800L_RET_ERROR;
+    }
+
+    /* For this request only, a later plain body must not be labelled gzip */
+    if (labelled && (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_USERDATA, "") != SIM800L_RET_OK))
+    {
+        ESP_LOGW(SIM800L_HTTP_TAG, "Clearing USERDATA failed");
+    }
+
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    transfer_stats.elapsed_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(SIM800L_HTTP_TAG, "POST %s: %lu of %lu bytes on the wire in %llu ms",
+             transfer_stats.compressed ? "compressed" : "plain", transfer_stats.wire_bytes, transfer_stats.body_bytes, transfer_stats.elapsed_us / 1000);
+
+    if (action != NULL)
+    {
+        memcpy(action, &request_action, sizeof(sim800l_http_action_t));
+    }
+
+    if (stats != NULL)
+    {
+        memcpy(stats, &transfer_stats, sizeof(sim800l_http_transfer_stats_t));
+    }
+
+    return SIM800L_RET_OK;
+}
+
+void sim800l_http_header_parser_init(sim800l_http_header_parser_t *parser, sim800l_http_header_callback_t callback, void *arg)
+{
+    memset(parser, 0, sizeof(sim800l_http_header_parser_t));
+    parser->callback = callback;
+    parser->arg = arg;
+}
+
+void sim800l_http_header_parser_feed(sim800l_http_header_parser_t *parser, const uint8_t *data, size_t data_len)
+{
+    const char *cursor = (const char *)data;
+    const char *end = cursor + data_len;
+
+    while (cursor < end)
+    {
+        const char *line_end = memchr(cursor, '\n', end - cursor);
+
+        /* Incomplete line, keep it for the next piece */
+        if (line_end == NULL)
+        {
+            size_t copy_len = end - cursor;
+            if (copy_len > sizeof(parser->line) - parser->line_len)
+            {
+                copy_len = sizeof(parser->line) - parser->line_len;
+            }
+
+            memcpy(parser->line + parser->line_len, cursor, copy_len);
+            parser->line_len += copy_len;
+            return;
+        }
+
+        if (parser->line_len == 0)
+        {
+            /* Whole line in this piece, parse in place */
+            sim800l_http_header_parse_line(parser, cursor, line_end - cursor);
+        }
+        else
+        {
+            /* Complete the staged line */
+            size_t copy_len = line_end - cursor;
+            if (copy_len > sizeof(parser->line) - parser->line_len)
+            {
+                copy_len = sizeof(parser->line) - parser->line_len;
+            }
+
+            memcpy(parser->line + parser->line_len, cursor, copy_len);
+            sim800l_http_header_parse_line(parser, parser->line, parser->line_len + copy_len);
+            parser->line_len = 0;
+        }
+
+        cursor = line_end + 1;
+    }
+}
+
+void sim800l_http_header_parser_finish(sim800l_http_header_parser_t *parser)
+{
+    if (parser->line_len > 0)
+    {
+        sim800l_http_header_parse_line(parser, parser->line, parser->line_len);
+        parser->line_len = 0;
+    }
+}
+
+/*
+ *     Private functions development
+ */
+static sim800l_ret_t sim800l_http_download_range(sim800l_handle_t sim800l_handle, const sim800l_http_download_config_t *config, sim800l_http_download_checkpoint_t *checkpoint, sim800l_http_download_stats_t *stats, uint8_t *chunk, bool *complete, bool *abort)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    /* Already done */
+    if ((checkpoint->total_length != 0) && (checkpoint->offset >= checkpoint->total_length))
+    {
+        *complete = true;
+        return SIM800L_RET_OK;
+    }
+
+    char value[16] = {0};
+
+    /* Bearer profile and URL, lost after a reconnection */
+    snprintf(value, sizeof(value), "%lu", config->cid);
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_CID, value) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_URL, config->url) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Byte range [BREAK, BREAKEND] */
+    uint32_t range_end = checkpoint->offset + config->range_size - 1;
+
+    snprintf(value, sizeof(value), "%lu", checkpoint->offset);
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_BREAK, value) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    snprintf(value, sizeof(value), "%lu", range_end);
+    if (sim800l_http_set_param(sim800l_handle, SIM800L_HTTP_PARAM_BREAKEND, value) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Request */
+    sim800l_http_action_t action = {0};
+    if (sim800l_http_action_wait(sim800l_handle, SIM800L_HTTP_METHOD_GET, &action, config->action_timeout) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    stats->requests++;
+
+    /* Offset of the first byte held by the modem */
+    uint32_t base = 0;
+
+    if (action.http_code == 206)
+    {
+        base = checkpoint->offset;
+
+        /* Short range is the last one */
+        if (action.content_length < config->range_size)
+        {
+            checkpoint->total_length = checkpoint->offset + action.content_length;
+        }
+    }
+    else if (action.http_code == 200)
+    {
+        /* Server ignored the range, skip what is already stored */
+        checkpoint->total_length = action.content_length;
+    }
+    else if (action.http_code == 416)
+    {
+        /* Previous range ended exactly at the end of the resource */
+        checkpoint->total_length = checkpoint->offset;
+    }
+    else
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTP code %lu", action.http_code);
+        return SIM800L_RET_ERROR;
+    }
+
+    uint32_t end = base + action.content_length;
+    if ((checkpoint->total_length != 0) && (end > checkpoint->total_length))
+    {
+        end = checkpoint->total_length;
+    }
+
+    while (checkpoint->offset < end)
+    {
+        size_t length = end - checkpoint->offset;
+        if (length > config->chunk_size)
+        {
+            length = config->chunk_size;
+        }
+
+        size_t data_len = 0;
+        if (sim800l_http_read_data(sim800l_handle, checkpoint->offset - base, length, chunk, &data_len) != SIM800L_RET_OK)
+        {
+            return SIM800L_RET_ERROR;
+        }
+
+        if (data_len == 0)
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "Empty read at offset %lu", checkpoint->offset);
+            return SIM800L_RET_ERROR;
+        }
+
+        /* Hand data to the application */
+        if (config->data_callback != NULL)
+        {
+            if (config->data_callback(chunk, data_len, checkpoint->offset, config->arg) != SIM800L_RET_OK)
+            {
+                *abort = true;
+                return SIM800L_RET_ERROR;
+            }
+        }
+
+        /* Checkpoint */
+        checkpoint->crc32 = esp_rom_crc32_le(checkpoint->crc32, chunk, data_len);
+        checkpoint->offset += data_len;
+        stats->bytes += data_len;
+
+        if (config->progress_callback != NULL)
+        {
+            config->progress_callback(checkpoint, config->arg);
+        }
+    }
+
+    *complete = (checkpoint->total_length != 0) ? (checkpoint->offset >= checkpoint->total_length) : (action.content_length == 0);
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_http_conditional_request(sim800l_handle_t sim800l_handle, sim800l_http_conditional_t *conditional, sim800l_http_action_t *action, uint8_t *buffer, size_t buffer_size, size_t *data_len)
+{
+    /* Request */
+    sim800l_http_action_t request_action = {0};
+    if (sim800l_http_action_wait(sim800l_handle, SIM800L_HTTP_METHOD_GET, &request_action, SIM800L_HTTP_SESSION_REQUEST_TIMEOUT) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    if (action != NULL)
+    {
+        memcpy(action, &request_action, sizeof(sim800l_http_action_t));
+    }
+
+    /* Not modified, nothing to read */
+    if (request_action.http_code == 304)
+    {
+        ESP_LOGI(SIM800L_HTTP_TAG, "Not modified");
+        return SIM800L_RET_OK;
+    }
+
+    /* Refresh validators, a 200 without an ETag must not keep the previous one */
+    conditional->retry_after = 0;
+    if (request_action.http_code == 200)
+    {
+        conditional->etag[0] = '\0';
+        conditional->content_type[0] = '\0';
+    }
+
+    if (sim800l_http_read_header(sim800l_handle, sim800l_http_conditional_header, conditional) != SIM800L_RET_OK)
+    {
+        ESP_LOGW(SIM800L_HTTP_TAG, "Header not available");
+    }
+
+    if (request_action.http_code != 200)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "HTTP code %lu", request_action.http_code);
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Body */
+    if ((buffer != NULL) && (data_len != NULL) && (request_action.content_length > 0))
+    {
+        size_t length = request_action.content_length;
+        if (length > buffer_size)
+        {
+            length = buffer_size;
+        }
+
+        return sim800l_http_read_data(sim800l_handle, 0, length, buffer, data_len);
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_http_escape_quotes(const char *input, char *output, size_t output_size)
+{
+    /* '"' as \22, the AT parser takes hex escapes inside quoted strings */
+    size_t length = 0;
+    for (; (*input != '\0') && (length + 4 <= output_size); input++)
+    {
+        if (*input == '"')
+        {
+            memcpy(output + length, "\\22", 3);
+            length += 3;
+        }
+        else
+        {
+            output[length++] = *input;
+        }
+    }
+
+    output[length] = '\0';
+}
+
+/*
+ *     HTTPPARA names in sim800l_http_param_tag_t order, numeric ones are CID, REDIR and TIMEOUT
+ */
+static const char *sim800l_http_shadow_names[SIM800L_HTTP_SHADOW_PARAMS] = {
+    "CID", "URL", "UA", "PROIP", "PROPORT", "REDIR", "BREAK", "BREAKEND", "TIMEOUT", "CONTENT", "USERDATA"
+};
+
+static bool sim800l_http_shadow_get(sim800l_http_param_t *param)
+{
+    char *strings[SIM800L_HTTP_SHADOW_PARAMS] = {NULL, param->url, param->ua, param->proip, param->proport, NULL, param->break_, param->breakend, NULL, param->content, param->userdata};
+    uint32_t *numbers[SIM800L_HTTP_SHADOW_PARAMS] = {&param->cid, NULL, NULL, NULL, NULL, &param->redir, NULL, NULL, &param->timeout, NULL, NULL};
+    char key[SIM800L_SHADOW_KEY_SIZE] = {0};
+
+    /* All or nothing, a partial answer would mix in stale fields */
+    for (uint32_t i = 0; i < SIM800L_HTTP_SHADOW_PARAMS; i++)
+    {
+        snprintf(key, sizeof(key), "%s%s", SIM800L_HTTP_SHADOW_PREFIX, sim800l_http_shadow_names[i]);
+        if (!sim800l_shadow_lookup(key, NULL, 0))
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < SIM800L_HTTP_SHADOW_PARAMS; i++)
+    {
+        snprintf(key, sizeof(key), "%s%s", SIM800L_HTTP_SHADOW_PREFIX, sim800l_http_shadow_names[i]);
+
+        if (numbers[i] != NULL)
+        {
+            char number[12] = {0};
+            sim800l_shadow_lookup(key, number, sizeof(number));
+            *numbers[i] = (uint32_t)atoi(number);
+        }
+        else if (strings[i] != NULL)
+        {
+            /* Same buffer contract as the AT+HTTPPARA? path */
+            sim800l_shadow_lookup(key, strings[i], SIM800L_SHADOW_VALUE_MAX);
+        }
+    }
+
+    return true;
+}
+
+static void sim800l_http_shadow_put(const sim800l_http_param_t *param)
+{
+    const char *strings[SIM800L_HTTP_SHADOW_PARAMS] = {NULL, param->url, param->ua, param->proip, param->proport, NULL, param->break_, param->breakend, NULL, param->content, param->userdata};
+    const uint32_t numbers[SIM800L_HTTP_SHADOW_PARAMS] = {param->cid, 0, 0, 0, 0, param->redir, 0, 0, param->timeout, 0, 0};
+    char key[SIM800L_SHADOW_KEY_SIZE] = {0};
+
+    for (uint32_t i = 0; i < SIM800L_HTTP_SHADOW_PARAMS; i++)
+    {
+        snprintf(key, sizeof(key), "%s%s", SIM800L_HTTP_SHADOW_PREFIX, sim800l_http_shadow_names[i]);
+
+        if ((i == SIM800L_HTTP_PARAM_CID) || (i == SIM800L_HTTP_PARAM_REDIR) || (i == SIM800L_HTTP_PARAM_TIMEOUT))
+        {
+            char number[12] = {0};
+            snprintf(number, sizeof(number), "%lu", numbers[i]);
+            sim800l_shadow_store(key, number);
+        }
+        else if (strings[i] != NULL)
+        {
+            sim800l_shadow_store(key, strings[i]);
+        }
+    }
+}
+
+static sim800l_ret_t sim800l_http_download_reconnect(sim800l_handle_t sim800l_handle, uint32_t cid)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    /* Tear down, errors are expected when the link is gone */
+    sim800l_http_switch(sim800l_handle, false);
+    sim800l_bearer_profile_switch(sim800l_handle, cid, false);
+
+    /* Bring up again, the profile parameters are still on the modem */
+    if (sim800l_bearer_profile_switch(sim800l_handle, cid, true) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "sim800l_bearer_profile_switch failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    return sim800l_http_switch(sim800l_handle, true);
+}
+
+
+static void sim800l_http_header_parse_line(sim800l_http_header_parser_t *parser, const char *line, size_t line_len)
+{
+    /* Drop CR */
+    if ((line_len > 0) && (line[line_len - 1] == '\r'))
+    {
+        line_len--;
+    }
+
+    /* Status line and blank lines have no colon */
+    const char *colon = memchr(line, ':', line_len);
+    if ((colon == NULL) || (colon == line))
+    {
+        return;
+    }
+
+    size_t name_len = colon - line;
+
+    /* Trim value */
+    const char *value = colon + 1;
+    const char *value_end = line + line_len;
+    while ((value < value_end) && ((*value == ' ') || (*value == '\t')))
+    {
+        value++;
+    }
+
+    while ((value_end > value) && ((value_end[-1] == ' ') || (value_end[-1] == '\t')))
+    {
+        value_end--;
+    }
+
+    parser->callback(line, name_len, value, value_end - value, parser->arg);
+}
+
+static void sim800l_http_conditional_header(const char *name, size_t name_len, const char *value, size_t value_len, void *arg)
+{
+    sim800l_http_conditional_t *conditional = (sim800l_http_conditional_t *)arg;
+
+    if ((name_len == strlen("ETag")) && (strncasecmp(name, "ETag", name_len) == 0))
+    {
+        if (value_len >= sizeof(conditional->etag))
+        {
+            /* Truncated validator would never match */
+            conditional->etag[0] = '\0';
+            return;
+        }
+
+        memcpy(conditional->etag, value, value_len);
+        conditional->etag[value_len] = '\0';
+    }
+    else if ((name_len == strlen("Content-Type")) && (strncasecmp(name, "Content-Type", name_len) == 0))
+    {
+        if (value_len >= sizeof(conditional->content_type))
+        {
+            value_len = sizeof(conditional->content_type) - 1;
+        }
+
+        memcpy(conditional->content_type, value, value_len);
+        conditional->content_type[value_len] = '\0';
+    }
+    else if ((name_len == strlen("Retry-After")) && (strncasecmp(name, "Retry-After", name_len) == 0))
+    {
+        /* Delta seconds only, HTTP dates are ignored */
+        uint32_t retry_after = 0;
+        for (size_t i = 0; (i < value_len) && (value[i] >= '0') && (value[i] <= '9'); i++)
+        {
+            retry_after = (retry_after * 10) + (value[i] - '0');
+        }
+
+        conditional->retry_after = retry_after;
+    }
+}
+
+
+/*
+ *     SIM800L call event functions
+ */
+sim800l_event_t sim800l_event_http_action(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    sim800l_http_action_t *action = (sim800l_http_action_t *)output_data;
+
+    /* Get Method */
+    action->method = atoi(input_args[0]);
+
+    /* Get http code */
+    action->http_code = atoi(input_args[1]);
+
+    /* Get content length */
+    action->content_length = atoi(input_args[2]);
+
+    /* Keep it for synchronous callers */
+    memcpy(&sim800l_http_last_action, action, sizeof(sim800l_http_action_t));
+
+    return SIM800L_EVENT_HTTP_ACTION;
+}
+
+void sim800l_data_http_read(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    sim800l_http_read_ctx_t *ctx = (sim800l_http_read_ctx_t *)arg;
+
+    if ((ctx == NULL) || (ctx->mutex == NULL))
+    {
+        return;
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    /* Only while a reader is waiting */
+    if ((ctx->buffer != NULL) && (data_offset < ctx->buffer_size))
+    {
+        /* Clamp to buffer */
+        if (data_len > ctx->buffer_size - data_offset)
+        {
+            data_len = ctx->buffer_size - data_offset;
+        }
+
+        memcpy(ctx->buffer + data_offset, data, data_len);
+        ctx->data_len = data_offset + data_len;
+    }
+
+    xSemaphoreGive(ctx->mutex);
+}
+
+void sim800l_data_http_head(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg)
+{
+    ESP_LOGD(SIM800L_HTTP_TAG, "%s", __func__);
+
+    if (sim800l_http_read_ctx.mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(sim800l_http_read_ctx.mutex, portMAX_DELAY);
+
+    /* Only while a reader is waiting */
+    if (sim800l_http_head_parser != NULL)
+    {
+        sim800l_http_header_parser_feed(sim800l_http_head_parser, data, data_len);
+    }
+
+    xSemaphoreGive(sim800l_http_read_ctx.mutex);
+}
+
+static void sim800l_http_encoding_header(const char *name, size_t name_len, const char *value, size_t value_len, void *arg)
+{
+    sim800l_http_compressed_ctx_t *ctx = (sim800l_http_compressed_ctx_t *)arg;
+
+    if ((name_len != strlen("Content-Encoding")) || (strncasecmp(name, "Content-Encoding", name_len) != 0))
+    {
+        return;
+    }
+
+    if ((value_len == strlen("gzip")) && (strncasecmp(value, "gzip", value_len) == 0))
+    {
+        ctx->gzip = true;
+    }
+    else if ((value_len == strlen("deflate")) && (strncasecmp(value, "deflate", value_len) == 0))
+    {
+        ctx->deflate = true;
+    }
+}
+
+static sim800l_ret_t sim800l_http_compressed_output(const uint8_t *data, size_t data_len, void *arg)
+{
+    sim800l_http_compressed_ctx_t *ctx = (sim800l_http_compressed_ctx_t *)arg;
+
+    ctx->stats->body_bytes += data_len;
+
+    return ctx->data_callback(data, data_len, ctx->arg);
+}
+
+static sim800l_ret_t sim800l_http_compressed_read(sim800l_handle_t sim800l_handle, uint32_t content_length, sim800l_http_compressed_ctx_t *ctx)
+{
+    uint8_t *chunk = malloc(SIM800L_HTTP_COMPRESSED_CHUNK_SIZE);
+    if (chunk == NULL)
+    {
+        ESP_LOGE(SIM800L_HTTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    sim800l_gzip_handle_t gzip_handle = NULL;
+    sim800l_ret_t ret = SIM800L_RET_OK;
+    uint32_t offset = 0;
+
+    while ((offset < content_length) && (ret == SIM800L_RET_OK))
+    {
+        size_t length = content_length - offset;
+        if (length > SIM800L_HTTP_COMPRESSED_CHUNK_SIZE)
+        {
+            length = SIM800L_HTTP_COMPRESSED_CHUNK_SIZE;
+        }
+
+        size_t data_len = 0;
+        ret = sim800l_http_read_data(sim800l_handle, offset, length, chunk, &data_len);
+        if ((ret != SIM800L_RET_OK) || (data_len == 0))
+        {
+            ESP_LOGE(SIM800L_HTTP_TAG, "HTTPREAD failed at %lu", offset);
+            ret = SIM800L_RET_ERROR;
+            break;
+        }
+
+        /* gzip magic when the server did not say (or HTTPHEAD was not available) */
+        if ((offset == 0) && !ctx->gzip && !ctx->deflate && (data_len >= 2) && (chunk[0] == 0x1f) && (chunk[1] == 0x8b))
+        {
+            ctx->gzip = true;
+        }
+
+        /* Inflater lives for the whole body, window included */
+        if ((offset == 0) && (ctx->gzip || ctx->deflate))
+        {
+            ret = sim800l_gzip_inflate_init(&gzip_handle, ctx->gzip ? SIM800L_GZIP_FORMAT_GZIP : SIM800L_GZIP_FORMAT_ZLIB, sim800l_http_compressed_output, ctx);
+            if (ret != SIM800L_RET_OK)
+            {
+                break;
+            }
+
+            ctx->stats->compressed = true;
+        }
+
+        offset += data_len;
+        ctx->stats->wire_bytes += data_len;
+
+        if (gzip_handle != NULL)
+        {
+            ret = sim800l_gzip_inflate_feed(gzip_handle, chunk, data_len);
+        }
+        else
+        {
+            ret = sim800l_http_compressed_output(chunk, data_len, ctx);
+        }
+    }
+
+    /* Checks the end marker and, for gzip, CRC-32 and size */
+    if ((ret == SIM800L_RET_OK) && (gzip_handle != NULL))
+    {
+        ret = sim800l_gzip_inflate_finish(gzip_handle, NULL);
+    }
+
+    sim800l_gzip_inflate_deinit(gzip_handle);
+    free(chunk);
+
+    return ret;
 }
\ No newline at end of file
@@ -0,0 +1,526 @@
+/*
+ * @file sim800l_location.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L GSM location and network time functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_location.h"
+#include "sim800l_common.h"
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_LOCATION_MAX_AGE_MS     300000      /* 5 minutes, a cell fix does not move */
+#define SIM800L_LOCATION_TIME_MAX_AGE_MS 3600000    /* 1 hour, esp_timer drift is negligible */
+#define SIM800L_LOCATION_TIMEOUT        20000       /* AT+CIPGSMLOC goes to a server over the bearer */
+#define SIM800L_LOCATION_RESPONSE_SIZE  512
+#define SIM800L_LOCATION_MAX_FIELDS     5
+#define SIM800L_LOCATION_MIN_YEAR       2020        /* RTC not set by the network reads 2004 */
+
+#define SIM800L_LOCATION_TYPE_LOCATION  1
+#define SIM800L_LOCATION_TYPE_TIME      2
+
+/*
+ *     Tag
+ */
+#define SIM800L_LOCATION_TAG "SIM800L LOCATION"
+
+/*
+ *     URC
+ */
+#define SIM800L_EVENT_TIME_STR          "*PSUTTZ"
+
+/*
+ *     Cache, timestamps are esp_timer_get_time() when the value was read
+ */
+static struct
+{
+    bool valid;
+    double longitude;
+    double latitude;
+    int64_t epoch;
+    int64_t timestamp;
+} sim800l_location_fix = {0};
+
+static struct
+{
+    bool valid;
+    int64_t epoch;
+    int32_t timezone;
+    sim800l_time_source_t source;
+    int64_t timestamp;
+} sim800l_location_time = {0};
+
+static bool sim800l_location_rtc_synced = false;    /* *PSUTTZ or AT+CNTP seen, AT+CCLK can be trusted */
+static SemaphoreHandle_t sim800l_location_mutex = NULL;
+static sim800l_location_stats_t sim800l_location_stats = {0};
+
+/*
+ *     Private functions
+ */
+static bool sim800l_location_init(void);
+static sim800l_ret_t sim800l_location_query(sim800l_handle_t sim800l_handle, uint32_t type, uint32_t cid, double *longitude, double *latitude, int64_t *epoch);
+static sim800l_ret_t sim800l_location_clock(sim800l_handle_t sim800l_handle, int64_t *epoch, int32_t *timezone);
+static void sim800l_location_store_time(int64_t epoch, int32_t timezone, sim800l_time_source_t source, int64_t timestamp);
+static char *sim800l_location_first_line(char *response);
+static int64_t sim800l_location_epoch(int32_t year, int32_t month, int32_t day, int32_t hour, int32_t minute, int32_t second);
+static int32_t sim800l_location_int(const char *arg);
+
+/*
+ *     Callbacks
+ */
+sim800l_event_t sim800l_event_time(char **input_args, void *output_data);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_location_get(sim800l_handle_t sim800l_handle, uint32_t cid, uint32_t max_age_ms, sim800l_location_t *location)
+{
+    ESP_LOGD(SIM800L_LOCATION_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (location == NULL))
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_location_init())
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    uint32_t max_age = (max_age_ms > 0) ? max_age_ms : SIM800L_LOCATION_MAX_AGE_MS;
+    int64_t now = esp_timer_get_time();
+
+    /* Cached fix, no bearer traffic */
+    xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+    if (sim800l_location_fix.valid && ((now - sim800l_location_fix.timestamp) / 1000 <= max_age))
+    {
+        location->longitude = sim800l_location_fix.longitude;
+        location->latitude = sim800l_location_fix.latitude;
+        location->epoch = sim800l_location_fix.epoch;
+        location->age_ms = (uint32_t)((now - sim800l_location_fix.timestamp) / 1000);
+        sim800l_location_stats.location_hits++;
+        xSemaphoreGive(sim800l_location_mutex);
+        return SIM800L_RET_OK;
+    }
+    xSemaphoreGive(sim800l_location_mutex);
+
+    /* Query */
+    double longitude = 0;
+    double latitude = 0;
+    int64_t epoch = 0;
+
+    sim800l_ret_t ret = sim800l_location_query(sim800l_handle, SIM800L_LOCATION_TYPE_LOCATION, cid, &longitude, &latitude, &epoch);
+    int64_t done = esp_timer_get_time();
+
+    xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+    sim800l_location_stats.location_queries++;
+    sim800l_location_stats.location_query_us += (uint64_t)(done - now);
+
+    if (ret != SIM800L_RET_OK)
+    {
+        sim800l_location_stats.location_failures++;
+        xSemaphoreGive(sim800l_location_mutex);
+        return ret;
+    }
+
+    sim800l_location_fix.valid = true;
+    sim800l_location_fix.longitude = longitude;
+    sim800l_location_fix.latitude = latitude;
+    sim800l_location_fix.epoch = epoch;
+    sim800l_location_fix.timestamp = done;
+    xSemaphoreGive(sim800l_location_mutex);
+
+    /* The fix carries the time too */
+    sim800l_location_store_time(epoch, 0, SIM800L_TIME_SOURCE_GSMLOC, done);
+
+    location->longitude = longitude;
+    location->latitude = latitude;
+    location->epoch = epoch;
+    location->age_ms = 0;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_location_time_switch(sim800l_handle_t sim800l_handle, bool enable)
+{
+    ESP_LOGD(SIM800L_LOCATION_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_location_init())
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    if (enable)
+    {
+        if (sim800l_register_callback(SIM800L_EVENT_TIME_STR, sim800l_event_time) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_LOCATION_TAG, "sim800l_register_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+    }
+    else
+    {
+        sim800l_unregister_callback(SIM800L_EVENT_TIME_STR);
+    }
+
+    /* *PSUTTZ comes with the next network time update, some firmwares need AT&W and a restart first */
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)(enable ? SIM800L_COMMAND_LOCAL_TIMESTAMP "=1\r\n" : SIM800L_COMMAND_LOCAL_TIMESTAMP "=0\r\n"), SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "AT+CLTS failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_location_time_get(sim800l_handle_t sim800l_handle, uint32_t cid, uint32_t max_age_ms, sim800l_time_t *time)
+{
+    ESP_LOGD(SIM800L_LOCATION_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (time == NULL))
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_location_init())
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    uint32_t max_age = (max_age_ms > 0) ? max_age_ms : SIM800L_LOCATION_TIME_MAX_AGE_MS;
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+    if (!(sim800l_location_time.valid && ((now - sim800l_location_time.timestamp) / 1000 <= max_age)))
+    {
+        xSemaphoreGive(sim800l_location_mutex);
+
+        /* RTC once the network has set it, a local query, otherwise a time only AT+CIPGSMLOC */
+        int64_t epoch = 0;
+        int32_t timezone = 0;
+        sim800l_time_source_t source = SIM800L_TIME_SOURCE_RTC;
+        sim800l_ret_t ret = SIM800L_RET_ERROR;
+
+        if (sim800l_location_rtc_synced)
+        {
+            ret = sim800l_location_clock(sim800l_handle, &epoch, &timezone);
+        }
+
+        if (ret != SIM800L_RET_OK)
+        {
+            source = SIM800L_TIME_SOURCE_GSMLOC;
+            timezone = 0;
+            ret = sim800l_location_query(sim800l_handle, SIM800L_LOCATION_TYPE_TIME, cid, NULL, NULL, &epoch);
+        }
+
+        int64_t done = esp_timer_get_time();
+
+        xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+        sim800l_location_stats.time_queries++;
+        sim800l_location_stats.time_query_us += (uint64_t)(done - now);
+        if (ret != SIM800L_RET_OK)
+        {
+            sim800l_location_stats.time_failures++;
+            xSemaphoreGive(sim800l_location_mutex);
+            return ret;
+        }
+        xSemaphoreGive(sim800l_location_mutex);
+
+        sim800l_location_store_time(epoch, timezone, source, done);
+
+        xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+    }
+    else
+    {
+        sim800l_location_stats.time_hits++;
+    }
+
+    /* Advanced by the time since it was read */
+    int64_t elapsed = esp_timer_get_time() - sim800l_location_time.timestamp;
+    time->epoch = sim800l_location_time.epoch + elapsed / 1000000;
+    time->timezone = sim800l_location_time.timezone;
+    time->source = sim800l_location_time.source;
+    time->age_ms = (uint32_t)(elapsed / 1000);
+    xSemaphoreGive(sim800l_location_mutex);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_location_time_read_rtc(sim800l_handle_t sim800l_handle, sim800l_time_source_t source, sim800l_time_t *time)
+{
+    ESP_LOGD(SIM800L_LOCATION_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (time == NULL))
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_location_init())
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Caller knows the RTC was just set, e.g. after AT+CNTP */
+    int64_t epoch = 0;
+    int32_t timezone = 0;
+    int64_t start = esp_timer_get_time();
+    sim800l_ret_t ret = sim800l_location_clock(sim800l_handle, &epoch, &timezone);
+    int64_t done = esp_timer_get_time();
+
+    xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+    sim800l_location_stats.time_queries++;
+    sim800l_location_stats.time_query_us += (uint64_t)(done - start);
+    if (ret != SIM800L_RET_OK)
+    {
+        sim800l_location_stats.time_failures++;
+        xSemaphoreGive(sim800l_location_mutex);
+        return ret;
+    }
+    xSemaphoreGive(sim800l_location_mutex);
+
+    sim800l_location_store_time(epoch, timezone, source, done);
+    sim800l_location_rtc_synced = true;
+
+    time->epoch = epoch;
+    time->timezone = timezone;
+    time->source = source;
+    time->age_ms = 0;
+
+    return SIM800L_RET_OK;
+}
+
+void sim800l_location_flush(void)
+{
+    ESP_LOGD(SIM800L_LOCATION_TAG, "%s", __func__);
+
+    if (sim800l_location_mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+    sim800l_location_fix.valid = false;
+    sim800l_location_time.valid = false;
+    xSemaphoreGive(sim800l_location_mutex);
+}
+
+sim800l_ret_t sim800l_location_get_stats(sim800l_location_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_location_stats, sizeof(sim800l_location_stats_t));
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static bool sim800l_location_init(void)
+{
+    if (sim800l_location_mutex == NULL)
+    {
+        sim800l_location_mutex = xSemaphoreCreateMutex();
+    }
+
+    return sim800l_location_mutex != NULL;
+}
+
+static sim800l_ret_t sim800l_location_query(sim800l_handle_t sim800l_handle, uint32_t type, uint32_t cid, double *longitude, double *latitude, int64_t *epoch)
+{
+    char command[32] = {0};
+    char response[SIM800L_LOCATION_RESPONSE_SIZE] = {0};
+
+    snprintf(command, sizeof(command), "%s=%lu,%lu\r\n", SIM800L_COMMAND_GSM_LOCATION, type, (cid > 0) ? cid : 1);
+    if (sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, sizeof(response), SIM800L_LOCATION_TIMEOUT) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "sim800l_out_data failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* Type 1: <code>,<longitude>,<latitude>,<date>,<time>, type 2: <code>,<date>,<time> */
+    char *fields[SIM800L_LOCATION_MAX_FIELDS] = {0};
+    size_t count = sim800l_tokenize(sim800l_location_first_line(response), ',', fields, SIM800L_LOCATION_MAX_FIELDS);
+    if (count == 0)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* 601 network error, 602 no memory, 603 DNS error, 604 stack busy */
+    uint32_t code = strtoul(fields[0], NULL, 10);
+    if (code != 0)
+    {
+        ESP_LOGW(SIM800L_LOCATION_TAG, "AT+CIPGSMLOC error %lu", code);
+        return SIM800L_RET_ERROR;
+    }
+
+    size_t date = (type == SIM800L_LOCATION_TYPE_LOCATION) ? 3 : 1;
+    if (count < date + 2)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if ((sscanf(fields[date], "%d/%d/%d", &year, &month, &day) != 3) ||
+        (sscanf(fields[date + 1], "%d:%d:%d", &hour, &minute, &second) != 3))
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    if (longitude != NULL)
+    {
+        *longitude = strtod(fields[1], NULL);
+    }
+
+    if (latitude != NULL)
+    {
+        *latitude = strtod(fields[2], NULL);
+    }
+
+    *epoch = sim800l_location_epoch(year, month, day, hour, minute, second);
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_location_clock(sim800l_handle_t sim800l_handle, int64_t *epoch, int32_t *timezone)
+{
+    /* Response, "yy/MM/dd,hh:mm:ss±zz" in local time */
+    char response[64] = {0};
+
+    if (sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_CLOCK "?\r\n", (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_LOCATION_TAG, "sim800l_out_data failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    char *line = sim800l_location_first_line(response);
+    if (*line == '"')
+    {
+        line++;
+    }
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, zone = 0;
+    if ((sscanf(line, "%d/%d/%d,%d:%d:%d%d", &year, &month, &day, &hour, &minute, &second, &zone) != 7) ||
+        (year + 2000 < SIM800L_LOCATION_MIN_YEAR))
+    {
+        ESP_LOGW(SIM800L_LOCATION_TAG, "RTC not set");
+        return SIM800L_RET_ERROR;
+    }
+
+    *epoch = sim800l_location_epoch(year + 2000, month, day, hour, minute, second) - (int64_t)zone * 15 * 60;
+    *timezone = zone;
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_location_store_time(int64_t epoch, int32_t timezone, sim800l_time_source_t source, int64_t timestamp)
+{
+    xSemaphoreTake(sim800l_location_mutex, portMAX_DELAY);
+    sim800l_location_time.valid = true;
+    sim800l_location_time.epoch = epoch;
+    sim800l_location_time.timezone = timezone;
+    sim800l_location_time.source = source;
+    sim800l_location_time.timestamp = timestamp;
+    xSemaphoreGive(sim800l_location_mutex);
+}
+
+static char *sim800l_location_first_line(char *response)
+{
+    /* sim800l_out_data already dropped the "+<cmd>:" prefix */
+    while (*response == ' ')
+    {
+        response++;
+    }
+
+    response[strcspn(response, "\r\n")] = '\0';
+
+    return response;
+}
+
+static int64_t sim800l_location_epoch(int32_t year, int32_t month, int32_t day, int32_t hour, int32_t minute, int32_t second)
+{
+    /* Days from 1970-01-01 in the proleptic Gregorian calendar, March based years */
+    int32_t y = year - ((month <= 2) ? 1 : 0);
+    int32_t era = ((y >= 0) ? y : y - 399) / 400;
+    int32_t yoe = y - era * 400;
+    int32_t doy = (153 * (month + ((month > 2) ? -3 : 9)) + 2) / 5 + day - 1;
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+static int32_t sim800l_location_int(const char *arg)
+{
+    if (arg == NULL)
+    {
+        return 0;
+    }
+
+    /* " 2024" or "\"+8\"" */
+    while ((*arg == ' ') || (*arg == '"'))
+    {
+        arg++;
+    }
+
+    return (int32_t)strtol(arg, NULL, 10);
+}
+
+/*
+ *     Callbacks development
+ */
+sim800l_event_t sim800l_event_time(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_LOCATION_TAG, "%s", __func__);
+
+    /* *PSUTTZ: <year>,<month>,<day>,<hour>,<min>,<sec>,"<tz>",<dst>, universal time */
+    sim800l_time_event_t *event = (sim800l_time_event_t *)output_data;
+    for (uint32_t i = 0; i < 7; i++)
+    {
+        if (input_args[i] == NULL)
+        {
+            return SIM800L_EVENT_TIME;
+        }
+    }
+
+    event->source = SIM800L_TIME_SOURCE_NETWORK;
+    event->epoch = sim800l_location_epoch(sim800l_location_int(input_args[0]), sim800l_location_int(input_args[1]), sim800l_location_int(input_args[2]),
+                                          sim800l_location_int(input_args[3]), sim800l_location_int(input_args[4]), sim800l_location_int(input_args[5]));
+    event->timezone = sim800l_location_int(input_args[6]);
+    event->dst = (uint32_t)sim800l_location_int(input_args[7]);
+
+    sim800l_location_store_time(event->epoch, event->timezone, SIM800L_TIME_SOURCE_NETWORK, esp_timer_get_time());
+    sim800l_location_rtc_synced = true;
+    sim800l_location_stats.network_updates++;
+
+    return SIM800L_EVENT_TIME;
+}
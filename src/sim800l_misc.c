@@ -27,10 +27,10 @@ sim800l_ret_t sim800l_command_AT(sim800l_handle_t sim800l_handle)
 {
     ESP_LOGD(SIM800L_MISC_TAG, "%s", __func__);
 
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Send AT command */
-    esp_err_t esp_ret = sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_AT, (uint8_t *)response, 1000);
+    esp_err_t esp_ret = sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_AT, (uint8_t *)response, sizeof(response), 1000);
     if (esp_ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_MISC_TAG, "sim800l_command_AT failed: %s", esp_err_to_name(esp_ret));
@@ -0,0 +1,726 @@
+/*
+ * @file sim800l_mqtt.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L MQTT 3.1.1 client functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_mqtt.h"
+#include "sim800l_tcpip.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <esp_timer.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_MQTT_ARENA_SIZE         2048    /* Packets queued for the next flush */
+#define SIM800L_MQTT_INFLIGHT_SIZE      2048    /* Copies of unacknowledged QoS 1 PUBLISH */
+#define SIM800L_MQTT_MAX_INFLIGHT       8
+#define SIM800L_MQTT_RX_SIZE            1024    /* Largest packet accepted from the broker */
+#define SIM800L_MQTT_SEND_TIMEOUT       30000
+#define SIM800L_MQTT_RETRY_MS           10000   /* PUBACK wait before a DUP resend */
+#define SIM800L_MQTT_POLL_MS            100
+
+/*
+ *     MQTT 3.1.1 packet types, upper nibble of the fixed header
+ */
+#define SIM800L_MQTT_CONNECT            0x10
+#define SIM800L_MQTT_CONNACK            0x20
+#define SIM800L_MQTT_PUBLISH            0x30
+#define SIM800L_MQTT_PUBACK             0x40
+#define SIM800L_MQTT_SUBSCRIBE          0x82    /* Reserved flags 0010 */
+#define SIM800L_MQTT_SUBACK             0x90
+#define SIM800L_MQTT_PINGREQ            0xC0
+#define SIM800L_MQTT_PINGRESP           0xD0
+#define SIM800L_MQTT_DISCONNECT         0xE0
+#define SIM800L_MQTT_DUP                0x08
+
+/*
+ *     Tag
+ */
+#define SIM800L_MQTT_TAG "SIM800L MQTT"
+
+/*
+ *     QoS 1 PUBLISH waiting for its PUBACK
+ */
+typedef struct
+{
+    uint16_t packet_id;                 /* 0 for a free slot */
+    uint16_t offset;                    /* Copy in sim800l_mqtt_inflight_arena */
+    uint16_t length;
+    int64_t sent;
+} sim800l_mqtt_inflight_t;
+
+static volatile sim800l_mqtt_state_t sim800l_mqtt_state = SIM800L_MQTT_STATE_DISCONNECTED;
+static uint32_t sim800l_mqtt_link = 0;
+static uint16_t sim800l_mqtt_keepalive = 0;
+static uint16_t sim800l_mqtt_packet_id = 0;
+static uint16_t sim800l_mqtt_suback_id = 0;         /* SUBSCRIBE waiting for its SUBACK */
+static int64_t sim800l_mqtt_last_tx = 0;
+static int64_t sim800l_mqtt_ping_sent = 0;          /* 0 when no PINGREQ is outstanding */
+
+static uint8_t sim800l_mqtt_arena[SIM800L_MQTT_ARENA_SIZE];
+static size_t sim800l_mqtt_arena_len = 0;
+static uint8_t sim800l_mqtt_inflight_arena[SIM800L_MQTT_INFLIGHT_SIZE];
+static size_t sim800l_mqtt_inflight_len = 0;
+static sim800l_mqtt_inflight_t sim800l_mqtt_inflight[SIM800L_MQTT_MAX_INFLIGHT] = {0};
+static uint32_t sim800l_mqtt_inflight_count = 0;
+static uint8_t sim800l_mqtt_rx[SIM800L_MQTT_RX_SIZE];
+static size_t sim800l_mqtt_rx_len = 0;
+
+static sim800l_mqtt_message_cb_t *sim800l_mqtt_message_cb = NULL;
+static void *sim800l_mqtt_message_arg = NULL;
+static sim800l_mqtt_stats_t sim800l_mqtt_stats = {0};
+
+/*
+ *     Private functions
+ */
+static size_t sim800l_mqtt_length_size(size_t length);
+static uint8_t *sim800l_mqtt_reserve(sim800l_handle_t sim800l_handle, uint8_t type, size_t remaining);
+static uint8_t *sim800l_mqtt_put_string(uint8_t *out, const char *string, size_t length);
+static uint16_t sim800l_mqtt_next_id(void);
+static sim800l_ret_t sim800l_mqtt_receive(sim800l_handle_t sim800l_handle, uint32_t timeout);
+static void sim800l_mqtt_process(sim800l_handle_t sim800l_handle, uint8_t header, const uint8_t *data, size_t data_len);
+static void sim800l_mqtt_release(void);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_mqtt_connect(sim800l_handle_t sim800l_handle, const sim800l_mqtt_config_t *config, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (config == NULL) || (config->host == NULL) || (config->client_id == NULL) || (config->link >= SIM800L_TCPIP_MAX_LINKS))
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_mqtt_state != SIM800L_MQTT_STATE_DISCONNECTED)
+    {
+        ESP_LOGW(SIM800L_MQTT_TAG, "Already connected");
+        return SIM800L_RET_OK;
+    }
+
+    sim800l_mqtt_release();
+    memset(&sim800l_mqtt_stats, 0, sizeof(sim800l_mqtt_stats_t));
+    sim800l_mqtt_link = config->link;
+    sim800l_mqtt_keepalive = config->keepalive;
+
+    if (sim800l_tcpip_open(sim800l_handle, config->link, SIM800L_TCPIP_PROTOCOL_TCP, config->host, config->port, timeout) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Connection to %s:%u failed", config->host, config->port);
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_mqtt_state = SIM800L_MQTT_STATE_CONNECTING;
+
+    size_t client_id_len = strlen(config->client_id);
+    size_t username_len = (config->username != NULL) ? strlen(config->username) : 0;
+    size_t password_len = (config->password != NULL) ? strlen(config->password) : 0;
+
+    /* Variable header is 10 bytes, "MQTT" level 4, flags and keep alive */
+    size_t remaining = 10 + 2 + client_id_len;
+    uint8_t flags = config->clean_session ? 0x02 : 0x00;
+
+    if (config->username != NULL)
+    {
+        remaining += 2 + username_len;
+        flags |= 0x80;
+    }
+
+    if (config->password != NULL)
+    {
+        remaining += 2 + password_len;
+        flags |= 0x40;
+    }
+
+    uint8_t *out = sim800l_mqtt_reserve(sim800l_handle, SIM800L_MQTT_CONNECT, remaining);
+    if (out == NULL)
+    {
+        sim800l_mqtt_disconnect(sim800l_handle);
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    out = sim800l_mqtt_put_string(out, "MQTT", 4);
+    *out++ = 4;
+    *out++ = flags;
+    *out++ = config->keepalive >> 8;
+    *out++ = config->keepalive & 0xFF;
+    out = sim800l_mqtt_put_string(out, config->client_id, client_id_len);
+
+    if (config->username != NULL)
+    {
+        out = sim800l_mqtt_put_string(out, config->username, username_len);
+    }
+
+    if (config->password != NULL)
+    {
+        sim800l_mqtt_put_string(out, config->password, password_len);
+    }
+
+    if (sim800l_mqtt_flush(sim800l_handle) != SIM800L_RET_OK)
+    {
+        sim800l_mqtt_disconnect(sim800l_handle);
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* CONNACK moves the state to connected */
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout * 1000;
+
+    while ((sim800l_mqtt_state == SIM800L_MQTT_STATE_CONNECTING) && (esp_timer_get_time() < deadline))
+    {
+        if (sim800l_mqtt_receive(sim800l_handle, SIM800L_MQTT_POLL_MS) != SIM800L_RET_OK)
+        {
+            break;
+        }
+    }
+
+    if (sim800l_mqtt_state != SIM800L_MQTT_STATE_CONNECTED)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "CONNACK not received");
+        sim800l_tcpip_close(sim800l_handle, sim800l_mqtt_link, 0);
+        sim800l_mqtt_state = SIM800L_MQTT_STATE_DISCONNECTED;
+        return SIM800L_RET_ERROR;
+    }
+
+    ESP_LOGI(SIM800L_MQTT_TAG, "Connected to %s:%u as %s", config->host, config->port, config->client_id);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_mqtt_disconnect(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_mqtt_state == SIM800L_MQTT_STATE_DISCONNECTED)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Goes out with whatever is still queued */
+    if ((sim800l_mqtt_state == SIM800L_MQTT_STATE_CONNECTED) && (sim800l_mqtt_reserve(sim800l_handle, SIM800L_MQTT_DISCONNECT, 0) != NULL))
+    {
+        sim800l_mqtt_flush(sim800l_handle);
+    }
+
+    sim800l_mqtt_state = SIM800L_MQTT_STATE_DISCONNECTED;
+    sim800l_tcpip_close(sim800l_handle, sim800l_mqtt_link, 0);
+    sim800l_mqtt_release();
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_mqtt_publish(sim800l_handle_t sim800l_handle, const char *topic, const uint8_t *payload, size_t payload_len, sim800l_mqtt_qos_t qos, bool retain)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (topic == NULL) || ((payload == NULL) && (payload_len > 0)) || (qos > SIM800L_MQTT_QOS_1))
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_mqtt_state != SIM800L_MQTT_STATE_CONNECTED)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Not connected");
+        return SIM800L_RET_ERROR;
+    }
+
+    size_t topic_len = strlen(topic);
+    size_t remaining = 2 + topic_len + ((qos == SIM800L_MQTT_QOS_1) ? 2 : 0) + payload_len;
+    size_t packet_len = 1 + sim800l_mqtt_length_size(remaining) + remaining;
+
+    /* QoS 1 keeps a copy for the DUP resend, wait for PUBACKs while the window is full */
+    if (qos == SIM800L_MQTT_QOS_1)
+    {
+        int64_t deadline = esp_timer_get_time() + (int64_t)SIM800L_MQTT_RETRY_MS * 1000;
+
+        while ((sim800l_mqtt_inflight_count == SIM800L_MQTT_MAX_INFLIGHT) || (sim800l_mqtt_inflight_len + packet_len > SIM800L_MQTT_INFLIGHT_SIZE))
+        {
+            if ((esp_timer_get_time() >= deadline) || (sim800l_mqtt_loop(sim800l_handle, SIM800L_MQTT_POLL_MS) != SIM800L_RET_OK))
+            {
+                ESP_LOGE(SIM800L_MQTT_TAG, "In-flight window full");
+                return SIM800L_RET_ERROR;
+            }
+        }
+    }
+
+    uint8_t header = SIM800L_MQTT_PUBLISH | (qos << 1) | (retain ? 0x01 : 0x00);
+    uint8_t *start = sim800l_mqtt_reserve(sim800l_handle, header, remaining);
+    if (start == NULL)
+    {
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Encoded in place, reserve returns the variable header */
+    uint8_t *out = sim800l_mqtt_put_string(start, topic, topic_len);
+    uint16_t packet_id = 0;
+
+    if (qos == SIM800L_MQTT_QOS_1)
+    {
+        packet_id = sim800l_mqtt_next_id();
+        *out++ = packet_id >> 8;
+        *out++ = packet_id & 0xFF;
+    }
+
+    if (payload_len > 0)
+    {
+        memcpy(out, payload, payload_len);
+    }
+
+    if (qos == SIM800L_MQTT_QOS_1)
+    {
+        for (uint32_t i = 0; i < SIM800L_MQTT_MAX_INFLIGHT; i++)
+        {
+            sim800l_mqtt_inflight_t *inflight = &sim800l_mqtt_inflight[i];
+
+            if (inflight->packet_id == 0)
+            {
+                inflight->packet_id = packet_id;
+                inflight->offset = sim800l_mqtt_inflight_len;
+                inflight->length = packet_len;
+                inflight->sent = esp_timer_get_time();
+                memcpy(&sim800l_mqtt_inflight_arena[inflight->offset], &sim800l_mqtt_arena[sim800l_mqtt_arena_len - packet_len], packet_len);
+                sim800l_mqtt_inflight_len += packet_len;
+                sim800l_mqtt_inflight_count++;
+                break;
+            }
+        }
+    }
+
+    sim800l_mqtt_stats.published++;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_mqtt_subscribe(sim800l_handle_t sim800l_handle, const char *topic, sim800l_mqtt_qos_t qos, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (topic == NULL) || (qos > SIM800L_MQTT_QOS_1))
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_mqtt_state != SIM800L_MQTT_STATE_CONNECTED)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Not connected");
+        return SIM800L_RET_ERROR;
+    }
+
+    size_t topic_len = strlen(topic);
+    uint8_t *out = sim800l_mqtt_reserve(sim800l_handle, SIM800L_MQTT_SUBSCRIBE, 2 + 2 + topic_len + 1);
+    if (out == NULL)
+    {
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    sim800l_mqtt_suback_id = sim800l_mqtt_next_id();
+    *out++ = sim800l_mqtt_suback_id >> 8;
+    *out++ = sim800l_mqtt_suback_id & 0xFF;
+    out = sim800l_mqtt_put_string(out, topic, topic_len);
+    *out = qos;
+
+    if (sim800l_mqtt_flush(sim800l_handle) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* SUBACK clears the pending id */
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout * 1000;
+
+    while ((sim800l_mqtt_suback_id != 0) && (esp_timer_get_time() < deadline))
+    {
+        if (sim800l_mqtt_loop(sim800l_handle, SIM800L_MQTT_POLL_MS) != SIM800L_RET_OK)
+        {
+            return SIM800L_RET_ERROR;
+        }
+    }
+
+    if (sim800l_mqtt_suback_id != 0)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "SUBACK not received for %s", topic);
+        sim800l_mqtt_suback_id = 0;
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_mqtt_flush(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_mqtt_arena_len == 0)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Every packet queued since the last flush shares the same CIPSENDs */
+    sim800l_ret_t ret = sim800l_tcpip_send_all(sim800l_handle, sim800l_mqtt_link, sim800l_mqtt_arena, sim800l_mqtt_arena_len, 0, SIM800L_MQTT_SEND_TIMEOUT);
+
+    if (ret == SIM800L_RET_OK)
+    {
+        sim800l_mqtt_stats.tx_bytes += sim800l_mqtt_arena_len;
+        sim800l_mqtt_stats.batches++;
+        sim800l_mqtt_last_tx = esp_timer_get_time();
+    }
+    else
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Flush of %u bytes failed", sim800l_mqtt_arena_len);
+    }
+
+    sim800l_mqtt_arena_len = 0;
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_mqtt_loop(sim800l_handle_t sim800l_handle, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_mqtt_state != SIM800L_MQTT_STATE_CONNECTED)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    if (sim800l_mqtt_receive(sim800l_handle, timeout) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Connection lost");
+        sim800l_mqtt_state = SIM800L_MQTT_STATE_DISCONNECTED;
+        sim800l_mqtt_release();
+        return SIM800L_RET_ERROR;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    /* Keep alive, the broker drops us after 1.5x keepalive of silence */
+    if (sim800l_mqtt_keepalive > 0)
+    {
+        int64_t keepalive_us = (int64_t)sim800l_mqtt_keepalive * 1000000;
+
+        if ((sim800l_mqtt_ping_sent != 0) && (now - sim800l_mqtt_ping_sent > keepalive_us))
+        {
+            ESP_LOGE(SIM800L_MQTT_TAG, "PINGRESP timeout");
+            sim800l_mqtt_disconnect(sim800l_handle);
+            return SIM800L_RET_ERROR;
+        }
+
+        if ((sim800l_mqtt_ping_sent == 0) && (now - sim800l_mqtt_last_tx >= keepalive_us / 2) &&
+            (sim800l_mqtt_reserve(sim800l_handle, SIM800L_MQTT_PINGREQ, 0) != NULL))
+        {
+            sim800l_mqtt_ping_sent = now;
+        }
+    }
+
+    /* QoS 1 without PUBACK, queued again with DUP */
+    for (uint32_t i = 0; i < SIM800L_MQTT_MAX_INFLIGHT; i++)
+    {
+        sim800l_mqtt_inflight_t *inflight = &sim800l_mqtt_inflight[i];
+
+        if ((inflight->packet_id == 0) || (now - inflight->sent < (int64_t)SIM800L_MQTT_RETRY_MS * 1000))
+        {
+            continue;
+        }
+
+        if (sim800l_mqtt_arena_len + inflight->length > SIM800L_MQTT_ARENA_SIZE)
+        {
+            break;
+        }
+
+        sim800l_mqtt_inflight_arena[inflight->offset] |= SIM800L_MQTT_DUP;
+        memcpy(&sim800l_mqtt_arena[sim800l_mqtt_arena_len], &sim800l_mqtt_inflight_arena[inflight->offset], inflight->length);
+        sim800l_mqtt_arena_len += inflight->length;
+        inflight->sent = now;
+        sim800l_mqtt_stats.retransmits++;
+    }
+
+    /* PUBACKs, PINGREQ, resends and anything published since the last flush */
+    return sim800l_mqtt_flush(sim800l_handle);
+}
+
+sim800l_ret_t sim800l_mqtt_set_message_callback(sim800l_mqtt_message_cb_t *callback, void *arg)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    sim800l_mqtt_message_cb = callback;
+    sim800l_mqtt_message_arg = arg;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_mqtt_state_t sim800l_mqtt_get_state(void)
+{
+    return sim800l_mqtt_state;
+}
+
+sim800l_ret_t sim800l_mqtt_get_stats(sim800l_mqtt_stats_t *stats)
+{
+    ESP_LOGD(SIM800L_MQTT_TAG, "%s", __func__);
+
+    if (stats == NULL)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    *stats = sim800l_mqtt_stats;
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static size_t sim800l_mqtt_length_size(size_t length)
+{
+    /* Remaining length, 7 bits per byte */
+    return (length < 128) ? 1 : (length < 16384) ? 2 : (length < 2097152) ? 3 : 4;
+}
+
+static uint8_t *sim800l_mqtt_reserve(sim800l_handle_t sim800l_handle, uint8_t type, size_t remaining)
+{
+    size_t packet_len = 1 + sim800l_mqtt_length_size(remaining) + remaining;
+
+    if (packet_len > SIM800L_MQTT_ARENA_SIZE)
+    {
+        ESP_LOGE(SIM800L_MQTT_TAG, "Packet of %u bytes does not fit the arena", packet_len);
+        return NULL;
+    }
+
+    /* Arena full, what is queued goes out first */
+    if ((sim800l_mqtt_arena_len + packet_len > SIM800L_MQTT_ARENA_SIZE) && (sim800l_mqtt_flush(sim800l_handle) != SIM800L_RET_OK))
+    {
+        return NULL;
+    }
+
+    uint8_t *out = &sim800l_mqtt_arena[sim800l_mqtt_arena_len];
+    sim800l_mqtt_arena_len += packet_len;
+
+    *out++ = type;
+
+    do
+    {
+        uint8_t byte = remaining % 128;
+        remaining /= 128;
+        *out++ = (remaining > 0) ? (byte | 0x80) : byte;
+    } while (remaining > 0);
+
+    return out;
+}
+
+static uint8_t *sim800l_mqtt_put_string(uint8_t *out, const char *string, size_t length)
+{
+    *out++ = length >> 8;
+    *out++ = length & 0xFF;
+    memcpy(out, string, length);
+
+    return out + length;
+}
+
+static uint16_t sim800l_mqtt_next_id(void)
+{
+    /* 0 is not a valid packet identifier */
+    if (++sim800l_mqtt_packet_id == 0)
+    {
+        sim800l_mqtt_packet_id = 1;
+    }
+
+    return sim800l_mqtt_packet_id;
+}
+
+static sim800l_ret_t sim800l_mqtt_receive(sim800l_handle_t sim800l_handle, uint32_t timeout)
+{
+    size_t received = 0;
+
+    if (sim800l_tcpip_recv(sim800l_handle, sim800l_mqtt_link, &sim800l_mqtt_rx[sim800l_mqtt_rx_len], SIM800L_MQTT_RX_SIZE - sim800l_mqtt_rx_len, &received, timeout) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_mqtt_rx_len += received;
+    sim800l_mqtt_stats.rx_bytes += received;
+
+    /* Whole packets only, a partial one stays at the front of the buffer */
+    size_t offset = 0;
+
+    while (sim800l_mqtt_rx_len - offset >= 2)
+    {
+        size_t remaining = 0;
+        size_t length_size = 0;
+        size_t multiplier = 1;
+        bool complete = false;
+
+        while ((length_size < 4) && (offset + 1 + length_size < sim800l_mqtt_rx_len))
+        {
+            uint8_t byte = sim800l_mqtt_rx[offset + 1 + length_size++];
+            remaining += (byte & 0x7F) * multiplier;
+            multiplier *= 128;
+
+            if ((byte & 0x80) == 0)
+            {
+                complete = true;
+                break;
+            }
+        }
+
+        size_t packet_len = 1 + length_size + remaining;
+
+        if (complete && (packet_len > SIM800L_MQTT_RX_SIZE))
+        {
+            ESP_LOGE(SIM800L_MQTT_TAG, "Packet of %u bytes too large", packet_len);
+            return SIM800L_RET_ERROR;
+        }
+
+        if (!complete || (offset + packet_len > sim800l_mqtt_rx_len))
+        {
+            break;
+        }
+
+        sim800l_mqtt_process(sim800l_handle, sim800l_mqtt_rx[offset], &sim800l_mqtt_rx[offset + 1 + length_size], remaining);
+        offset += packet_len;
+    }
+
+    if (offset > 0)
+    {
+        memmove(sim800l_mqtt_rx, &sim800l_mqtt_rx[offset], sim800l_mqtt_rx_len - offset);
+        sim800l_mqtt_rx_len -= offset;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_mqtt_process(sim800l_handle_t sim800l_handle, uint8_t header, const uint8_t *data, size_t data_len)
+{
+    uint16_t packet_id = (data_len >= 2) ? ((data[0] << 8) | data[1]) : 0;
+
+    switch (header & 0xF0)
+    {
+    case SIM800L_MQTT_CONNACK:
+        /* Return code in the second byte, 0 is accepted */
+        if ((data_len >= 2) && (data[1] == 0))
+        {
+            sim800l_mqtt_state = SIM800L_MQTT_STATE_CONNECTED;
+            sim800l_mqtt_ping_sent = 0;
+        }
+        else
+        {
+            ESP_LOGE(SIM800L_MQTT_TAG, "Connection refused: %u", (data_len >= 2) ? data[1] : 0xFF);
+        }
+        break;
+
+    case SIM800L_MQTT_PUBACK:
+        for (uint32_t i = 0; i < SIM800L_MQTT_MAX_INFLIGHT; i++)
+        {
+            if (sim800l_mqtt_inflight[i].packet_id == packet_id)
+            {
+                sim800l_mqtt_inflight[i].packet_id = 0;
+                sim800l_mqtt_inflight_count--;
+                sim800l_mqtt_stats.acked++;
+                break;
+            }
+        }
+
+        /* Arena reclaimed once nothing is in flight */
+        if (sim800l_mqtt_inflight_count == 0)
+        {
+            sim800l_mqtt_inflight_len = 0;
+        }
+        break;
+
+    case SIM800L_MQTT_SUBACK:
+        if (packet_id == sim800l_mqtt_suback_id)
+        {
+            sim800l_mqtt_suback_id = 0;
+        }
+        break;
+
+    case SIM800L_MQTT_PINGRESP:
+        sim800l_mqtt_ping_sent = 0;
+        break;
+
+    case SIM800L_MQTT_PUBLISH:
+    {
+        if (data_len < 2)
+        {
+            break;
+        }
+
+        size_t topic_len = (data[0] << 8) | data[1];
+        size_t offset = 2 + topic_len;
+        uint8_t qos = (header >> 1) & 0x03;
+
+        if (qos > 0)
+        {
+            packet_id = (offset + 2 <= data_len) ? ((data[offset] << 8) | data[offset + 1]) : 0;
+            offset += 2;
+        }
+
+        if (offset > data_len)
+        {
+            break;
+        }
+
+        sim800l_mqtt_stats.received++;
+
+        if (sim800l_mqtt_message_cb != NULL)
+        {
+            sim800l_mqtt_message_cb((const char *)&data[2], topic_len, &data[offset], data_len - offset, sim800l_mqtt_message_arg);
+        }
+
+        /* PUBACK goes out with the next flush */
+        if (qos == 1)
+        {
+            uint8_t *out = sim800l_mqtt_reserve(sim800l_handle, SIM800L_MQTT_PUBACK, 2);
+            if (out != NULL)
+            {
+                *out++ = packet_id >> 8;
+                *out = packet_id & 0xFF;
+            }
+        }
+        break;
+    }
+
+    default:
+        ESP_LOGW(SIM800L_MQTT_TAG, "Unhandled packet 0x%02X", header);
+        break;
+    }
+}
+
+static void sim800l_mqtt_release(void)
+{
+    sim800l_mqtt_arena_len = 0;
+    sim800l_mqtt_inflight_len = 0;
+    sim800l_mqtt_inflight_count = 0;
+    sim800l_mqtt_rx_len = 0;
+    sim800l_mqtt_suback_id = 0;
+    sim800l_mqtt_ping_sent = 0;
+    memset(sim800l_mqtt_inflight, 0, sizeof(sim800l_mqtt_inflight));
+}
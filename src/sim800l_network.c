@@ -0,0 +1,473 @@
+/*
+ * @file sim800l_network.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L network registration and signal quality functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_network.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_NETWORK_INTERVAL_MS     10000
+#define SIM800L_NETWORK_BUSY_MS         100     /* Line in use, try the sample again shortly */
+#define SIM800L_NETWORK_RSSI_UNKNOWN    99
+
+#define SIM800L_NETWORK_TASK_STACK_SIZE 3072
+#define SIM800L_NETWORK_TASK_PRIORITY   0       /* Below application tasks, samples are never urgent */
+#define SIM800L_NETWORK_TASK_NAME       "sim800l_network_task"
+
+/*
+ *     Event bits
+ */
+#define SIM800L_NETWORK_WAKE_BIT        BIT0
+#define SIM800L_NETWORK_STOPPED_BIT     BIT1
+
+/*
+ *     Tag
+ */
+#define SIM800L_NETWORK_TAG "SIM800L NETWORK"
+
+/*
+ *     URC
+ */
+#define SIM800L_EVENT_NETWORK_CREG_STR  "+CREG"
+#define SIM800L_EVENT_NETWORK_CGREG_STR "+CGREG"
+
+/*
+ *     Registration
+ */
+static bool sim800l_network_reports = false;
+static sim800l_network_registration_t sim800l_network_registration = {0};
+
+/*
+ *     Signal history, samples are numbered and sample n lives at n % SIM800L_NETWORK_HISTORY_SIZE
+ */
+static struct
+{
+    sim800l_network_sample_t ring[SIM800L_NETWORK_HISTORY_SIZE];
+    uint32_t next;                      /* Number of the next sample */
+    uint32_t window;
+    uint32_t sum;                       /* rssi of the last window samples */
+    uint32_t min_queue[SIM800L_NETWORK_HISTORY_SIZE]; /* Sample numbers with increasing rssi, front is the minimum */
+    uint32_t min_front;
+    uint32_t min_count;
+} sim800l_network_history = {0};
+
+/*
+ *     Monitor
+ */
+static sim800l_handle_t sim800l_network_handle = NULL;
+static SemaphoreHandle_t sim800l_network_mutex = NULL;
+static EventGroupHandle_t sim800l_network_events = NULL;
+static volatile bool sim800l_network_running = false;
+static uint32_t sim800l_network_interval = SIM800L_NETWORK_INTERVAL_MS;
+
+/*
+ *     Private functions
+ */
+static void sim800l_network_task(void *args);
+static sim800l_ret_t sim800l_network_sample(sim800l_handle_t sim800l_handle, sim800l_network_sample_t *sample);
+static void sim800l_network_push(const sim800l_network_sample_t *sample);
+static uint32_t sim800l_network_hex(const char *arg);
+static sim800l_event_t sim800l_network_registration_event(char **input_args, void *output_data, bool gprs);
+
+/*
+ *     Callbacks
+ */
+sim800l_event_t sim800l_event_network_creg(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_network_cgreg(char **input_args, void *output_data);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_network_switch(sim800l_handle_t sim800l_handle, bool enable)
+{
+    ESP_LOGD(SIM800L_NETWORK_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_NETWORK_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (enable == sim800l_network_reports)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    if (enable)
+    {
+        if ((sim800l_register_callback(SIM800L_EVENT_NETWORK_CREG_STR, sim800l_event_network_creg) != ESP_OK) ||
+            (sim800l_register_callback(SIM800L_EVENT_NETWORK_CGREG_STR, sim800l_event_network_cgreg) != ESP_OK))
+        {
+            ESP_LOGE(SIM800L_NETWORK_TAG, "sim800l_register_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+    }
+    else
+    {
+        sim800l_unregister_callback(SIM800L_EVENT_NETWORK_CREG_STR);
+        sim800l_unregister_callback(SIM800L_EVENT_NETWORK_CGREG_STR);
+    }
+
+    sim800l_network_reports = enable;
+
+    /* 2: registration changes with location, 0: off */
+    const char *mode = enable ? "=2\r\n" : "=0\r\n";
+    char command[24] = {0};
+
+    snprintf(command, sizeof(command), "%s%s", SIM800L_COMMAND_NETWORK_REGISTRATION, mode);
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)command, SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_NETWORK_TAG, "AT+CREG failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    snprintf(command, sizeof(command), "%s%s", SIM800L_COMMAND_GPRS_REGISTRATION, mode);
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)command, SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_NETWORK_TAG, "AT+CGREG failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_network_monitor_start(sim800l_handle_t sim800l_handle, const sim800l_network_monitor_config_t *config)
+{
+    ESP_LOGD(SIM800L_NETWORK_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_NETWORK_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_network_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    if (sim800l_network_mutex == NULL)
+    {
+        sim800l_network_mutex = xSemaphoreCreateMutex();
+        sim800l_network_events = xEventGroupCreate();
+        if ((sim800l_network_mutex == NULL) || (sim800l_network_events == NULL))
+        {
+            ESP_LOGE(SIM800L_NETWORK_TAG, "Memory allocation failed");
+            return SIM800L_RET_ERROR_MEM;
+        }
+    }
+
+    sim800l_ret_t ret = sim800l_network_switch(sim800l_handle, true);
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    /* Defaults for unset fields */
+    sim800l_network_interval = ((config != NULL) && (config->interval_ms > 0)) ? config->interval_ms : SIM800L_NETWORK_INTERVAL_MS;
+
+    memset(&sim800l_network_history, 0, sizeof(sim800l_network_history));
+    sim800l_network_history.window = ((config != NULL) && (config->window > 0) && (config->window < SIM800L_NETWORK_HISTORY_SIZE)) ? config->window : SIM800L_NETWORK_HISTORY_SIZE;
+
+    xEventGroupClearBits(sim800l_network_events, SIM800L_NETWORK_WAKE_BIT | SIM800L_NETWORK_STOPPED_BIT);
+
+    sim800l_network_handle = sim800l_handle;
+    sim800l_network_running = true;
+    if (xTaskCreate(sim800l_network_task, SIM800L_NETWORK_TASK_NAME, SIM800L_NETWORK_TASK_STACK_SIZE, NULL, SIM800L_NETWORK_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_NETWORK_TAG, "xTaskCreate failed");
+        sim800l_network_running = false;
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_network_monitor_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_NETWORK_TAG, "%s", __func__);
+
+    if (!sim800l_network_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Registration reports stay on, the bearer manager may rely on them */
+    sim800l_network_running = false;
+    xEventGroupSetBits(sim800l_network_events, SIM800L_NETWORK_WAKE_BIT);
+
+    if (!(xEventGroupWaitBits(sim800l_network_events, SIM800L_NETWORK_STOPPED_BIT, pdTRUE, pdTRUE, 5000 / portTICK_PERIOD_MS) & SIM800L_NETWORK_STOPPED_BIT))
+    {
+        ESP_LOGW(SIM800L_NETWORK_TAG, "Monitor task did not stop");
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_network_get_registration(sim800l_network_registration_t *registration)
+{
+    if (registration == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Written by the bridge task, small enough to copy as is */
+    memcpy(registration, &sim800l_network_registration, sizeof(sim800l_network_registration_t));
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_network_get_signal(sim800l_network_signal_t *signal)
+{
+    if (signal == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memset(signal, 0, sizeof(sim800l_network_signal_t));
+
+    if (sim800l_network_mutex == NULL)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    xSemaphoreTake(sim800l_network_mutex, portMAX_DELAY);
+
+    /* Running sum and min queue are kept on insert, nothing is scanned here */
+    uint32_t next = sim800l_network_history.next;
+    if (next > 0)
+    {
+        uint32_t samples = (next < sim800l_network_history.window) ? next : sim800l_network_history.window;
+        uint32_t min_sample = sim800l_network_history.min_queue[sim800l_network_history.min_front];
+
+        signal->current = sim800l_network_history.ring[(next - 1) % SIM800L_NETWORK_HISTORY_SIZE];
+        signal->min_rssi = sim800l_network_history.ring[min_sample % SIM800L_NETWORK_HISTORY_SIZE].rssi;
+        signal->avg_rssi = (sim800l_network_history.sum + samples / 2) / samples;
+        signal->samples = samples;
+    }
+
+    xSemaphoreGive(sim800l_network_mutex);
+
+    return (signal->samples > 0) ? SIM800L_RET_OK : SIM800L_RET_ERROR;
+}
+
+size_t sim800l_network_get_history(sim800l_network_sample_t *samples, size_t max_samples)
+{
+    if ((samples == NULL) || (sim800l_network_mutex == NULL))
+    {
+        return 0;
+    }
+
+    xSemaphoreTake(sim800l_network_mutex, portMAX_DELAY);
+
+    /* Oldest first */
+    uint32_t next = sim800l_network_history.next;
+    uint32_t kept = (next < SIM800L_NETWORK_HISTORY_SIZE) ? next : SIM800L_NETWORK_HISTORY_SIZE;
+    size_t count = (kept < max_samples) ? kept : max_samples;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        samples[i] = sim800l_network_history.ring[(next - count + i) % SIM800L_NETWORK_HISTORY_SIZE];
+    }
+
+    xSemaphoreGive(sim800l_network_mutex);
+
+    return count;
+}
+
+bool sim800l_network_is_registered(void)
+{
+    sim800l_network_stat_t stat = sim800l_network_registration.cgreg;
+
+    return (stat == SIM800L_NETWORK_HOME) || (stat == SIM800L_NETWORK_ROAMING);
+}
+
+int32_t sim800l_network_rssi_to_dbm(uint8_t rssi)
+{
+    /* 0 is -113 dBm or less, 31 is -51 dBm or more */
+    return (rssi > 31) ? 0 : -113 + 2 * (int32_t)rssi;
+}
+
+/*
+ *     Private functions development
+ */
+static void sim800l_network_task(void *args)
+{
+    while (sim800l_network_running)
+    {
+        uint32_t delay = sim800l_network_interval;
+
+        /* Only on an idle line, an application command is never held up by a sample */
+        if ((sim800l_data_mode_get(sim800l_network_handle, NULL) != SIM800L_DATA_MODE_OFF) || (sim800l_lock(sim800l_network_handle, 0) != ESP_OK))
+        {
+            delay = SIM800L_NETWORK_BUSY_MS;
+        }
+        else
+        {
+            sim800l_network_sample_t sample = {0};
+            sim800l_ret_t ret = sim800l_network_sample(sim800l_network_handle, &sample);
+
+            sim800l_unlock(sim800l_network_handle);
+
+            if ((ret == SIM800L_RET_OK) && (sample.rssi != SIM800L_NETWORK_RSSI_UNKNOWN))
+            {
+                xSemaphoreTake(sim800l_network_mutex, portMAX_DELAY);
+                sim800l_network_push(&sample);
+                xSemaphoreGive(sim800l_network_mutex);
+            }
+        }
+
+        /* Stop cuts the wait short */
+        xEventGroupWaitBits(sim800l_network_events, SIM800L_NETWORK_WAKE_BIT, pdTRUE, pdTRUE, delay / portTICK_PERIOD_MS);
+    }
+
+    xEventGroupSetBits(sim800l_network_events, SIM800L_NETWORK_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+static sim800l_ret_t sim800l_network_sample(sim800l_handle_t sim800l_handle, sim800l_network_sample_t *sample)
+{
+    /* Response, +CSQ: <rssi>,<ber> */
+    char response[32] = {0};
+
+    if (sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_SIGNAL_QUALITY "\r\n", (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_NETWORK_TAG, "sim800l_out_data failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    char *args = strchr(response, ':');
+    if (args == NULL)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    char *end = NULL;
+    sample->rssi = (uint8_t)strtoul(args + 1, &end, 10);
+    sample->ber = ((end != NULL) && (*end == ',')) ? (uint8_t)strtoul(end + 1, NULL, 10) : SIM800L_NETWORK_RSSI_UNKNOWN;
+    sample->timestamp = esp_timer_get_time();
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_network_push(const sim800l_network_sample_t *sample)
+{
+    uint32_t number = sim800l_network_history.next;
+    uint32_t window = sim800l_network_history.window;
+
+    /* Sample leaving the window, window <= history so it is still in the ring */
+    if (number >= window)
+    {
+        sim800l_network_history.sum -= sim800l_network_history.ring[(number - window) % SIM800L_NETWORK_HISTORY_SIZE].rssi;
+    }
+
+    sim800l_network_history.ring[number % SIM800L_NETWORK_HISTORY_SIZE] = *sample;
+    sim800l_network_history.sum += sample->rssi;
+
+    /* Min queue: drop the front once it is out of the window, then the back entries this sample beats */
+    uint32_t *queue = sim800l_network_history.min_queue;
+    if ((sim800l_network_history.min_count > 0) && (queue[sim800l_network_history.min_front] + window <= number))
+    {
+        sim800l_network_history.min_front = (sim800l_network_history.min_front + 1) % SIM800L_NETWORK_HISTORY_SIZE;
+        sim800l_network_history.min_count--;
+    }
+
+    while (sim800l_network_history.min_count > 0)
+    {
+        uint32_t back = (sim800l_network_history.min_front + sim800l_network_history.min_count - 1) % SIM800L_NETWORK_HISTORY_SIZE;
+        if (sim800l_network_history.ring[queue[back] % SIM800L_NETWORK_HISTORY_SIZE].rssi < sample->rssi)
+        {
+            break;
+        }
+
+        sim800l_network_history.min_count--;
+    }
+
+    queue[(sim800l_network_history.min_front + sim800l_network_history.min_count) % SIM800L_NETWORK_HISTORY_SIZE] = number;
+    sim800l_network_history.min_count++;
+
+    sim800l_network_history.next = number + 1;
+}
+
+static uint32_t sim800l_network_hex(const char *arg)
+{
+    if (arg == NULL)
+    {
+        return 0;
+    }
+
+    /* "1A2B" with quotes and leading spaces */
+    while ((*arg == ' ') || (*arg == '"'))
+    {
+        arg++;
+    }
+
+    return (uint32_t)strtoul(arg, NULL, 16);
+}
+
+static sim800l_event_t sim800l_network_registration_event(char **input_args, void *output_data, bool gprs)
+{
+    sim800l_network_event_t *event = (sim800l_network_event_t *)output_data;
+
+    /* URC "<stat>[,<lac>,<ci>]", query answer "<n>,<stat>[,<lac>,<ci>]", lac is always quoted */
+    uint32_t first = 0;
+    if ((input_args[0] != NULL) && (input_args[1] != NULL) && (strchr(input_args[1], '"') == NULL))
+    {
+        first = 1;
+    }
+
+    event->gprs = gprs;
+    event->stat = (input_args[first] != NULL) ? (sim800l_network_stat_t)atoi(input_args[first]) : SIM800L_NETWORK_UNKNOWN;
+    event->lac = (input_args[first] != NULL) ? sim800l_network_hex(input_args[first + 1]) : 0;
+    event->ci = ((input_args[first] != NULL) && (input_args[first + 1] != NULL)) ? sim800l_network_hex(input_args[first + 2]) : 0;
+
+    sim800l_network_stat_t *stat = gprs ? &sim800l_network_registration.cgreg : &sim800l_network_registration.creg;
+    if (*stat != event->stat)
+    {
+        ESP_LOGI(SIM800L_NETWORK_TAG, "%s %d", gprs ? "CGREG" : "CREG", event->stat);
+        *stat = event->stat;
+        sim800l_network_registration.changed = esp_timer_get_time();
+    }
+
+    if (event->lac != 0)
+    {
+        sim800l_network_registration.lac = event->lac;
+        sim800l_network_registration.ci = event->ci;
+    }
+
+    return SIM800L_EVENT_NETWORK;
+}
+
+/*
+ *     Callbacks development
+ */
+sim800l_event_t sim800l_event_network_creg(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_NETWORK_TAG, "%s", __func__);
+
+    return sim800l_network_registration_event(input_args, output_data, false);
+}
+
+sim800l_event_t sim800l_event_network_cgreg(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_NETWORK_TAG, "%s", __func__);
+
+    return sim800l_network_registration_event(input_args, output_data, true);
+}
@@ -0,0 +1,413 @@
+/*
+ * @file sim800l_ntp.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L NTP (AT+CNTP) time sync functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_ntp.h"
+#include "sim800l_bearer.h"
+#include "sim800l_location.h"
+#include "sim800l_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_NTP_SERVER              "pool.ntp.org"
+#define SIM800L_NTP_MIN_INTERVAL_MS     21600000    /* 6 hours */
+#define SIM800L_NTP_TIMEOUT             20000       /* +CNTP after the request */
+#define SIM800L_NTP_RESULT_OK           1           /* 61 network, 62 DNS, 63 connect, 64 timeout, 65 server, 66 not allowed */
+#define SIM800L_NTP_MIN_EPOCH           1577836800  /* 2020-01-01, below that the system clock was never set */
+#define SIM800L_NTP_STEP_LIMIT_US       (1800LL * 1000000)  /* Further off than this is stepped, adjtime takes too long */
+#define SIM800L_NTP_RESOLUTION_US       1000000     /* AT+CCLK has whole seconds, closer than this is left alone */
+
+#define SIM800L_NTP_TASK_STACK_SIZE     4096
+#define SIM800L_NTP_TASK_PRIORITY       1
+#define SIM800L_NTP_TASK_NAME           "sim800l_ntp_task"
+
+/*
+ *     Event bits
+ */
+#define SIM800L_NTP_DONE_BIT            BIT0
+#define SIM800L_NTP_WAKE_BIT            BIT1
+#define SIM800L_NTP_STOPPED_BIT         BIT2
+
+/*
+ *     Tag
+ */
+#define SIM800L_NTP_TAG "SIM800L NTP"
+
+/*
+ *     URC
+ */
+#define SIM800L_EVENT_NTP_STR           "+CNTP"
+
+/*
+ *     Sync
+ */
+static EventGroupHandle_t sim800l_ntp_events = NULL;
+static volatile uint32_t sim800l_ntp_result = 0;
+static sim800l_ntp_stats_t sim800l_ntp_stats = {0};
+
+/*
+ *     Auto sync
+ */
+static sim800l_handle_t sim800l_ntp_handle = NULL;
+static sim800l_ntp_config_t sim800l_ntp_config = {0};
+static char sim800l_ntp_server[64] = {0};
+static volatile bool sim800l_ntp_running = false;
+
+/*
+ *     Private functions
+ */
+static void sim800l_ntp_task(void *args);
+static bool sim800l_ntp_init(void);
+static bool sim800l_ntp_bearer_up(sim800l_handle_t sim800l_handle, uint32_t cid);
+static void sim800l_ntp_apply(int64_t epoch, int64_t read_at);
+
+/*
+ *     Event handlers
+ */
+static void sim800l_ntp_bearer_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data);
+
+/*
+ *     Callbacks
+ */
+sim800l_event_t sim800l_event_ntp(char **input_args, void *output_data);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_ntp_sync(sim800l_handle_t sim800l_handle, const sim800l_ntp_config_t *config)
+{
+    ESP_LOGD(SIM800L_NTP_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_ntp_init())
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    uint32_t cid = ((config != NULL) && (config->cid > 0)) ? config->cid : SIM800L_BEARER_CID_DEFAULT;
+    uint32_t min_interval = ((config != NULL) && (config->min_interval_ms > 0)) ? config->min_interval_ms : SIM800L_NTP_MIN_INTERVAL_MS;
+    const char *server = ((config != NULL) && (config->server != NULL)) ? config->server : SIM800L_NTP_SERVER;
+    int32_t timezone = (config != NULL) ? config->timezone : 0;
+
+    /* Recent enough, nothing to gain */
+    if ((sim800l_ntp_stats.last_sync != 0) && ((esp_timer_get_time() - sim800l_ntp_stats.last_sync) / 1000 < min_interval))
+    {
+        sim800l_ntp_stats.skipped++;
+        return SIM800L_RET_OK;
+    }
+
+    /* Piggyback only, a radio wakeup for the time alone costs more than the drift */
+    if (!sim800l_ntp_bearer_up(sim800l_handle, cid))
+    {
+        ESP_LOGD(SIM800L_NTP_TAG, "Bearer %lu down, skipped", cid);
+        sim800l_ntp_stats.skipped++;
+        return SIM800L_RET_ERROR;
+    }
+
+    if (sim800l_register_callback(SIM800L_EVENT_NTP_STR, sim800l_event_ntp) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "sim800l_register_callback failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    char command[96] = {0};
+    sim800l_ret_t ret = SIM800L_RET_OK;
+
+    snprintf(command, sizeof(command), "%s=%lu\r\n", SIM800L_COMMAND_NTP_BEARER, cid);
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)command, SIM800L_EVENT_OK, 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "AT+CNTPCID failed");
+        ret = SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    if (ret == SIM800L_RET_OK)
+    {
+        snprintf(command, sizeof(command), "%s=\"%s\",%ld\r\n", SIM800L_COMMAND_NTP, server, timezone);
+        if (sim800l_out_data_event(sim800l_handle, (uint8_t *)command, SIM800L_EVENT_OK, 1000) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_NTP_TAG, "AT+CNTP config failed");
+            ret = SIM800L_RET_ERROR_SEND_COMMAND;
+        }
+    }
+
+    /* OK first, the result follows as +CNTP: <code> */
+    if (ret == SIM800L_RET_OK)
+    {
+        sim800l_ntp_result = 0;
+        xEventGroupClearBits(sim800l_ntp_events, SIM800L_NTP_DONE_BIT);
+
+        if (sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_NTP "\r\n", SIM800L_EVENT_OK, 1000) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_NTP_TAG, "AT+CNTP failed");
+            ret = SIM800L_RET_ERROR_SEND_COMMAND;
+        }
+        else if (!(xEventGroupWaitBits(sim800l_ntp_events, SIM800L_NTP_DONE_BIT, pdTRUE, pdTRUE, SIM800L_NTP_TIMEOUT / portTICK_PERIOD_MS) & SIM800L_NTP_DONE_BIT))
+        {
+            ESP_LOGE(SIM800L_NTP_TAG, "+CNTP timeout");
+            ret = SIM800L_RET_ERROR;
+        }
+        else if (sim800l_ntp_result != SIM800L_NTP_RESULT_OK)
+        {
+            ESP_LOGW(SIM800L_NTP_TAG, "+CNTP error %lu", sim800l_ntp_result);
+            ret = SIM800L_RET_ERROR;
+        }
+    }
+
+    sim800l_unregister_callback(SIM800L_EVENT_NTP_STR);
+
+    /* RTC is set now, read it back and bring the system clock in line */
+    sim800l_time_t time = {0};
+    if ((ret == SIM800L_RET_OK) && (sim800l_location_time_read_rtc(sim800l_handle, SIM800L_TIME_SOURCE_NTP, &time) != SIM800L_RET_OK))
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "AT+CCLK failed");
+        ret = SIM800L_RET_ERROR;
+    }
+
+    if (ret != SIM800L_RET_OK)
+    {
+        sim800l_ntp_stats.failures++;
+        return ret;
+    }
+
+    sim800l_ntp_apply(time.epoch, esp_timer_get_time());
+    sim800l_ntp_stats.syncs++;
+    sim800l_ntp_stats.last_sync = esp_timer_get_time();
+
+    ESP_LOGI(SIM800L_NTP_TAG, "Synced, offset %lld ms", sim800l_ntp_stats.last_offset_ms);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ntp_job(sim800l_handle_t sim800l_handle, void *arg)
+{
+    ESP_LOGD(SIM800L_NTP_TAG, "%s", __func__);
+
+    /* As a sim800l_scheduler job, rides on a session opened for real work, a failure is not worth a retry */
+    sim800l_ntp_sync(sim800l_handle, (const sim800l_ntp_config_t *)arg);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ntp_auto_start(sim800l_handle_t sim800l_handle, const sim800l_ntp_config_t *config)
+{
+    ESP_LOGD(SIM800L_NTP_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_ntp_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    if (!sim800l_ntp_init())
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Kept for the task, the server string too */
+    memset(&sim800l_ntp_config, 0, sizeof(sim800l_ntp_config_t));
+    if (config != NULL)
+    {
+        sim800l_ntp_config = *config;
+        if (config->server != NULL)
+        {
+            snprintf(sim800l_ntp_server, sizeof(sim800l_ntp_server), "%s", config->server);
+            sim800l_ntp_config.server = sim800l_ntp_server;
+        }
+    }
+
+    if (sim800l_ntp_config.min_interval_ms == 0)
+    {
+        sim800l_ntp_config.min_interval_ms = SIM800L_NTP_MIN_INTERVAL_MS;
+    }
+
+    /* Bearer manager UP is the cue */
+    if (sim800l_register_event(sim800l_handle, SIM800L_EVENT_BEARER, sim800l_ntp_bearer_handler, NULL) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "sim800l_register_event failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    xEventGroupClearBits(sim800l_ntp_events, SIM800L_NTP_WAKE_BIT | SIM800L_NTP_STOPPED_BIT);
+
+    sim800l_ntp_handle = sim800l_handle;
+    sim800l_ntp_running = true;
+    if (xTaskCreate(sim800l_ntp_task, SIM800L_NTP_TASK_NAME, SIM800L_NTP_TASK_STACK_SIZE, NULL, SIM800L_NTP_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_NTP_TAG, "xTaskCreate failed");
+        sim800l_ntp_running = false;
+        sim800l_unregister_event(sim800l_handle, SIM800L_EVENT_BEARER, sim800l_ntp_bearer_handler);
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ntp_auto_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_NTP_TAG, "%s", __func__);
+
+    if (!sim800l_ntp_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    sim800l_ntp_running = false;
+    xEventGroupSetBits(sim800l_ntp_events, SIM800L_NTP_WAKE_BIT);
+
+    /* A sync in flight has to finish first */
+    if (!(xEventGroupWaitBits(sim800l_ntp_events, SIM800L_NTP_STOPPED_BIT, pdTRUE, pdTRUE, (SIM800L_NTP_TIMEOUT + 5000) / portTICK_PERIOD_MS) & SIM800L_NTP_STOPPED_BIT))
+    {
+        ESP_LOGW(SIM800L_NTP_TAG, "NTP task did not stop");
+    }
+
+    sim800l_unregister_event(sim800l_handle, SIM800L_EVENT_BEARER, sim800l_ntp_bearer_handler);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ntp_get_stats(sim800l_ntp_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_ntp_stats, sizeof(sim800l_ntp_stats_t));
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static void sim800l_ntp_task(void *args)
+{
+    while (sim800l_ntp_running)
+    {
+        /* Bearer came up, or min_interval passed and it may still be up; sync skips when it is not */
+        xEventGroupWaitBits(sim800l_ntp_events, SIM800L_NTP_WAKE_BIT, pdTRUE, pdTRUE, sim800l_ntp_config.min_interval_ms / portTICK_PERIOD_MS);
+
+        if (sim800l_ntp_running)
+        {
+            sim800l_ntp_sync(sim800l_ntp_handle, &sim800l_ntp_config);
+        }
+    }
+
+    xEventGroupSetBits(sim800l_ntp_events, SIM800L_NTP_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+static bool sim800l_ntp_init(void)
+{
+    if (sim800l_ntp_events == NULL)
+    {
+        sim800l_ntp_events = xEventGroupCreate();
+    }
+
+    return sim800l_ntp_events != NULL;
+}
+
+static bool sim800l_ntp_bearer_up(sim800l_handle_t sim800l_handle, uint32_t cid)
+{
+    /* AT+SAPBR=2 is answered locally, no radio */
+    sim800l_bearer_t bearer = {0};
+
+    return (sim800l_bearer_profile_query(sim800l_handle, cid, &bearer) == SIM800L_RET_OK) && (bearer.status == 1);
+}
+
+static void sim800l_ntp_apply(int64_t epoch, int64_t read_at)
+{
+    struct timeval now = {0};
+    gettimeofday(&now, NULL);
+
+    /* AT+CCLK truncates to the second, the middle of it is the best guess */
+    int64_t ntp_us = epoch * 1000000 + SIM800L_NTP_RESOLUTION_US / 2 + (esp_timer_get_time() - read_at);
+    int64_t system_us = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+    int64_t offset_us = ntp_us - system_us;
+
+    sim800l_ntp_stats.last_offset_ms = offset_us / 1000;
+
+    /* Never set or far off: step, a slew would take hours */
+    if ((now.tv_sec < SIM800L_NTP_MIN_EPOCH) || (llabs(offset_us) > SIM800L_NTP_STEP_LIMIT_US))
+    {
+        struct timeval step = {
+            .tv_sec = (time_t)(ntp_us / 1000000),
+            .tv_usec = (suseconds_t)(ntp_us % 1000000)};
+        settimeofday(&step, NULL);
+        sim800l_ntp_stats.steps++;
+    }
+    else if (llabs(offset_us) >= SIM800L_NTP_RESOLUTION_US)
+    {
+        /* Timestamps stay monotonic */
+        struct timeval delta = {
+            .tv_sec = (time_t)(offset_us / 1000000),
+            .tv_usec = (suseconds_t)(offset_us % 1000000)};
+        adjtime(&delta, NULL);
+        sim800l_ntp_stats.slews++;
+    }
+}
+
+/*
+ *     Event handlers development
+ */
+static void sim800l_ntp_bearer_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_bearer_event_t *event = (sim800l_bearer_event_t *)((sim800l_event_data_t *)event_data)->ptr;
+
+    /* The sync itself runs in the NTP task, never in the event loop */
+    if ((event != NULL) && (event->state == SIM800L_BEARER_STATE_UP) && (sim800l_ntp_events != NULL))
+    {
+        xEventGroupSetBits(sim800l_ntp_events, SIM800L_NTP_WAKE_BIT);
+    }
+}
+
+/*
+ *     Callbacks development
+ */
+sim800l_event_t sim800l_event_ntp(char **input_args, void *output_data)
+{
+    ESP_LOGD(SIM800L_NTP_TAG, "%s", __func__);
+
+    /* +CNTP: <code> */
+    sim800l_time_event_t *event = (sim800l_time_event_t *)output_data;
+    event->source = SIM800L_TIME_SOURCE_NTP;
+    event->result = (input_args[0] != NULL) ? strtoul(input_args[0], NULL, 10) : 0;
+
+    sim800l_ntp_result = event->result;
+    if (sim800l_ntp_events != NULL)
+    {
+        xEventGroupSetBits(sim800l_ntp_events, SIM800L_NTP_DONE_BIT);
+    }
+
+    return SIM800L_EVENT_TIME;
+}
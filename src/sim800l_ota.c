@@ -0,0 +1,437 @@
+/*
+ * @file sim800l_ota.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L OTA functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_http.h"
+#include "sim800l_ota.h"
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_OTA_BUFFER_SIZE         4096
+#define SIM800L_OTA_NUM_BUFFERS         2
+
+#define SIM800L_OTA_TASK_STACK_SIZE     4096
+#define SIM800L_OTA_TASK_PRIORITY       2
+#define SIM800L_OTA_TASK_NAME           "sim800l_ota_task"
+
+/*
+ *     Tag
+ */
+#define SIM800L_OTA_TAG "SIM800L OTA"
+
+/*
+ *     OTA buffer
+ */
+typedef struct
+{
+    uint8_t *data;
+    size_t data_len;
+} sim800l_ota_buffer_t;
+
+/*
+ *     OTA context
+ */
+typedef struct
+{
+    const sim800l_ota_config_t *config;
+    esp_ota_handle_t ota_handle;
+    mbedtls_sha256_context sha256;
+    sim800l_ota_buffer_t buffers[SIM800L_OTA_NUM_BUFFERS];
+    sim800l_ota_buffer_t *fill;          /* Buffer being filled from the UART */
+    size_t buffer_size;
+    QueueHandle_t free_queue;
+    QueueHandle_t full_queue;
+    SemaphoreHandle_t done;
+    esp_err_t write_ret;
+    volatile uint32_t total;             /* Image length, 0 until the server reports it */
+    sim800l_ota_stats_t stats;
+} sim800l_ota_ctx_t;
+
+/*
+ *     Private functions
+ */
+static sim800l_ret_t sim800l_ota_run(sim800l_handle_t sim800l_handle, sim800l_ota_ctx_t *ctx);
+static void sim800l_ota_write(sim800l_ota_ctx_t *ctx, sim800l_ota_buffer_t *buffer);
+static sim800l_ret_t sim800l_ota_submit(sim800l_ota_ctx_t *ctx);
+static sim800l_ret_t sim800l_ota_data(const uint8_t *data, size_t data_len, uint32_t offset, void *arg);
+static void sim800l_ota_progress(const sim800l_http_download_checkpoint_t *checkpoint, void *arg);
+
+/*
+ *     SIM800L task
+ */
+static void sim800l_ota_task(void *args);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_ota_update(sim800l_handle_t sim800l_handle, const sim800l_ota_config_t *config, sim800l_ota_stats_t *stats)
+{
+    ESP_LOGD(SIM800L_OTA_TAG, "%s", __func__);
+
+    /* Check args */
+    if ((sim800l_handle == NULL) || (config == NULL) || (config->url == NULL))
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Create context */
+    sim800l_ota_ctx_t *ctx = calloc(1, sizeof(sim800l_ota_ctx_t));
+    if (ctx == NULL)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    ctx->config = config;
+    ctx->buffer_size = (config->buffer_size != 0) ? config->buffer_size : SIM800L_OTA_BUFFER_SIZE;
+    ctx->write_ret = ESP_OK;
+
+    /* Run update */
+    sim800l_ret_t ret = sim800l_ota_run(sim800l_handle, ctx);
+
+    if (stats != NULL)
+    {
+        memcpy(stats, &ctx->stats, sizeof(sim800l_ota_stats_t));
+    }
+
+    /* Free context */
+    if (ctx->free_queue != NULL)
+    {
+        vQueueDelete(ctx->free_queue);
+    }
+
+    if (ctx->full_queue != NULL)
+    {
+        vQueueDelete(ctx->full_queue);
+    }
+
+    if (ctx->done != NULL)
+    {
+        vSemaphoreDelete(ctx->done);
+    }
+
+    for (uint32_t i = 0; i < SIM800L_OTA_NUM_BUFFERS; i++)
+    {
+        free(ctx->buffers[i].data);
+    }
+
+    free(ctx);
+    ctx = NULL;
+
+    return ret;
+}
+
+/*
+ *     Private functions development
+ */
+static sim800l_ret_t sim800l_ota_run(sim800l_handle_t sim800l_handle, sim800l_ota_ctx_t *ctx)
+{
+    ESP_LOGD(SIM800L_OTA_TAG, "%s", __func__);
+
+    const sim800l_ota_config_t *config = ctx->config;
+
+    /* Get target partition */
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (partition == NULL)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "No OTA partition");
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Allocate buffers */
+    for (uint32_t i = 0; i < SIM800L_OTA_NUM_BUFFERS; i++)
+    {
+        ctx->buffers[i].data = calloc(ctx->buffer_size, sizeof(uint8_t));
+        if (ctx->buffers[i].data == NULL)
+        {
+            ESP_LOGE(SIM800L_OTA_TAG, "Memory allocation failed");
+            return SIM800L_RET_ERROR_MEM;
+        }
+    }
+
+    /* Create queues */
+    ctx->free_queue = xQueueCreate(SIM800L_OTA_NUM_BUFFERS, sizeof(sim800l_ota_buffer_t *));
+    ctx->full_queue = xQueueCreate(SIM800L_OTA_NUM_BUFFERS + 1, sizeof(sim800l_ota_buffer_t *));
+    ctx->done = xSemaphoreCreateBinary();
+    if ((ctx->free_queue == NULL) || (ctx->full_queue == NULL) || (ctx->done == NULL))
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "xQueueCreate failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* First buffer is filled right away, the others wait in the free queue */
+    ctx->fill = &ctx->buffers[0];
+    for (uint32_t i = 1; i < SIM800L_OTA_NUM_BUFFERS; i++)
+    {
+        sim800l_ota_buffer_t *buffer = &ctx->buffers[i];
+        xQueueSend(ctx->free_queue, &buffer, 0);
+    }
+
+    /* Begin OTA, sequential writes erase sector by sector as data arrives */
+    esp_err_t esp_ret = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &ctx->ota_handle);
+    if (esp_ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "esp_ota_begin failed: %s", esp_err_to_name(esp_ret));
+        return SIM800L_RET_ERROR;
+    }
+
+    mbedtls_sha256_init(&ctx->sha256);
+    mbedtls_sha256_starts(&ctx->sha256, 0);
+
+    /* Start flash writer */
+    if (!config->serial)
+    {
+        if (xTaskCreate(sim800l_ota_task, SIM800L_OTA_TASK_NAME, SIM800L_OTA_TASK_STACK_SIZE, ctx, SIM800L_OTA_TASK_PRIORITY, NULL) != pdPASS)
+        {
+            ESP_LOGE(SIM800L_OTA_TAG, "xTaskCreate failed");
+            mbedtls_sha256_free(&ctx->sha256);
+            esp_ota_abort(ctx->ota_handle);
+            return SIM800L_RET_ERROR;
+        }
+    }
+
+    /* Stream the image */
+    sim800l_http_download_config_t download_config = {
+        .url = config->url,
+        .cid = config->cid,
+        .chunk_size = config->chunk_size,
+        .max_retries = config->max_retries,
+        .data_callback = sim800l_ota_data,
+        .progress_callback = sim800l_ota_progress,
+        .arg = ctx,
+    };
+    sim800l_http_download_checkpoint_t checkpoint = {0};
+    sim800l_http_download_stats_t download_stats = {0};
+
+    int64_t start_time = esp_timer_get_time();
+
+    sim800l_ret_t ret = sim800l_http_download(sim800l_handle, &download_config, &checkpoint, &download_stats);
+
+    /* Flush the last partial buffer */
+    if (ret == SIM800L_RET_OK)
+    {
+        ret = sim800l_ota_submit(ctx);
+    }
+
+    /* Stop flash writer with an empty buffer */
+    if (!config->serial)
+    {
+        sim800l_ota_buffer_t *stop = NULL;
+        xQueueSend(ctx->full_queue, &stop, portMAX_DELAY);
+        xSemaphoreTake(ctx->done, portMAX_DELAY);
+    }
+
+    ctx->stats.elapsed_us = (uint64_t)(esp_timer_get_time() - start_time);
+    ctx->stats.retries = download_stats.retries;
+    if (ctx->stats.elapsed_us > 0)
+    {
+        ctx->stats.throughput = (uint32_t)(((uint64_t)ctx->stats.bytes * 1000000) / ctx->stats.elapsed_us);
+    }
+
+    mbedtls_sha256_finish(&ctx->sha256, ctx->stats.sha256);
+    mbedtls_sha256_free(&ctx->sha256);
+
+    if ((ret != SIM800L_RET_OK) || (ctx->write_ret != ESP_OK))
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "OTA failed after %lu bytes", ctx->stats.bytes);
+        esp_ota_abort(ctx->ota_handle);
+        return (ret != SIM800L_RET_OK) ? ret : SIM800L_RET_ERROR;
+    }
+
+    /* Verify image hash */
+    if ((config->expected_sha256 != NULL) && (memcmp(config->expected_sha256, ctx->stats.sha256, sizeof(ctx->stats.sha256)) != 0))
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "SHA-256 mismatch");
+        esp_ota_abort(ctx->ota_handle);
+        return SIM800L_RET_ERROR_CHECKSUM;
+    }
+
+    /* Validate image and switch boot partition */
+    esp_ret = esp_ota_end(ctx->ota_handle);
+    if (esp_ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "esp_ota_end failed: %s", esp_err_to_name(esp_ret));
+        return SIM800L_RET_ERROR;
+    }
+
+    esp_ret = esp_ota_set_boot_partition(partition);
+    if (esp_ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(esp_ret));
+        return SIM800L_RET_ERROR;
+    }
+
+    ESP_LOGI(SIM800L_OTA_TAG, "OTA done: %lu bytes, %lu B/s, flash %llu us, stall %llu us", ctx->stats.bytes, ctx->stats.throughput, ctx->stats.flash_us, ctx->stats.stall_us);
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_ota_write(sim800l_ota_ctx_t *ctx, sim800l_ota_buffer_t *buffer)
+{
+    ESP_LOGD(SIM800L_OTA_TAG, "%s", __func__);
+
+    /* Keep failing once an error was seen */
+    if (ctx->write_ret != ESP_OK)
+    {
+        return;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+
+    ctx->write_ret = esp_ota_write(ctx->ota_handle, buffer->data, buffer->data_len);
+    if (ctx->write_ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "esp_ota_write failed: %s", esp_err_to_name(ctx->write_ret));
+        return;
+    }
+
+    /* Hash incrementally, while the next buffer is still on the wire */
+    mbedtls_sha256_update(&ctx->sha256, buffer->data, buffer->data_len);
+
+    ctx->stats.flash_us += (uint64_t)(esp_timer_get_time() - start_time);
+    ctx->stats.bytes += buffer->data_len;
+
+    /* Report only what is committed to flash */
+    if (ctx->config->progress_callback != NULL)
+    {
+        ctx->config->progress_callback(ctx->stats.bytes, ctx->total, ctx->config->arg);
+    }
+}
+
+static sim800l_ret_t sim800l_ota_submit(sim800l_ota_ctx_t *ctx)
+{
+    ESP_LOGD(SIM800L_OTA_TAG, "%s", __func__);
+
+    if (ctx->fill->data_len == 0)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Serial mode writes inline */
+    if (ctx->config->serial)
+    {
+        sim800l_ota_write(ctx, ctx->fill);
+        ctx->fill->data_len = 0;
+
+        return (ctx->write_ret == ESP_OK) ? SIM800L_RET_OK : SIM800L_RET_ERROR;
+    }
+
+    /* Hand the full buffer to the writer */
+    if (xQueueSend(ctx->full_queue, &ctx->fill, portMAX_DELAY) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "xQueueSend failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Take the other one, waiting only if flash is slower than the radio */
+    int64_t start_time = esp_timer_get_time();
+
+    if (xQueueReceive(ctx->free_queue, &ctx->fill, portMAX_DELAY) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_OTA_TAG, "xQueueReceive failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    ctx->stats.stall_us += (uint64_t)(esp_timer_get_time() - start_time);
+    ctx->fill->data_len = 0;
+
+    return (ctx->write_ret == ESP_OK) ? SIM800L_RET_OK : SIM800L_RET_ERROR;
+}
+
+static sim800l_ret_t sim800l_ota_data(const uint8_t *data, size_t data_len, uint32_t offset, void *arg)
+{
+    ESP_LOGD(SIM800L_OTA_TAG, "%s", __func__);
+
+    sim800l_ota_ctx_t *ctx = (sim800l_ota_ctx_t *)arg;
+
+    while (data_len > 0)
+    {
+        /* Copy into the buffer being filled */
+        size_t copy_len = ctx->buffer_size - ctx->fill->data_len;
+        if (copy_len > data_len)
+        {
+            copy_len = data_len;
+        }
+
+        memcpy(ctx->fill->data + ctx->fill->data_len, data, copy_len);
+        ctx->fill->data_len += copy_len;
+        data += copy_len;
+        data_len -= copy_len;
+
+        /* Swap when full */
+        if (ctx->fill->data_len == ctx->buffer_size)
+        {
+            if (sim800l_ota_submit(ctx) != SIM800L_RET_OK)
+            {
+                return SIM800L_RET_ERROR;
+            }
+        }
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static void sim800l_ota_progress(const sim800l_http_download_checkpoint_t *checkpoint, void *arg)
+{
+    sim800l_ota_ctx_t *ctx = (sim800l_ota_ctx_t *)arg;
+
+    /* Download offset runs ahead of flash, keep only the length */
+    ctx->total = checkpoint->total_length;
+}
+
+/*
+ * SIM800L OTA task
+ *
+ * @brief This task writes filled buffers to flash while the next one is read from the UART.
+ *
+ */
+static void sim800l_ota_task(void *args)
+{
+    ESP_LOGD(SIM800L_OTA_TAG, "%s", __func__);
+
+    sim800l_ota_ctx_t *ctx = (sim800l_ota_ctx_t *)args;
+
+    while (true)
+    {
+        sim800l_ota_buffer_t *buffer = NULL;
+        if (xQueueReceive(ctx->full_queue, &buffer, portMAX_DELAY) != pdPASS)
+        {
+            continue;
+        }
+
+        /* Empty buffer stops the task */
+        if (buffer == NULL)
+        {
+            break;
+        }
+
+        sim800l_ota_write(ctx, buffer);
+
+        /* Give it back to the radio side */
+        buffer->data_len = 0;
+        xQueueSend(ctx->free_queue, &buffer, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
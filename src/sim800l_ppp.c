@@ -0,0 +1,356 @@
+/*
+ * @file sim800l_ppp.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L PPPoS functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_ppp.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <esp_timer.h>
+#include <esp_netif.h>
+#include <esp_netif_ppp.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_PPP_DIAL_TIMEOUT        10000
+#define SIM800L_PPP_HANGUP_TIMEOUT      20000
+#define SIM800L_PPP_TERMINATE_MS        500     /* Time left to lwIP for LCP Terminate */
+
+/*
+ *     Tag
+ */
+#define SIM800L_PPP_TAG "SIM800L PPP"
+
+/*
+ *     URC
+ */
+#define SIM800L_EVENT_PPP_CONNECT_STR       "CONNECT"
+#define SIM800L_EVENT_PPP_NO_CARRIER_STR    "NO CARRIER"      /* Data mode exit line, the URC itself comes through the core */
+
+/*
+ *     esp_netif driver glue
+ */
+typedef struct
+{
+    esp_netif_driver_base_t base;
+    sim800l_handle_t sim800l_handle;
+} sim800l_ppp_glue_t;
+
+static sim800l_ppp_glue_t sim800l_ppp_glue = {0};
+static esp_netif_t *sim800l_ppp_netif = NULL;
+static volatile sim800l_ppp_state_t sim800l_ppp_state = SIM800L_PPP_STATE_IDLE;
+static volatile bool sim800l_ppp_remote_hangup = false;     /* NO CARRIER seen, release pending */
+static int64_t sim800l_ppp_connected = 0;
+static sim800l_ppp_stats_t sim800l_ppp_stats = {0};
+
+/*
+ *     Private functions
+ */
+static esp_err_t sim800l_ppp_post_attach(esp_netif_t *esp_netif, void *args);
+static esp_err_t sim800l_ppp_transmit(void *h, void *buffer, size_t len);
+static void sim800l_ppp_input(const uint8_t *data, size_t data_len, void *arg);
+static void sim800l_ppp_release(sim800l_handle_t sim800l_handle);
+static void sim800l_ppp_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data);
+
+/*
+ *     Callbacks
+ */
+sim800l_event_t sim800l_event_ppp_no_carrier(char **input_args, void *output_data);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_ppp_start(sim800l_handle_t sim800l_handle, const char *apn, esp_netif_t **esp_netif)
+{
+    ESP_LOGD(SIM800L_PPP_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (apn == NULL))
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_ppp_state == SIM800L_PPP_STATE_CONNECTED)
+    {
+        ESP_LOGW(SIM800L_PPP_TAG, "Already connected");
+        return SIM800L_RET_OK;
+    }
+
+    /* Created once, lwIP keeps its PPP control block across sessions */
+    if (sim800l_ppp_netif == NULL)
+    {
+        esp_netif_config_t netif_config = ESP_NETIF_DEFAULT_PPP();
+
+        sim800l_ppp_netif = esp_netif_new(&netif_config);
+        if (sim800l_ppp_netif == NULL)
+        {
+            ESP_LOGE(SIM800L_PPP_TAG, "esp_netif_new failed");
+            return SIM800L_RET_ERROR_MEM;
+        }
+
+        sim800l_ppp_glue.base.post_attach = sim800l_ppp_post_attach;
+        sim800l_ppp_glue.sim800l_handle = sim800l_handle;
+
+        if (esp_netif_attach(sim800l_ppp_netif, &sim800l_ppp_glue) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_PPP_TAG, "esp_netif_attach failed");
+            esp_netif_destroy(sim800l_ppp_netif);
+            sim800l_ppp_netif = NULL;
+            return SIM800L_RET_ERROR;
+        }
+    }
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_PPP_CONTEXT) + strlen(apn) + 12 * sizeof(char) + strlen("\r\n") + 1; /* cmd=1,"IP","s"\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=1,\"IP\",\"%s\"\r\n", SIM800L_COMMAND_PPP_CONTEXT, apn) < 0)
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    esp_err_t ret = sim800l_out_data_event(sim800l_handle, command, SIM800L_EVENT_OK, 1000);
+
+    free(command);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "AT+CGDCONT failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* Hangup is reported by the modem once it is back in command mode, the core routes NO CARRIER here while the call is up */
+    if (sim800l_set_no_carrier_callback(sim800l_event_ppp_no_carrier) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "sim800l_set_no_carrier_callback failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Released from the event loop, not from the bridge task that reported it */
+    sim800l_ppp_remote_hangup = false;
+    if (sim800l_register_event(sim800l_handle, SIM800L_EVENT_PPP, sim800l_ppp_event_handler, NULL) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "sim800l_register_event failed");
+        sim800l_set_no_carrier_callback(NULL);
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Frames go straight from the bridge task to lwIP */
+    if ((sim800l_data_mode_set_sink(sim800l_handle, sim800l_ppp_input, NULL) != ESP_OK) ||
+        (sim800l_data_mode_arm(sim800l_handle, SIM800L_EVENT_PPP_CONNECT_STR, SIM800L_EVENT_PPP_NO_CARRIER_STR, true) != ESP_OK))
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "Data mode setup failed");
+        sim800l_ppp_release(sim800l_handle);
+        return SIM800L_RET_ERROR;
+    }
+
+    memset(&sim800l_ppp_stats, 0, sizeof(sim800l_ppp_stats_t));
+    sim800l_ppp_state = SIM800L_PPP_STATE_DIALING;
+
+    /* Response */
+    char response[32] = {0};
+
+    /* CONNECT, or NO CARRIER/ERROR when the context can not be activated */
+    if ((sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_PPP_DIAL, (uint8_t *)response, sizeof(response), SIM800L_PPP_DIAL_TIMEOUT) != ESP_OK) ||
+        (strnstr(response, SIM800L_EVENT_PPP_CONNECT_STR, sizeof(response)) == NULL))
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "Dial-up failed: %s", response);
+        sim800l_ppp_release(sim800l_handle);
+        sim800l_ppp_state = SIM800L_PPP_STATE_IDLE;
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_ppp_connected = esp_timer_get_time();
+    sim800l_ppp_state = SIM800L_PPP_STATE_CONNECTED;
+
+    /* LCP/IPCP run in lwIP, IP_EVENT_PPP_GOT_IP follows */
+    esp_netif_action_start(sim800l_ppp_netif, 0, 0, NULL);
+    esp_netif_action_connected(sim800l_ppp_netif, 0, 0, NULL);
+
+    if (esp_netif != NULL)
+    {
+        *esp_netif = sim800l_ppp_netif;
+    }
+
+    ESP_LOGI(SIM800L_PPP_TAG, "PPP link up");
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_ppp_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_PPP_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_PPP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_ppp_state == SIM800L_PPP_STATE_IDLE)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    sim800l_ret_t ret = SIM800L_RET_OK;
+
+    if (sim800l_ppp_state == SIM800L_PPP_STATE_CONNECTED)
+    {
+        /* Let lwIP send LCP Terminate while the link is still up */
+        esp_netif_action_disconnected(sim800l_ppp_netif, 0, 0, NULL);
+        esp_netif_action_stop(sim800l_ppp_netif, 0, 0, NULL);
+        vTaskDelay(SIM800L_PPP_TERMINATE_MS / portTICK_PERIOD_MS);
+
+        /* From here on lwIP writes are dropped */
+        sim800l_ppp_state = SIM800L_PPP_STATE_HANGUP;
+
+        /* Back to command mode, then drop the call */
+        if ((sim800l_data_mode_escape(sim800l_handle) != ESP_OK) ||
+            (sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_CALL_HANGUP, SIM800L_EVENT_OK, SIM800L_PPP_HANGUP_TIMEOUT) != ESP_OK))
+        {
+            ESP_LOGE(SIM800L_PPP_TAG, "Hangup failed");
+            ret = SIM800L_RET_ERROR_SEND_COMMAND;
+        }
+    }
+
+    sim800l_ppp_release(sim800l_handle);
+    sim800l_ppp_state = SIM800L_PPP_STATE_IDLE;
+
+    ESP_LOGI(SIM800L_PPP_TAG, "PPP link down");
+
+    return ret;
+}
+
+sim800l_ppp_state_t sim800l_ppp_get_state(void)
+{
+    return sim800l_ppp_state;
+}
+
+sim800l_ret_t sim800l_ppp_get_stats(sim800l_ppp_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_ppp_stats, sizeof(sim800l_ppp_stats_t));
+
+    if (sim800l_ppp_state == SIM800L_PPP_STATE_CONNECTED)
+    {
+        stats->connected_us = esp_timer_get_time() - sim800l_ppp_connected;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static esp_err_t sim800l_ppp_post_attach(esp_netif_t *esp_netif, void *args)
+{
+    sim800l_ppp_glue_t *glue = (sim800l_ppp_glue_t *)args;
+
+    const esp_netif_driver_ifconfig_t driver_ifconfig = {
+        .handle = glue,
+        .transmit = sim800l_ppp_transmit,
+        .driver_free_rx_buffer = NULL};
+
+    glue->base.netif = esp_netif;
+
+    return esp_netif_set_driver_config(esp_netif, &driver_ifconfig);
+}
+
+static esp_err_t sim800l_ppp_transmit(void *h, void *buffer, size_t len)
+{
+    sim800l_ppp_glue_t *glue = (sim800l_ppp_glue_t *)h;
+
+    /* Frames after hangup would be read as AT commands */
+    if (sim800l_ppp_state != SIM800L_PPP_STATE_CONNECTED)
+    {
+        return ESP_OK;
+    }
+
+    if (sim800l_out_data_raw(glue->sim800l_handle, (const uint8_t *)buffer, len) != ESP_OK)
+    {
+        return ESP_FAIL;
+    }
+
+    sim800l_ppp_stats.tx_bytes += len;
+
+    return ESP_OK;
+}
+
+static void sim800l_ppp_input(const uint8_t *data, size_t data_len, void *arg)
+{
+    /* pppos_input copies into pbufs, the UART read buffer is reused right after */
+    if (esp_netif_receive(sim800l_ppp_netif, (void *)data, data_len, NULL) == ESP_OK)
+    {
+        sim800l_ppp_stats.rx_bytes += data_len;
+    }
+}
+
+static void sim800l_ppp_release(sim800l_handle_t sim800l_handle)
+{
+    sim800l_data_mode_exit(sim800l_handle);
+    sim800l_data_mode_set_sink(sim800l_handle, NULL, NULL);
+    sim800l_set_no_carrier_callback(NULL);
+    sim800l_unregister_event(sim800l_handle, SIM800L_EVENT_PPP, sim800l_ppp_event_handler);
+    sim800l_ppp_remote_hangup = false;
+}
+
+static void sim800l_ppp_event_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    sim800l_handle_t sim800l_handle = ((sim800l_event_data_t *)event_data)->sim800l_handle;
+
+    /* Network side hangup, a later transparent session must not find the lwIP sink */
+    if (!sim800l_ppp_remote_hangup || (sim800l_ppp_state != SIM800L_PPP_STATE_HANGUP))
+    {
+        return;
+    }
+
+    sim800l_ppp_release(sim800l_handle);
+    sim800l_ppp_state = SIM800L_PPP_STATE_IDLE;
+
+    ESP_LOGI(SIM800L_PPP_TAG, "PPP link down (NO CARRIER)");
+}
+
+/*
+ *     Callbacks development
+ */
+sim800l_event_t sim800l_event_ppp_no_carrier(char **input_args, void *output_data)
+{
+    sim800l_ppp_event_t *event = (sim800l_ppp_event_t *)output_data;
+
+    /* Peer or network hung up, the bridge task already left data mode */
+    if (sim800l_ppp_state == SIM800L_PPP_STATE_CONNECTED)
+    {
+        sim800l_ppp_state = SIM800L_PPP_STATE_HANGUP;
+        sim800l_ppp_remote_hangup = true;
+
+        esp_netif_action_disconnected(sim800l_ppp_netif, 0, 0, NULL);
+        esp_netif_action_stop(sim800l_ppp_netif, 0, 0, NULL);
+    }
+
+    event->state = sim800l_ppp_state;
+
+    return SIM800L_EVENT_PPP;
+}
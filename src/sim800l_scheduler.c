@@ -0,0 +1,762 @@
+/*
+ * @file sim800l_scheduler.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L link aware transfer scheduler functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_scheduler.h"
+#include "sim800l_bearer.h"
+#include "sim800l_network.h"
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_SCHEDULER_MIN_RSSI          10      /* -93 dBm */
+#define SIM800L_SCHEDULER_CHECK_INTERVAL_MS 5000
+#define SIM800L_SCHEDULER_MAX_RETRIES       2
+#define SIM800L_SCHEDULER_LEAD_MS           30000
+#define SIM800L_SCHEDULER_RSSI_UNKNOWN      99
+#define SIM800L_SCHEDULER_NO_DEADLINE       INT64_MAX
+
+#define SIM800L_SCHEDULER_BEARER_OPEN_MS    3000
+#define SIM800L_SCHEDULER_ATTEMPT_MS        2000
+#define SIM800L_SCHEDULER_FAIL_RSSI         8
+
+#define SIM800L_SCHEDULER_TASK_STACK_SIZE   4096
+#define SIM800L_SCHEDULER_TASK_PRIORITY     1
+#define SIM800L_SCHEDULER_TASK_NAME         "sim800l_scheduler_task"
+
+/*
+ *     Event bits
+ */
+#define SIM800L_SCHEDULER_WAKE_BIT          BIT0
+#define SIM800L_SCHEDULER_STOPPED_BIT       BIT1
+
+/*
+ *     Tag
+ */
+#define SIM800L_SCHEDULER_TAG "SIM800L SCHEDULER"
+
+/*
+ *     Queue entry, deadline is absolute in ms
+ */
+typedef struct
+{
+    sim800l_scheduler_job_t job;
+    int64_t deadline;
+    bool used;
+} sim800l_scheduler_entry_t;
+
+/*
+ *     Policy engine, shared by the task and the replay, only the clock, link and bearer differ
+ */
+typedef struct sim800l_scheduler_engine
+{
+    sim800l_scheduler_entry_t *entries;
+    sim800l_scheduler_config_t config;
+    sim800l_scheduler_stats_t *stats;
+    bool gated;                         /* false runs every job as soon as it is queued */
+    SemaphoreHandle_t mutex;            /* NULL in the replay */
+    void *ctx;
+    int64_t (*now)(struct sim800l_scheduler_engine *engine);
+    bool (*link)(struct sim800l_scheduler_engine *engine, uint8_t *rssi);
+    bool (*open)(struct sim800l_scheduler_engine *engine);
+    void (*close)(struct sim800l_scheduler_engine *engine);
+    bool (*attempt)(struct sim800l_scheduler_engine *engine, sim800l_scheduler_entry_t *entry);
+} sim800l_scheduler_engine_t;
+
+/*
+ *     Replay state
+ */
+typedef struct
+{
+    const sim800l_scheduler_model_t *model;
+    const sim800l_scheduler_trace_t *trace;
+    size_t trace_len;
+    int64_t clock;
+} sim800l_scheduler_replay_t;
+
+/*
+ *     Scheduler
+ */
+static sim800l_handle_t sim800l_scheduler_handle = NULL;
+static SemaphoreHandle_t sim800l_scheduler_mutex = NULL;
+static EventGroupHandle_t sim800l_scheduler_events = NULL;
+static volatile bool sim800l_scheduler_running = false;
+static volatile bool sim800l_scheduler_force = false;
+static bool sim800l_scheduler_owned = false;      /* Bearer opened by this session, closed after it */
+static sim800l_scheduler_entry_t sim800l_scheduler_entries[SIM800L_SCHEDULER_MAX_JOBS] = {0};
+static sim800l_scheduler_stats_t sim800l_scheduler_stats = {0};
+static sim800l_scheduler_engine_t sim800l_scheduler_engine = {0};
+
+/*
+ *     Private functions
+ */
+static void sim800l_scheduler_task(void *args);
+static void sim800l_scheduler_defaults(sim800l_scheduler_config_t *config, const sim800l_scheduler_config_t *input);
+static void sim800l_scheduler_lock(sim800l_scheduler_engine_t *engine);
+static void sim800l_scheduler_unlock(sim800l_scheduler_engine_t *engine);
+static bool sim800l_scheduler_enqueue(sim800l_scheduler_engine_t *engine, const sim800l_scheduler_job_t *job, int64_t now);
+static void sim800l_scheduler_expire(sim800l_scheduler_engine_t *engine, int64_t now);
+static bool sim800l_scheduler_due(sim800l_scheduler_engine_t *engine, int64_t now, bool force, bool *forced);
+static int32_t sim800l_scheduler_pick(sim800l_scheduler_engine_t *engine, uint32_t tried);
+static void sim800l_scheduler_session(sim800l_scheduler_engine_t *engine, bool forced);
+static uint32_t sim800l_scheduler_pending(sim800l_scheduler_engine_t *engine);
+
+static int64_t sim800l_scheduler_modem_now(sim800l_scheduler_engine_t *engine);
+static bool sim800l_scheduler_modem_link(sim800l_scheduler_engine_t *engine, uint8_t *rssi);
+static bool sim800l_scheduler_modem_open(sim800l_scheduler_engine_t *engine);
+static void sim800l_scheduler_modem_close(sim800l_scheduler_engine_t *engine);
+static bool sim800l_scheduler_modem_attempt(sim800l_scheduler_engine_t *engine, sim800l_scheduler_entry_t *entry);
+
+static void sim800l_scheduler_replay_run(sim800l_scheduler_engine_t *engine, const sim800l_scheduler_replay_job_t *jobs, size_t jobs_len);
+static const sim800l_scheduler_trace_t *sim800l_scheduler_replay_sample(sim800l_scheduler_replay_t *replay);
+static int64_t sim800l_scheduler_replay_now(sim800l_scheduler_engine_t *engine);
+static bool sim800l_scheduler_replay_link(sim800l_scheduler_engine_t *engine, uint8_t *rssi);
+static bool sim800l_scheduler_replay_open(sim800l_scheduler_engine_t *engine);
+static void sim800l_scheduler_replay_close(sim800l_scheduler_engine_t *engine);
+static bool sim800l_scheduler_replay_attempt(sim800l_scheduler_engine_t *engine, sim800l_scheduler_entry_t *entry);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_scheduler_start(sim800l_handle_t sim800l_handle, const sim800l_scheduler_config_t *config)
+{
+    ESP_LOGD(SIM800L_SCHEDULER_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_scheduler_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    if (sim800l_scheduler_mutex == NULL)
+    {
+        sim800l_scheduler_mutex = xSemaphoreCreateMutex();
+        sim800l_scheduler_events = xEventGroupCreate();
+        if ((sim800l_scheduler_mutex == NULL) || (sim800l_scheduler_events == NULL))
+        {
+            ESP_LOGE(SIM800L_SCHEDULER_TAG, "Memory allocation failed");
+            return SIM800L_RET_ERROR_MEM;
+        }
+    }
+
+    sim800l_scheduler_engine_t *engine = &sim800l_scheduler_engine;
+    sim800l_scheduler_defaults(&engine->config, config);
+    if ((engine->config.cid < 1) || (engine->config.cid > SIM800L_BEARER_MAX_PROFILES))
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "Invalid CID %lu", engine->config.cid);
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Link quality comes from the network monitor, already running is fine */
+    if (sim800l_network_monitor_start(sim800l_handle, NULL) != SIM800L_RET_OK)
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "sim800l_network_monitor_start failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    memset(sim800l_scheduler_entries, 0, sizeof(sim800l_scheduler_entries));
+    memset(&sim800l_scheduler_stats, 0, sizeof(sim800l_scheduler_stats_t));
+
+    engine->entries = sim800l_scheduler_entries;
+    engine->stats = &sim800l_scheduler_stats;
+    engine->gated = true;
+    engine->mutex = sim800l_scheduler_mutex;
+    engine->ctx = NULL;
+    engine->now = sim800l_scheduler_modem_now;
+    engine->link = sim800l_scheduler_modem_link;
+    engine->open = sim800l_scheduler_modem_open;
+    engine->close = sim800l_scheduler_modem_close;
+    engine->attempt = sim800l_scheduler_modem_attempt;
+
+    xEventGroupClearBits(sim800l_scheduler_events, SIM800L_SCHEDULER_WAKE_BIT | SIM800L_SCHEDULER_STOPPED_BIT);
+
+    sim800l_scheduler_handle = sim800l_handle;
+    sim800l_scheduler_force = false;
+    sim800l_scheduler_running = true;
+    if (xTaskCreate(sim800l_scheduler_task, SIM800L_SCHEDULER_TASK_NAME, SIM800L_SCHEDULER_TASK_STACK_SIZE, NULL, SIM800L_SCHEDULER_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "xTaskCreate failed");
+        sim800l_scheduler_running = false;
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_scheduler_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_SCHEDULER_TAG, "%s", __func__);
+
+    if (!sim800l_scheduler_running)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Queued jobs are kept, a later start does not run them, call sim800l_scheduler_flush first */
+    sim800l_scheduler_running = false;
+    xEventGroupSetBits(sim800l_scheduler_events, SIM800L_SCHEDULER_WAKE_BIT);
+
+    if (!(xEventGroupWaitBits(sim800l_scheduler_events, SIM800L_SCHEDULER_STOPPED_BIT, pdTRUE, pdTRUE, portMAX_DELAY) & SIM800L_SCHEDULER_STOPPED_BIT))
+    {
+        ESP_LOGW(SIM800L_SCHEDULER_TAG, "Scheduler task did not stop");
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_scheduler_submit(const sim800l_scheduler_job_t *job)
+{
+    ESP_LOGD(SIM800L_SCHEDULER_TAG, "%s", __func__);
+
+    if ((job == NULL) || (job->run == NULL))
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_scheduler_running)
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "Scheduler not started");
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_scheduler_engine_t *engine = &sim800l_scheduler_engine;
+    if (!sim800l_scheduler_enqueue(engine, job, engine->now(engine)))
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "Queue full");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* The task decides, a good link runs it right away */
+    xEventGroupSetBits(sim800l_scheduler_events, SIM800L_SCHEDULER_WAKE_BIT);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_scheduler_flush(void)
+{
+    ESP_LOGD(SIM800L_SCHEDULER_TAG, "%s", __func__);
+
+    if (!sim800l_scheduler_running)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Next check opens a session whatever the link looks like */
+    sim800l_scheduler_force = true;
+    xEventGroupSetBits(sim800l_scheduler_events, SIM800L_SCHEDULER_WAKE_BIT);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_scheduler_get_stats(sim800l_scheduler_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_scheduler_engine_t *engine = &sim800l_scheduler_engine;
+
+    sim800l_scheduler_lock(engine);
+    memcpy(stats, &sim800l_scheduler_stats, sizeof(sim800l_scheduler_stats_t));
+    sim800l_scheduler_unlock(engine);
+
+    if (engine->entries != NULL)
+    {
+        stats->pending = sim800l_scheduler_pending(engine);
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_scheduler_replay(const sim800l_scheduler_config_t *config, const sim800l_scheduler_model_t *model,
+                                       const sim800l_scheduler_trace_t *trace, size_t trace_len,
+                                       const sim800l_scheduler_replay_job_t *jobs, size_t jobs_len,
+                                       sim800l_scheduler_stats_t *scheduled, sim800l_scheduler_stats_t *immediate)
+{
+    ESP_LOGD(SIM800L_SCHEDULER_TAG, "%s", __func__);
+
+    if ((trace == NULL) || (trace_len == 0) || ((jobs == NULL) && (jobs_len > 0)) || (scheduled == NULL))
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_scheduler_model_t replay_model = {
+        .bearer_open_ms = ((model != NULL) && (model->bearer_open_ms > 0)) ? model->bearer_open_ms : SIM800L_SCHEDULER_BEARER_OPEN_MS,
+        .attempt_ms = ((model != NULL) && (model->attempt_ms > 0)) ? model->attempt_ms : SIM800L_SCHEDULER_ATTEMPT_MS,
+        .fail_rssi = ((model != NULL) && (model->fail_rssi > 0)) ? model->fail_rssi : SIM800L_SCHEDULER_FAIL_RSSI};
+
+    sim800l_scheduler_entry_t *entries = calloc(SIM800L_SCHEDULER_MAX_JOBS, sizeof(sim800l_scheduler_entry_t));
+    if (entries == NULL)
+    {
+        ESP_LOGE(SIM800L_SCHEDULER_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    sim800l_scheduler_replay_t replay = {
+        .model = &replay_model,
+        .trace = trace,
+        .trace_len = trace_len};
+
+    sim800l_scheduler_engine_t engine = {
+        .entries = entries,
+        .mutex = NULL,
+        .ctx = &replay,
+        .now = sim800l_scheduler_replay_now,
+        .link = sim800l_scheduler_replay_link,
+        .open = sim800l_scheduler_replay_open,
+        .close = sim800l_scheduler_replay_close,
+        .attempt = sim800l_scheduler_replay_attempt};
+
+    sim800l_scheduler_defaults(&engine.config, config);
+
+    /* Policy under test */
+    engine.gated = true;
+    engine.stats = scheduled;
+    sim800l_scheduler_replay_run(&engine, jobs, jobs_len);
+
+    /* Baseline, every job goes out as soon as it is submitted */
+    if (immediate != NULL)
+    {
+        memset(entries, 0, SIM800L_SCHEDULER_MAX_JOBS * sizeof(sim800l_scheduler_entry_t));
+        engine.gated = false;
+        engine.stats = immediate;
+        sim800l_scheduler_replay_run(&engine, jobs, jobs_len);
+    }
+
+    free(entries);
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static void sim800l_scheduler_task(void *args)
+{
+    sim800l_scheduler_engine_t *engine = &sim800l_scheduler_engine;
+
+    while (sim800l_scheduler_running)
+    {
+        bool forced = false;
+        int64_t now = engine->now(engine);
+
+        sim800l_scheduler_expire(engine, now);
+
+        bool force = sim800l_scheduler_force;
+        if (sim800l_scheduler_due(engine, now, force, &forced))
+        {
+            sim800l_scheduler_session(engine, forced);
+        }
+
+        if (force)
+        {
+            sim800l_scheduler_force = false;
+        }
+
+        /* Submit, flush and stop cut the wait short */
+        xEventGroupWaitBits(sim800l_scheduler_events, SIM800L_SCHEDULER_WAKE_BIT, pdTRUE, pdTRUE, engine->config.check_interval_ms / portTICK_PERIOD_MS);
+    }
+
+    xEventGroupSetBits(sim800l_scheduler_events, SIM800L_SCHEDULER_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+static void sim800l_scheduler_defaults(sim800l_scheduler_config_t *config, const sim800l_scheduler_config_t *input)
+{
+    config->cid = ((input != NULL) && (input->cid > 0)) ? input->cid : SIM800L_BEARER_CID_DEFAULT;
+    config->min_rssi = ((input != NULL) && (input->min_rssi > 0)) ? input->min_rssi : SIM800L_SCHEDULER_MIN_RSSI;
+    config->check_interval_ms = ((input != NULL) && (input->check_interval_ms > 0)) ? input->check_interval_ms : SIM800L_SCHEDULER_CHECK_INTERVAL_MS;
+    config->max_retries = ((input != NULL) && (input->max_retries > 0)) ? input->max_retries : SIM800L_SCHEDULER_MAX_RETRIES;
+    config->lead_ms = ((input != NULL) && (input->lead_ms > 0)) ? input->lead_ms : SIM800L_SCHEDULER_LEAD_MS;
+}
+
+static void sim800l_scheduler_lock(sim800l_scheduler_engine_t *engine)
+{
+    if (engine->mutex != NULL)
+    {
+        xSemaphoreTake(engine->mutex, portMAX_DELAY);
+    }
+}
+
+static void sim800l_scheduler_unlock(sim800l_scheduler_engine_t *engine)
+{
+    if (engine->mutex != NULL)
+    {
+        xSemaphoreGive(engine->mutex);
+    }
+}
+
+static bool sim800l_scheduler_enqueue(sim800l_scheduler_engine_t *engine, const sim800l_scheduler_job_t *job, int64_t now)
+{
+    bool queued = false;
+
+    sim800l_scheduler_lock(engine);
+
+    for (uint32_t i = 0; i < SIM800L_SCHEDULER_MAX_JOBS; i++)
+    {
+        if (!engine->entries[i].used)
+        {
+            engine->entries[i].job = *job;
+            engine->entries[i].deadline = (job->deadline_ms > 0) ? now + job->deadline_ms : SIM800L_SCHEDULER_NO_DEADLINE;
+            engine->entries[i].used = true;
+            queued = true;
+            break;
+        }
+    }
+
+    engine->stats->submitted++;
+    if (!queued)
+    {
+        engine->stats->dropped++;
+    }
+
+    sim800l_scheduler_unlock(engine);
+
+    return queued;
+}
+
+static void sim800l_scheduler_expire(sim800l_scheduler_engine_t *engine, int64_t now)
+{
+    sim800l_scheduler_lock(engine);
+
+    for (uint32_t i = 0; i < SIM800L_SCHEDULER_MAX_JOBS; i++)
+    {
+        if (engine->entries[i].used && (engine->entries[i].deadline < now))
+        {
+            ESP_LOGW(SIM800L_SCHEDULER_TAG, "Job %lu missed its deadline", i);
+            engine->entries[i].used = false;
+            engine->stats->dropped++;
+        }
+    }
+
+    sim800l_scheduler_unlock(engine);
+}
+
+static bool sim800l_scheduler_due(sim800l_scheduler_engine_t *engine, int64_t now, bool force, bool *forced)
+{
+    bool queued = false;
+    bool urgent = false;
+
+    sim800l_scheduler_lock(engine);
+
+    for (uint32_t i = 0; i < SIM800L_SCHEDULER_MAX_JOBS; i++)
+    {
+        if (engine->entries[i].used)
+        {
+            queued = true;
+            if ((engine->entries[i].deadline != SIM800L_SCHEDULER_NO_DEADLINE) && (engine->entries[i].deadline - engine->config.lead_ms <= now))
+            {
+                urgent = true;
+            }
+        }
+    }
+
+    sim800l_scheduler_unlock(engine);
+
+    if (!queued)
+    {
+        return false;
+    }
+
+    if (!engine->gated)
+    {
+        return true;
+    }
+
+    uint8_t rssi = SIM800L_SCHEDULER_RSSI_UNKNOWN;
+    bool registered = engine->link(engine, &rssi);
+    if (registered && (rssi != SIM800L_SCHEDULER_RSSI_UNKNOWN) && (rssi >= engine->config.min_rssi))
+    {
+        return true;
+    }
+
+    /* Bad link, only a deadline or a flush pays for the retries */
+    *forced = urgent || force;
+
+    return *forced;
+}
+
+static int32_t sim800l_scheduler_pick(sim800l_scheduler_engine_t *engine, uint32_t tried)
+{
+    int32_t best = -1;
+
+    sim800l_scheduler_lock(engine);
+
+    /* Highest priority, then earliest deadline */
+    for (uint32_t i = 0; i < SIM800L_SCHEDULER_MAX_JOBS; i++)
+    {
+        sim800l_scheduler_entry_t *entry = &engine->entries[i];
+        if ((!entry->used) || (tried & (1UL << i)))
+        {
+            continue;
+        }
+
+        if ((best < 0) ||
+            (entry->job.priority > engine->entries[best].job.priority) ||
+            ((entry->job.priority == engine->entries[best].job.priority) && (entry->deadline < engine->entries[best].deadline)))
+        {
+            best = i;
+        }
+    }
+
+    sim800l_scheduler_unlock(engine);
+
+    return best;
+}
+
+static void sim800l_scheduler_session(sim800l_scheduler_engine_t *engine, bool forced)
+{
+    int64_t opened = engine->now(engine);
+    uint32_t tried = 0;
+
+    engine->stats->sessions++;
+    if (forced)
+    {
+        engine->stats->forced++;
+    }
+
+    if (engine->open(engine))
+    {
+        /* Back to back, one bearer for the whole queue */
+        int32_t index = -1;
+        while ((index = sim800l_scheduler_pick(engine, tried)) >= 0)
+        {
+            sim800l_scheduler_entry_t *entry = &engine->entries[index];
+            bool done = false;
+
+            tried |= (1UL << index);
+            for (uint32_t attempt = 0; (attempt <= engine->config.max_retries) && (!done); attempt++)
+            {
+                if (attempt > 0)
+                {
+                    engine->stats->retries++;
+                }
+
+                done = engine->attempt(engine, entry);
+            }
+
+            if (!done)
+            {
+                /* The link went bad, the rest waits for the next session */
+                ESP_LOGW(SIM800L_SCHEDULER_TAG, "Job %ld failed, ending session", index);
+                break;
+            }
+
+            sim800l_scheduler_lock(engine);
+            entry->used = false;
+            engine->stats->completed++;
+            sim800l_scheduler_unlock(engine);
+        }
+
+        engine->close(engine);
+    }
+    else
+    {
+        ESP_LOGW(SIM800L_SCHEDULER_TAG, "Bearer open failed");
+    }
+
+    engine->stats->bearer_up_us += (uint64_t)(engine->now(engine) - opened) * 1000;
+}
+
+static uint32_t sim800l_scheduler_pending(sim800l_scheduler_engine_t *engine)
+{
+    uint32_t pending = 0;
+
+    sim800l_scheduler_lock(engine);
+
+    for (uint32_t i = 0; i < SIM800L_SCHEDULER_MAX_JOBS; i++)
+    {
+        pending += engine->entries[i].used ? 1 : 0;
+    }
+
+    sim800l_scheduler_unlock(engine);
+
+    return pending;
+}
+
+static int64_t sim800l_scheduler_modem_now(sim800l_scheduler_engine_t *engine)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static bool sim800l_scheduler_modem_link(sim800l_scheduler_engine_t *engine, uint8_t *rssi)
+{
+    sim800l_network_signal_t signal = {0};
+
+    if (sim800l_network_get_signal(&signal) == SIM800L_RET_OK)
+    {
+        *rssi = signal.current.rssi;
+    }
+
+    return sim800l_network_is_registered();
+}
+
+static bool sim800l_scheduler_modem_open(sim800l_scheduler_engine_t *engine)
+{
+    sim800l_bearer_t bearer = {0};
+
+    /* Already up, someone else owns it and it stays up */
+    sim800l_scheduler_owned = false;
+    if ((sim800l_bearer_profile_query(sim800l_scheduler_handle, engine->config.cid, &bearer) == SIM800L_RET_OK) && (bearer.status == 1))
+    {
+        return true;
+    }
+
+    if (sim800l_bearer_profile_switch(sim800l_scheduler_handle, engine->config.cid, true) != SIM800L_RET_OK)
+    {
+        return false;
+    }
+
+    sim800l_scheduler_owned = true;
+
+    return true;
+}
+
+static void sim800l_scheduler_modem_close(sim800l_scheduler_engine_t *engine)
+{
+    /* Radio back to idle as soon as the queue is done */
+    if (sim800l_scheduler_owned)
+    {
+        sim800l_bearer_profile_switch(sim800l_scheduler_handle, engine->config.cid, false);
+        sim800l_scheduler_owned = false;
+    }
+}
+
+static bool sim800l_scheduler_modem_attempt(sim800l_scheduler_engine_t *engine, sim800l_scheduler_entry_t *entry)
+{
+    return entry->job.run(sim800l_scheduler_handle, entry->job.arg) == SIM800L_RET_OK;
+}
+
+static void sim800l_scheduler_replay_run(sim800l_scheduler_engine_t *engine, const sim800l_scheduler_replay_job_t *jobs, size_t jobs_len)
+{
+    sim800l_scheduler_replay_t *replay = (sim800l_scheduler_replay_t *)engine->ctx;
+    sim800l_scheduler_job_t job = {0};
+    size_t next = 0;
+
+    memset(engine->stats, 0, sizeof(sim800l_scheduler_stats_t));
+
+    /* Until the trace ends and every deadline has passed */
+    int64_t end = replay->trace[replay->trace_len - 1].time_ms;
+    for (size_t i = 0; i < jobs_len; i++)
+    {
+        if ((jobs[i].deadline_ms > 0) && ((int64_t)jobs[i].submit_ms + jobs[i].deadline_ms > end))
+        {
+            end = (int64_t)jobs[i].submit_ms + jobs[i].deadline_ms;
+        }
+    }
+
+    replay->clock = replay->trace[0].time_ms;
+    while (replay->clock <= end)
+    {
+        bool forced = false;
+
+        while ((next < jobs_len) && (jobs[next].submit_ms <= replay->clock))
+        {
+            job.priority = jobs[next].priority;
+            job.deadline_ms = jobs[next].deadline_ms;
+            sim800l_scheduler_enqueue(engine, &job, jobs[next].submit_ms);
+            next++;
+        }
+
+        sim800l_scheduler_expire(engine, replay->clock);
+
+        if (sim800l_scheduler_due(engine, replay->clock, false, &forced))
+        {
+            sim800l_scheduler_session(engine, forced);
+        }
+
+        /* Same wake up as the task, the next check or the next submit */
+        int64_t wake = replay->clock + engine->config.check_interval_ms;
+        if ((next < jobs_len) && (jobs[next].submit_ms > replay->clock) && (jobs[next].submit_ms < wake))
+        {
+            wake = jobs[next].submit_ms;
+        }
+
+        replay->clock = wake;
+    }
+
+    engine->stats->pending = sim800l_scheduler_pending(engine);
+}
+
+static const sim800l_scheduler_trace_t *sim800l_scheduler_replay_sample(sim800l_scheduler_replay_t *replay)
+{
+    /* Last sample at or before the clock, the first one before the trace starts */
+    size_t low = 0;
+    size_t high = replay->trace_len;
+
+    while (high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (replay->trace[middle].time_ms <= replay->clock)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return &replay->trace[low];
+}
+
+static int64_t sim800l_scheduler_replay_now(sim800l_scheduler_engine_t *engine)
+{
+    return ((sim800l_scheduler_replay_t *)engine->ctx)->clock;
+}
+
+static bool sim800l_scheduler_replay_link(sim800l_scheduler_engine_t *engine, uint8_t *rssi)
+{
+    const sim800l_scheduler_trace_t *sample = sim800l_scheduler_replay_sample((sim800l_scheduler_replay_t *)engine->ctx);
+
+    *rssi = sample->rssi;
+
+    return sample->registered;
+}
+
+static bool sim800l_scheduler_replay_open(sim800l_scheduler_engine_t *engine)
+{
+    sim800l_scheduler_replay_t *replay = (sim800l_scheduler_replay_t *)engine->ctx;
+    const sim800l_scheduler_trace_t *sample = sim800l_scheduler_replay_sample(replay);
+
+    replay->clock += replay->model->bearer_open_ms;
+
+    return sample->registered;
+}
+
+static void sim800l_scheduler_replay_close(sim800l_scheduler_engine_t *engine)
+{
+}
+
+static bool sim800l_scheduler_replay_attempt(sim800l_scheduler_engine_t *engine, sim800l_scheduler_entry_t *entry)
+{
+    sim800l_scheduler_replay_t *replay = (sim800l_scheduler_replay_t *)engine->ctx;
+    const sim800l_scheduler_trace_t *sample = sim800l_scheduler_replay_sample(replay);
+
+    replay->clock += replay->model->attempt_ms;
+
+    return sample->registered && (sample->rssi != SIM800L_SCHEDULER_RSSI_UNKNOWN) && (sample->rssi >= replay->model->fail_rssi);
+}
@@ -0,0 +1,275 @@
+/*
+ * @file sim800l_shadow.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L settings shadow functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_shadow.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <stdlib.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_SHADOW_ENTRIES          40      /* 3 bearer profiles, HTTPPARA and the single settings */
+
+/*
+ *     Tag
+ */
+#define SIM800L_SHADOW_TAG "SIM800L SHADOW"
+
+/*
+ *     Shadow table
+ */
+typedef struct
+{
+    char key[SIM800L_SHADOW_KEY_SIZE];  /* Empty for a free entry */
+    char *value;
+} sim800l_shadow_entry_t;
+
+static sim800l_shadow_entry_t sim800l_shadow_table[SIM800L_SHADOW_ENTRIES] = {0};
+static SemaphoreHandle_t sim800l_shadow_mutex = NULL;
+static bool sim800l_shadow_enabled = true;
+static sim800l_shadow_stats_t sim800l_shadow_stats = {0};
+
+/*
+ *     Private functions
+ */
+static sim800l_shadow_entry_t *sim800l_shadow_find(const char *key);
+static void sim800l_shadow_release(sim800l_shadow_entry_t *entry);
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_shadow_init(void)
+{
+    ESP_LOGD(SIM800L_SHADOW_TAG, "%s", __func__);
+
+    if (sim800l_shadow_mutex != NULL)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Set calls come from application tasks, invalidation from the bridge task */
+    sim800l_shadow_mutex = xSemaphoreCreateMutex();
+    if (sim800l_shadow_mutex == NULL)
+    {
+        ESP_LOGE(SIM800L_SHADOW_TAG, "xSemaphoreCreateMutex failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_shadow_switch(bool enable)
+{
+    ESP_LOGD(SIM800L_SHADOW_TAG, "%s", __func__);
+
+    /* Disabled, every setting goes to the modem, useful to measure the savings */
+    sim800l_shadow_invalidate(NULL);
+    sim800l_shadow_enabled = enable;
+
+    return SIM800L_RET_OK;
+}
+
+bool sim800l_shadow_unchanged(const char *key, const char *value)
+{
+    if ((key == NULL) || (value == NULL) || !sim800l_shadow_enabled || (sim800l_shadow_mutex == NULL))
+    {
+        return false;
+    }
+
+    xSemaphoreTake(sim800l_shadow_mutex, portMAX_DELAY);
+
+    sim800l_shadow_entry_t *entry = sim800l_shadow_find(key);
+    bool unchanged = (entry != NULL) && (strcmp(entry->value, value) == 0);
+    if (unchanged)
+    {
+        sim800l_shadow_stats.sets_skipped++;
+    }
+
+    xSemaphoreGive(sim800l_shadow_mutex);
+
+    return unchanged;
+}
+
+void sim800l_shadow_store(const char *key, const char *value)
+{
+    if ((key == NULL) || (value == NULL) || !sim800l_shadow_enabled || (sim800l_shadow_mutex == NULL) || (strlen(key) >= SIM800L_SHADOW_KEY_SIZE))
+    {
+        return;
+    }
+
+    xSemaphoreTake(sim800l_shadow_mutex, portMAX_DELAY);
+
+    sim800l_shadow_entry_t *entry = sim800l_shadow_find(key);
+
+    /* Too long to keep, the old value is stale either way */
+    if (strlen(value) >= SIM800L_SHADOW_VALUE_MAX)
+    {
+        sim800l_shadow_release(entry);
+        xSemaphoreGive(sim800l_shadow_mutex);
+        return;
+    }
+
+    if (entry == NULL)
+    {
+        for (uint32_t i = 0; i < SIM800L_SHADOW_ENTRIES; i++)
+        {
+            if (sim800l_shadow_table[i].key[0] == '\0')
+            {
+                entry = &sim800l_shadow_table[i];
+                snprintf(entry->key, sizeof(entry->key), "%s", key);
+                sim800l_shadow_stats.entries++;
+                break;
+            }
+        }
+    }
+
+    if (entry == NULL)
+    {
+        ESP_LOGW(SIM800L_SHADOW_TAG, "Table full, %s not kept", key);
+        xSemaphoreGive(sim800l_shadow_mutex);
+        return;
+    }
+
+    char *copy = strdup(value);
+    if (copy == NULL)
+    {
+        sim800l_shadow_release(entry);
+    }
+    else
+    {
+        free(entry->value);
+        entry->value = copy;
+    }
+
+    xSemaphoreGive(sim800l_shadow_mutex);
+}
+
+bool sim800l_shadow_lookup(const char *key, char *value, size_t value_size)
+{
+    if ((key == NULL) || !sim800l_shadow_enabled || (sim800l_shadow_mutex == NULL))
+    {
+        return false;
+    }
+
+    xSemaphoreTake(sim800l_shadow_mutex, portMAX_DELAY);
+
+    /* value NULL only checks that the key is known */
+    sim800l_shadow_entry_t *entry = sim800l_shadow_find(key);
+    if ((entry != NULL) && (value != NULL) && (value_size > 0))
+    {
+        snprintf(value, value_size, "%s", entry->value);
+    }
+
+    xSemaphoreGive(sim800l_shadow_mutex);
+
+    return (entry != NULL);
+}
+
+void sim800l_shadow_count_served(void)
+{
+    if (sim800l_shadow_mutex == NULL)
+    {
+        return;
+    }
+
+    /* Reset by the bridge task on RDY */
+    xSemaphoreTake(sim800l_shadow_mutex, portMAX_DELAY);
+    sim800l_shadow_stats.queries_served++;
+    xSemaphoreGive(sim800l_shadow_mutex);
+}
+
+void sim800l_shadow_invalidate(const char *prefix)
+{
+    ESP_LOGD(SIM800L_SHADOW_TAG, "%s", __func__);
+
+    if (sim800l_shadow_mutex == NULL)
+    {
+        return;
+    }
+
+    xSemaphoreTake(sim800l_shadow_mutex, portMAX_DELAY);
+
+    for (uint32_t i = 0; i < SIM800L_SHADOW_ENTRIES; i++)
+    {
+        sim800l_shadow_entry_t *entry = &sim800l_shadow_table[i];
+        if ((entry->key[0] != '\0') && ((prefix == NULL) || (strncmp(entry->key, prefix, strlen(prefix)) == 0)))
+        {
+            sim800l_shadow_release(entry);
+        }
+    }
+
+    /* Modem reset, report what this boot saved and count the next one from zero */
+    if (prefix == NULL)
+    {
+        sim800l_shadow_stats.previous_saved = sim800l_shadow_stats.sets_skipped + sim800l_shadow_stats.queries_served;
+        sim800l_shadow_stats.sets_skipped = 0;
+        sim800l_shadow_stats.queries_served = 0;
+        sim800l_shadow_stats.invalidations++;
+        ESP_LOGI(SIM800L_SHADOW_TAG, "Cleared, %lu round trips saved this boot", sim800l_shadow_stats.previous_saved);
+    }
+
+    xSemaphoreGive(sim800l_shadow_mutex);
+}
+
+sim800l_ret_t sim800l_shadow_get_stats(sim800l_shadow_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_shadow_mutex == NULL)
+    {
+        memset(stats, 0, sizeof(sim800l_shadow_stats_t));
+        return SIM800L_RET_OK;
+    }
+
+    /* One snapshot, the counters move together on a reset */
+    xSemaphoreTake(sim800l_shadow_mutex, portMAX_DELAY);
+    memcpy(stats, &sim800l_shadow_stats, sizeof(sim800l_shadow_stats_t));
+    xSemaphoreGive(sim800l_shadow_mutex);
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static sim800l_shadow_entry_t *sim800l_shadow_find(const char *key)
+{
+    for (uint32_t i = 0; i < SIM800L_SHADOW_ENTRIES; i++)
+    {
+        if ((sim800l_shadow_table[i].key[0] != '\0') && (strcmp(sim800l_shadow_table[i].key, key) == 0))
+        {
+            return &sim800l_shadow_table[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void sim800l_shadow_release(sim800l_shadow_entry_t *entry)
+{
+    if (entry == NULL)
+    {
+        return;
+    }
+
+    free(entry->value);
+    entry->value = NULL;
+    entry->key[0] = '\0';
+    sim800l_shadow_stats.entries--;
+}
@@ -12,6 +12,7 @@
  */
 #include "sim800l_core.h"
 #include "sim800l_sms.h"
+#include "sim800l_shadow.h"
 #include <esp_log.h>
 #include <string.h>
 
@@ -23,6 +24,8 @@
 #define SIM800L_EVENT_SMS_NEW_MASSAGE_STR "+CMTI"
 #define SIM800L_EVENT_SMS_SEND_STR "+CMGS"
 
+#define SIM800L_SMS_SHADOW_MODE "CMGF"
+
 sim800l_event_t sim800l_event_sms_new_message(char **input_args, void *output_data);
 sim800l_event_t sim800l_event_sms_send(char **input_args, void *output_data);
 
@@ -74,7 +77,15 @@ sim800l_ret_t sim800l_sms_set_mode(sim800l_handle_t sim800l_handle, sim800l_sms_
     esp_err_t ret = ESP_FAIL;
 
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
+
+    /* Already in this mode, nothing to send */
+    char mode[4] = {0};
+    snprintf(mode, sizeof(mode), "%d", sms_mode);
+    if (sim800l_shadow_unchanged(SIM800L_SMS_SHADOW_MODE, mode))
+    {
+        return SIM800L_RET_OK;
+    }
 
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_SMS_MODE) + sizeof(char) + sizeof(sim800l_sms_mode_t) + strlen("\r\n") + 1;
@@ -97,7 +108,7 @@ sim800l_ret_t sim800l_sms_set_mode(sim800l_handle_t sim800l_handle, sim800l_sms_
     }
 
     /* Send AT command */
-    ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000);
+    ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_SMS_TAG, "sim800l_call_answer failed: %s", esp_err_to_name(ret));
@@ -116,6 +127,9 @@ sim800l_ret_t sim800l_sms_set_mode(sim800l_handle_t sim800l_handle, sim800l_sms_
 
     free(command);
     command = NULL;
+
+    sim800l_shadow_store(SIM800L_SMS_SHADOW_MODE, mode);
+
     return SIM800L_RET_OK;
 }
 
@@ -123,6 +137,14 @@ sim800l_sms_mode_t sim800l_sms_get_mode(sim800l_handle_t sim800l_handle)
 {
     ESP_LOGD(SIM800L_SMS_TAG, "%s", __func__);
 
+    /* Set or read since the last modem reset */
+    char mode[4] = {0};
+    if (sim800l_shadow_lookup(SIM800L_SMS_SHADOW_MODE, mode, sizeof(mode)))
+    {
+        sim800l_shadow_count_served();
+        return (atoi(mode) == SIM800L_SMS_MODE_TEXT) ? SIM800L_SMS_MODE_TEXT : SIM800L_SMS_MODE_PDU;
+    }
+
     /* Get command length */
     uint32_t command_length = strlen(SIM800L_COMMAND_SMS_MODE) + sizeof(char) + strlen("\r\n") + 1;
 
@@ -143,10 +165,10 @@ sim800l_sms_mode_t sim800l_sms_get_mode(sim800l_handle_t sim800l_handle)
     }
 
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Send AT command */
-    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000) != ESP_OK)
+    if (sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
     {
         ESP_LOGE(SIM800L_SMS_TAG, "sim800l_call_answer failed");
         free(command);
@@ -156,11 +178,13 @@ sim800l_sms_mode_t sim800l_sms_get_mode(sim800l_handle_t sim800l_handle)
     if(strncmp(response, "1", strlen("1")) == 0)
     {
         free(command);
+        sim800l_shadow_store(SIM800L_SMS_SHADOW_MODE, "1");
         return SIM800L_SMS_MODE_TEXT;
     }
     else if(strncmp(response, "0", strlen("0")) == 0)
     {
         free(command);
+        sim800l_shadow_store(SIM800L_SMS_SHADOW_MODE, "0");
         return SIM800L_SMS_MODE_PDU;
     }
 
@@ -195,7 +219,7 @@ sim800l_ret_t sim800l_sms_read_message(sim800l_handle_t sim800l_handle, uint32_t
     char response[256] = {0};
 
     /* Send AT command */
-    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 10000);
+    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 10000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_SMS_TAG, "sim800l_out_data failed: %s", esp_err_to_name(ret));
@@ -205,7 +229,7 @@ sim800l_ret_t sim800l_sms_read_message(sim800l_handle_t sim800l_handle, uint32_t
     free(command);
     command = NULL;
 
-    if (strncmp(response, "ERROR", strlen("ERROR")) == 0)
+    if (strnstr(response, "ERROR", sizeof(response)) != NULL)
     {
         ESP_LOGE(SIM800L_SMS_TAG, "sim800l_call_answer failed");
         return SIM800L_RET_ERROR;
@@ -302,10 +326,10 @@ sim800l_ret_t sim800l_sms_send_message(sim800l_handle_t sim800l_handle, const ch
     }
 
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Send AT command */
-    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, 1000);
+    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_SMS_TAG, "sim800l_call_answer failed");
@@ -343,7 +367,7 @@ sim800l_ret_t sim800l_sms_send_message(sim800l_handle_t sim800l_handle, const ch
     }
 
     /* Send message */
-    ret = sim800l_out_data(sim800l_handle, (uint8_t *)message, NULL, 1000);
+    ret = sim800l_out_data(sim800l_handle, (uint8_t *)message, NULL, 0, 1000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_SMS_TAG, "sim800l_out_data failed: %s", esp_err_to_name(ret));
@@ -413,10 +437,10 @@ sim800l_ret_t sim800l_sms_delete_message(sim800l_handle_t sim800l_handle, uint32
     }
 
     /* Response */
-    char response[10] = {0};
+    char response[32] = {0};
 
     /* Send AT command */
-    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, 1000);
+    esp_err_t ret = sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, sizeof(response), 1000);
     if (ret != ESP_OK)
     {
         ESP_LOGE(SIM800L_SMS_TAG, "sim800l_call_answer failed: %s", esp_err_to_name(ret));
@@ -0,0 +1,1581 @@
+/*
+ * @file sim800l_tcpip.c
+ * @author Eduardo Gomes
+ * @brief Source file for SIM800L TCP/IP functions
+ *
+ * @copyright MIT
+ *
+ */
+
+/*
+ *     Includes
+ */
+#include "sim800l_core.h"
+#include "sim800l_tcpip.h"
+#include "sim800l_dns.h"
+#include "sim800l_common.h"
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/stream_buffer.h>
+
+/*
+ *     Define
+ */
+#define SIM800L_TCPIP_RX_BUFFER_SIZE        2048
+#define SIM800L_TCPIP_MAX_SEND              1460    /* Largest AT+CIPSEND with CIPMUX=1 */
+#define SIM800L_TCPIP_MAX_RXGET             1460    /* Largest AT+CIPRXGET=2 */
+#define SIM800L_TCPIP_POLL_MS               100
+#define SIM800L_TCPIP_SEND_TIMEOUT          1000
+#define SIM800L_TCPIP_SEND_CONFIRM_TIMEOUT  30000   /* SEND OK / DATA ACCEPT, GPRS round trips take seconds */
+#define SIM800L_TCPIP_CONNECT_TIMEOUT       75000
+#define SIM800L_TCPIP_SEND_RETRIES          3
+#define SIM800L_TCPIP_RETRY_DELAY_MS        200
+#define SIM800L_TCPIP_DNS_TIMEOUT           10000
+
+/*
+ *     Tag
+ */
+#define SIM800L_TCPIP_TAG "SIM800L TCPIP"
+
+/*
+ *     URC
+ */
+#define SIM800L_EVENT_TCPIP_CONNECT_OK_STR      "CONNECT OK"
+#define SIM800L_EVENT_TCPIP_CONNECT_FAIL_STR    "CONNECT FAIL"
+#define SIM800L_EVENT_TCPIP_ALREADY_STR         "ALREADY CONNECT"
+#define SIM800L_EVENT_TCPIP_SEND_OK_STR         "SEND OK"
+#define SIM800L_EVENT_TCPIP_SEND_FAIL_STR       "SEND FAIL"
+#define SIM800L_EVENT_TCPIP_CLOSED_STR          "CLOSED"
+#define SIM800L_EVENT_TCPIP_CLOSE_OK_STR        "CLOSE OK"
+#define SIM800L_EVENT_TCPIP_CONNECT_STR         "CONNECT"
+#define SIM800L_EVENT_TCPIP_DATA_ACCEPT_STR     "DATA ACCEPT"
+#define SIM800L_EVENT_TCPIP_SERVER_OK_STR       "SERVER OK"
+#define SIM800L_EVENT_TCPIP_SERVER_CLOSE_STR    "SERVER CLOSE"
+#define SIM800L_EVENT_TCPIP_REMOTE_IP_STR       "REMOTE IP"
+#define SIM800L_DATA_TCPIP_RECEIVE_STR          "+RECEIVE"
+#define SIM800L_EVENT_TCPIP_RXGET_STR           "+CIPRXGET"
+#define SIM800L_DATA_TCPIP_RXGET_STR            "+CIPRXGET:"
+
+/*
+ *     TCP/IP link
+ */
+typedef struct
+{
+    sim800l_tcpip_state_t state;
+    bool send_pending;                  /* Data written, SEND OK not received yet */
+    bool send_failed;
+    volatile bool rx_notified;          /* "+CIPRXGET: 1,<n>", data waiting in the modem */
+    volatile uint32_t rx_pending;       /* Unread bytes in the modem after the last read */
+    uint32_t acked;                     /* Peer acknowledged bytes, last AT+CIPACK */
+    StreamBufferHandle_t rx_buffer;     /* Filled by the bridge task, drained by recv */
+    sim800l_tcpip_stats_t stats;
+} sim800l_tcpip_link_t;
+
+static sim800l_tcpip_link_t sim800l_tcpip_links[SIM800L_TCPIP_MAX_LINKS] = {0};
+
+/*
+ *     Quick send, sends complete on DATA ACCEPT
+ */
+static bool sim800l_tcpip_quick_send = false;
+
+/*
+ *     Server, inbound connections take a free link
+ */
+static volatile bool sim800l_tcpip_server_listening = false;
+
+/*
+ *     Manual receive, AT+CIPRXGET=2 copies straight into the caller's buffer, under the mutex
+ */
+static bool sim800l_tcpip_manual_receive = false;
+static struct
+{
+    SemaphoreHandle_t mutex;
+    uint8_t *buffer;
+    size_t buffer_size;
+    size_t received;
+} sim800l_tcpip_rxget_ctx = {0};
+
+/*
+ *     Transparent mode, uses link 0 for its state
+ */
+static int64_t sim800l_tcpip_transparent_connected = 0;
+static sim800l_tcpip_transparent_stats_t sim800l_tcpip_transparent_stats = {0};
+
+/*
+ *     Private functions
+ */
+static sim800l_ret_t sim800l_tcpip_callbacks(bool enable);
+static sim800l_ret_t sim800l_tcpip_command(sim800l_handle_t sim800l_handle, const char *command, const char *expected, uint32_t timeout);
+static sim800l_ret_t sim800l_tcpip_wait(sim800l_handle_t sim800l_handle, uint32_t link, bool (*done)(const sim800l_tcpip_link_t *link), uint32_t timeout);
+static bool sim800l_tcpip_connect_done(const sim800l_tcpip_link_t *link);
+static bool sim800l_tcpip_send_done(const sim800l_tcpip_link_t *link);
+static bool sim800l_tcpip_close_done(const sim800l_tcpip_link_t *link);
+static sim800l_event_t sim800l_tcpip_link_event(char **input_args, void *output_data, sim800l_tcpip_state_t state, bool send_done, bool send_failed);
+static void sim800l_tcpip_receive(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg);
+static sim800l_ret_t sim800l_tcpip_recv_manual(sim800l_handle_t sim800l_handle, uint32_t link, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout);
+static bool sim800l_tcpip_rx_ready(const sim800l_tcpip_link_t *link);
+static void sim800l_tcpip_rxget(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg);
+
+/*
+ *     Callbacks
+ */
+sim800l_event_t sim800l_event_tcpip_connect_ok(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_connect_fail(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_send_ok(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_send_fail(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_closed(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_rxget(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_data_accept(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_server_ok(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_server_close(char **input_args, void *output_data);
+sim800l_event_t sim800l_event_tcpip_remote_ip(char **input_args, void *output_data);
+
+/*
+ *     URC table
+ */
+static const struct
+{
+    const char *name;
+    sim800l_event_t (*callback)(char **input_args, void *output_data);
+} sim800l_tcpip_urcs[] = {
+    {SIM800L_EVENT_TCPIP_CONNECT_OK_STR, sim800l_event_tcpip_connect_ok},
+    {SIM800L_EVENT_TCPIP_ALREADY_STR, sim800l_event_tcpip_connect_ok},
+    {SIM800L_EVENT_TCPIP_CONNECT_FAIL_STR, sim800l_event_tcpip_connect_fail},
+    {SIM800L_EVENT_TCPIP_SEND_OK_STR, sim800l_event_tcpip_send_ok},
+    {SIM800L_EVENT_TCPIP_SEND_FAIL_STR, sim800l_event_tcpip_send_fail},
+    {SIM800L_EVENT_TCPIP_CLOSED_STR, sim800l_event_tcpip_closed},
+    {SIM800L_EVENT_TCPIP_CLOSE_OK_STR, sim800l_event_tcpip_closed},
+    {SIM800L_EVENT_TCPIP_CONNECT_STR, sim800l_event_tcpip_connect_ok},      /* Transparent mode */
+    {SIM800L_EVENT_TCPIP_DATA_ACCEPT_STR, sim800l_event_tcpip_data_accept}, /* Quick send */
+    {SIM800L_EVENT_TCPIP_SERVER_OK_STR, sim800l_event_tcpip_server_ok},
+    {SIM800L_EVENT_TCPIP_SERVER_CLOSE_STR, sim800l_event_tcpip_server_close},
+    {SIM800L_EVENT_TCPIP_REMOTE_IP_STR, sim800l_event_tcpip_remote_ip},     /* Server accept */
+};
+
+/*
+ *     Public functions development
+ */
+sim800l_ret_t sim800l_tcpip_switch(sim800l_handle_t sim800l_handle, bool enable)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (sim800l_tcpip_callbacks(enable) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    if (enable)
+    {
+        /* Only accepted while the IP stack is in IP INITIAL */
+        return sim800l_tcpip_command(sim800l_handle, SIM800L_COMMAND_TCPIP_MUX, "OK", 1000);
+    }
+
+    /* Nothing feeds the ring buffers anymore */
+    for (uint32_t i = 0; i < SIM800L_TCPIP_MAX_LINKS; i++)
+    {
+        if (sim800l_tcpip_links[i].rx_buffer != NULL)
+        {
+            vStreamBufferDelete(sim800l_tcpip_links[i].rx_buffer);
+        }
+
+        memset(&sim800l_tcpip_links[i], 0, sizeof(sim800l_tcpip_link_t));
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_attach(sim800l_handle_t sim800l_handle, const char *apn, const char *user, const char *pwd, char *ip, size_t ip_size)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (apn == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "APN is NULL");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    user = (user != NULL) ? user : "";
+    pwd = (pwd != NULL) ? pwd : "";
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_APN) + strlen(apn) + strlen(user) + strlen(pwd) + 9 * sizeof(char) + strlen("\r\n") + 1; /* cmd="s","s","s"\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=\"%s\",\"%s\",\"%s\"\r\n", SIM800L_COMMAND_TCPIP_APN, apn, user, pwd) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, (const char *)command, "OK", 1000);
+
+    free(command);
+
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    /* Bring up the GPRS context, up to 85 s */
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_TCPIP_UP, SIM800L_EVENT_OK, 85000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "AT+CIICR failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* Local address, answered without OK */
+    char response[32] = {0};
+    if (sim800l_out_data(sim800l_handle, (uint8_t *)SIM800L_COMMAND_TCPIP_IP, (uint8_t *)response, sizeof(response), 1000) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "AT+CIFSR failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    if (strnstr(response, "ERROR", sizeof(response)) != NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "No local address");
+        return SIM800L_RET_ERROR;
+    }
+
+    if ((ip != NULL) && (ip_size > 0))
+    {
+        size_t ip_len = strcspn(response, "\r\n");
+        if (ip_len >= ip_size)
+        {
+            ip_len = ip_size - 1;
+        }
+
+        memcpy(ip, response, ip_len);
+        ip[ip_len] = '\0';
+    }
+
+    ESP_LOGI(SIM800L_TCPIP_TAG, "GPRS up: %.*s", (int)strcspn(response, "\r\n"), response);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_detach(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, SIM800L_COMMAND_TCPIP_SHUT, "SHUT OK", 65000);
+
+    /* All links are gone either way */
+    for (uint32_t i = 0; i < SIM800L_TCPIP_MAX_LINKS; i++)
+    {
+        sim800l_tcpip_links[i].state = SIM800L_TCPIP_STATE_CLOSED;
+        sim800l_tcpip_links[i].send_pending = false;
+    }
+
+    /* CIPSHUT closes the listening port as well */
+    sim800l_tcpip_server_listening = false;
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_tcpip_open(sim800l_handle_t sim800l_handle, uint32_t link, sim800l_tcpip_protocol_t protocol, const char *host, uint16_t port, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if ((link >= SIM800L_TCPIP_MAX_LINKS) || (host == NULL))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+
+    if (tcpip_link->state == SIM800L_TCPIP_STATE_CONNECTED)
+    {
+        ESP_LOGW(SIM800L_TCPIP_TAG, "Link %lu already connected", link);
+        return SIM800L_RET_OK;
+    }
+
+    /* Ring buffer is kept across connections, the bridge task may still hold it */
+    if (tcpip_link->rx_buffer == NULL)
+    {
+        tcpip_link->rx_buffer = xStreamBufferCreate(SIM800L_TCPIP_RX_BUFFER_SIZE, 1);
+        if (tcpip_link->rx_buffer == NULL)
+        {
+            ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+            return SIM800L_RET_ERROR_MEM;
+        }
+    }
+    else
+    {
+        xStreamBufferReset(tcpip_link->rx_buffer);
+    }
+
+    /* Cached address skips the lookup CIPSTART would do, the hostname goes as is if it can not be resolved */
+    char address[16] = {0};
+    if (sim800l_dns_resolve(sim800l_handle, host, address, sizeof(address), SIM800L_TCPIP_DNS_TIMEOUT) == SIM800L_RET_OK)
+    {
+        host = address;
+    }
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_START) + strlen(host) + 10 + 5 + 10 * sizeof(char) + strlen("\r\n") + 1; /* cmd=d,"TCP","s",d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=%lu,\"%s\",\"%s\",%u\r\n", SIM800L_COMMAND_TCPIP_START, link,
+                 (protocol == SIM800L_TCPIP_PROTOCOL_UDP) ? "UDP" : "TCP", host, port) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    memset(&tcpip_link->stats, 0, sizeof(sim800l_tcpip_stats_t));
+    tcpip_link->send_pending = false;
+    tcpip_link->rx_notified = false;
+    tcpip_link->rx_pending = 0;
+    tcpip_link->acked = 0;
+    tcpip_link->state = SIM800L_TCPIP_STATE_CONNECTING;
+
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, (const char *)command, "OK", 1000);
+
+    free(command);
+
+    if (ret != SIM800L_RET_OK)
+    {
+        tcpip_link->state = SIM800L_TCPIP_STATE_FAILED;
+        return ret;
+    }
+
+    /* "<n>, CONNECT OK" or "<n>, CONNECT FAIL" */
+    ret = sim800l_tcpip_wait(sim800l_handle, link, sim800l_tcpip_connect_done, (timeout > 0) ? timeout : SIM800L_TCPIP_CONNECT_TIMEOUT);
+    if ((ret != SIM800L_RET_OK) || (tcpip_link->state != SIM800L_TCPIP_STATE_CONNECTED))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu: connection to %s:%u failed", link, host, port);
+        tcpip_link->state = SIM800L_TCPIP_STATE_FAILED;
+        return SIM800L_RET_ERROR;
+    }
+
+    ESP_LOGI(SIM800L_TCPIP_TAG, "Link %lu connected to %s:%u", link, host, port);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_send(sim800l_handle_t sim800l_handle, uint32_t link, const uint8_t *data, size_t data_len, size_t *sent, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if ((link >= SIM800L_TCPIP_MAX_LINKS) || (data == NULL) || (data_len == 0) || (sent == NULL))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+    *sent = 0;
+
+    if (tcpip_link->state != SIM800L_TCPIP_STATE_CONNECTED)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu not connected", link);
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Previous send not acknowledged, try again later */
+    if (tcpip_link->send_pending)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    size_t length = (data_len > SIM800L_TCPIP_MAX_SEND) ? SIM800L_TCPIP_MAX_SEND : data_len;
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_SEND) + 2 * sizeof(char) + 2 * 10 + strlen("\r\n") + 1; /* cmd=d,d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=%lu,%u\r\n", SIM800L_COMMAND_TCPIP_SEND, link, length) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* Nothing else may be written between the '>' prompt and the data */
+    sim800l_lock(sim800l_handle, portMAX_DELAY);
+
+    /* Wait for the '>' prompt */
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, (const char *)command, ">", SIM800L_TCPIP_SEND_TIMEOUT);
+
+    free(command);
+
+    if (ret != SIM800L_RET_OK)
+    {
+        sim800l_unlock(sim800l_handle);
+        return ret;
+    }
+
+    /* Armed before the data goes out, SEND OK may come right after it */
+    tcpip_link->send_failed = false;
+    tcpip_link->send_pending = true;
+
+    esp_err_t err = sim800l_out_data_raw(sim800l_handle, data, length);
+
+    sim800l_unlock(sim800l_handle);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_out_data_raw failed");
+        tcpip_link->send_pending = false;
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    tcpip_link->stats.tx_bytes += length;
+    *sent = length;
+
+    /* Non-blocking, SEND OK (DATA ACCEPT in quick send) is reported through SIM800L_EVENT_TCPIP */
+    if (timeout == 0)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* SEND FAIL, the modem did not send it, nothing is on the stream */
+    if ((sim800l_tcpip_wait(sim800l_handle, link, sim800l_tcpip_send_done, timeout) == SIM800L_RET_OK) && tcpip_link->send_failed)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu: send failed", link);
+        tcpip_link->stats.tx_bytes -= length;
+        *sent = 0;
+        return SIM800L_RET_ERROR;
+    }
+
+    /* No answer in time, the modem owns the bytes now, *sent keeps them counted */
+    if (tcpip_link->send_pending)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu: send not confirmed", link);
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_recv(sim800l_handle_t sim800l_handle, uint32_t link, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if ((link >= SIM800L_TCPIP_MAX_LINKS) || (buffer == NULL) || (received == NULL))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+    *received = 0;
+
+    if (sim800l_tcpip_manual_receive)
+    {
+        return sim800l_tcpip_recv_manual(sim800l_handle, link, buffer, buffer_size, received, timeout);
+    }
+
+    if (tcpip_link->rx_buffer == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu never opened", link);
+        return SIM800L_RET_ERROR;
+    }
+
+    /* timeout 0 returns what is buffered right now */
+    *received = xStreamBufferReceive(tcpip_link->rx_buffer, buffer, buffer_size, timeout / portTICK_PERIOD_MS);
+
+    /* Closed and drained */
+    if ((*received == 0) && (tcpip_link->state != SIM800L_TCPIP_STATE_CONNECTED))
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_close(sim800l_handle_t sim800l_handle, uint32_t link, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (link >= SIM800L_TCPIP_MAX_LINKS)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+
+    if (tcpip_link->state == SIM800L_TCPIP_STATE_CLOSED)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_CLOSE) + sizeof(char) + 10 + strlen("\r\n") + 1; /* cmd=d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=%lu\r\n", SIM800L_COMMAND_TCPIP_CLOSE, link) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    tcpip_link->state = SIM800L_TCPIP_STATE_CLOSING;
+
+    /* Answered with "<n>, CLOSE OK", or ERROR if the peer already closed */
+    char response[32] = {0};
+    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000);
+
+    free(command);
+
+    if ((ret != ESP_OK) || (strnstr(response, "ERROR", sizeof(response)) != NULL))
+    {
+        tcpip_link->state = SIM800L_TCPIP_STATE_CLOSED;
+        tcpip_link->send_pending = false;
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    if (sim800l_tcpip_wait(sim800l_handle, link, sim800l_tcpip_close_done, (timeout > 0) ? timeout : SIM800L_TCPIP_SEND_TIMEOUT) != SIM800L_RET_OK)
+    {
+        ESP_LOGW(SIM800L_TCPIP_TAG, "Link %lu: CLOSE OK not received", link);
+    }
+
+    tcpip_link->state = SIM800L_TCPIP_STATE_CLOSED;
+    tcpip_link->send_pending = false;
+
+    return SIM800L_RET_OK;
+}
+
+size_t sim800l_tcpip_available(uint32_t link)
+{
+    if (link >= SIM800L_TCPIP_MAX_LINKS)
+    {
+        return 0;
+    }
+
+    /* Known after the first read, a notification alone has no count */
+    if (sim800l_tcpip_manual_receive)
+    {
+        return sim800l_tcpip_links[link].rx_pending;
+    }
+
+    if (sim800l_tcpip_links[link].rx_buffer == NULL)
+    {
+        return 0;
+    }
+
+    return xStreamBufferBytesAvailable(sim800l_tcpip_links[link].rx_buffer);
+}
+
+sim800l_tcpip_state_t sim800l_tcpip_get_state(uint32_t link)
+{
+    if (link >= SIM800L_TCPIP_MAX_LINKS)
+    {
+        return SIM800L_TCPIP_STATE_CLOSED;
+    }
+
+    return sim800l_tcpip_links[link].state;
+}
+
+sim800l_ret_t sim800l_tcpip_get_stats(uint32_t link, sim800l_tcpip_stats_t *stats)
+{
+    if ((link >= SIM800L_TCPIP_MAX_LINKS) || (stats == NULL))
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_tcpip_links[link].stats, sizeof(sim800l_tcpip_stats_t));
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_set_quick_send(sim800l_handle_t sim800l_handle, bool enable)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    /* DATA ACCEPT comes as soon as the modem buffered the data, SEND OK waits for the peer */
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, enable ? SIM800L_COMMAND_TCPIP_QUICK_SEND "=1\r\n" : SIM800L_COMMAND_TCPIP_QUICK_SEND "=0\r\n", "OK", 1000);
+    if (ret == SIM800L_RET_OK)
+    {
+        sim800l_tcpip_quick_send = enable;
+    }
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_tcpip_get_ack(sim800l_handle_t sim800l_handle, uint32_t link, uint32_t *sent, uint32_t *acked, uint32_t *unacked)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (link >= SIM800L_TCPIP_MAX_LINKS)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_ACK) + sizeof(char) + 10 + strlen("\r\n") + 1; /* cmd=d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=%lu\r\n", SIM800L_COMMAND_TCPIP_ACK, link) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* "+CIPACK: <txlen>,<acklen>,<nacklen>" */
+    char response[48] = {0};
+    esp_err_t ret = sim800l_out_data(sim800l_handle, command, (uint8_t *)response, sizeof(response), 1000);
+
+    free(command);
+
+    uint32_t tx_len = 0;
+    uint32_t ack_len = 0;
+    uint32_t nack_len = 0;
+
+    if ((ret != ESP_OK) || (sscanf(response, "%lu,%lu,%lu", &tx_len, &ack_len, &nack_len) != 3))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "AT+CIPACK failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    sim800l_tcpip_links[link].acked = ack_len;
+
+    if (sent != NULL)
+    {
+        *sent = tx_len;
+    }
+
+    if (acked != NULL)
+    {
+        *acked = ack_len;
+    }
+
+    if (unacked != NULL)
+    {
+        *unacked = nack_len;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_send_all(sim800l_handle_t sim800l_handle, uint32_t link, const uint8_t *data, size_t data_len, uint32_t window, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if ((link >= SIM800L_TCPIP_MAX_LINKS) || (data == NULL))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout * 1000;
+    uint32_t retries = 0;
+    size_t offset = 0;
+
+    while (offset < data_len)
+    {
+        if (esp_timer_get_time() >= deadline)
+        {
+            ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu: send timeout (%u/%u)", link, offset, data_len);
+            return SIM800L_RET_ERROR;
+        }
+
+        /* Window of bytes in flight, the modem is only asked once the local count says it is full */
+        if (sim800l_tcpip_quick_send && (window > 0) && (tcpip_link->stats.tx_bytes - tcpip_link->acked >= window))
+        {
+            uint32_t unacked = 0;
+            if ((sim800l_tcpip_get_ack(sim800l_handle, link, NULL, NULL, &unacked) == SIM800L_RET_OK) && (unacked >= window))
+            {
+                vTaskDelay(SIM800L_TCPIP_POLL_MS / portTICK_PERIOD_MS);
+                continue;
+            }
+        }
+
+        /* Confirmation wait bounded by what is left of the timeout */
+        int64_t remaining_ms = (deadline - esp_timer_get_time()) / 1000;
+        uint32_t confirm_timeout = (remaining_ms < SIM800L_TCPIP_SEND_CONFIRM_TIMEOUT) ? (uint32_t)remaining_ms + 1 : SIM800L_TCPIP_SEND_CONFIRM_TIMEOUT;
+
+        size_t sent = 0;
+        sim800l_ret_t ret = sim800l_tcpip_send(sim800l_handle, link, data + offset, data_len - offset, &sent, confirm_timeout);
+
+        if (tcpip_link->state != SIM800L_TCPIP_STATE_CONNECTED)
+        {
+            return SIM800L_RET_ERROR;
+        }
+
+        /* Previous chunk still unconfirmed, nothing was written */
+        if ((ret == SIM800L_RET_OK) && (sent == 0))
+        {
+            vTaskDelay(SIM800L_TCPIP_POLL_MS / portTICK_PERIOD_MS);
+            continue;
+        }
+
+        /* Written but not confirmed, sending it again could put it on the stream twice */
+        if ((ret != SIM800L_RET_OK) && (sent > 0))
+        {
+            ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu: chunk at %u not confirmed, not resent", link, offset);
+            return SIM800L_RET_ERROR;
+        }
+
+        /* No '>' prompt or SEND FAIL, the modem did not take the chunk, safe to send again */
+        if (ret != SIM800L_RET_OK)
+        {
+            if (++retries > SIM800L_TCPIP_SEND_RETRIES)
+            {
+                ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu: send failed after %d retries", link, SIM800L_TCPIP_SEND_RETRIES);
+                return SIM800L_RET_ERROR;
+            }
+
+            tcpip_link->stats.retransmits++;
+            vTaskDelay(SIM800L_TCPIP_RETRY_DELAY_MS / portTICK_PERIOD_MS);
+            continue;
+        }
+
+        retries = 0;
+        offset += sent;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_server_start(sim800l_handle_t sim800l_handle, uint16_t port)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if ((sim800l_handle == NULL) || (port == 0))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Ring buffers up front, accepts are handled in the bridge task */
+    for (uint32_t link = 0; link < SIM800L_TCPIP_MAX_LINKS; link++)
+    {
+        if (sim800l_tcpip_links[link].rx_buffer == NULL)
+        {
+            sim800l_tcpip_links[link].rx_buffer = xStreamBufferCreate(SIM800L_TCPIP_RX_BUFFER_SIZE, 1);
+            if (sim800l_tcpip_links[link].rx_buffer == NULL)
+            {
+                ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+                return SIM800L_RET_ERROR_MEM;
+            }
+        }
+    }
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_SERVER) + 3 * sizeof(char) + 5 + strlen("\r\n") + 1; /* cmd=1,d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=1,%u\r\n", SIM800L_COMMAND_TCPIP_SERVER, port) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* OK first, then SERVER OK once the port is open */
+    esp_err_t ret = sim800l_out_data_event(sim800l_handle, command, SIM800L_EVENT_TCPIP_SERVER, SIM800L_TCPIP_SEND_TIMEOUT * 5);
+
+    free(command);
+
+    if ((ret != ESP_OK) || !sim800l_tcpip_server_listening)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "AT+CIPSERVER failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    ESP_LOGI(SIM800L_TCPIP_TAG, "Listening on port %u", port);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_server_stop(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (sim800l_handle == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (!sim800l_tcpip_server_listening)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Accepted links stay up, close them with sim800l_tcpip_close */
+    if (sim800l_out_data_event(sim800l_handle, (uint8_t *)SIM800L_COMMAND_TCPIP_SERVER "=0\r\n", SIM800L_EVENT_TCPIP_SERVER, SIM800L_TCPIP_SEND_TIMEOUT * 5) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "AT+CIPSERVER=0 failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+bool sim800l_tcpip_server_is_listening(void)
+{
+    return sim800l_tcpip_server_listening;
+}
+
+sim800l_ret_t sim800l_tcpip_set_manual_receive(sim800l_handle_t sim800l_handle, bool enable)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (enable)
+    {
+        if (sim800l_tcpip_rxget_ctx.mutex == NULL)
+        {
+            sim800l_tcpip_rxget_ctx.mutex = xSemaphoreCreateMutex();
+            if (sim800l_tcpip_rxget_ctx.mutex == NULL)
+            {
+                ESP_LOGE(SIM800L_TCPIP_TAG, "Mutex creation failed");
+                return SIM800L_RET_ERROR_MEM;
+            }
+        }
+
+        /* "+CIPRXGET: 1,<n>" notification */
+        if (sim800l_register_callback(SIM800L_EVENT_TCPIP_RXGET_STR, sim800l_event_tcpip_rxget) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_register_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
+        /* "+CIPRXGET: 2,<n>,<len>,<left>" followed by <len> bytes */
+        if (sim800l_register_data_callback(SIM800L_DATA_TCPIP_RXGET_STR, 2, sim800l_tcpip_rxget, NULL) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_register_data_callback failed");
+            sim800l_unregister_callback(SIM800L_EVENT_TCPIP_RXGET_STR);
+            return SIM800L_RET_ERROR;
+        }
+    }
+
+    /* Only accepted before the first connection */
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, enable ? SIM800L_COMMAND_TCPIP_RXGET "=1\r\n" : SIM800L_COMMAND_TCPIP_RXGET "=0\r\n", "OK", 1000);
+
+    if ((ret != SIM800L_RET_OK) || !enable)
+    {
+        sim800l_unregister_callback(SIM800L_EVENT_TCPIP_RXGET_STR);
+        sim800l_unregister_data_callback(SIM800L_DATA_TCPIP_RXGET_STR);
+    }
+
+    sim800l_tcpip_manual_receive = (ret == SIM800L_RET_OK) ? enable : false;
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_switch(sim800l_handle_t sim800l_handle, bool enable, const sim800l_tcpip_transparent_config_t *config)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (!enable)
+    {
+        /* Back to AT+CIPSEND, only accepted with no connection open */
+        sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, SIM800L_COMMAND_TCPIP_MODE "=0\r\n", "OK", 1000);
+
+        sim800l_tcpip_callbacks(false);
+        sim800l_data_mode_exit(sim800l_handle);
+        memset(&sim800l_tcpip_links[0], 0, sizeof(sim800l_tcpip_link_t));
+
+        return ret;
+    }
+
+    if (sim800l_tcpip_callbacks(true) != SIM800L_RET_OK)
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    /* Transparent mode is single connection only, both need IP INITIAL */
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, SIM800L_COMMAND_TCPIP_SINGLE, "OK", 1000);
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    ret = sim800l_tcpip_command(sim800l_handle, SIM800L_COMMAND_TCPIP_MODE "=1\r\n", "OK", 1000);
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    uint32_t send_size = ((config != NULL) && (config->send_size > 0)) ? config->send_size : SIM800L_TCPIP_MAX_SEND;
+    uint32_t wait_time = ((config != NULL) && (config->wait_time > 0)) ? config->wait_time : 1;
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_TRANSPARENT_CONFIG) + 3 * 10 + 6 * sizeof(char) + strlen("\r\n") + 1; /* cmd=5,d,d,1\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent, 5 retries, "+++" escape enabled */
+    if (snprintf((char *)command, command_length, "%s=5,%lu,%lu,1\r\n", SIM800L_COMMAND_TCPIP_TRANSPARENT_CONFIG, wait_time, send_size) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    ret = sim800l_tcpip_command(sim800l_handle, (const char *)command, "OK", 1000);
+
+    free(command);
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_open(sim800l_handle_t sim800l_handle, sim800l_tcpip_protocol_t protocol, const char *host, uint16_t port, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (host == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[0];
+
+    /* Cached address skips the lookup CIPSTART would do */
+    char address[16] = {0};
+    if (sim800l_dns_resolve(sim800l_handle, host, address, sizeof(address), SIM800L_TCPIP_DNS_TIMEOUT) == SIM800L_RET_OK)
+    {
+        host = address;
+    }
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_START) + strlen(host) + 5 + 10 * sizeof(char) + strlen("\r\n") + 1; /* cmd="TCP","s",d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=\"%s\",\"%s\",%u\r\n", SIM800L_COMMAND_TCPIP_START,
+                 (protocol == SIM800L_TCPIP_PROTOCOL_UDP) ? "UDP" : "TCP", host, port) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* Everything after "CONNECT" up to "CLOSED" is payload */
+    if (sim800l_data_mode_arm(sim800l_handle, SIM800L_EVENT_TCPIP_CONNECT_STR, SIM800L_EVENT_TCPIP_CLOSED_STR, true) != ESP_OK)
+    {
+        free(command);
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    memset(&sim800l_tcpip_transparent_stats, 0, sizeof(sim800l_tcpip_transparent_stats_t));
+    tcpip_link->state = SIM800L_TCPIP_STATE_CONNECTING;
+
+    sim800l_ret_t ret = sim800l_tcpip_command(sim800l_handle, (const char *)command, "OK", 1000);
+
+    free(command);
+
+    if (ret == SIM800L_RET_OK)
+    {
+        /* "CONNECT" or "CONNECT FAIL" */
+        ret = sim800l_tcpip_wait(sim800l_handle, 0, sim800l_tcpip_connect_done, (timeout > 0) ? timeout : SIM800L_TCPIP_CONNECT_TIMEOUT);
+    }
+
+    if ((ret != SIM800L_RET_OK) || (tcpip_link->state != SIM800L_TCPIP_STATE_CONNECTED))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Transparent connection to %s:%u failed", host, port);
+        sim800l_data_mode_exit(sim800l_handle);
+        tcpip_link->state = SIM800L_TCPIP_STATE_FAILED;
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_tcpip_transparent_connected = esp_timer_get_time();
+
+    ESP_LOGI(SIM800L_TCPIP_TAG, "Transparent connection to %s:%u", host, port);
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_write(sim800l_handle_t sim800l_handle, const uint8_t *data, size_t data_len)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if ((data == NULL) || (data_len == 0))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    if (sim800l_data_mode_get(sim800l_handle, NULL) != SIM800L_DATA_MODE_ON)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Not in data mode");
+        return SIM800L_RET_ERROR;
+    }
+
+    /* No framing, the modem packetizes by CIPCCFG SendSz/WaitTm */
+    int64_t start = esp_timer_get_time();
+
+    if (sim800l_out_data_raw(sim800l_handle, data, data_len) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_out_data_raw failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    sim800l_tcpip_transparent_stats.tx_us += esp_timer_get_time() - start;
+    sim800l_tcpip_transparent_stats.tx_bytes += data_len;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_read(sim800l_handle_t sim800l_handle, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if ((buffer == NULL) || (received == NULL))
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Invalid argument");
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    /* Also drains what arrived before an escape */
+    if (sim800l_data_mode_read(sim800l_handle, buffer, buffer_size, received, timeout) != ESP_OK)
+    {
+        /* Out of data mode and drained */
+        return SIM800L_RET_ERROR;
+    }
+
+    sim800l_tcpip_transparent_stats.rx_bytes += *received;
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_escape(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    /* "+++" with guard times, no-op when already in command mode */
+    if (sim800l_data_mode_escape(sim800l_handle) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Escape failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_resume(sim800l_handle_t sim800l_handle, uint32_t timeout)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    if (sim800l_tcpip_links[0].state != SIM800L_TCPIP_STATE_CONNECTED)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Not connected");
+        return SIM800L_RET_ERROR;
+    }
+
+    if (sim800l_data_mode_get(sim800l_handle, NULL) == SIM800L_DATA_MODE_ON)
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Keep unread bytes from before the escape */
+    if (sim800l_data_mode_arm(sim800l_handle, SIM800L_EVENT_TCPIP_CONNECT_STR, SIM800L_EVENT_TCPIP_CLOSED_STR, false) != ESP_OK)
+    {
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* ATO is answered with CONNECT, or NO CARRIER when the link is gone */
+    if (sim800l_tcpip_command(sim800l_handle, SIM800L_COMMAND_DATA_MODE, SIM800L_EVENT_TCPIP_CONNECT_STR, (timeout > 0) ? timeout : SIM800L_TCPIP_SEND_TIMEOUT) != SIM800L_RET_OK)
+    {
+        sim800l_data_mode_exit(sim800l_handle);
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_close(sim800l_handle_t sim800l_handle)
+{
+    ESP_LOGD(SIM800L_TCPIP_TAG, "%s", __func__);
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[0];
+
+    if (tcpip_link->state != SIM800L_TCPIP_STATE_CONNECTED)
+    {
+        sim800l_data_mode_exit(sim800l_handle);
+        return SIM800L_RET_OK;
+    }
+
+    /* AT+CIPCLOSE needs command mode */
+    sim800l_ret_t ret = sim800l_tcpip_transparent_escape(sim800l_handle);
+    if (ret != SIM800L_RET_OK)
+    {
+        return ret;
+    }
+
+    tcpip_link->state = SIM800L_TCPIP_STATE_CLOSING;
+
+    ret = sim800l_tcpip_command(sim800l_handle, SIM800L_COMMAND_TCPIP_CLOSE "\r\n", SIM800L_EVENT_TCPIP_CLOSE_OK_STR, SIM800L_TCPIP_SEND_TIMEOUT);
+
+    tcpip_link->state = SIM800L_TCPIP_STATE_CLOSED;
+
+    return ret;
+}
+
+sim800l_ret_t sim800l_tcpip_transparent_get_stats(sim800l_handle_t sim800l_handle, sim800l_tcpip_transparent_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return SIM800L_RET_INVALID_ARG;
+    }
+
+    memcpy(stats, &sim800l_tcpip_transparent_stats, sizeof(sim800l_tcpip_transparent_stats_t));
+    sim800l_data_mode_get(sim800l_handle, &stats->rx_dropped);
+
+    if (sim800l_tcpip_transparent_connected > 0)
+    {
+        stats->connected_us = esp_timer_get_time() - sim800l_tcpip_transparent_connected;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+/*
+ *     Private functions development
+ */
+static sim800l_ret_t sim800l_tcpip_callbacks(bool enable)
+{
+    if (enable)
+    {
+        /* Link URCs ("<n>, CONNECT OK") */
+        for (uint32_t i = 0; i < sizeof(sim800l_tcpip_urcs) / sizeof(sim800l_tcpip_urcs[0]); i++)
+        {
+            if (sim800l_register_callback(sim800l_tcpip_urcs[i].name, sim800l_tcpip_urcs[i].callback) != ESP_OK)
+            {
+                ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_register_callback failed");
+                return SIM800L_RET_ERROR;
+            }
+        }
+
+        /* "+RECEIVE,<n>,<len>:" followed by <len> bytes */
+        if (sim800l_register_data_callback(SIM800L_DATA_TCPIP_RECEIVE_STR, 1, sim800l_tcpip_receive, NULL) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_register_data_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+
+        return SIM800L_RET_OK;
+    }
+
+    /* Unregister callbacks */
+    for (uint32_t i = 0; i < sizeof(sim800l_tcpip_urcs) / sizeof(sim800l_tcpip_urcs[0]); i++)
+    {
+        if (sim800l_unregister_callback(sim800l_tcpip_urcs[i].name) != ESP_OK)
+        {
+            ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_unregister_callback failed");
+            return SIM800L_RET_ERROR;
+        }
+    }
+
+    if (sim800l_unregister_data_callback(SIM800L_DATA_TCPIP_RECEIVE_STR) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_unregister_data_callback failed");
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_tcpip_command(sim800l_handle_t sim800l_handle, const char *command, const char *expected, uint32_t timeout)
+{
+    /* Response */
+    char response[32] = {0};
+
+    /* Send AT command */
+    if (sim800l_out_data(sim800l_handle, (uint8_t *)command, (uint8_t *)response, sizeof(response), timeout) != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "sim800l_out_data failed");
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    /* Check response */
+    if (strnstr(response, expected, sizeof(response)) == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Unexpected response: %s", response);
+        return SIM800L_RET_ERROR;
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_tcpip_wait(sim800l_handle_t sim800l_handle, uint32_t link, bool (*done)(const sim800l_tcpip_link_t *link), uint32_t timeout)
+{
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout * 1000;
+
+    /* Link state is updated by the callbacks before the event bit is set */
+    while (!done(&sim800l_tcpip_links[link]))
+    {
+        if (esp_timer_get_time() >= deadline)
+        {
+            return SIM800L_RET_ERROR;
+        }
+
+        sim800l_out_data_event(sim800l_handle, NULL, SIM800L_EVENT_TCPIP, SIM800L_TCPIP_POLL_MS);
+    }
+
+    return SIM800L_RET_OK;
+}
+
+static sim800l_ret_t sim800l_tcpip_recv_manual(sim800l_handle_t sim800l_handle, uint32_t link, uint8_t *buffer, size_t buffer_size, size_t *received, uint32_t timeout)
+{
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+
+    /* Nothing announced yet, wait for "+CIPRXGET: 1" */
+    if ((timeout > 0) && (sim800l_tcpip_wait(sim800l_handle, link, sim800l_tcpip_rx_ready, timeout) != SIM800L_RET_OK))
+    {
+        return SIM800L_RET_OK;
+    }
+
+    if (!sim800l_tcpip_rx_ready(tcpip_link))
+    {
+        return SIM800L_RET_OK;
+    }
+
+    /* Closed and drained */
+    if (!tcpip_link->rx_notified && (tcpip_link->rx_pending == 0))
+    {
+        return SIM800L_RET_ERROR;
+    }
+
+    size_t length = (buffer_size > SIM800L_TCPIP_MAX_RXGET) ? SIM800L_TCPIP_MAX_RXGET : buffer_size;
+
+    /* Get command length */
+    uint32_t command_length = strlen(SIM800L_COMMAND_TCPIP_RXGET) + 4 * sizeof(char) + 2 * 10 + strlen("\r\n") + 1; /* cmd=2,d,d\r\n */
+
+    /* Allocate dinamic memory */
+    uint8_t *command = calloc(command_length, sizeof(uint8_t));
+    if (command == NULL)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Memory allocation failed");
+        return SIM800L_RET_ERROR_MEM;
+    }
+
+    /* Assembly of the command to be sent */
+    if (snprintf((char *)command, command_length, "%s=2,%lu,%u\r\n", SIM800L_COMMAND_TCPIP_RXGET, link, length) < 0)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Assembly of the command to be sent failed");
+        free(command);
+        return SIM800L_RET_ERROR_BUILD_COMMAND;
+    }
+
+    /* The bridge task copies the payload into the caller's buffer */
+    xSemaphoreTake(sim800l_tcpip_rxget_ctx.mutex, portMAX_DELAY);
+    sim800l_tcpip_rxget_ctx.buffer = buffer;
+    sim800l_tcpip_rxget_ctx.buffer_size = length;
+    sim800l_tcpip_rxget_ctx.received = 0;
+    xSemaphoreGive(sim800l_tcpip_rxget_ctx.mutex);
+
+    /* Consumed now, the response tells what is left */
+    tcpip_link->rx_notified = false;
+
+    esp_err_t ret = sim800l_out_data_event(sim800l_handle, command, SIM800L_EVENT_OK, SIM800L_TCPIP_SEND_TIMEOUT);
+
+    free(command);
+
+    /* On timeout the payload may still be arriving, wait out a copy in progress and drop the rest */
+    xSemaphoreTake(sim800l_tcpip_rxget_ctx.mutex, portMAX_DELAY);
+    *received = sim800l_tcpip_rxget_ctx.received;
+    sim800l_tcpip_rxget_ctx.buffer = NULL;
+    xSemaphoreGive(sim800l_tcpip_rxget_ctx.mutex);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(SIM800L_TCPIP_TAG, "Link %lu: AT+CIPRXGET failed", link);
+        return SIM800L_RET_ERROR_SEND_COMMAND;
+    }
+
+    tcpip_link->stats.rx_bytes += *received;
+
+    return SIM800L_RET_OK;
+}
+
+static bool sim800l_tcpip_rx_ready(const sim800l_tcpip_link_t *link)
+{
+    return link->rx_notified || (link->rx_pending > 0) || (link->state != SIM800L_TCPIP_STATE_CONNECTED);
+}
+
+static bool sim800l_tcpip_connect_done(const sim800l_tcpip_link_t *link)
+{
+    return link->state != SIM800L_TCPIP_STATE_CONNECTING;
+}
+
+static bool sim800l_tcpip_send_done(const sim800l_tcpip_link_t *link)
+{
+    return !link->send_pending || (link->state != SIM800L_TCPIP_STATE_CONNECTED);
+}
+
+static bool sim800l_tcpip_close_done(const sim800l_tcpip_link_t *link)
+{
+    return link->state == SIM800L_TCPIP_STATE_CLOSED;
+}
+
+static sim800l_event_t sim800l_tcpip_link_event(char **input_args, void *output_data, sim800l_tcpip_state_t state, bool send_done, bool send_failed)
+{
+    sim800l_tcpip_event_t *event = (sim800l_tcpip_event_t *)output_data;
+
+    /* No link number in single connection mode */
+    uint32_t link = (input_args[0] != NULL) ? atoi(input_args[0]) : 0;
+    if (link >= SIM800L_TCPIP_MAX_LINKS)
+    {
+        return SIM800L_EVENT_TCPIP;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+
+    if (send_done)
+    {
+        tcpip_link->send_failed = send_failed;
+        tcpip_link->send_pending = false;
+
+        if (send_failed)
+        {
+            tcpip_link->stats.send_failed++;
+        }
+    }
+    else
+    {
+        tcpip_link->state = state;
+    }
+
+    event->link = link;
+    event->state = tcpip_link->state;
+    event->send_done = send_done;
+    event->send_failed = send_failed;
+
+    return SIM800L_EVENT_TCPIP;
+}
+
+static void sim800l_tcpip_receive(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg)
+{
+    uint32_t link = input_args[0];
+    if ((link >= SIM800L_TCPIP_MAX_LINKS) || (sim800l_tcpip_links[link].rx_buffer == NULL))
+    {
+        return;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+
+    /* Never block the bridge task, a full ring buffer drops */
+    size_t stored = xStreamBufferSend(tcpip_link->rx_buffer, data, data_len, 0);
+
+    tcpip_link->stats.rx_bytes += stored;
+    tcpip_link->stats.rx_dropped += data_len - stored;
+}
+
+static void sim800l_tcpip_rxget(const uint32_t *input_args, uint32_t num_args, const uint8_t *data, size_t data_offset, size_t data_len, void *arg)
+{
+    /* Only mode 2 carries data */
+    if ((input_args[0] != 2) || (sim800l_tcpip_rxget_ctx.mutex == NULL))
+    {
+        return;
+    }
+
+    xSemaphoreTake(sim800l_tcpip_rxget_ctx.mutex, portMAX_DELAY);
+
+    /* Nobody waiting means a stale response */
+    if ((sim800l_tcpip_rxget_ctx.buffer != NULL) && (data_offset + data_len <= sim800l_tcpip_rxget_ctx.buffer_size))
+    {
+        memcpy(sim800l_tcpip_rxget_ctx.buffer + data_offset, data, data_len);
+        sim800l_tcpip_rxget_ctx.received = data_offset + data_len;
+    }
+
+    xSemaphoreGive(sim800l_tcpip_rxget_ctx.mutex);
+}
+
+/*
+ *     Callbacks development
+ */
+sim800l_event_t sim800l_event_tcpip_connect_ok(char **input_args, void *output_data)
+{
+    return sim800l_tcpip_link_event(input_args, output_data, SIM800L_TCPIP_STATE_CONNECTED, false, false);
+}
+
+sim800l_event_t sim800l_event_tcpip_connect_fail(char **input_args, void *output_data)
+{
+    return sim800l_tcpip_link_event(input_args, output_data, SIM800L_TCPIP_STATE_FAILED, false, false);
+}
+
+sim800l_event_t sim800l_event_tcpip_send_ok(char **input_args, void *output_data)
+{
+    return sim800l_tcpip_link_event(input_args, output_data, SIM800L_TCPIP_STATE_CONNECTED, true, false);
+}
+
+sim800l_event_t sim800l_event_tcpip_send_fail(char **input_args, void *output_data)
+{
+    return sim800l_tcpip_link_event(input_args, output_data, SIM800L_TCPIP_STATE_CONNECTED, true, true);
+}
+
+sim800l_event_t sim800l_event_tcpip_closed(char **input_args, void *output_data)
+{
+    return sim800l_tcpip_link_event(input_args, output_data, SIM800L_TCPIP_STATE_CLOSED, false, false);
+}
+
+sim800l_event_t sim800l_event_tcpip_rxget(char **input_args, void *output_data)
+{
+    sim800l_tcpip_event_t *event = (sim800l_tcpip_event_t *)output_data;
+
+    if ((input_args[0] == NULL) || (input_args[1] == NULL))
+    {
+        return SIM800L_EVENT_TCPIP;
+    }
+
+    uint32_t mode = atoi(input_args[0]);
+    uint32_t link = atoi(input_args[1]);
+    if (link >= SIM800L_TCPIP_MAX_LINKS)
+    {
+        return SIM800L_EVENT_TCPIP;
+    }
+
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[link];
+
+    if (mode == 1)
+    {
+        /* New data, no count until it is read */
+        tcpip_link->rx_notified = true;
+    }
+    else if ((mode == 2) && (input_args[2] != NULL) && (input_args[3] != NULL))
+    {
+        tcpip_link->rx_pending = atoi(input_args[3]);
+    }
+
+    event->link = link;
+    event->state = tcpip_link->state;
+    event->send_done = false;
+    event->send_failed = false;
+
+    return SIM800L_EVENT_TCPIP;
+}
+
+sim800l_event_t sim800l_event_tcpip_data_accept(char **input_args, void *output_data)
+{
+    /* "DATA ACCEPT:<n>,<length>", the send is done as far as the modem is concerned */
+    return sim800l_tcpip_link_event(input_args, output_data, SIM800L_TCPIP_STATE_CONNECTED, true, false);
+}
+
+sim800l_event_t sim800l_event_tcpip_server_ok(char **input_args, void *output_data)
+{
+    sim800l_tcpip_server_event_t *event = (sim800l_tcpip_server_event_t *)output_data;
+
+    sim800l_tcpip_server_listening = true;
+
+    event->state = SIM800L_TCPIP_SERVER_LISTENING;
+    event->link = SIM800L_TCPIP_MAX_LINKS;
+    event->timestamp = esp_timer_get_time();
+
+    return SIM800L_EVENT_TCPIP_SERVER;
+}
+
+sim800l_event_t sim800l_event_tcpip_server_close(char **input_args, void *output_data)
+{
+    sim800l_tcpip_server_event_t *event = (sim800l_tcpip_server_event_t *)output_data;
+
+    sim800l_tcpip_server_listening = false;
+
+    event->state = SIM800L_TCPIP_SERVER_CLOSED;
+    event->link = SIM800L_TCPIP_MAX_LINKS;
+    event->timestamp = esp_timer_get_time();
+
+    return SIM800L_EVENT_TCPIP_SERVER;
+}
+
+sim800l_event_t sim800l_event_tcpip_remote_ip(char **input_args, void *output_data)
+{
+    sim800l_tcpip_server_event_t *event = (sim800l_tcpip_server_event_t *)output_data;
+
+    event->timestamp = esp_timer_get_time();
+    event->state = SIM800L_TCPIP_SERVER_ACCEPT;
+    event->link = (input_args[0] != NULL) ? atoi(input_args[0]) : SIM800L_TCPIP_MAX_LINKS;
+
+    if (event->link >= SIM800L_TCPIP_MAX_LINKS)
+    {
+        return SIM800L_EVENT_TCPIP_SERVER;
+    }
+
+    if (input_args[1] != NULL)
+    {
+        strncpy(event->remote_ip, input_args[1], sizeof(event->remote_ip) - 1);
+    }
+
+    /* Same state as a link opened with CIPSTART, buffer created by sim800l_tcpip_server_start */
+    sim800l_tcpip_link_t *tcpip_link = &sim800l_tcpip_links[event->link];
+
+    if (tcpip_link->rx_buffer != NULL)
+    {
+        xStreamBufferReset(tcpip_link->rx_buffer);
+    }
+
+    memset(&tcpip_link->stats, 0, sizeof(sim800l_tcpip_stats_t));
+    tcpip_link->send_pending = false;
+    tcpip_link->send_failed = false;
+    tcpip_link->rx_notified = false;
+    tcpip_link->rx_pending = 0;
+    tcpip_link->acked = 0;
+    tcpip_link->state = SIM800L_TCPIP_STATE_CONNECTED;
+
+    return SIM800L_EVENT_TCPIP_SERVER;
+}